@@ -24,6 +24,7 @@ QNNContext::QNNContext(const std::string& model_name,
                        const std::string& model_path, const std::string& backend_lib_path, const std::string& system_lib_path, bool async) {
     m_model_name = model_name;
 
+    py::gil_scoped_release release;
     g_LibAppBuilder.ModelInitialize(model_name, model_path, backend_lib_path, system_lib_path, async);
 }
 
@@ -32,9 +33,21 @@ QNNContext::QNNContext(const std::string& model_name, const std::string& proc_na
     m_model_name = model_name;
     m_proc_name = proc_name;
 
+    py::gil_scoped_release release;
     g_LibAppBuilder.ModelInitialize(model_name, proc_name, model_path, backend_lib_path, system_lib_path, async);
 }
 
+QNNContext::QNNContext(const std::string& model_name, const std::string& proc_name,
+                       const std::string& model_path, const std::string& backend_lib_path,
+                       const std::string& system_lib_path, const std::vector<LoraAdapter>& lora_adapters, bool async) {
+    m_model_name = model_name;
+    m_proc_name = proc_name;
+    m_lora_adapters = lora_adapters;
+
+    py::gil_scoped_release release;
+    g_LibAppBuilder.ModelInitialize(model_name, proc_name, model_path, backend_lib_path, system_lib_path, m_lora_adapters, async);
+}
+
 QNNContext::QNNContext(const std::string& model_name,
                        const std::string& model_path, const std::string& backend_lib_path, 
                        const std::string& system_lib_path, const std::vector<LoraAdapter>& lora_adapters, bool async) {
@@ -42,10 +55,12 @@ QNNContext::QNNContext(const std::string& model_name,
     m_model_name = model_name;
     m_lora_adapters = lora_adapters;
 
+    py::gil_scoped_release release;
     g_LibAppBuilder.ModelInitialize(model_name, model_path, backend_lib_path, system_lib_path, m_lora_adapters, async);
 }
 
 QNNContext::~QNNContext() {
+    py::gil_scoped_release release;
     if (m_proc_name.empty())
         g_LibAppBuilder.ModelDestroy(m_model_name);
     else
@@ -53,20 +68,66 @@ QNNContext::~QNNContext() {
 }
 
 
-std::vector<py::array_t<float>> 
-QNNContext::Inference(const std::vector<py::array_t<float>>& input, const std::string& perf_profile) {
-    return inference(m_model_name, input, perf_profile);
+py::list
+QNNContext::Inference(const std::vector<py::object>& input, const std::string& perf_profile, bool native, py::object out) {
+    if (!m_proc_name.empty()) {     // Through the share memory arena.
+        return inference_P(m_model_name, m_proc_name, "", input, perf_profile, native, out);
+    }
+    return inference(m_model_name, input, perf_profile, native, out);
+}
+
+py::list
+QNNContext::Inference(const ShareMemory& share_memory, const std::vector<py::object>& input, const std::string& perf_profile,
+                      bool native, py::object out) {
+    return inference_P(m_model_name, m_proc_name, share_memory.m_share_memory_name, input, perf_profile, native, out);
 }
 
-std::vector<py::array_t<float>> 
-QNNContext::Inference(const ShareMemory& share_memory, const std::vector<py::array_t<float>>& input, const std::string& perf_profile) {
-    return inference_P(m_model_name, m_proc_name, share_memory.m_share_memory_name, input, perf_profile);
+void
+QNNContext::InferenceAsync(const std::vector<py::object>& input, py::function callback, const std::string& perf_profile, bool native, py::object out) {
+    std::shared_ptr<PyInference> pInference = std::make_shared<PyInference>();
+    // A model of a service process goes through the share memory arena.
+    prepare_inference_P(*pInference, m_model_name, m_proc_name, "", input, perf_profile, native, out);
+    inference_async(pInference, callback);
 }
 
 bool QNNContext::ApplyBinaryUpdate(const std::vector<LoraAdapter>& lora_adapters) {
+    py::gil_scoped_release release;
     return g_LibAppBuilder.ModelApplyBinaryUpdate(m_model_name, const_cast<std::vector<LoraAdapter>&>(lora_adapters));
 }
 
+bool QNNContext::SetBatching(size_t max_batch_size, uint32_t max_wait_us) {
+    return g_LibAppBuilder.ModelSetBatching(m_model_name, max_batch_size, max_wait_us);
+}
+
+bool QNNContext::SetReplicas(uint32_t replicas) {
+    py::gil_scoped_release release;
+    return g_LibAppBuilder.ModelSetReplicas(m_model_name, replicas);
+}
+
+py::dict QNNContext::GetInfo() {
+    return get_info_P(m_model_name, m_proc_name);
+}
+
+py::dict QNNContext::GetStats() {
+    return get_stats(m_model_name);
+}
+
+bool QNNContext::ResetStats() {
+    return g_LibAppBuilder.ModelResetStats(m_model_name);
+}
+
+std::string QNNContext::DumpStats(bool json) {
+    return g_LibAppBuilder.ModelDumpStats(m_model_name, json);
+}
+
+py::list QNNContext::GetProfilingStats() {
+    return get_profiling_stats(m_model_name);
+}
+
+bool QNNContext::ResetProfilingStats() {
+    return g_LibAppBuilder.ModelResetProfilingStats(m_model_name);
+}
+
 PYBIND11_MODULE(appbuilder, m) {
     m.doc() = R"pbdoc(
         Pybind11 AppBuilder Extension.
@@ -78,12 +139,29 @@ PYBIND11_MODULE(appbuilder, m) {
             model_initialize
             model_inference
             model_destroy
+            model_set_batching
+            model_set_replicas
+            model_get_info
+            model_get_stats
+            model_reset_stats
+            model_dump_stats
+            model_get_profiling_stats
+            model_reset_profiling_stats
             memory_create
             memory_delete
             set_log_level
             set_profiling_level
             set_perf_profile
             rel_perf_profile
+            set_context_cache_dir
+            set_model_warmup
+            set_trace_enabled
+            dump_trace
+            set_log_inference_time
+            set_log_async
+            get_log_dropped_count
+            set_svc_doorbell
+            set_async_workers
             )pbdoc";
 
     m.attr("__name__") = "qai_appbuilder";
@@ -92,23 +170,46 @@ PYBIND11_MODULE(appbuilder, m) {
     m.attr("__license__") = "BSD-3-Clause";
 
     m.def("model_initialize", &initialize, "Initialize models.");
-#ifdef _WIN32
     m.def("model_initialize", &initialize_P, "Initialize models.");
-#endif
-    m.def("model_inference", &inference, "Inference models.");
-#ifdef _WIN32
-    m.def("model_inference", &inference_P, "Inference models.");
-#endif
+    m.def("model_inference", &inference, "Inference models.",
+          py::arg("model_name"), py::arg("input"), py::arg("perf_profile") = "default", py::arg("native") = false, py::arg("out") = py::none());
+    m.def("model_inference", &inference_P, "Inference models.",
+          py::arg("model_name"), py::arg("proc_name"), py::arg("share_memory_name"), py::arg("input"), py::arg("perf_profile") = "default",
+          py::arg("native") = false, py::arg("out") = py::none());
     m.def("model_destroy", &destroy, "Destroy models.");
-#ifdef _WIN32
     m.def("model_destroy", &destroy_P, "Destroy models.");
-#endif
+    m.def("model_set_batching", &set_batching, "Enable dynamic micro-batching for a model.");
+    m.def("model_set_replicas", &set_replicas, "Run a model in several service processes.");
+    m.def("model_get_info", &get_info, "Get the name, data type, shape and quantization of the inputs and outputs of a model.");
+    m.def("model_get_info", &get_info_P, "Get the name, data type, shape and quantization of the inputs and outputs of a model.");
+    m.def("model_get_stats", &get_stats, "Get initialization and latency statistics of a model.");
+    m.def("model_reset_stats", &reset_stats, "Clear the latency histograms of a model.");
+    m.def("model_dump_stats", &dump_stats, "Format the statistics of a model, or of all models if model_name is empty, as text or JSON.",
+          py::arg("model_name") = "", py::arg("json") = false);
+    m.def("model_get_profiling_stats", &get_profiling_stats, "Get per event statistics of the backend profiling events of a model.");
+    m.def("model_reset_profiling_stats", &reset_profiling_stats, "Clear the recorded backend profiling events of a model.");
     m.def("memory_create", &create_memory, "Create share memory.");
     m.def("memory_delete", &delete_memory, "Delete share memory.");
     m.def("set_log_level", &set_log_level, "Set QNN log level.");
     m.def("set_profiling_level", &set_profiling_level, "Set QNN profiling level.");
     m.def("set_perf_profile", &set_perf_profile, "Set HTP perf profile.");
     m.def("rel_perf_profile", &rel_perf_profile, "Release HTP perf profile.");
+    m.def("set_context_cache_dir", &set_context_cache_dir, "Set the context binary cache directory.",
+          py::arg("cache_dir"), py::arg("max_cache_size") = 0);
+    m.def("set_model_warmup", &set_model_warmup, "Set the number of warmup runs done by model initialization.",
+          py::arg("count"), py::arg("random_inputs") = false);
+    m.def("set_trace_enabled", &set_trace_enabled, "Enable or disable timeline tracing.");
+    m.def("dump_trace", &dump_trace, "Write the recorded trace spans as Chrome trace JSON.",
+          py::arg("trace_path"), py::arg("clear") = true);
+    m.def("set_log_inference_time", &set_log_inference_time, "Log the duration of every inference.");
+    m.def("set_log_async", &set_log_async, "Write log messages from a background thread.");
+    m.def("get_log_dropped_count", &get_log_dropped_count, "Number of log messages dropped by asynchronous logging.");
+    m.def("set_svc_doorbell", &set_svc_doorbell, "Talk to the service processes started from now on through share memory rings.",
+          py::arg("enable"), py::arg("spin_us") = 20);
+    m.def("set_async_workers", &set_async_workers, "Set the number of threads running asynchronous inferences, 0 for the default.");
+
+    // Finish the asynchronous inferences while the interpreter can still run their callbacks.
+    py::module_::import("atexit").attr("register")(py::cpp_function([]() { set_async_workers(0); }));
 
 
     py::class_<ShareMemory>(m, "ShareMemory")
@@ -118,9 +219,22 @@ PYBIND11_MODULE(appbuilder, m) {
         .def(py::init<const std::string&, const std::string&, const std::string&, const std::string&, bool>())
         .def(py::init<const std::string&, const std::string&, const std::string&, const std::string&, const std::vector<LoraAdapter>&, bool>())
         .def(py::init<const std::string&, const std::string&, const std::string&, const std::string&, const std::string&, bool>())
-        .def("Inference", py::overload_cast<const std::vector<py::array_t<float>>&, const std::string&>(&QNNContext::Inference))
-        .def("Inference", py::overload_cast<const ShareMemory&, const std::vector<py::array_t<float>>&, const std::string&>(&QNNContext::Inference))
-        .def("ApplyBinaryUpdate", &QNNContext::ApplyBinaryUpdate, "Apply Lora binary update");
+        .def(py::init<const std::string&, const std::string&, const std::string&, const std::string&, const std::string&, const std::vector<LoraAdapter>&, bool>())
+        .def("Inference", py::overload_cast<const std::vector<py::object>&, const std::string&, bool, py::object>(&QNNContext::Inference),
+             py::arg("input"), py::arg("perf_profile") = "default", py::arg("native") = false, py::arg("out") = py::none())
+        .def("Inference", py::overload_cast<const ShareMemory&, const std::vector<py::object>&, const std::string&, bool, py::object>(&QNNContext::Inference),
+             py::arg("share_memory"), py::arg("input"), py::arg("perf_profile") = "default", py::arg("native") = false, py::arg("out") = py::none())
+        .def("InferenceAsync", &QNNContext::InferenceAsync, "Run an inference on a worker thread, then call 'callback(outputs, error)'",
+             py::arg("input"), py::arg("callback"), py::arg("perf_profile") = "default", py::arg("native") = false, py::arg("out") = py::none())
+        .def("ApplyBinaryUpdate", &QNNContext::ApplyBinaryUpdate, "Apply Lora binary update")
+        .def("SetBatching", &QNNContext::SetBatching, "Enable dynamic micro-batching")
+        .def("SetReplicas", &QNNContext::SetReplicas, "Run the model in several service processes")
+        .def("GetInfo", &QNNContext::GetInfo, "Get the inputs and outputs of the model")
+        .def("GetStats", &QNNContext::GetStats, "Get initialization and latency statistics")
+        .def("ResetStats", &QNNContext::ResetStats, "Clear the latency histograms")
+        .def("DumpStats", &QNNContext::DumpStats, "Format the statistics as text or JSON", py::arg("json") = false)
+        .def("GetProfilingStats", &QNNContext::GetProfilingStats, "Get per event backend profiling statistics")
+        .def("ResetProfilingStats", &QNNContext::ResetProfilingStats, "Clear the recorded backend profiling events");
 
 
     py::class_<LoraAdapter>(m, "LoraAdapter")
@@ -23,6 +23,9 @@ namespace py = pybind11;
 
 LibAppBuilder g_LibAppBuilder;
 
+// The calls into g_LibAppBuilder which load, run or destroy a model release the GIL, so other Python threads run
+// meanwhile. Everything they need from Python objects, like the buffer pointers, is read before.
+
 /*
     QNN_LOG_LEVEL_ERROR = 1,
     QNN_LOG_LEVEL_WARN = 2,
@@ -52,93 +55,478 @@ int rel_perf_profile() {
     return RelPerfProfileGlobal();
 }
 
+int set_context_cache_dir(const std::string& cache_dir, uint64_t max_cache_size = 0) {
+    return SetContextCacheDir(cache_dir, max_cache_size);
+}
+
+void set_model_warmup(uint32_t count, bool random_inputs = false) {
+    SetModelWarmup(count, random_inputs);
+}
+
+void set_trace_enabled(bool enable) {
+    SetTraceEnabled(enable);
+}
+
+int dump_trace(const std::string& trace_path, bool clear = true) {
+    return DumpTrace(trace_path, clear);
+}
+
+void set_log_inference_time(bool enable) {
+    SetLogInferenceTime(enable);
+}
+
+void set_log_async(bool enable) {
+    SetLogAsync(enable);
+}
+
+void set_svc_doorbell(bool enable, uint32_t spin_us) {
+    SetSvcDoorbell(enable, spin_us);
+}
+
+void set_async_workers(uint32_t count) {
+    py::gil_scoped_release release;     // The workers finishing their inferences take the GIL.
+    SetAsyncWorkers(count);
+}
+
+uint64_t get_log_dropped_count() {
+    return GetLogDroppedCount();
+}
+
 int initialize(const std::string& model_name,
                const std::string& model_path, const std::string& backend_lib_path, const std::string& system_lib_path, bool async) {
+    py::gil_scoped_release release;
     return g_LibAppBuilder.ModelInitialize(model_name, model_path, backend_lib_path, system_lib_path, async);
 }
 
 int initialize_P(const std::string& model_name, const std::string& proc_name,
                  const std::string& model_path, const std::string& backend_lib_path, const std::string& system_lib_path, bool async) {
+    py::gil_scoped_release release;
     return g_LibAppBuilder.ModelInitialize(model_name, proc_name, model_path, backend_lib_path, system_lib_path, async);
 }
 
+int set_batching(std::string model_name, size_t max_batch_size, uint32_t max_wait_us) {
+    return g_LibAppBuilder.ModelSetBatching(model_name, max_batch_size, max_wait_us);
+}
+
+int set_replicas(std::string model_name, uint32_t replicas) {
+    py::gil_scoped_release release;
+    return g_LibAppBuilder.ModelSetReplicas(model_name, replicas);
+}
+
+py::dict latency_stats_to_dict(const LatencyStats& stats) {
+    py::dict result;
+    result["count"] = stats.count;
+    result["mean_us"] = stats.meanUs;
+    result["min_us"] = stats.minUs;
+    result["p50_us"] = stats.p50Us;
+    result["p90_us"] = stats.p90Us;
+    result["p99_us"] = stats.p99Us;
+    result["p999_us"] = stats.p999Us;
+    result["max_us"] = stats.maxUs;
+    return result;
+}
+
+py::dict get_stats(std::string model_name) {
+    py::dict result;
+    ModelStats stats;
+    if (!g_LibAppBuilder.ModelGetStats(model_name, stats)) {
+        return result;
+    }
+    result["initialize_ms"] = stats.initializeMs;
+    result["warmup_runs"] = stats.warmupRuns;
+    result["cold_latency_ms"] = stats.coldLatencyMs;
+    result["warm_latency_ms"] = stats.warmLatencyMs;
+    result["executions"] = stats.executions;
+    result["warm"] = stats.warm;
+    result["total"] = latency_stats_to_dict(stats.total);
+    result["input_conversion"] = latency_stats_to_dict(stats.inputConversion);
+    result["execute"] = latency_stats_to_dict(stats.execute);
+    result["output_conversion"] = latency_stats_to_dict(stats.outputConversion);
+    return result;
+}
+
+py::dict tensor_info_to_dict(const TensorInfo& info) {
+    py::dict result;
+    result["name"] = info.name;
+    result["dtype"] = info.dataType;
+    result["shape"] = py::tuple(py::cast(info.shape));
+    result["size"] = info.size;
+    result["quantized"] = info.quantized;
+    result["scale"] = info.scale;
+    result["offset"] = info.offset;
+    return result;
+}
+
+// Empty if the model is unknown. A model in a service process is asked for them the first time.
+py::dict get_info_P(std::string model_name, std::string proc_name) {
+    py::dict result;
+    std::vector<TensorInfo> inputs, outputs;
+    bool known = false;
+    {
+        py::gil_scoped_release release;
+        known = g_LibAppBuilder.ModelGetInfo(model_name, proc_name, inputs, outputs);
+    }
+    if (!known) {
+        return result;
+    }
+    py::list inputList, outputList;
+    for (auto& info : inputs) {
+        inputList.append(tensor_info_to_dict(info));
+    }
+    for (auto& info : outputs) {
+        outputList.append(tensor_info_to_dict(info));
+    }
+    result["inputs"] = inputList;
+    result["outputs"] = outputList;
+    return result;
+}
+
+py::dict get_info(std::string model_name) {
+    return get_info_P(model_name, "");
+}
+
+int reset_stats(std::string model_name) {
+    return g_LibAppBuilder.ModelResetStats(model_name);
+}
+
+std::string dump_stats(std::string model_name, bool json) {
+    return g_LibAppBuilder.ModelDumpStats(model_name, json);
+}
+
+py::list get_profiling_stats(std::string model_name) {
+    py::list result;
+    std::vector<ProfilingEventStats> stats;
+    if (!g_LibAppBuilder.ModelGetProfilingStats(model_name, stats)) {
+        return result;
+    }
+    for (auto& event : stats) {
+        py::dict item;
+        item["identifier"] = event.identifier;
+        item["graph"] = event.graphIdx;
+        item["type"] = event.type;
+        item["unit"] = event.unit;
+        item["count"] = event.count;
+        item["min"] = event.min;
+        item["max"] = event.max;
+        item["mean"] = event.mean;
+        item["p50"] = event.p50;
+        item["p99"] = event.p99;
+        result.append(item);
+    }
+    return result;
+}
+
+int reset_profiling_stats(std::string model_name) {
+    return g_LibAppBuilder.ModelResetProfilingStats(model_name);
+}
+
 int destroy(std::string model_name) {
+    py::gil_scoped_release release;
     return g_LibAppBuilder.ModelDestroy(model_name);
 }
 
 int destroy_P(std::string model_name, std::string proc_name) {
+    py::gil_scoped_release release;
     return g_LibAppBuilder.ModelDestroy(model_name, proc_name);
 }
 
-std::vector<py::array_t<float>> inference(std::string model_name, const std::vector<py::array_t<float>>& input, std::string perf_profile) {
-    std::vector<uint8_t*> inputBuffers;
-    std::vector<uint8_t*> outputBuffers;
-    std::vector<size_t> outputSize;
-
-    //QNN_INF("inference input vector length: %d\n", input.size());
+// A numpy array sharing the memory of 'object': a numpy array, an object with '__dlpack__' on the CPU such as a torch
+// tensor, or one with the buffer protocol. 'writeable' is for the 'out' arrays, which numpy before 2.0 can't get from
+// DLPack. Nothing is copied, the array keeps 'object' alive. If DLPack fails, e.g. numpy before 1.23 has no
+// from_dlpack(), np.asarray() is tried; TypeError tells why neither gave an array of numbers.
+py::array as_array(py::handle object, const std::string& what, size_t index, bool writeable) {
+    if (py::isinstance<py::array>(object)) {
+        return py::reinterpret_borrow<py::array>(object);
+    }
 
-    for (auto i = 0; i < input.size(); i++) {
-        py::buffer_info buf = input[i].request();
-        inputBuffers.push_back(reinterpret_cast<uint8_t*>(buf.ptr));
+    py::module_ numpy = py::module_::import("numpy");
+    std::string dlpackError;
+    if (py::hasattr(object, "__dlpack__")) {
+        try {
+            py::array array = numpy.attr("from_dlpack")(object);
+            if (!writeable || array.writeable() || !py::hasattr(object, "__array__")) {
+                return array;
+            }
+        }
+        catch (py::error_already_set& e) {
+            dlpackError = std::string(" (from_dlpack: ") + e.what() + ")";
+        }
+    }
+    std::string error = what + " " + std::to_string(index) + " of type " + std::string(py::str(py::type::of(object))) +
+                        " can't be shared with numpy";
+    py::array array;
+    try {
+        array = numpy.attr("asarray")(object);
+    }
+    catch (py::error_already_set& e) {
+        throw py::type_error(error + ": " + e.what() + dlpackError);
+    }
+    if (array.dtype().kind() == 'O') {      // np.asarray() wraps any object.
+        throw py::type_error(error + dlpackError + ".");
     }
+    return array;
+}
 
-    g_LibAppBuilder.ModelInference(model_name, inputBuffers, outputBuffers, outputSize, perf_profile);
+// The buffer of an input array, which is used as it is: nothing is cast or copied here.
+uint8_t* input_buffer(const py::array& array, size_t index) {
+    if (!(array.flags() & py::array::c_style)) {
+        throw py::value_error("Input " + std::to_string(index) + " is not C-contiguous, pass np.ascontiguousarray() of it.");
+    }
+    return reinterpret_cast<uint8_t*>(const_cast<void*>(array.data()));
+}
 
-    //QNN_INF("inference::inference output vector length: %d\n", outputBuffers.size());
+size_t element_count(const TensorInfo& info) {
+    size_t count = 1;
+    for (size_t dim : info.shape) {
+        count *= dim;
+    }
+    return count;
+}
 
-    std::vector<py::array_t<float>> output;
-    //start_time();
-    for (auto i = 0; i < outputBuffers.size(); i++) {
-        size_t size = outputSize[i] / (sizeof(float) / sizeof(uint8_t));
+// Check 'input' against the inputs of the model, unknown if 'inputs' is nullptr: each array is float32, converted to
+// the data type of its input by the library, or already in that data type, used as it is. Its size has to match.
+void check_inputs(const std::string& model_name, const std::vector<py::array>& input, const std::vector<TensorInfo>* inputs,
+                  std::vector<uint8_t*>& inputBuffers, std::vector<std::string>& inputDataTypes) {
+    if (inputs && input.size() != inputs->size()) {
+        throw py::value_error("Model " + model_name + " takes " + std::to_string(inputs->size()) + " inputs, got " +
+                              std::to_string(input.size()) + ".");
+    }
 
-        // https://github.com/pybind/pybind11/issues/1042#issuecomment-325941022
-        // Avoid memory copy for saving time. 'py::capsule' for freeing the memory.
-        py::capsule free_data((float*)outputBuffers[i], [](void* f) {free(f);});
-        auto result = py::array_t<float>(size, (float*)outputBuffers[i], free_data);
+    for (size_t i = 0; i < input.size(); i++) {
+        std::string dataType = py::str(input[i].dtype());
+        std::string nativeType = inputs ? (*inputs)[i].dataType : "float32";
+        if (dataType != "float32" && dataType != nativeType) {
+            throw py::type_error("Input " + std::to_string(i) + " is " + dataType + ", model " + model_name + " takes " +
+                                 nativeType + " or float32.");
+        }
+        if (inputs) {
+            size_t size = dataType == nativeType ? (*inputs)[i].size : element_count((*inputs)[i]) * sizeof(float);
+            if ((size_t)input[i].nbytes() != size) {
+                throw py::value_error("Input " + std::to_string(i) + " has " + std::to_string(input[i].nbytes()) + " bytes, model " +
+                                      model_name + " takes " + std::to_string(size) + " bytes of " + dataType + ".");
+            }
+        }
+        inputBuffers.push_back(input_buffer(input[i], i));
+        inputDataTypes.push_back(dataType);
+    }
+}
 
-        output.push_back(result);
+// Check the 'out' arrays the outputs are written to: C-contiguous and writable, with the data type (float32 or the native
+// one) and the size of their output.
+void check_outputs(const std::string& model_name, const std::vector<py::array>& out, const std::vector<TensorInfo>& outputs,
+                   bool native, std::vector<uint8_t*>& outputBuffers, std::vector<size_t>& outputSize) {
+    if (out.size() != outputs.size()) {
+        throw py::value_error("Model " + model_name + " has " + std::to_string(outputs.size()) + " outputs, got " +
+                              std::to_string(out.size()) + " out arrays.");
     }
-    //print_time("convert Data To ArrayV");
 
-    return output;
+    for (size_t i = 0; i < out.size(); i++) {
+        std::string dataType = py::str(out[i].dtype());
+        std::string outputType = native ? outputs[i].dataType : "float32";
+        if (dataType != outputType) {
+            throw py::type_error("Out array " + std::to_string(i) + " is " + dataType + ", output " + std::to_string(i) +
+                                 " of model " + model_name + " is " + outputType + ".");
+        }
+        size_t size = native ? outputs[i].size : element_count(outputs[i]) * sizeof(float);
+        if ((size_t)out[i].nbytes() != size) {
+            throw py::value_error("Out array " + std::to_string(i) + " has " + std::to_string(out[i].nbytes()) + " bytes, output " +
+                                  std::to_string(i) + " of model " + model_name + " has " + std::to_string(size) + ".");
+        }
+        if (!(out[i].flags() & py::array::c_style) || !out[i].writeable()) {
+            throw py::value_error("Out array " + std::to_string(i) + " is not a writable C-contiguous array.");
+        }
+        outputBuffers.push_back(reinterpret_cast<uint8_t*>(out[i].mutable_data()));
+        outputSize.push_back(size);
+    }
 }
 
-std::vector<py::array_t<float>> inference_P(std::string model_name, std::string proc_name, std::string share_memory_name,
-                                            const std::vector<py::array_t<float>>& input, std::string perf_profile) {
-    std::vector<uint8_t*> inputBuffers;
-    std::vector<size_t> inputSize;
-    std::vector<uint8_t*> outputBuffers;
-    std::vector<size_t> outputSize;
+// An inference with the Python objects its buffers belong to, see prepare_inference().
+struct PyInference {
+    std::shared_ptr<InferenceRequest> request = std::make_shared<InferenceRequest>();
+    std::vector<py::array> input;
+    std::vector<py::array> out;
+    py::object outObjects;                  // The list of 'out' as the caller passed it, which is returned.
+    std::vector<TensorInfo> outputs;        // Of the model, if 'known'.
+    bool known = false;
+    bool remote = false;
+    py::function callback;                  // Of inference_async().
+
+    // Drops the Python objects, with the GIL held.
+    void release() {
+        input.clear();
+        out.clear();
+        outObjects = py::object();
+        callback = py::function();
+    }
+};
 
-    for (auto i = 0; i < input.size(); i++) {
-        py::buffer_info buf = input[i].request();
-        inputBuffers.push_back(reinterpret_cast<uint8_t*>(buf.ptr));
-        size_t size = buf.size * (sizeof(float) / sizeof(uint8_t));
-        inputSize.push_back(size);
-        // QNN_INF("inference input data size: %llu\n", size);
+// Check the arguments of an inference and fill in its request, with 'proc_name' for a model of that service process.
+// 'input' and 'out' hold numpy arrays or objects as_array() shares.
+void prepare_inference_P(PyInference& inference, std::string model_name, std::string proc_name, std::string share_memory_name,
+                         const std::vector<py::object>& input, std::string perf_profile, bool native, py::object out) {
+    InferenceRequest& request = *inference.request;
+    request.modelName = model_name;
+    request.procName = proc_name;
+    request.shareMemoryName = share_memory_name;
+    request.perfProfile = perf_profile;
+    request.nativeOutputs = native;
+    request.callerOutputs = !out.is_none();
+    inference.remote = !proc_name.empty();
+    for (size_t i = 0; i < input.size(); i++) {
+        inference.input.push_back(as_array(input[i], "Input", i, false));
     }
 
-    g_LibAppBuilder.ModelInference(model_name, proc_name, share_memory_name, inputBuffers, inputSize, outputBuffers, outputSize, perf_profile);
+    //QNN_INF("inference input vector length: %d\n", input.size());
 
-    //QNN_INF("inference_P::inference output vector length: %d\n", outputBuffers.size());
+    std::vector<TensorInfo> inputs;
+    if (inference.remote) {
+        py::gil_scoped_release release;     // The service process is asked the first time.
+        inference.known = g_LibAppBuilder.ModelGetInfo(model_name, proc_name, inputs, inference.outputs);
+    }
+    else {
+        inference.known = g_LibAppBuilder.ModelGetInfo(model_name, inputs, inference.outputs);
+    }
+    check_inputs(model_name, inference.input, inference.known ? &inputs : nullptr, request.inputBuffers, request.inputDataTypes);
+    if (inference.remote) {     // Copied to the share memory by size.
+        for (const py::array& array : inference.input) {
+            request.inputSize.push_back((size_t)array.nbytes());
+        }
+    }
+
+    if ((native || request.callerOutputs) && !inference.known) {
+        throw py::value_error("The outputs of model " + model_name + " are unknown, 'native' and 'out' need them.");
+    }
+    if (request.callerOutputs) {
+        py::list outObjects(out);
+        for (size_t i = 0; i < outObjects.size(); i++) {
+            inference.out.push_back(as_array(outObjects[i], "Out array", i, true));
+        }
+        inference.outObjects = outObjects;
+        check_outputs(model_name, inference.out, inference.outputs, native, request.outputBuffers, request.outputSize);
+    }
+}
+
+// Same for a model of this process.
+void prepare_inference(PyInference& inference, std::string model_name, const std::vector<py::object>& input,
+                       std::string perf_profile, bool native, py::object out) {
+    prepare_inference_P(inference, model_name, "", "", input, perf_profile, native, out);
+}
+
+// Run the request of 'inference' on this thread, without the GIL.
+void run_inference(PyInference& inference) {
+    InferenceRequest& request = *inference.request;
+    py::gil_scoped_release release;
+    if (inference.remote) {
+        request.result = g_LibAppBuilder.ModelInference(request.modelName, request.procName, request.shareMemoryName, request.inputBuffers,
+                                                        request.inputSize, request.inputDataTypes, request.outputBuffers, request.outputSize,
+                                                        request.perfProfile, request.nativeOutputs, request.callerOutputs);
+    }
+    else {
+        request.result = g_LibAppBuilder.ModelInference(request.modelName, request.inputBuffers, request.inputDataTypes, request.outputBuffers,
+                                                        request.outputSize, request.perfProfile, request.nativeOutputs, request.callerOutputs);
+    }
+}
+
+// The outputs have the shape of the model, float32 or its native data type; with 'out' they are written into those
+// arrays, which are returned, and nothing is allocated. The outputs of a model the library can't describe are flat.
+// Those of a model in a service process which are left in a named share memory stay there until its next inference,
+// unless 'copy' is set. The arrays export '__dlpack__', e.g. torch.from_dlpack() shares them.
+py::list finish_inference(PyInference& inference, bool copy) {
+    InferenceRequest& request = *inference.request;
+    py::list output;
+
+    //QNN_INF("inference output vector length: %d\n", request.outputBuffers.size());
+
+    if (request.callerOutputs) {
+        if (request.result) {
+            output = py::reinterpret_borrow<py::list>(inference.outObjects);
+        }
+        return output;
+    }
 
-    std::vector<py::array_t<float>> output;
     //start_time();
-    for (auto i = 0; i < outputBuffers.size(); i++) {
-        size_t size = outputSize[i] / (sizeof(float) / sizeof(uint8_t));
+    const std::vector<TensorInfo>& outputs = inference.outputs;
+    bool native = request.nativeOutputs;
+    for (size_t i = 0; i < request.outputBuffers.size(); i++) {
+        uint8_t* buffer = request.outputBuffers[i];
 
         // https://github.com/pybind/pybind11/issues/1042#issuecomment-325941022
-        // Avoid memory copy for saving time. 'py::capsule' for freeing the memory.
-        py::capsule free_data((float*)outputBuffers[i], [](void* f) {});  // Not free this memory since it's share memory.
-        auto result = py::array_t<float>(size, (float*)outputBuffers[i], free_data);
-
-        output.push_back(result);
+        // Avoid memory copy for saving time. 'py::capsule' for freeing the memory, except the named share memory.
+        bool shared = !request.shareMemoryName.empty();
+        py::capsule free_data = shared ? py::capsule(buffer, [](void* f) {}) : py::capsule(buffer, [](void* f) {free(f);});
+        if (!request.result) {  // The capsule frees what a failed inference left.
+            continue;
+        }
+
+        py::dtype dtype = py::dtype::of<float>();
+        std::vector<py::ssize_t> shape{(py::ssize_t)(request.outputSize[i] / sizeof(float))};
+        size_t itemSize = inference.known && native ? py::dtype(outputs[i].dataType).itemsize() : sizeof(float);
+        if (inference.known && request.outputBuffers.size() == outputs.size() && request.outputSize[i] == element_count(outputs[i]) * itemSize) {
+            dtype = native ? py::dtype(outputs[i].dataType) : dtype;
+            shape.assign(outputs[i].shape.begin(), outputs[i].shape.end());
+        }
+        if (shared && copy) {
+            output.append(py::array(dtype, shape, buffer));     // Without a base, the data is copied.
+        }
+        else {
+            output.append(py::array(dtype, shape, buffer, free_data));
+        }
     }
     //print_time("convert Data To ArrayV");
 
     return output;
 }
 
+py::list inference(std::string model_name, const std::vector<py::object>& input, std::string perf_profile,
+                   bool native, py::object out) {
+    PyInference inference;
+    prepare_inference(inference, model_name, input, perf_profile, native, out);
+    run_inference(inference);
+    return finish_inference(inference, false);
+}
+
+py::list inference_P(std::string model_name, std::string proc_name, std::string share_memory_name,
+                     const std::vector<py::object>& input, std::string perf_profile, bool native, py::object out) {
+    PyInference inference;
+    prepare_inference_P(inference, model_name, proc_name, share_memory_name, input, perf_profile, native, out);
+    run_inference(inference);
+    return finish_inference(inference, false);
+}
+
+// Queue a prepared inference on the workers of the library and return. Once it's done, a worker takes the GIL and
+// calls 'callback(outputs, error)': 'outputs' as inference() returns them, an empty list if it failed, or 'error' a
+// message if they couldn't be made. Outputs left in a named share memory are copied, the worker runs other inferences next.
+void inference_async(std::shared_ptr<PyInference> inference, py::function callback) {
+    inference->callback = callback;
+    // The library copies the callback without the GIL, so it holds the Python objects through 'inference' only and
+    // drops them before it returns.
+    bool queued = g_LibAppBuilder.ModelInferenceAsync(inference->request, [inference](std::shared_ptr<InferenceRequest> request) {
+        py::gil_scoped_acquire acquire;
+        try {
+            py::object error = py::none();
+            py::list output;
+            try {
+                output = finish_inference(*inference, true);
+            }
+            catch (const std::exception& e) {
+                error = py::str(e.what());
+            }
+            inference->callback(output, error);
+        }
+        catch (py::error_already_set& e) {
+            e.discard_as_unraisable("inference_async callback");
+        }
+        catch (const std::exception& e) {
+            QNN_ERR("inference_async::Callback of model %s failed: %s\n", request->modelName.c_str(), e.what());
+        }
+        inference->release();
+    });
+    if (!queued) {
+        inference->release();
+        throw std::runtime_error("Failed to queue an inference of model " + inference->request->modelName + ".");
+    }
+}
+
 bool ApplyBinaryUpdate(const std::vector<LoraAdapter>& lora_adapters);
 
 int create_memory(std::string share_memory_name, size_t share_memory_size) {
@@ -176,11 +564,28 @@ public:
        	       const std::string& model_path, const std::string& backend_lib_path, 
                const std::string& system_lib_path, bool async = false);
 
-    std::vector<py::array_t<float>> Inference(const std::vector<py::array_t<float>>& input, const std::string& perf_profile = "default");
-    std::vector<py::array_t<float>> Inference(const ShareMemory& share_memory, const std::vector<py::array_t<float>>& input, const std::string& perf_profile = "default");
+    QNNContext(const std::string& model_name, const std::string& proc_name,
+               const std::string& model_path, const std::string& backend_lib_path,
+               const std::string& system_lib_path, const std::vector<LoraAdapter>& lora_adapters, bool async = false);
+
+    py::list Inference(const std::vector<py::object>& input, const std::string& perf_profile = "default",
+                       bool native = false, py::object out = py::none());
+    py::list Inference(const ShareMemory& share_memory, const std::vector<py::object>& input, const std::string& perf_profile = "default",
+                       bool native = false, py::object out = py::none());
+    void InferenceAsync(const std::vector<py::object>& input, py::function callback, const std::string& perf_profile = "default",
+                        bool native = false, py::object out = py::none());
     
     bool ApplyBinaryUpdate(const std::vector<LoraAdapter>& lora_adapters);
 
+    bool SetBatching(size_t max_batch_size, uint32_t max_wait_us);
+    bool SetReplicas(uint32_t replicas);
+    py::dict GetInfo();
+    py::dict GetStats();
+    bool ResetStats();
+    std::string DumpStats(bool json);
+    py::list GetProfilingStats();
+    bool ResetProfilingStats();
+
     ~QNNContext();
 };
 
@@ -0,0 +1,96 @@
+# ---------------------------------------------------------------------
+# Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+# SPDX-License-Identifier: BSD-3-Clause
+# ---------------------------------------------------------------------
+
+# Runs several models from one asyncio event loop, first one inference after the other, then all of them awaited
+# together with QNNContext.inference_async(), and prints the throughput of both.
+# The models are those the other samples downloaded, or the .bin files given with --models.
+
+import sys
+import os
+sys.path.append(".")
+sys.path.append("python")
+import argparse
+import asyncio
+import time
+import numpy as np
+
+from qai_appbuilder import (QNNContext, Runtime, LogLevel, ProfilingLevel, PerfProfile, QNNConfig, AsyncWorkers)
+
+####################################################################
+
+MODEL_NAMES = ["inception_v3", "yolov8_det", "unet_segmentation", "real_esrgan_general_x4v3"]
+
+####################################################################
+
+execution_ws = os.getcwd()
+qnn_dir = execution_ws + "\\qai_libs"
+
+if not "python" in execution_ws:
+    execution_ws = execution_ws + "\\" + "python"
+
+####################################################################
+
+def random_inputs(model):
+    inputs = []
+    for info in model.GetInfo()["inputs"]:
+        dtype = np.dtype(info["dtype"])
+        if dtype.kind == "f":
+            inputs.append(np.random.rand(*info["shape"]).astype(np.float32))
+        else:
+            inputs.append(np.random.randint(0, 128, size=info["shape"]).astype(dtype))
+    return inputs
+
+async def run_sequential(models, inputs, count):
+    for _ in range(count):
+        for model, input in zip(models, inputs):
+            await model.inference_async(input)
+
+async def run_concurrent(models, inputs, count):
+    # Each model keeps 'count' inferences in flight, they run one at a time; the models run at the same time.
+    await asyncio.gather(*[model.inference_async(input) for _ in range(count) for model, input in zip(models, inputs)])
+
+def measure(name, models, inputs, count, run):
+    begin = time.perf_counter()
+    asyncio.run(run(models, inputs, count))
+    elapsed = time.perf_counter() - begin
+    inferences = count * len(models)
+    print(f"{name:<12} {inferences} inferences in {elapsed * 1000:.1f} ms, {inferences / elapsed:.1f} inferences/s")
+    return elapsed
+
+def main():
+    parser = argparse.ArgumentParser(description="Await the inferences of several models in one asyncio event loop.")
+    parser.add_argument("--models", nargs="*", help="Paths of the model .bin files, by default those of the other samples.")
+    parser.add_argument("--count", type=int, default=20, help="Inferences per model.")
+    parser.add_argument("--workers", type=int, default=0, help="Worker threads, 0 for one per core.")
+    args = parser.parse_args()
+
+    model_paths = args.models
+    if not model_paths:
+        model_paths = [execution_ws + "\\" + name + "\\models\\" + name + ".bin" for name in MODEL_NAMES]
+        model_paths = [path for path in model_paths if os.path.exists(path)]
+    if not model_paths:
+        print("No models found, run the other samples first to download them or pass them with --models.")
+        exit()
+
+    # Config AppBuilder environment.
+    QNNConfig.Config(qnn_dir, Runtime.HTP, LogLevel.WARN, ProfilingLevel.OFF)
+    AsyncWorkers.SetAsyncWorkers(args.workers)
+
+    models = [QNNContext(f"async_{i}", path) for i, path in enumerate(model_paths)]
+    inputs = [random_inputs(model) for model in models]
+
+    PerfProfile.SetPerfProfileGlobal(PerfProfile.BURST)
+
+    measure("warmup", models, inputs, 1, run_sequential)
+    sequential = measure("sequential", models, inputs, args.count, run_sequential)
+    concurrent = measure("concurrent", models, inputs, args.count, run_concurrent)
+    print(f"speedup {sequential / concurrent:.2f}x with {len(models)} models")
+
+    PerfProfile.RelPerfProfileGlobal()
+
+    del(models)
+
+if __name__ == "__main__":
+    main()
@@ -202,7 +202,7 @@ def Inference(input_image_path, output_image_path):
     
     Img = preprocess_PIL_image(resized_image)
     img = preprocess_PIL_image(resized_image).numpy()
-    img = np.transpose(img, (0, 2, 3, 1))
+    img = np.ascontiguousarray(np.transpose(img, (0, 2, 3, 1)))
     original_image = np.array(original_image)
 
     # Burst the HTP.
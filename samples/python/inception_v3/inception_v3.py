@@ -101,7 +101,7 @@ def Inference(input_image_path):
     # Read and preprocess the image.
     image = Image.open(input_image_path)
     image = preprocess_PIL_image(image).numpy()
-    image = np.transpose(image, (0, 2, 3, 1))
+    image = np.ascontiguousarray(np.transpose(image, (0, 2, 3, 1)))
 
     # Burst the HTP.
     PerfProfile.SetPerfProfileGlobal(PerfProfile.BURST)
@@ -113,7 +113,7 @@ def Inference(input_image_path):
     PerfProfile.RelPerfProfileGlobal()
     
     # show the Top 5 predictions for image
-    output = torch.from_numpy(output_data)  
+    output = torch.from_numpy(output_data).reshape(-1)  # The scores of the classes, without the batch dimension.
     probabilities = torch.softmax(output, dim=0)
     post_process(probabilities, output)
     
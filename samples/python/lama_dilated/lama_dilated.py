@@ -100,8 +100,8 @@ def Inference(input_image_path, input_mask_path, output_image_path):
     image_masked = image_masked.numpy()
     mask_torch = mask_torch.numpy()
      
-    image_masked = np.transpose(image_masked, (0, 2, 3, 1)) 
-    mask_torch = np.transpose(mask_torch, (0, 2, 3, 1)) 
+    image_masked = np.ascontiguousarray(np.transpose(image_masked, (0, 2, 3, 1)))
+    mask_torch = np.ascontiguousarray(np.transpose(mask_torch, (0, 2, 3, 1)))
 
     # Burst the HTP.
     PerfProfile.SetPerfProfileGlobal(PerfProfile.BURST)
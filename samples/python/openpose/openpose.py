@@ -367,7 +367,7 @@ def Inference(input_image_path, output_image_path):
     image, scale, padding = pil_resize_pad(image_input, (IMAGE_SIZE, IMAGE_SIZE))
 
     pixel_tensor = preprocess_PIL_image(image).numpy()
-    pixel_values = np.transpose(pixel_tensor, (0, 2, 3, 1))
+    pixel_values = np.ascontiguousarray(np.transpose(pixel_tensor, (0, 2, 3, 1)))
 
     # Burst the HTP.
     PerfProfile.SetPerfProfileGlobal(PerfProfile.BURST)
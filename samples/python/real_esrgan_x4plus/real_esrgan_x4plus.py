@@ -85,7 +85,7 @@ def Inference(input_image_path, output_image_path, show_image = True):
     image, scale, padding = pil_resize_pad(orig_image, (IMAGE_SIZE, IMAGE_SIZE))
 
     image = np.array(image)
-    image = np.clip(image, 0, 255) / 255.0  # normalization
+    image = (np.clip(image, 0, 255) / 255.0).astype(np.float32)  # normalization
 
     # Burst the HTP.
     PerfProfile.SetPerfProfileGlobal(PerfProfile.BURST)
@@ -84,18 +84,22 @@ class TextEncoder(QNNContext):
 class Unet(QNNContext):
     def Inference(self, input_data_1, input_data_2, input_data_3):
         # We need to reshape the array to 1 dimensionality before send it to the network. 'input_data_2' already is 1 dimensionality, so doesn't need to reshape.
-        input_data_1 = input_data_1.reshape(input_data_1.size)
-        input_data_3 = input_data_3.reshape(input_data_3.size)
+        # 'input_data_1' is a torch tensor, the model reads its memory through DLPack.
+        input_data_1 = input_data_1.reshape(-1)
+        input_data_3 = input_data_3.reshape(-1)
+        # The time step is an 'np.int32' scalar, the model takes it as float32.
+        input_data_2 = np.array(input_data_2, dtype=np.float32)
 
         input_datas=[input_data_1, input_data_2, input_data_3]
         output_data = super().Inference(input_datas)[0]
 
-        output_data = output_data.reshape(1, 64, 64, 4)
+        # Share the output with torch for the scheduler, without a copy.
+        output_data = torch.from_dlpack(output_data.reshape(1, 64, 64, 4))
         return output_data
 
 class VaeDecoder(QNNContext):
     def Inference(self, input_data):
-        input_data = input_data.reshape(input_data.size)
+        input_data = input_data.reshape(-1)
         input_datas=[input_data]
 
         output_data = super().Inference(input_datas)[0]
@@ -171,24 +175,19 @@ def setup_parameters(prompt, un_prompt, seed, step, text_guidance):
     assert user_text_guidance >= 5.0 and user_text_guidance <= 15.0, "user_text_guidance should be a float from [5.0, 15.0]"
 
 def run_scheduler(noise_pred_uncond, noise_pred_text, latent_in, timestep):
-    # Convert all inputs from NHWC to NCHW
-    noise_pred_uncond = np.transpose(noise_pred_uncond, (0, 3, 1, 2)).copy()
-    noise_pred_text = np.transpose(noise_pred_text, (0, 3, 1, 2)).copy()
-    latent_in = np.transpose(latent_in, (0, 3, 1, 2)).copy()
-
-    # Convert all inputs to torch tensors
-    noise_pred_uncond = torch.from_numpy(noise_pred_uncond)
-    noise_pred_text = torch.from_numpy(noise_pred_text)
-    latent_in = torch.from_numpy(latent_in)
+    # Convert all inputs from NHWC to NCHW, the torch tensors are views of the model outputs.
+    noise_pred_uncond = noise_pred_uncond.permute(0, 3, 1, 2)
+    noise_pred_text = noise_pred_text.permute(0, 3, 1, 2)
+    latent_in = latent_in.permute(0, 3, 1, 2)
 
     # Merge noise_pred_uncond and noise_pred_text based on user_text_guidance
     noise_pred = noise_pred_uncond + user_text_guidance * (noise_pred_text - noise_pred_uncond)
 
     # Run Scheduler step
-    latent_out = scheduler.step(noise_pred, timestep, latent_in).prev_sample.numpy()
+    latent_out = scheduler.step(noise_pred, timestep, latent_in).prev_sample
 
-    # Convert latent_out from NCHW to NHWC
-    latent_out = np.transpose(latent_out, (0, 2, 3, 1)).copy()
+    # Convert latent_out from NCHW to NHWC, contiguous for the next inference.
+    latent_out = latent_out.permute(0, 2, 3, 1).contiguous()
 
     return latent_out
 
@@ -211,8 +210,8 @@ def model_execute(callback, image_path, show_image = True):
     user_text_embedding = text_encoder.Inference(cond_tokens)
 
     # Initialize the latent input with random initial latent
-    random_init_latent = torch.randn((1, 4, 64, 64), generator=torch.manual_seed(user_seed)).numpy()
-    latent_in = random_init_latent.transpose(0, 2, 3, 1)
+    random_init_latent = torch.randn((1, 4, 64, 64), generator=torch.manual_seed(user_seed))
+    latent_in = random_init_latent.permute(0, 2, 3, 1).contiguous()
 
     time_emb_path = time_embedding_dir + str(user_step) + "\\"
 
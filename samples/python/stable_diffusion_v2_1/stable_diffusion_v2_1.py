@@ -89,6 +89,8 @@ class Unet(QNNContextProc):
         # We need to reshape the array to 1 dimensionality before send it to the network. 'input_data_2' already is 1 dimensionality, so doesn't need to reshape.
         input_data_1 = input_data_1.reshape(input_data_1.size)
         input_data_3 = input_data_3.reshape(input_data_3.size)
+        # The time step is an 'np.int32' scalar, the model takes it as float32.
+        input_data_2 = np.array(input_data_2, dtype=np.float32)
 
         input_datas=[input_data_1, input_data_2, input_data_3]
         output_data = super().Inference(share_mem, input_datas)[0]
@@ -81,7 +81,7 @@ def Inference(input_image_path, output_image_path):
     image_input = image
 
     image = preprocess_PIL_image(image).numpy()
-    image = np.transpose(image, (0, 2, 3, 1))
+    image = np.ascontiguousarray(np.transpose(image, (0, 2, 3, 1)))
 
     # Burst the HTP.
     PerfProfile.SetPerfProfileGlobal(PerfProfile.BURST)
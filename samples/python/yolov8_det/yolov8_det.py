@@ -302,7 +302,7 @@ def Inference(input_image_path, output_image_path):
     outputImg = outputImg.resize((IMAGE_SIZE, IMAGE_SIZE))
     image = preprocess_PIL_image(image) # transfer raw image to torch tensor format
     image  = image.permute(0, 2, 3, 1)
-    image = image.numpy()
+    image = np.ascontiguousarray(image.numpy())
 
     output_image = np.array(outputImg.convert("RGB"))  # transfer to numpy array
 
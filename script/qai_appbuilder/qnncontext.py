@@ -8,6 +8,7 @@
 
 import os
 import sys
+import asyncio
 import functools
 import time
 from qai_appbuilder import appbuilder
@@ -49,6 +50,16 @@ class LogLevel():
     def SetLogLevel(log_level, log_path):
         appbuilder.set_log_level(log_level, log_path)
 
+    def SetLogAsync(enable):
+        """
+            Write log messages from a background thread. Messages are dropped instead of blocking the caller when a
+            thread logs faster than they can be written, GetLogDroppedCount() returns how many.
+        """
+        appbuilder.set_log_async(enable)
+
+    def GetLogDroppedCount():
+        return appbuilder.get_log_dropped_count()
+
 class ProfilingLevel():
     """
         file:///C:/Qualcomm/AIStack/QNN/2.19.0.240124/docs/QNN/general/htp/htp_backend.html?highlight=rpc_control_latency#qnn-htp-profiling
@@ -61,6 +72,86 @@ class ProfilingLevel():
     def SetProfilingLevel(profiling_level):
         appbuilder.set_profiling_level(profiling_level)
 
+class ContextCache():
+    """
+        Cache the context of models loaded from a model library (*.dll / *.so), so only the first load
+        prepares the graphs. Least recently used entries are removed once the cache exceeds 'max_cache_size'
+        bytes (0: no limit). An empty 'cache_dir' disables the cache.
+    """
+    def SetContextCacheDir(cache_dir, max_cache_size = 0):
+        return appbuilder.set_context_cache_dir(cache_dir, max_cache_size)
+
+class ModelWarmup():
+    """
+        Run 'count' executions at the end of every following model initialization, with zero inputs or random
+        inputs if 'random_inputs' is set, so the first real request doesn't pay for the cold start. 0 disables it.
+        QNNContext.GetStats() reports the cold and warm latency.
+    """
+    def SetModelWarmup(count, random_inputs = False):
+        appbuilder.set_model_warmup(count, random_inputs)
+
+class SvcDoorbell():
+    """
+        Talk to the service processes of QNNContextProc started from now on through rings in share memory instead
+        of pipes. A waiting thread spins up to 'spin_us' microseconds before it sleeps; 0 sleeps right away.
+    """
+    def SetSvcDoorbell(enable, spin_us = 20):
+        appbuilder.set_svc_doorbell(enable, spin_us)
+
+class AsyncWorkers():
+    """
+        Threads running the inference_async() calls of every model, by default one per core and at least 4. The
+        current threads finish the inferences already queued before the new ones start.
+    """
+    def SetAsyncWorkers(count = 0):
+        appbuilder.set_async_workers(count)
+
+def _set_future(future, output, error):
+    if future.cancelled():
+        return
+    if error is not None:
+        future.set_exception(RuntimeError(error))
+    else:
+        future.set_result(output)
+
+async def _inference_async(context, input, perf_profile, native = False, out = None):
+    # The worker which ran the inference calls 'done', the future is completed in the thread of the event loop.
+    loop = asyncio.get_running_loop()
+    future = loop.create_future()
+    def done(output, error):
+        loop.call_soon_threadsafe(_set_future, future, output, error)
+    context.InferenceAsync(input, done, perf_profile, native, out)
+    return await future
+
+def _model_specs(model, key):
+    # The inputs and outputs of a model don't change while it's loaded, GetInfo() is asked once.
+    if not getattr(model, "m_info", None):
+        model.m_info = model.m_context.GetInfo()
+    return model.m_info.get(key, [])
+
+class ModelStats():
+    """
+        Statistics of every model loaded in this process, as text or JSON. By default single inferences aren't logged
+        any more; SetLogInferenceTime(True) logs the duration of each one.
+    """
+    def DumpStats(json = False):
+        return appbuilder.model_dump_stats("", json)
+
+    def SetLogInferenceTime(enable):
+        appbuilder.set_log_inference_time(enable)
+
+class Trace():
+    """
+        Timeline of model loading and inference stages per thread, with the backend profiling events as child spans of
+        'graphExecute' when profiling is enabled. DumpTrace() writes Chrome trace JSON, open it in chrome://tracing or
+        https://ui.perfetto.dev. 'clear' drops the dumped spans.
+    """
+    def SetTraceEnabled(enable):
+        appbuilder.set_trace_enabled(enable)
+
+    def DumpTrace(trace_path, clear = True):
+        return appbuilder.dump_trace(trace_path, clear)
+
 class Runtime():
     """Available runtimes for model execution on Qualcomm harwdware."""
     CPU = "Cpu"
@@ -158,9 +249,23 @@ class QNNLoraContext:
                                                m_lora_adapters, is_async)
 
     #@timer
-    def Inference(self, input, perf_profile = PerfProfile.DEFAULT):
-        return self.m_context.Inference(input, perf_profile)
-    
+    def Inference(self, input, perf_profile = PerfProfile.DEFAULT, native = False, out = None):
+        return self.m_context.Inference(input, perf_profile, native, out)
+
+    async def inference_async(self, input, perf_profile = PerfProfile.DEFAULT, native = False, out = None):
+        return await _inference_async(self.m_context, input, perf_profile, native, out)
+
+    def GetInfo(self):
+        return self.m_context.GetInfo()
+
+    @property
+    def input_specs(self):
+        return _model_specs(self, "inputs")
+
+    @property
+    def output_specs(self):
+        return _model_specs(self, "outputs")
+
     def apply_binary_update(self, lora_adapters=None):
         self.lora_adapters = lora_adapters
         
@@ -209,8 +314,80 @@ class QNNContext:
         self.m_context = appbuilder.QNNContext(model_name, model_path, backend_lib_path, system_lib_path, is_async)
 
     #@timer
-    def Inference(self, input, perf_profile = PerfProfile.DEFAULT):
-        return self.m_context.Inference(input, perf_profile)
+    def Inference(self, input, perf_profile = PerfProfile.DEFAULT, native = False, out = None):
+        """
+        'input' is a list of C-contiguous numpy arrays, one per input of the model. An array in the data type of its
+        input (see GetInfo()) is used as it is, a float32 array is converted to it; other data types raise TypeError.
+        Returns one array per output with the shape of the model, float32 or with 'native' in the data type of the
+        model, see GetInfo() for the quantization of those. 'out' is a list of arrays of that shape and data type
+        which the outputs are written to and which are returned; reusing them, an inference allocates no memory.
+        Torch tensors on the CPU and other objects with '__dlpack__' can be passed instead of numpy arrays, their
+        memory is shared and not copied. torch.from_dlpack() shares the memory of the output arrays the same way.
+        """
+        return self.m_context.Inference(input, perf_profile, native, out)
+
+    async def inference_async(self, input, perf_profile = PerfProfile.DEFAULT, native = False, out = None):
+        """
+        Inference() for asyncio: a worker thread runs the inference without the GIL while the event loop goes on,
+        so several inferences of this and other models can be awaited at once, e.g. with asyncio.gather(). 'input'
+        and 'out' must not change until it completes. Returns an empty list if the inference failed.
+        """
+        return await _inference_async(self.m_context, input, perf_profile, native, out)
+
+    def GetInfo(self):
+        """
+        Returns a dict with the 'inputs' and 'outputs' of the model, each one a dict with its 'name', 'dtype' (the
+        numpy data type of the model, e.g. 'uint8'), 'shape', 'size' in bytes and, for 'quantized' ones, the 'scale'
+        and 'offset' of its values: value = (quantized value + offset) * scale.
+        """
+        return self.m_context.GetInfo()
+
+    @property
+    def input_specs(self):
+        """
+        The inputs of the model as GetInfo() describes them, in the order Inference() takes them. Use them to allocate
+        inputs and 'out' arrays in the right shape and data type, which are then used without a conversion.
+        """
+        return _model_specs(self, "inputs")
+
+    @property
+    def output_specs(self):
+        """The outputs of the model as GetInfo() describes them, in the order Inference() returns them."""
+        return _model_specs(self, "outputs")
+
+    def SetBatching(self, max_batch_size, max_wait_us = 1000):
+        """
+        Enable dynamic micro-batching for a model compiled with a batch dimension. Concurrent single-item
+        Inference() calls are packed into one execution of up to 'max_batch_size' items, the oldest request
+        waits at most 'max_wait_us' for the batch to fill. 'max_batch_size' <= 1 disables batching.
+        """
+        return self.m_context.SetBatching(max_batch_size, max_wait_us)
+
+    def GetStats(self):
+        """
+        Returns a dict with the initialization time, the number of warmup runs, the latency of the first (cold)
+        execution, the mean latency of the following (warm) executions, the number of executions and whether
+        the model is warm yet. 'total', 'input_conversion', 'execute' and 'output_conversion' hold the latency
+        distribution (count, mean, min, p50, p90, p99, p99.9 and max in microseconds) of the inferences so far.
+        """
+        return self.m_context.GetStats()
+
+    def ResetStats(self):
+        return self.m_context.ResetStats()
+
+    def DumpStats(self, json = False):
+        return self.m_context.DumpStats(json)
+
+    def GetProfilingStats(self):
+        """
+        Returns one dict per backend profiling event and graph with 'identifier', 'graph', 'type', 'unit', 'count',
+        'min', 'max', 'mean', 'p50' and 'p99' of the event value, over the events recorded since the model was loaded
+        or ResetProfilingStats() was called. Needs ProfilingLevel.SetProfilingLevel() before the model is loaded.
+        """
+        return self.m_context.GetProfilingStats()
+
+    def ResetProfilingStats(self):
+        return self.m_context.ResetProfilingStats()
 
     #@timer
     def __del__(self):
@@ -228,12 +405,15 @@ class QNNContextProc:
                  backend_lib_path: str = "None",
                  system_lib_path: str = "None",
                  runtime : str = Runtime.HTP,
-                 is_async: bool = False
+                 is_async: bool = False,
+                 lora_adapters = None
     ) -> None:
         """Load a QNN model from `model_path`
 
         Args:
             model_path (str): model path
+            lora_adapters: List of LoraAdapter class objects, loaded with the model. If the service process dies,
+                           it is restarted and the model is loaded again with the same adapters.
         """
         self.model_path = model_path
         self.proc_name = proc_name
@@ -253,11 +433,53 @@ class QNNContextProc:
             system_lib_path = g_system_lib_path
 
         os.putenv('PATH', g_base_path)
-        self.m_context = appbuilder.QNNContext(model_name, proc_name, model_path, backend_lib_path, system_lib_path, is_async)
+        if lora_adapters:
+            m_lora_adapters = [adapter.m_adapter for adapter in lora_adapters]
+            self.m_context = appbuilder.QNNContext(model_name, proc_name, model_path, backend_lib_path, system_lib_path,
+                                                   m_lora_adapters, is_async)
+        else:
+            self.m_context = appbuilder.QNNContext(model_name, proc_name, model_path, backend_lib_path, system_lib_path, is_async)
 
     #@timer
-    def Inference(self, shareMemory, input, perf_profile = PerfProfile.DEFAULT):
-        return self.m_context.Inference(shareMemory.m_memory, input, perf_profile)
+    def Inference(self, shareMemory, input, perf_profile = PerfProfile.DEFAULT, native = False, out = None):
+        """
+        'shareMemory' can be None: the data then goes through the share memory arena, which grows as needed and lets
+        inferences run at the same time. The outputs are then arrays of their own, those in 'shareMemory' are valid
+        until its next inference.
+        'input', 'native' and 'out' are those of QNNContext.Inference(), the service process converts the data.
+        """
+        if shareMemory is None:
+            return self.m_context.Inference(input, perf_profile, native, out)
+        return self.m_context.Inference(shareMemory.m_memory, input, perf_profile, native, out)
+
+    async def inference_async(self, input, perf_profile = PerfProfile.DEFAULT, native = False, out = None):
+        """
+        Inference() through the share memory arena for asyncio, see QNNContext.inference_async(). The outputs are
+        copies, they stay valid.
+        """
+        return await _inference_async(self.m_context, input, perf_profile, native, out)
+
+    def GetInfo(self):
+        """
+        QNNContext.GetInfo() of the model, asked from the service process the first time.
+        """
+        return self.m_context.GetInfo()
+
+    @property
+    def input_specs(self):
+        return _model_specs(self, "inputs")
+
+    @property
+    def output_specs(self):
+        return _model_specs(self, "outputs")
+
+    def SetReplicas(self, replicas):
+        """
+        Run the model in 'replicas' service processes: 'proc_name' and 'proc_name#1', 'proc_name#2', ... Each
+        Inference() goes to the process with the least work in flight; a process which died is restarted and its
+        models are loaded again. Inferences running at the same time need different QNNShareMemory objects.
+        """
+        return self.m_context.SetReplicas(replicas)
 
     #@timer
     def __del__(self):
@@ -76,6 +76,8 @@ def build_clean():
         os.remove(binary_path + "/libappbuilder.pdb")
     if os.path.exists(binary_path + "/libappbuilder.so"):
         os.remove(binary_path + "/libappbuilder.so")
+    if os.path.exists(binary_path + "/QAIAppSvc"):
+        os.remove(binary_path + "/QAIAppSvc")
     if os.path.exists(binary_path + "/Genie.dll"):
         os.remove(binary_path + "/Genie.dll")
 
@@ -95,6 +97,8 @@ def build_cmake():
         shutil.copy("lib/" + CONFIG + "/libappbuilder.pdb", binary_path)
     if os.path.exists("lib/" + "libappbuilder.so"):
         shutil.copy("lib/" + "libappbuilder.so", binary_path)
+    if os.path.exists("lib/" + "QAIAppSvc"):
+        shutil.copy("lib/" + "QAIAppSvc", binary_path)
 
     if sys.platform.startswith('win'): # Copy Genie library to 'lib' folder for compiling GenieBuilder pyd.
         LIB_PATH = QNN_SDK_ROOT + "/lib/aarch64-windows-msvc"
@@ -135,6 +139,8 @@ def build_release():
 
     if os.path.exists("lib/" + "/libappbuilder.so"):
         shutil.copy("lib/" + "/libappbuilder.so", tmp_path)
+    if os.path.exists("lib/" + "/QAIAppSvc"):
+        shutil.copy("lib/" + "/QAIAppSvc", tmp_path)
 
     if not os.path.exists(include_path):
         os.mkdir(include_path)
@@ -201,7 +207,7 @@ setup(
     version=VERSION,
     packages=[package_name],
     package_dir={'': 'script'},
-    package_data={"": ["*.dll", "*.pdb", "*.exe", "*.so"]},
+    package_data={"": ["*.dll", "*.pdb", "*.exe", "*.so", "QAIAppSvc"]},
     ext_modules=[CMakeExtension("qai_appbuilder.appbuilder", "pybind")],
     cmdclass={"build_ext": CMakeBuild},
     zip_safe=False,
@@ -15,20 +15,38 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <fcntl.h>
+#include <mutex>
+#include <atomic>
+#include <shared_mutex>
+#include <sstream>
+#include <algorithm>
+#include <tuple>
+#include <thread>
 
 #include "BuildId.hpp"
+#include "DataUtil.hpp"
 #include "DynamicLoadUtil.hpp"
 #include "Logger.hpp"
+#include "AsyncLog.hpp"
+#include "PAL/Directory.hpp"
 #include "PAL/DynamicLoading.hpp"
+#include "PAL/FileOp.hpp"
 #include "PAL/GetOpt.hpp"
+#include "PAL/Path.hpp"
 #include "QnnSampleApp.hpp"
 #include "Lora.hpp"
 #include "QnnSampleAppUtils.hpp"
+#include "QnnTypeMacros.hpp"
 #include "LibAppBuilder.hpp"
+#include "BatchScheduler.hpp"
+#include "ContextCache.hpp"
+#include "LatencyHistogram.hpp"
+#include "Trace.hpp"
+#include "WorkerPool.hpp"
 #ifdef _WIN32
 #include <io.h>
-#include "Utils/Utils.hpp"
 #endif
+#include "Utils/Utils.hpp"
 
 using namespace qnn;
 using namespace qnn::log;
@@ -41,9 +59,57 @@ static QNN_INTERFACE_VER_TYPE sg_qnnInterface;
 QnnHtpDevice_Infrastructure_t *gs_htpInfra(nullptr);
 static bool sg_perf_global = false;
 
-std::unordered_map<std::string, std::unique_ptr<sample_app::QnnSampleApp>> sg_model_map;
+// A model loaded in this process. Its mutex serializes the calls into 'app', which owns one set of input and
+// output tensors: executions, binary updates and the teardown. 'app' is reset once the model is destroyed.
+struct ModelEntry {
+    std::mutex mutex;
+    std::unique_ptr<sample_app::QnnSampleApp> app;
+    std::vector<TensorInfo> inputs;     // Set before the model is published.
+    std::vector<TensorInfo> outputs;
+};
+static std::unordered_map<std::string, std::shared_ptr<ModelEntry>> sg_model_map;
+static std::shared_timed_mutex sg_model_map_mutex;
+// Loading and destroying models go through the backend handle and interface shared by all models, one at a time.
+static std::mutex sg_model_load_mutex;
+
+// Micro-batching schedulers, keyed by model name. Only present for models with batching enabled.
+static std::unordered_map<std::string, std::shared_ptr<batchscheduler::BatchScheduler>> sg_batch_map;
+static std::mutex sg_batch_map_mutex;
 static sample_app::ProfilingLevel sg_parsedProfilingLevel = sample_app::ProfilingLevel::OFF;
 
+// Context binary cache for models loaded from a model library. Disabled while the directory is empty.
+static std::string sg_context_cache_dir;
+static uint64_t sg_context_cache_max_size = 0;
+static std::mutex sg_context_cache_mutex;
+
+static uint32_t sg_warmup_count = 0;
+static bool sg_warmup_random_inputs = false;
+
+static std::atomic<bool> sg_log_inference_time{false};
+
+// Per model statistics. Everything updated per request is atomic, the map lock is only held
+// for the lookup.
+struct ModelMetrics {
+    double initializeMs = 0;   // Set before the model is published.
+    uint32_t warmupRuns = 0;
+    std::atomic<uint64_t> executions{0};
+    std::atomic<uint64_t> coldLatencyUs{0};
+    std::atomic<uint64_t> warmLatencySumUs{0};
+    std::shared_ptr<latency::StageHistograms> histograms = std::make_shared<latency::StageHistograms>();
+};
+static std::unordered_map<std::string, std::shared_ptr<ModelMetrics>> sg_metrics_map;
+static std::shared_timed_mutex sg_metrics_map_mutex;
+
+// Profiling records of the models loaded with profiling enabled. Held here as well as by the
+// model, so statistics can be read while the model is executing.
+static std::unordered_map<std::string, std::shared_ptr<profiling::ProfilingRecorder>> sg_profiling_map;
+static std::mutex sg_profiling_map_mutex;
+
+// Threads of ModelInferenceAsync(), started by its first call.
+static std::shared_ptr<workerpool::WorkerPool> sg_async_pool;
+static uint32_t sg_async_workers = 0;
+static std::mutex sg_async_pool_mutex;
+
 namespace qnn {
 namespace tools {
 namespace libappbuilder {
@@ -111,30 +177,156 @@ std::unique_ptr<sample_app::QnnSampleApp> initQnnSampleApp(std::string cachedBin
 }  // namespace qnn
 
 
-std::unique_ptr<sample_app::QnnSampleApp> getQnnSampleApp(std::string model_name) {
+std::shared_ptr<ModelEntry> getModelEntry(const std::string& model_name) {
+  std::shared_lock<std::shared_timed_mutex> lock(sg_model_map_mutex);
   auto it = sg_model_map.find(model_name);
   if (it != sg_model_map.end()) {
-    if (it->second) {
-      auto app = std::move(it->second);
-      sg_model_map.erase(it);
-      return app;
+    return it->second;
+  }
+  return nullptr;
+}
+
+static TensorInfo toTensorInfo(const Qnn_Tensor_t* tensor) {
+  TensorInfo info;
+  info.name     = QNN_TENSOR_GET_NAME(tensor) ? QNN_TENSOR_GET_NAME(tensor) : "";
+  info.dataType = datautil::getDataTypeName(QNN_TENSOR_GET_DATA_TYPE(tensor));
+  info.shape.assign(QNN_TENSOR_GET_DIMENSIONS(tensor), QNN_TENSOR_GET_DIMENSIONS(tensor) + QNN_TENSOR_GET_RANK(tensor));
+  size_t size = 0;
+  if (!info.shape.empty()) {
+    std::tie(std::ignore, size) = datautil::calculateLength(info.shape, QNN_TENSOR_GET_DATA_TYPE(tensor));
+  }
+  info.size = size;
+
+  Qnn_QuantizeParams_t quantParams = QNN_TENSOR_GET_QUANT_PARAMS(tensor);
+  if (QNN_DEFINITION_DEFINED == quantParams.encodingDefinition &&
+      QNN_QUANTIZATION_ENCODING_SCALE_OFFSET == quantParams.quantizationEncoding) {
+    info.quantized = true;
+    info.scale     = quantParams.scaleOffsetEncoding.scale;
+    info.offset    = quantParams.scaleOffsetEncoding.offset;
+  }
+  return info;
+}
+
+// Publish a loaded model. Returns false if 'model_name' is already loaded, 'app' is released then.
+bool putModelEntry(const std::string& model_name, std::unique_ptr<sample_app::QnnSampleApp> app) {
+  std::shared_ptr<ModelEntry> entry = std::make_shared<ModelEntry>();
+  std::vector<const Qnn_Tensor_t*> inputs, outputs;
+  if (sample_app::StatusCode::SUCCESS == app->getIOTensors(inputs, outputs)) {
+    for (const Qnn_Tensor_t* tensor : inputs) {
+      entry->inputs.push_back(toTensorInfo(tensor));
     }
+    for (const Qnn_Tensor_t* tensor : outputs) {
+      entry->outputs.push_back(toTensorInfo(tensor));
+    }
+  }
+  entry->app = std::move(app);
+  std::unique_lock<std::shared_timed_mutex> lock(sg_model_map_mutex);
+  return sg_model_map.insert(std::make_pair(model_name, std::move(entry))).second;
+}
+
+// Unpublish a model, the caller locks the entry to wait for the calls already running on it.
+std::shared_ptr<ModelEntry> takeModelEntry(const std::string& model_name) {
+  std::unique_lock<std::shared_timed_mutex> lock(sg_model_map_mutex);
+  auto it = sg_model_map.find(model_name);
+  if (it == sg_model_map.end()) {
+    return nullptr;
+  }
+  std::shared_ptr<ModelEntry> entry = std::move(it->second);
+  sg_model_map.erase(it);
+  return entry;
+}
+
+std::shared_ptr<batchscheduler::BatchScheduler> getBatchScheduler(const std::string& model_name) {
+  std::lock_guard<std::mutex> lock(sg_batch_map_mutex);
+  auto it = sg_batch_map.find(model_name);
+  if (it != sg_batch_map.end()) {
+    return it->second;
   }
   return nullptr;
 }
 
+std::shared_ptr<workerpool::WorkerPool> getAsyncPool() {
+  std::lock_guard<std::mutex> lock(sg_async_pool_mutex);
+  if (!sg_async_pool) {
+    size_t threadCount = sg_async_workers;
+    if (0 == threadCount) {
+      threadCount = std::max<size_t>(4, std::thread::hardware_concurrency());
+    }
+    sg_async_pool = std::make_shared<workerpool::WorkerPool>("async", threadCount);
+  }
+  return sg_async_pool;
+}
+
+std::shared_ptr<ModelMetrics> getModelMetrics(const std::string& model_name) {
+    std::shared_lock<std::shared_timed_mutex> lock(sg_metrics_map_mutex);
+    auto it = sg_metrics_map.find(model_name);
+    if (it != sg_metrics_map.end()) {
+        return it->second;
+    }
+    return nullptr;
+}
+
+// Accounts one execution of 'latency_us' to the model: the first one is the cold latency, the
+// following ones make up the warm mean.
+void recordExecution(ModelMetrics& metrics, uint64_t latency_us) {
+    if (0 == metrics.executions.fetch_add(1)) {
+        metrics.coldLatencyUs = latency_us;
+    } else {
+        metrics.warmLatencySumUs += latency_us;
+    }
+}
+
+static LatencyStats toLatencyStats(const latency::LatencyHistogram& histogram) {
+    latency::LatencySnapshot snapshot = histogram.snapshot();
+    LatencyStats stats;
+    stats.count  = snapshot.count;
+    stats.meanUs = snapshot.meanUs;
+    stats.minUs  = snapshot.minUs;
+    stats.p50Us  = snapshot.p50Us;
+    stats.p90Us  = snapshot.p90Us;
+    stats.p99Us  = snapshot.p99Us;
+    stats.p999Us = snapshot.p999Us;
+    stats.maxUs  = snapshot.maxUs;
+    return stats;
+}
+
+static ModelStats toModelStats(const ModelMetrics& metrics) {
+    ModelStats stats;
+    stats.initializeMs     = metrics.initializeMs;
+    stats.warmupRuns       = metrics.warmupRuns;
+    stats.executions       = metrics.executions;
+    stats.coldLatencyMs    = metrics.coldLatencyUs / 1000.0;
+    stats.warm             = stats.executions > 1;
+    stats.warmLatencyMs    = stats.warm ? metrics.warmLatencySumUs / 1000.0 / (stats.executions - 1) : 0;
+    stats.total            = toLatencyStats(metrics.histograms->total);
+    stats.inputConversion  = toLatencyStats(metrics.histograms->inputConversion);
+    stats.execute          = toLatencyStats(metrics.histograms->execute);
+    stats.outputConversion = toLatencyStats(metrics.histograms->outputConversion);
+    return stats;
+}
+
+void removeBatchScheduler(const std::string& model_name) {
+  std::shared_ptr<batchscheduler::BatchScheduler> scheduler;
+  {
+    std::lock_guard<std::mutex> lock(sg_batch_map_mutex);
+    auto it = sg_batch_map.find(model_name);
+    if (it == sg_batch_map.end()) {
+      return;
+    }
+    scheduler = std::move(it->second);
+    sg_batch_map.erase(it);
+  }
+  scheduler->stop();   // Flush the queued requests before the model goes away.
+}
+
 void SetProcInfo(std::string proc_name, uint64_t epoch) {
     setEpoch(epoch);
-#ifdef _WIN32
     g_ProcName = proc_name;
-#endif
 }
 
 bool SetProfilingLevel(int32_t profiling_level) {
     sg_parsedProfilingLevel = (sample_app::ProfilingLevel)profiling_level;
-#ifdef _WIN32
     g_profilingLevel = profiling_level;
-#endif
     return true;
 }
 
@@ -160,13 +352,68 @@ bool SetLogLevel(int32_t log_level, const std::string log_path) {
     return false;
   }
 
-#ifdef _WIN32
   g_logEpoch = getEpoch();
   g_logLevel = log_level;
-#endif
   return true;
 }
 
+bool SetContextCacheDir(const std::string& cache_dir, uint64_t max_cache_size) {
+    std::lock_guard<std::mutex> lock(sg_context_cache_mutex);
+    if (!cache_dir.empty() && cache_dir != "None" && !pal::Directory::makePath(cache_dir)) {
+        QNN_ERR("SetContextCacheDir::failed to create cache directory %s\n", cache_dir.c_str());
+        return false;
+    }
+    sg_context_cache_dir = (cache_dir == "None") ? "" : cache_dir;
+    sg_context_cache_max_size = max_cache_size;
+    return true;
+}
+
+void SetTraceEnabled(bool enable) {
+    trace::setEnabled(enable);
+}
+
+bool DumpTrace(const std::string& trace_path, bool clear) {
+    bool result = trace::dump(trace_path);
+    if (clear) {
+        trace::clear();
+    }
+    return result;
+}
+
+void SetLogInferenceTime(bool enable) {
+    sg_log_inference_time = enable;
+}
+
+void SetLogAsync(bool enable) {
+    log::async::setEnabled(enable);
+}
+
+uint64_t GetLogDroppedCount() {
+    return log::async::getDroppedCount();
+}
+
+void SetAsyncWorkers(uint32_t count) {
+    std::shared_ptr<workerpool::WorkerPool> pool;
+    {
+        std::lock_guard<std::mutex> lock(sg_async_pool_mutex);
+        sg_async_workers = count;
+        pool.swap(sg_async_pool);
+    }
+    if (pool) {
+        pool->stop();
+    }
+}
+
+void SetModelWarmup(uint32_t count, bool random_inputs) {
+    sg_warmup_count = count;
+    sg_warmup_random_inputs = random_inputs;
+}
+
+void SetSvcDoorbell(bool enable, uint32_t spin_us) {
+    g_svcDoorbell = enable;
+    g_svcSpinUs = spin_us;
+}
+
 bool SetPerfProfileGlobal(const std::string& perf_profile) {
     if (nullptr == sg_backendHandle) {
         QNN_ERR("SetPerfProfileGlobal::initialize one model before set perf profile!\n");
@@ -205,12 +452,11 @@ bool RelPerfProfileGlobal() {
 }
 
 void QNN_ERR(const char* fmt, ...) {
-    QnnLog_Callback_t logCallback = getLogCallback();
-    if (!logCallback) {return;}
-
-    if (QNN_LOG_LEVEL_ERROR > getLogLevel()) {
+    if (!isLevelEnabled(QNN_LOG_LEVEL_ERROR)) {
         return;
     }
+    QnnLog_Callback_t logCallback = getLogCallback();
+    if (!logCallback) {return;}
     va_list argp;
     va_start(argp, fmt);
     (*logCallback)(fmt, QNN_LOG_LEVEL_ERROR, getTimediff(), argp);
@@ -218,12 +464,11 @@ void QNN_ERR(const char* fmt, ...) {
 }
 
 void QNN_WAR(const char* fmt, ...) {
-    QnnLog_Callback_t logCallback = getLogCallback();
-    if (!logCallback) {return;}
-
-    if (QNN_LOG_LEVEL_WARN > getLogLevel()) {
+    if (!isLevelEnabled(QNN_LOG_LEVEL_WARN)) {
         return;
     }
+    QnnLog_Callback_t logCallback = getLogCallback();
+    if (!logCallback) {return;}
     va_list argp;
     va_start(argp, fmt);
     (*logCallback)(fmt, QNN_LOG_LEVEL_WARN, getTimediff(), argp);
@@ -231,12 +476,11 @@ void QNN_WAR(const char* fmt, ...) {
 }
 
 void QNN_INF(const char* fmt, ...) {
-    QnnLog_Callback_t logCallback = getLogCallback();
-    if (!logCallback) {return;}
-
-    if (QNN_LOG_LEVEL_INFO > getLogLevel()) {
+    if (!isLevelEnabled(QNN_LOG_LEVEL_INFO)) {
         return;
     }
+    QnnLog_Callback_t logCallback = getLogCallback();
+    if (!logCallback) {return;}
 
     va_list argp;
     va_start(argp, fmt);
@@ -245,12 +489,11 @@ void QNN_INF(const char* fmt, ...) {
 }
 
 void QNN_VEB(const char* fmt, ...) {
-    QnnLog_Callback_t logCallback = getLogCallback();
-    if (!logCallback) {return;}
-
-    if (QNN_LOG_LEVEL_VERBOSE > getLogLevel()) {
+    if (!isLevelEnabled(QNN_LOG_LEVEL_VERBOSE)) {
         return;
     }
+    QnnLog_Callback_t logCallback = getLogCallback();
+    if (!logCallback) {return;}
     va_list argp;
     va_start(argp, fmt);
     (*logCallback)(fmt, QNN_LOG_LEVEL_DEBUG, getTimediff(), argp);
@@ -258,12 +501,11 @@ void QNN_VEB(const char* fmt, ...) {
 }
 
 void QNN_DBG(const char* fmt, ...) {
-    QnnLog_Callback_t logCallback = getLogCallback();
-    if (!logCallback) {return;}
-
-    if (QNN_LOG_LEVEL_DEBUG > getLogLevel()) {
+    if (!isLevelEnabled(QNN_LOG_LEVEL_DEBUG)) {
         return;
     }
+    QnnLog_Callback_t logCallback = getLogCallback();
+    if (!logCallback) {return;}
     va_list argp;
     va_start(argp, fmt);
     (*logCallback)(fmt, QNN_LOG_LEVEL_DEBUG, getTimediff(), argp);
@@ -271,19 +513,11 @@ void QNN_DBG(const char* fmt, ...) {
 }
 
 bool CreateShareMemory(std::string share_memory_name, size_t share_memory_size) {
-#ifdef _WIN32
     return CreateShareMem(share_memory_name, share_memory_size);
-#else
-    return true;
-#endif
 }
 
 bool DeleteShareMemory(std::string share_memory_name) {
-#ifdef _WIN32
     return DeleteShareMem(share_memory_name);
-#else
-    return true;
-#endif
 }
 
 bool ModelInitializeEx(const std::string& model_name, const std::string& proc_name, const std::string& model_path,
@@ -294,15 +528,16 @@ bool ModelInitializeEx(const std::string& model_name, const std::string& proc_na
 
   QNN_INF("LibAppBuilder::ModelInitialize: %s \n", model_name.c_str());
 
-#ifdef _WIN32
   if(!proc_name.empty()) {
     // If proc_name, create process and save process info & model name to map, load model in new process.
-    result = TalkToSvc_Initialize(model_name, proc_name, model_path, backend_lib_path, system_lib_path, async);
+    TRACE_SCOPE("TalkToSvc_Initialize", model_name);
+    result = TalkToSvc_Initialize(model_name, proc_name, model_path, backend_lib_path, system_lib_path, lora_adapters, async);
     return result;
   }
-#endif
 
+  TRACE_SCOPE("ModelInitialize", model_name);
   TimerHelper timerHelper;
+  std::lock_guard<std::mutex> loadLock(sg_model_load_mutex);
 
   bool loadFromCachedBinary{ true };
   std::string cachedBinaryPath = model_path;
@@ -335,6 +570,32 @@ bool ModelInitializeEx(const std::string& model_name, const std::string& proc_na
     QNN_INFO("LibAppBuilder   build version: %s", qnn::tools::getBuildId().c_str());
     QNN_INFO("Backend        build version: %s", app->getBackendBuildId().c_str());
 
+    // Look the model library up in the context cache: on a hit, load the serialized context
+    // instead of composing and finalizing the graphs again.
+    std::string cacheDir;
+    uint64_t cacheMaxSize = 0;
+    {
+        std::lock_guard<std::mutex> lock(sg_context_cache_mutex);
+        cacheDir = sg_context_cache_dir;
+        cacheMaxSize = sg_context_cache_max_size;
+    }
+    std::string cacheKey;
+    if (!loadFromCachedBinary && !cacheDir.empty()) {
+        TRACE_SCOPE("contextCacheLookup");
+        std::vector<std::string> cacheDependencies = {backEndPath};
+        std::string cacheConfig = "appbuilder=" + qnn::tools::getBuildId() +
+                                  ";profiling=" + std::to_string((int)sg_parsedProfilingLevel) +
+                                  app->getContextCacheConfig(cacheDependencies);
+        cacheKey = contextcache::computeKey(cachedBinaryPath, app->getBackendBuildId(), cacheConfig, cacheDependencies);
+        std::string cachedBinary;
+        if (!cacheKey.empty() && contextcache::lookup(cacheDir, cacheKey, cachedBinary) &&
+            sample_app::StatusCode::SUCCESS == app->setCachedBinary(cachedBinary, systemLibraryPath)) {
+            QNN_INF("LibAppBuilder::ModelInitialize: %s loaded from context cache %s\n", model_name.c_str(), cachedBinary.c_str());
+            loadFromCachedBinary = true;
+        }
+    }
+    bool fromContextCache = loadFromCachedBinary && !cacheKey.empty();
+
     app->initializeLog();
 
     if (sample_app::StatusCode::SUCCESS != app->initializeBackend()) {
@@ -374,8 +635,20 @@ bool ModelInitializeEx(const std::string& model_name, const std::string& proc_na
         app->reportError("Graph Finalize failure");
         return false;
       }
+      if (!cacheKey.empty()) {
+        std::string tempName = contextcache::getTempName(cacheKey);
+        if (sample_app::StatusCode::SUCCESS == app->saveBinary(cacheDir, tempName)) {
+          contextcache::commit(cacheDir, cacheKey, cacheDir + pal::Path::getSeparator() + tempName + ".bin", cacheMaxSize);
+        } else {
+          QNN_WAR("LibAppBuilder::ModelInitialize: unable to save %s to the context cache\n", model_name.c_str());
+        }
+      }
     } else {
       if (sample_app::StatusCode::SUCCESS != app->createFromBinary()) {
+        if (fromContextCache) {
+          // Drop the entry so the next load rebuilds it from the model library.
+          contextcache::evict(cacheDir, cacheKey);
+        }
         app->reportError("Create From Binary failure");
         return false;
       }
@@ -400,9 +673,38 @@ bool ModelInitializeEx(const std::string& model_name, const std::string& proc_na
         return app->reportError("Binary update/execution failure");
     }
 
+    std::shared_ptr<ModelMetrics> metrics = std::make_shared<ModelMetrics>();
+    app->setStageHistograms(metrics->histograms);
+
+    if (app->getProfilingRecorder()) {
+        std::lock_guard<std::mutex> lock(sg_profiling_map_mutex);
+        sg_profiling_map[model_name] = app->getProfilingRecorder();
+    }
+
+    // Warm up before the model becomes visible to ModelInference(), so no request hits the cold path.
+    if (sg_warmup_count > 0) {
+        std::vector<double> latencyMs;
+        if (sample_app::StatusCode::SUCCESS != app->warmup(sg_warmup_count, sg_warmup_random_inputs, latencyMs)) {
+            QNN_WAR("LibAppBuilder::ModelInitialize: warmup of %s failed\n", model_name.c_str());
+        }
+        for (double latency : latencyMs) {
+            recordExecution(*metrics, (uint64_t)(latency * 1000));
+        }
+        metrics->warmupRuns = (uint32_t)latencyMs.size();
+    }
+
+    metrics->initializeMs = timerHelper.ElapsedMs();
+    {
+        std::unique_lock<std::shared_timed_mutex> lock(sg_metrics_map_mutex);
+        sg_metrics_map[model_name] = metrics;
+    }
+
     timerHelper.Print("model_initialize " + model_name);
 
-    sg_model_map.insert(std::make_pair(model_name, std::move(app)));
+    if (!putModelEntry(model_name, std::move(app))) {
+        QNN_ERR("LibAppBuilder::ModelInitialize: model %s is already loaded.\n", model_name.c_str());
+        return false;
+    }
 
     return true;
   }
@@ -410,39 +712,93 @@ bool ModelInitializeEx(const std::string& model_name, const std::string& proc_na
   return false;
 }
 
+// Run the model in this process. Called directly or from the micro-batching scheduler thread.
+bool ModelExecute(const std::string& model_name, std::vector<uint8_t*>& inputBuffers,
+                  std::vector<uint8_t*>& outputBuffers, std::vector<size_t>& outputSize,
+                  std::string& perfProfile, const std::vector<std::string>& inputDataTypes = std::vector<std::string>(),
+                  bool nativeOutputs = false, bool callerOutputs = false) {
+    TRACE_SCOPE("ModelExecute", model_name);
+    std::shared_ptr<ModelEntry> entry = getModelEntry(model_name);
+    if (nullptr == entry) {
+        QNN_ERR("Inference failure, can't find the model with model_name: %s\n", model_name.c_str());
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    sample_app::QnnSampleApp* app = entry->app.get();
+    if (nullptr == app) {       // Destroyed while this call waited.
+        QNN_ERR("Inference failure, can't find the model with model_name: %s\n", model_name.c_str());
+        return false;
+    }
+
+    bool result = true;
+    auto start = std::chrono::steady_clock::now();
+    if (sample_app::StatusCode::SUCCESS != app->executeGraphsBuffers(inputBuffers, outputBuffers, outputSize, perfProfile, inputDataTypes,
+                                                                          nativeOutputs, callerOutputs)) {
+        app->reportError("Graph Execution failure");
+        result = false;
+    }
+    else if (std::shared_ptr<ModelMetrics> metrics = getModelMetrics(model_name)) {
+        recordExecution(*metrics, (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    return result;
+}
+
 bool ModelInferenceEx(std::string model_name, std::string proc_name, std::string share_memory_name,
                       std::vector<uint8_t*>& inputBuffers, std::vector<size_t>& inputSize,
                       std::vector<uint8_t*>& outputBuffers, std::vector<size_t>& outputSize,
-                      std::string& perfProfile) {
+                      std::string& perfProfile, const std::vector<std::string>& inputDataTypes = std::vector<std::string>(),
+                      bool nativeOutputs = false, bool callerOutputs = false) {
     bool result = true;
 
     //QNN_INF("LibAppBuilder::ModelInference: %s \n", model_name.c_str());
 
-#ifdef _WIN32
     if (!proc_name.empty()) {
         // If proc_name, run the model in that process.
-        result = TalkToSvc_Inference(model_name, proc_name, share_memory_name, inputBuffers, inputSize, outputBuffers, outputSize, perfProfile);
+        TRACE_SCOPE("TalkToSvc_Inference", model_name);
+        result = TalkToSvc_Inference(model_name, proc_name, share_memory_name, inputBuffers, inputSize, outputBuffers, outputSize, perfProfile,
+                                     inputDataTypes, nativeOutputs, callerOutputs);
         return result;
     }
-#endif
 
     TimerHelper timerHelper;
 
-    std::unique_ptr<sample_app::QnnSampleApp> app = getQnnSampleApp(model_name);
-
-    if (result && nullptr == app) {
-        app->reportError("Inference failure");
-        result = false;
+    std::shared_ptr<batchscheduler::BatchScheduler> scheduler = getBatchScheduler(model_name);
+    if (scheduler && callerOutputs) {
+        // The slices of the batch outputs go into the buffers of the caller.
+        std::vector<uint8_t*> itemBuffers;
+        std::vector<size_t> itemSize;
+        result = scheduler->submit(inputBuffers, itemBuffers, itemSize, perfProfile, inputDataTypes, nativeOutputs);
+        for (size_t i = 0; i < itemBuffers.size(); i++) {
+            if (result && (i >= outputBuffers.size() || i >= outputSize.size() || outputSize[i] < itemSize[i])) {
+                QNN_ERR("Inference failure, output buffer %zu of %s is missing or smaller than %zu bytes.\n",
+                        i, model_name.c_str(), itemSize[i]);
+                result = false;
+            }
+            if (result) {
+                memcpy(outputBuffers[i], itemBuffers[i], itemSize[i]);
+                outputSize[i] = itemSize[i];
+            }
+            free(itemBuffers[i]);
+        }
     }
-
-    if (result && sample_app::StatusCode::SUCCESS != app->executeGraphsBuffers(inputBuffers, outputBuffers, outputSize, perfProfile)) {
-        app->reportError("Graph Execution failure");
-        result = false;
+    else if (scheduler) {
+        result = scheduler->submit(inputBuffers, outputBuffers, outputSize, perfProfile, inputDataTypes, nativeOutputs);
+    }
+    else {
+        result = ModelExecute(model_name, inputBuffers, outputBuffers, outputSize, perfProfile, inputDataTypes,
+                              nativeOutputs, callerOutputs);
     }
 
-    sg_model_map.insert(std::make_pair(model_name, std::move(app)));
+    if (result) {
+        if (std::shared_ptr<ModelMetrics> metrics = getModelMetrics(model_name)) {
+            metrics->histograms->total.record((uint64_t)(timerHelper.ElapsedMs() * 1000));
+        }
+    }
 
-    timerHelper.Print("model_inference " + model_name);
+    if (sg_log_inference_time) {
+        timerHelper.Print("model_inference " + model_name);
+    }
 
     return result;
 }
@@ -452,21 +808,34 @@ bool ModelDestroyEx(std::string model_name, std::string proc_name) {
 
     QNN_INF("LibAppBuilder::ModelDestroy: %s \n", model_name.c_str());
 
-#ifdef _WIN32
     if (!proc_name.empty()) {
         // If proc_name, desctroy the model in that process.
+        TRACE_SCOPE("TalkToSvc_Destroy", model_name);
         result = TalkToSvc_Destroy(model_name, proc_name);
         return result;
     }
-#endif
 
     TimerHelper timerHelper;
+    std::lock_guard<std::mutex> loadLock(sg_model_load_mutex);
 
-    std::unique_ptr<sample_app::QnnSampleApp> app = getQnnSampleApp(model_name);
-    if (nullptr == app) {
-        app->reportError("Can't find the model with model_name: " + model_name);
+    removeBatchScheduler(model_name);
+
+    {
+        std::unique_lock<std::shared_timed_mutex> lock(sg_metrics_map_mutex);
+        sg_metrics_map.erase(model_name);
+    }
+    {
+        std::lock_guard<std::mutex> lock(sg_profiling_map_mutex);
+        sg_profiling_map.erase(model_name);
+    }
+
+    std::shared_ptr<ModelEntry> entry = takeModelEntry(model_name);
+    if (nullptr == entry) {
+        QNN_ERR("Can't find the model with model_name: %s\n", model_name.c_str());
         return false;
     }
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    std::unique_ptr<sample_app::QnnSampleApp> app = std::move(entry->app);
 
     // improve performance.
     if (sample_app::StatusCode::SUCCESS != app->tearDownInputAndOutputTensors()) {
@@ -503,6 +872,66 @@ bool ModelDestroyEx(std::string model_name, std::string proc_name) {
     return true;
 }
 
+bool ModelSetBatchingEx(const std::string& model_name, size_t max_batch_size, uint32_t max_wait_us) {
+    QNN_INF("LibAppBuilder::ModelSetBatching: %s, max batch %zu, max wait %u us\n", model_name.c_str(), max_batch_size, max_wait_us);
+
+    removeBatchScheduler(model_name);
+
+    if (max_batch_size <= 1) {  // Batching disabled, requests run one by one.
+        return true;
+    }
+
+    std::shared_ptr<ModelEntry> entry = getModelEntry(model_name);
+    if (nullptr == entry) {
+        QNN_ERR("Can't find the model with model_name: %s\n", model_name.c_str());
+        return false;
+    }
+
+    // The leading dimension of every input is the batch, items are packed in their own element size.
+    std::vector<batchscheduler::BatchInput> inputs;
+    size_t modelBatchSize = 0;
+    for (const TensorInfo& info : entry->inputs) {
+        size_t elements = 1;
+        for (size_t dim : info.shape) {
+            elements *= dim;
+        }
+        if (info.shape.empty() || 0 == elements || (modelBatchSize && modelBatchSize != info.shape[0])) {
+            QNN_ERR("Failed to get the batch dimension of model: %s\n", model_name.c_str());
+            return false;
+        }
+        modelBatchSize = info.shape[0];
+
+        batchscheduler::BatchInput input;
+        input.dataType     = info.dataType;
+        input.itemElements = elements / modelBatchSize;
+        input.elementSize  = info.size / elements;
+        inputs.push_back(input);
+    }
+    if (modelBatchSize <= 1) {
+        QNN_ERR("Model %s has no batch dimension to fill, batching not enabled.\n", model_name.c_str());
+        return false;
+    }
+
+    batchscheduler::BatchConfig config;
+    config.modelBatchSize = modelBatchSize;
+    config.maxBatchSize   = max_batch_size;
+    config.maxWaitUs      = max_wait_us;
+
+    auto scheduler = std::make_shared<batchscheduler::BatchScheduler>(
+        model_name, config, inputs,
+        [model_name](std::vector<uint8_t*>& inputBuffers, std::vector<uint8_t*>& outputBuffers,
+                     std::vector<size_t>& outputSize, std::string& perfProfile,
+                     const std::vector<std::string>& inputDataTypes, bool nativeOutputs) {
+            return ModelExecute(model_name, inputBuffers, outputBuffers, outputSize, perfProfile, inputDataTypes,
+                                nativeOutputs);
+        });
+
+    std::lock_guard<std::mutex> lock(sg_batch_map_mutex);
+    sg_batch_map[model_name] = scheduler;
+
+    return true;
+}
+
 
 /////////////////////////////////////////////////////////////////////////////
 /// Class LibAppBuilder implementation.
@@ -511,11 +940,18 @@ bool ModelDestroyEx(std::string model_name, std::string proc_name) {
 bool LibAppBuilder::ModelInitialize(const std::string& model_name, const std::string& proc_name, const std::string& model_path,
                                     const std::string& backend_lib_path, const std::string& system_lib_path,
                                     bool async) {
-#ifdef _WIN32
+    std::vector<LoraAdapter> Adapters = std::vector<LoraAdapter>();
+    return ModelInitialize(model_name, proc_name, model_path, backend_lib_path, system_lib_path, Adapters, async);
+}
+
+bool LibAppBuilder::ModelInitialize(const std::string& model_name, const std::string& proc_name, const std::string& model_path,
+                                    const std::string& backend_lib_path, const std::string& system_lib_path,
+                                    std::vector<LoraAdapter>& lora_adapters,
+                                    bool async) {
     if (!proc_name.empty()) {   // Create process and save process info & model name to map, load model in new process.
-        return TalkToSvc_Initialize(model_name, proc_name, model_path, backend_lib_path, system_lib_path, async);
+        TRACE_SCOPE("TalkToSvc_Initialize", model_name);
+        return TalkToSvc_Initialize(model_name, proc_name, model_path, backend_lib_path, system_lib_path, lora_adapters, async);
     }
-#endif
     return false;
 }
 
@@ -537,11 +973,39 @@ bool LibAppBuilder::ModelInference(std::string model_name, std::string proc_name
                                         std::vector<uint8_t*>& inputBuffers, std::vector<size_t>& inputSize,
                                         std::vector<uint8_t*>& outputBuffers, std::vector<size_t>& outputSize,
                                         std::string& perfProfile) {
-#ifdef _WIN32
+    return ModelInference(model_name, proc_name, share_memory_name, inputBuffers, inputSize, std::vector<std::string>(), outputBuffers,
+                          outputSize, perfProfile);
+}
+
+bool LibAppBuilder::ModelInference(std::string model_name, std::string proc_name, std::string share_memory_name,
+                                   std::vector<uint8_t*>& inputBuffers, std::vector<size_t>& inputSize,
+                                   const std::vector<std::string>& inputDataTypes,
+                                   std::vector<uint8_t*>& outputBuffers, std::vector<size_t>& outputSize,
+                                   std::string& perfProfile, bool nativeOutputs, bool callerOutputs) {
     if (!proc_name.empty()) {   // If proc_name, run the model in that process.
-        return TalkToSvc_Inference(model_name, proc_name, share_memory_name, inputBuffers, inputSize, outputBuffers, outputSize, perfProfile);
+        TRACE_SCOPE("TalkToSvc_Inference", model_name);
+        return TalkToSvc_Inference(model_name, proc_name, share_memory_name, inputBuffers, inputSize, outputBuffers, outputSize, perfProfile,
+                                   inputDataTypes, nativeOutputs, callerOutputs);
     }
-#endif
+    return false;
+}
+
+bool LibAppBuilder::ModelInferenceAsync(std::shared_ptr<InferenceRequest> request, InferenceCallback callback) {
+    auto task = [request, callback] {
+        InferenceRequest& r = *request;
+        r.result = ModelInferenceEx(r.modelName, r.procName, r.shareMemoryName, r.inputBuffers, r.inputSize,
+                                    r.outputBuffers, r.outputSize, r.perfProfile, r.inputDataTypes,
+                                    r.nativeOutputs, r.callerOutputs);
+        callback(request);
+    };
+
+    // A pool stopped by SetAsyncWorkers() meanwhile refuses the task, the next one takes it.
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (getAsyncPool()->post(task)) {
+            return true;
+        }
+    }
+    QNN_ERR("Inference failure, can't queue the inference of %s.\n", request->modelName.c_str());
     return false;
 }
 
@@ -552,12 +1016,26 @@ bool LibAppBuilder::ModelInference(std::string model_name, std::vector<uint8_t*>
     return ModelInferenceEx(model_name, "", "", inputBuffers, inputSize, outputBuffers, outputSize, perfProfile);
 }
 
+bool LibAppBuilder::ModelInference(std::string model_name, std::vector<uint8_t*>& inputBuffers, const std::vector<std::string>& inputDataTypes,
+                                   std::vector<uint8_t*>& outputBuffers, std::vector<size_t>& outputSize,
+                                   std::string& perfProfile, bool nativeOutputs, bool callerOutputs) {
+    std::vector<size_t> inputSize;
+    return ModelInferenceEx(model_name, "", "", inputBuffers, inputSize, outputBuffers, outputSize, perfProfile, inputDataTypes,
+                            nativeOutputs, callerOutputs);
+}
+
 bool LibAppBuilder::ModelApplyBinaryUpdate(const std::string model_name, std::vector<LoraAdapter>& lora_adapters) {
     
     bool result = true;
-    std::unique_ptr<sample_app::QnnSampleApp> app = getQnnSampleApp(model_name);
+    std::shared_ptr<ModelEntry> entry = getModelEntry(model_name);
+    std::unique_lock<std::mutex> lock;
+    sample_app::QnnSampleApp* app = nullptr;
+    if (entry) {
+        lock = std::unique_lock<std::mutex>(entry->mutex);
+        app = entry->app.get();
+    }
     if (nullptr == app) {
-        app->reportError("Apply binary update failure: " + model_name);
+        QNN_ERR("Apply binary update failure: %s\n", model_name.c_str());
         result = false;
     }
     
@@ -573,17 +1051,23 @@ bool LibAppBuilder::ModelApplyBinaryUpdate(const std::string model_name, std::ve
     
     }
 
-    sg_model_map.insert(std::make_pair(model_name, std::move(app)));
-
     return result;
 }
 
+bool LibAppBuilder::ModelSetBatching(const std::string& model_name, size_t max_batch_size, uint32_t max_wait_us) {
+    return ModelSetBatchingEx(model_name, max_batch_size, max_wait_us);
+}
+
+bool LibAppBuilder::ModelSetReplicas(const std::string& model_name, uint32_t replicas) {
+    TRACE_SCOPE("TalkToSvc_SetReplicas", model_name);
+    return TalkToSvc_SetReplicas(model_name, replicas);
+}
+
 bool LibAppBuilder::ModelDestroy(std::string model_name, std::string proc_name) {
-#ifdef _WIN32
     if (!proc_name.empty()) {   // If proc_name, desctroy the model in that process.
+        TRACE_SCOPE("TalkToSvc_Destroy", model_name);
         return TalkToSvc_Destroy(model_name, proc_name);
     }
-#endif
     return false;
 }
 
@@ -591,21 +1075,186 @@ bool LibAppBuilder::ModelDestroy(std::string model_name) {
     return ModelDestroyEx(model_name, "");
 }
 
+bool LibAppBuilder::ModelGetInfo(const std::string& model_name, std::vector<TensorInfo>& inputs, std::vector<TensorInfo>& outputs) {
+    std::shared_ptr<ModelEntry> entry = getModelEntry(model_name);
+    if (nullptr == entry) {
+        return false;
+    }
+    inputs = entry->inputs;
+    outputs = entry->outputs;
+    return true;
+}
+
+bool LibAppBuilder::ModelGetInfo(const std::string& model_name, const std::string& proc_name, std::vector<TensorInfo>& inputs,
+                                 std::vector<TensorInfo>& outputs) {
+    if (proc_name.empty()) {
+        return ModelGetInfo(model_name, inputs, outputs);
+    }
+    return TalkToSvc_GetInfo(model_name, proc_name, inputs, outputs);
+}
+
+bool LibAppBuilder::GetModelInfo(const std::string& model_name, std::vector<TensorInfo>& inputs, std::vector<TensorInfo>& outputs) {
+    return ModelGetInfo(model_name, inputs, outputs);
+}
+
+bool LibAppBuilder::ModelGetStats(const std::string& model_name, ModelStats& stats) {
+    std::shared_ptr<ModelMetrics> metrics = getModelMetrics(model_name);
+    if (!metrics) {
+        return false;
+    }
+    stats = toModelStats(*metrics);
+    return true;
+}
+
+bool LibAppBuilder::ModelResetStats(const std::string& model_name) {
+    std::shared_ptr<ModelMetrics> metrics = getModelMetrics(model_name);
+    if (!metrics) {
+        return false;
+    }
+    metrics->histograms->total.reset();
+    metrics->histograms->inputConversion.reset();
+    metrics->histograms->execute.reset();
+    metrics->histograms->outputConversion.reset();
+    return true;
+}
+
+static void dumpJsonString(std::ostringstream& out, const std::string& value) {
+    out << '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        }
+        else if ((unsigned char)c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)c);
+            out << escaped;
+        }
+        else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+static void dumpLatencyStats(std::ostringstream& out, const char* stage, const LatencyStats& stats, bool json) {
+    if (json) {
+        out << "\"" << stage << "\":{\"count\":" << stats.count << ",\"mean_us\":" << stats.meanUs
+            << ",\"min_us\":" << stats.minUs << ",\"p50_us\":" << stats.p50Us << ",\"p90_us\":" << stats.p90Us
+            << ",\"p99_us\":" << stats.p99Us << ",\"p999_us\":" << stats.p999Us << ",\"max_us\":" << stats.maxUs << "}";
+    }
+    else {
+        out << "  " << stage << ": count " << stats.count << ", mean " << stats.meanUs << " us, min " << stats.minUs
+            << ", p50 " << stats.p50Us << ", p90 " << stats.p90Us << ", p99 " << stats.p99Us << ", p99.9 " << stats.p999Us
+            << ", max " << stats.maxUs << " us\n";
+    }
+}
+
+std::string LibAppBuilder::ModelDumpStats(const std::string& model_name, bool json) {
+    std::vector<std::pair<std::string, std::shared_ptr<ModelMetrics>>> models;
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(sg_metrics_map_mutex);
+        for (auto& item : sg_metrics_map) {
+            if (model_name.empty() || model_name == item.first) {
+                models.emplace_back(item.first, item.second);
+            }
+        }
+    }
+
+    std::ostringstream out;
+    out << (json ? "{" : "");
+    for (size_t i = 0; i < models.size(); i++) {
+        ModelStats stats = toModelStats(*models[i].second);
+        if (json) {
+            out << (i ? "," : "");
+            dumpJsonString(out, models[i].first);
+            out << ":{\"initialize_ms\":" << stats.initializeMs
+                << ",\"warmup_runs\":" << stats.warmupRuns << ",\"cold_latency_ms\":" << stats.coldLatencyMs
+                << ",\"warm_latency_ms\":" << stats.warmLatencyMs << ",\"executions\":" << stats.executions
+                << ",\"warm\":" << (stats.warm ? "true" : "false") << ",";
+            dumpLatencyStats(out, "total", stats.total, json);
+            out << ",";
+            dumpLatencyStats(out, "input_conversion", stats.inputConversion, json);
+            out << ",";
+            dumpLatencyStats(out, "execute", stats.execute, json);
+            out << ",";
+            dumpLatencyStats(out, "output_conversion", stats.outputConversion, json);
+            out << "}";
+        }
+        else {
+            out << models[i].first << ": initialize " << stats.initializeMs << " ms, " << stats.warmupRuns
+                << " warmup runs, cold " << stats.coldLatencyMs << " ms, warm " << stats.warmLatencyMs << " ms, "
+                << stats.executions << " executions\n";
+            dumpLatencyStats(out, "total", stats.total, json);
+            dumpLatencyStats(out, "input_conversion", stats.inputConversion, json);
+            dumpLatencyStats(out, "execute", stats.execute, json);
+            dumpLatencyStats(out, "output_conversion", stats.outputConversion, json);
+        }
+    }
+    out << (json ? "}" : "");
+    return out.str();
+}
+
+std::shared_ptr<profiling::ProfilingRecorder> getProfilingRecorder(const std::string& model_name) {
+    std::lock_guard<std::mutex> lock(sg_profiling_map_mutex);
+    auto it = sg_profiling_map.find(model_name);
+    if (it == sg_profiling_map.end()) {
+        QNN_ERR("Profiling isn't enabled for model %s\n", model_name.c_str());
+        return nullptr;
+    }
+    return it->second;
+}
+
+bool LibAppBuilder::ModelGetProfilingStats(const std::string& model_name, std::vector<ProfilingEventStats>& stats) {
+    std::shared_ptr<profiling::ProfilingRecorder> recorder = getProfilingRecorder(model_name);
+    if (!recorder) {
+        return false;
+    }
+    stats.clear();
+    for (auto& event : recorder->getStats()) {
+        ProfilingEventStats item;
+        item.identifier = event.identifier;
+        item.graphIdx   = event.graphIdx;
+        item.type       = event.type;
+        item.unit       = event.unit;
+        item.count      = event.count;
+        item.min        = event.min;
+        item.max        = event.max;
+        item.mean       = event.mean;
+        item.p50        = event.p50;
+        item.p99        = event.p99;
+        stats.push_back(item);
+    }
+    return true;
+}
+
+bool LibAppBuilder::ModelResetProfilingStats(const std::string& model_name) {
+    std::shared_ptr<profiling::ProfilingRecorder> recorder = getProfilingRecorder(model_name);
+    if (!recorder) {
+        return false;
+    }
+    recorder->reset();
+    return true;
+}
+
 bool LibAppBuilder::CreateShareMemory(std::string share_memory_name, size_t share_memory_size) {
-#ifdef _WIN32
     return CreateShareMem(share_memory_name, share_memory_size);
-#else
-    return true;
-#endif 
 }
 
 bool LibAppBuilder::DeleteShareMemory(std::string share_memory_name) {
-#ifdef _WIN32
+    TalkToSvc_UnmapShareMem(share_memory_name);
     return DeleteShareMem(share_memory_name);
-#else
-        return true;
-#endif
+}
+
+uint8_t* LibAppBuilder::AllocateShareMemoryBuffer(size_t size) {
+    ArenaSlice_t slice;
+    if (!ArenaAllocate(GetShareMemArena(), size, slice)) {
+        return nullptr;
+    }
+    return slice.data;
+}
 
+bool LibAppBuilder::FreeShareMemoryBuffer(uint8_t* buffer) {
+    return ArenaFreeBuffer(GetShareMemArena(), buffer);
 }
 
 int main(int argc, char** argv) {
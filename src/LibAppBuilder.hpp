@@ -8,6 +8,7 @@
 #pragma once
 
 #include <iostream>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -43,6 +44,124 @@ extern "C" LIBAPPBUILDER_API bool SetProfilingLevel(int32_t profiling_level);
 extern "C" LIBAPPBUILDER_API bool SetPerfProfileGlobal(const std::string& perf_profile);
 extern "C" LIBAPPBUILDER_API bool RelPerfProfileGlobal();
 
+// Cache the context of models loaded from a model library (*.dll / *.so) in 'cache_dir': the first
+// ModelInitialize() finalizes and saves the context, later ones load the saved binary. Least recently
+// used entries are removed once the cache exceeds 'max_cache_size' bytes (0: no limit). An empty
+// 'cache_dir' disables the cache.
+extern "C" LIBAPPBUILDER_API bool SetContextCacheDir(const std::string& cache_dir, uint64_t max_cache_size = 0);
+
+// Run 'count' executions on zero inputs (random inputs if 'random_inputs') at the end of every following
+// ModelInitialize(), so the first real request doesn't pay for lazy backend initialization. 0 disables it.
+extern "C" LIBAPPBUILDER_API void SetModelWarmup(uint32_t count, bool random_inputs = false);
+
+// Talk to the QAIAppSvc processes started from now on through rings in share memory instead of the pipes. A thread
+// waiting for the other process spins up to 'spin_us' microseconds before it sleeps on a futex / event; 0 sleeps
+// right away, which leaves the cores to the inferences at the cost of a wake-up per message.
+extern "C" LIBAPPBUILDER_API void SetSvcDoorbell(bool enable, uint32_t spin_us = 20);
+
+// Timeline tracing of model loading and inference stages, plus the backend profiling events when profiling is
+// enabled. Can be switched at any time; costs next to nothing while disabled.
+extern "C" LIBAPPBUILDER_API void SetTraceEnabled(bool enable);
+// Writes the spans recorded so far to 'trace_path' in Chrome trace JSON, for chrome://tracing or ui.perfetto.dev.
+extern "C" LIBAPPBUILDER_API bool DumpTrace(const std::string& trace_path, bool clear = true);
+
+// Log the duration of every ModelInference() call. Off by default, LibAppBuilder::ModelGetStats() has the aggregates.
+extern "C" LIBAPPBUILDER_API void SetLogInferenceTime(bool enable);
+
+// Write log messages from a background thread: the logging thread only formats the message into a per-thread
+// ring buffer. Messages are dropped, not waited for, when a thread logs faster than they can be written.
+extern "C" LIBAPPBUILDER_API void SetLogAsync(bool enable);
+// Number of log messages dropped because a ring buffer was full.
+extern "C" LIBAPPBUILDER_API uint64_t GetLogDroppedCount();
+
+// Threads running LibAppBuilder::ModelInferenceAsync(), 0 for the default: the number of cores, at least 4. The
+// current threads finish the inferences already queued and exit, the next call starts the new ones.
+extern "C" LIBAPPBUILDER_API void SetAsyncWorkers(uint32_t count);
+
+
+/////////////////////////////////////////////////////////////////////////////
+/// Latency distribution of one stage of ModelInference(), in microseconds.
+/// Percentiles are accurate to 1/16 of their value.
+/////////////////////////////////////////////////////////////////////////////
+struct LatencyStats {
+    uint64_t count  = 0;
+    double meanUs   = 0;
+    uint64_t minUs  = 0;
+    uint64_t p50Us  = 0;
+    uint64_t p90Us  = 0;
+    uint64_t p99Us  = 0;
+    uint64_t p999Us = 0;
+    uint64_t maxUs  = 0;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+/// Per model statistics, see LibAppBuilder::ModelGetStats().
+/////////////////////////////////////////////////////////////////////////////
+struct ModelStats {
+    double initializeMs   = 0;      // Time spent in ModelInitialize(), warmup included.
+    uint32_t warmupRuns   = 0;      // Executions done by the warmup stage.
+    double coldLatencyMs  = 0;      // First execution after initialization, warmup or real request.
+    double warmLatencyMs  = 0;      // Mean latency of the executions after the first one.
+    uint64_t executions   = 0;      // All executions, warmup included.
+    bool warm             = false;  // Set once the model has run at least two executions.
+
+    // Requests since the model was loaded or ModelResetStats(), warmup excluded.
+    LatencyStats total;             // Whole ModelInference() call, batch queueing included.
+    LatencyStats inputConversion;
+    LatencyStats execute;
+    LatencyStats outputConversion;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+/// Aggregate of one backend profiling event, see LibAppBuilder::ModelGetProfilingStats().
+/////////////////////////////////////////////////////////////////////////////
+struct ProfilingEventStats {
+    std::string identifier;
+    uint32_t graphIdx = 0;      // 0xFFFFFFFF for events not tied to a graph, e.g. context creation.
+    uint32_t type     = 0;      // QnnProfile_EventType_t
+    uint32_t unit     = 0;      // QnnProfile_EventUnit_t
+    uint64_t count    = 0;
+    uint64_t min      = 0;
+    uint64_t max      = 0;
+    double mean       = 0;
+    uint64_t p50      = 0;
+    uint64_t p99      = 0;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+/// Input or output of a model, see LibAppBuilder::ModelGetInfo().
+/////////////////////////////////////////////////////////////////////////////
+struct TensorInfo {
+    std::string name;
+    std::string dataType;       // Native data type as a numpy dtype name: "float32", "float16", "uint8", "int32" ...
+    std::vector<size_t> shape;
+    size_t size     = 0;        // Bytes in the native data type.
+    bool quantized  = false;    // Fixed point: the value is (native value + offset) * scale.
+    float scale     = 0;
+    int32_t offset  = 0;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+/// An inference for LibAppBuilder::ModelInferenceAsync(), with the arguments of LibAppBuilder::ModelInference().
+/////////////////////////////////////////////////////////////////////////////
+struct InferenceRequest {
+    std::string modelName;
+    std::string procName;                   // Empty if the model is loaded in this process.
+    std::string shareMemoryName;
+    std::vector<uint8_t*> inputBuffers;
+    std::vector<size_t> inputSize;
+    std::vector<std::string> inputDataTypes;
+    std::vector<uint8_t*> outputBuffers;
+    std::vector<size_t> outputSize;
+    std::string perfProfile = "default";
+    bool nativeOutputs = false;
+    bool callerOutputs = false;
+    bool result = false;                    // What ModelInference() returned.
+};
+
+// Called on a worker thread of the library when the inference of 'request' is done.
+typedef std::function<void(std::shared_ptr<InferenceRequest> request)> InferenceCallback;
+
 
 /////////////////////////////////////////////////////////////////////////////
 /// Class LibAppBuilder declaration.
@@ -61,22 +180,80 @@ public:
                          const std::string& backend_lib_path, const std::string& system_lib_path,
                          std::vector<LoraAdapter>& lora_adapters,
                          bool async = false);
+    // Load the model with its LoRA adapters in the service process 'proc_name'. The arguments are kept: if the
+    // process dies, it is restarted and the model loaded again with them.
+    bool ModelInitialize(const std::string& model_name, const std::string& proc_name, const std::string& model_path,
+                         const std::string& backend_lib_path, const std::string& system_lib_path,
+                         std::vector<LoraAdapter>& lora_adapters,
+                         bool async = false);
 
     bool ModelInference(std::string model_name, std::vector<uint8_t*>& inputBuffers, 
                               std::vector<uint8_t*>& outputBuffers, std::vector<size_t>& outputSize,
                               std::string& perfProfile);
+    // 'inputDataTypes' has the data type of each input buffer: the native data type of the input (TensorInfo::dataType)
+    // is used as it is, "float32" is converted to it. Other data types fail.
+    // 'nativeOutputs' returns the outputs in their native data type instead of float32.
+    // 'callerOutputs': 'outputBuffers' and 'outputSize' come in with a buffer of the caller and its size for each output,
+    // the outputs are written there and 'outputSize' is set to their sizes. The library allocates no output buffer then.
+    bool ModelInference(std::string model_name, std::vector<uint8_t*>& inputBuffers, const std::vector<std::string>& inputDataTypes,
+                        std::vector<uint8_t*>& outputBuffers, std::vector<size_t>& outputSize,
+                        std::string& perfProfile, bool nativeOutputs = false, bool callerOutputs = false);
     bool ModelInference(std::string model_name, std::string proc_name, std::string share_memory_name,
                               std::vector<uint8_t*>& inputBuffers, std::vector<size_t>& inputSize,
                               std::vector<uint8_t*>& outputBuffers, std::vector<size_t>& outputSize,
                               std::string& perfProfile);
+    // Same with the 'inputDataTypes', 'nativeOutputs' and 'callerOutputs' above, the service process converts the data.
+    bool ModelInference(std::string model_name, std::string proc_name, std::string share_memory_name,
+                        std::vector<uint8_t*>& inputBuffers, std::vector<size_t>& inputSize, const std::vector<std::string>& inputDataTypes,
+                        std::vector<uint8_t*>& outputBuffers, std::vector<size_t>& outputSize,
+                        std::string& perfProfile, bool nativeOutputs = false, bool callerOutputs = false);
+    // Queue 'request' to a worker thread of the library and return: the caller doesn't wait for the inference, and
+    // several can be in flight for one model. The buffers of 'request' must stay valid until 'callback' is called.
+    // The output buffers are the caller's to free like those of ModelInference(); with 'shareMemoryName' they are in
+    // that share memory and valid during 'callback' only. Returns false if the request can't be queued.
+    bool ModelInferenceAsync(std::shared_ptr<InferenceRequest> request, InferenceCallback callback);
 
     bool ModelApplyBinaryUpdate(const std::string model_name, std::vector<LoraAdapter>& lora_adapters);
 
+    // Enable dynamic micro-batching for a model compiled with a batch dimension: concurrent single-item
+    // ModelInference() calls are packed into one execution of up to 'max_batch_size' items, waiting at most
+    // 'max_wait_us' for the batch to fill. 'max_batch_size' <= 1 disables batching.
+    bool ModelSetBatching(const std::string& model_name, size_t max_batch_size, uint32_t max_wait_us);
+
+    // Run a model loaded with 'proc_name' in 'replicas' service processes: the one of ModelInitialize() and
+    // "<proc_name>#1", "<proc_name>#2", ... ModelInference() sends each inference to the replica with the least
+    // work in flight, a replica whose process died is restarted with its models loaded again.
+    bool ModelSetReplicas(const std::string& model_name, uint32_t replicas);
+
     bool ModelDestroy(std::string model_name);
     bool ModelDestroy(std::string model_name, std::string proc_name);
 
+    // Inputs and outputs of a model, in the order ModelInference() takes and returns them. They are read once when the
+    // model is loaded; for a model in a service process, they are asked from the process the first time.
+    bool ModelGetInfo(const std::string& model_name, std::vector<TensorInfo>& inputs, std::vector<TensorInfo>& outputs);
+    bool ModelGetInfo(const std::string& model_name, const std::string& proc_name, std::vector<TensorInfo>& inputs,
+                      std::vector<TensorInfo>& outputs);
+    // Alias of ModelGetInfo() for a model loaded in this process.
+    bool GetModelInfo(const std::string& model_name, std::vector<TensorInfo>& inputs, std::vector<TensorInfo>& outputs);
+
+    // Statistics of a model loaded in this process. Returns false if the model is unknown.
+    bool ModelGetStats(const std::string& model_name, ModelStats& stats);
+    bool ModelResetStats(const std::string& model_name);
+    // Statistics of 'model_name', or of every loaded model if empty, as text or JSON.
+    std::string ModelDumpStats(const std::string& model_name, bool json = false);
+
+    // Per event statistics of the backend profiling events recorded since the model was loaded or
+    // ModelResetProfilingStats() was called. Needs SetProfilingLevel() before ModelInitialize().
+    bool ModelGetProfilingStats(const std::string& model_name, std::vector<ProfilingEventStats>& stats);
+    bool ModelResetProfilingStats(const std::string& model_name);
+
     bool CreateShareMemory(std::string share_memory_name, size_t share_memory_size);
     bool DeleteShareMemory(std::string share_memory_name);
+
+    // Buffer in the share memory arena used by remote inferences with an empty 'share_memory_name'. Inputs
+    // allocated here are read by the service process in place instead of being copied.
+    uint8_t* AllocateShareMemoryBuffer(size_t size);
+    bool FreeShareMemoryBuffer(uint8_t* buffer);
 };
 
 
@@ -96,9 +273,12 @@ public:
     }
 
     void Print(std::string message) {
+        QNN_WAR("Time: %s %.2f\n", message.c_str(), ElapsedMs());
+    }
+
+    double ElapsedMs() {
         time_now = std::chrono::steady_clock::now();
-        double dr_ms = std::chrono::duration<double, std::milli>(time_now - time_start).count();
-        QNN_WAR("Time: %s %.2f\n", message.c_str(), dr_ms);
+        return std::chrono::duration<double, std::milli>(time_now - time_start).count();
     }
 
     void Print(std::string message, bool reset) {
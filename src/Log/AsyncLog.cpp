@@ -0,0 +1,261 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AsyncLog.hpp"
+#include "LogUtils.hpp"
+
+using namespace qnn::log;
+
+namespace {
+
+struct LogSlot {
+  uint64_t timestamp;
+  QnnLog_Level_t level;
+  uint32_t length;
+  char text[async::g_slotTextSize];
+};
+
+// Written by its owning thread only (head), drained by the writer thread only (tail).
+struct LogRing {
+  LogSlot slots[async::g_ringSlots];
+  std::atomic<uint64_t> head{0};
+  std::atomic<uint64_t> tail{0};
+  std::atomic<bool> orphaned{false};  // The owning thread exited, drop the ring once drained.
+  std::atomic<bool> writing{false};   // The owner is in enqueue(), setEnabled(false) waits for it.
+};
+
+struct RingOwner {
+  std::shared_ptr<LogRing> ring;
+  ~RingOwner() {
+    if (ring) {
+      ring->orphaned.store(true, std::memory_order_release);
+    }
+  }
+};
+
+struct DrainedRing {
+  std::shared_ptr<LogRing> ring;
+  uint64_t tail;
+};
+
+}  // namespace
+
+static std::atomic<bool> sg_enabled{false};
+static std::atomic<uint64_t> sg_dropped{0};
+
+static std::mutex sg_ringsMutex;
+static std::vector<std::shared_ptr<LogRing>> sg_rings;
+
+static std::mutex sg_writerMutex;  // Serializes setEnabled().
+static std::thread sg_writer;
+static std::atomic<bool> sg_stopWriter{false};
+
+static std::mutex sg_wakeMutex;
+static std::condition_variable sg_wakeCondition;
+
+static thread_local RingOwner tl_owner;
+
+static LogRing& localRing() {
+  if (!tl_owner.ring) {
+    tl_owner.ring = std::make_shared<LogRing>();
+    std::lock_guard<std::mutex> lock(sg_ringsMutex);
+    sg_rings.push_back(tl_owner.ring);
+  }
+  return *tl_owner.ring;
+}
+
+// Called when the logging turned synchronous: the messages this thread queued before are written
+// first. The writer drains every ring before it stops, see setEnabled().
+static bool syncAfterRing() {
+  LogRing* ring = tl_owner.ring.get();
+  while (ring && ring->tail.load(std::memory_order_acquire) != ring->head.load(std::memory_order_relaxed)) {
+    std::this_thread::yield();
+  }
+  return false;
+}
+
+// Copies every pending message of every ring into 'batch'. The slots stay owned by the writer
+// until commitRings() releases them, after the batch is written, so flush() can wait on them.
+static void drainRings(std::string& batch, std::vector<DrainedRing>& drained) {
+  std::vector<std::shared_ptr<LogRing>> rings;
+  {
+    std::lock_guard<std::mutex> lock(sg_ringsMutex);
+    rings = sg_rings;
+  }
+
+  char prefix[128];
+  for (auto& ring : rings) {
+    uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    uint64_t head = ring->head.load(std::memory_order_acquire);
+    if (tail == head) {
+      continue;
+    }
+    for (; tail < head; tail++) {
+      const LogSlot& slot = ring->slots[tail % async::g_ringSlots];
+      int prefixLength    = utils::logFormatPrefix(prefix, sizeof(prefix), slot.level, slot.timestamp);
+      batch.append(prefix, prefixLength);
+      batch.append(slot.text, slot.length);
+      batch.push_back('\n');
+    }
+    drained.push_back(DrainedRing{ring, tail});
+  }
+}
+
+static void commitRings(const std::vector<DrainedRing>& drained) {
+  for (auto& entry : drained) {
+    entry.ring->tail.store(entry.tail, std::memory_order_release);
+  }
+
+  // Rings of exited threads are released once empty; the owner never writes to them again.
+  std::lock_guard<std::mutex> lock(sg_ringsMutex);
+  for (auto it = sg_rings.begin(); it != sg_rings.end();) {
+    LogRing& ring = **it;
+    if (ring.orphaned.load(std::memory_order_acquire) &&
+        ring.tail.load(std::memory_order_relaxed) == ring.head.load(std::memory_order_acquire)) {
+      it = sg_rings.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+static void writerLoop() {
+  std::string batch;
+  batch.reserve(64 * 1024);
+  std::vector<DrainedRing> drained;
+  for (;;) {
+    bool stopping = sg_stopWriter.load(std::memory_order_acquire);
+    batch.clear();
+    drained.clear();
+    drainRings(batch, drained);
+    if (!drained.empty()) {
+      utils::logWrite(batch.data(), batch.size());
+      commitRings(drained);
+      sg_wakeCondition.notify_all();  // Wakes flush().
+      continue;
+    }
+    if (stopping) {
+      break;
+    }
+    // Producers only signal a half full ring, anything else is picked up within a millisecond.
+    std::unique_lock<std::mutex> lock(sg_wakeMutex);
+    sg_wakeCondition.wait_for(lock, std::chrono::milliseconds(1));
+  }
+}
+
+// Called once 'sg_enabled' is false: a producer which saw it true before publishes its message
+// before the writer is told to stop, so that message is still written, and in order.
+static void waitForProducers() {
+  std::vector<std::shared_ptr<LogRing>> rings;
+  {
+    std::lock_guard<std::mutex> lock(sg_ringsMutex);
+    rings = sg_rings;
+  }
+  for (auto& ring : rings) {
+    while (ring->writing.load(std::memory_order_seq_cst)) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+static bool ringsEmpty() {
+  std::lock_guard<std::mutex> lock(sg_ringsMutex);
+  for (auto& ring : sg_rings) {
+    if (ring->tail.load(std::memory_order_acquire) != ring->head.load(std::memory_order_acquire)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void async::setEnabled(bool enabled) {
+  std::lock_guard<std::mutex> lock(sg_writerMutex);
+  if (enabled == sg_writer.joinable()) {
+    return;
+  }
+  if (enabled) {
+    sg_stopWriter.store(false, std::memory_order_release);
+    sg_writer = std::thread(writerLoop);
+    sg_enabled.store(true, std::memory_order_release);
+  } else {
+    // New messages go the synchronous way from here on, the writer drains what is left.
+    sg_enabled.store(false, std::memory_order_seq_cst);
+    waitForProducers();
+    sg_stopWriter.store(true, std::memory_order_release);
+    sg_writer.join();
+  }
+}
+
+// Writes what is still queued at exit, a joinable std::thread must not be destroyed.
+static struct WriterShutdown {
+  ~WriterShutdown() { async::setEnabled(false); }
+} sg_writerShutdown;
+
+bool async::isEnabled() { return sg_enabled.load(std::memory_order_relaxed); }
+
+bool async::enqueue(const char* fmt, QnnLog_Level_t level, uint64_t timestamp, va_list argp) {
+  if (!sg_enabled.load(std::memory_order_relaxed)) {
+    return syncAfterRing();
+  }
+
+  // Announced before 'sg_enabled' is checked again: either setEnabled(false) sees 'writing' and
+  // waits for the message, or this thread sees the logging disabled.
+  LogRing& ring = localRing();
+  ring.writing.store(true, std::memory_order_seq_cst);
+  if (!sg_enabled.load(std::memory_order_seq_cst)) {
+    ring.writing.store(false, std::memory_order_release);
+    return syncAfterRing();
+  }
+
+  uint64_t head  = ring.head.load(std::memory_order_relaxed);
+  uint64_t used  = head - ring.tail.load(std::memory_order_acquire);
+  if (used >= g_ringSlots) {
+    ring.writing.store(false, std::memory_order_release);
+    sg_dropped.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  LogSlot& slot = ring.slots[head % g_ringSlots];
+  int length    = vsnprintf(slot.text, sizeof(slot.text), fmt, argp);
+  if (length < 0) {
+    length = 0;
+  } else if (length >= (int)sizeof(slot.text)) {
+    length = (int)sizeof(slot.text) - 1;
+  }
+  while (length > 0 && slot.text[length - 1] == '\n') {
+    length--;
+  }
+  slot.timestamp = timestamp;
+  slot.level     = level;
+  slot.length    = (uint32_t)length;
+  ring.head.store(head + 1, std::memory_order_release);
+  ring.writing.store(false, std::memory_order_release);
+  if (used == g_ringSlots / 2) {
+    sg_wakeCondition.notify_one();  // Don't leave a fast producer to the writer's polling.
+  }
+  return true;
+}
+
+void async::flush() {
+  std::unique_lock<std::mutex> lock(sg_wakeMutex);
+  while (sg_enabled.load(std::memory_order_acquire) && !ringsEmpty()) {
+    sg_wakeCondition.wait_for(lock, std::chrono::milliseconds(1));
+  }
+}
+
+uint64_t async::getDroppedCount() { return sg_dropped.load(std::memory_order_relaxed); }
@@ -0,0 +1,50 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+#pragma once
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+
+#include "QnnLog.h"
+
+namespace qnn {
+namespace log {
+namespace async {
+
+/*
+ * Asynchronous stdout logging. Every logging thread owns a fixed size single-producer /
+ * single-consumer ring; a message is formatted into the next free slot of the caller's ring,
+ * without lock or I/O. One writer thread drains all rings, adds the timestamp and level
+ * prefix and writes the messages in batches, with one flush per batch.
+ *
+ * Memory is bounded to g_ringSlots slots per logging thread. When a ring is full the message
+ * is dropped and counted instead of blocking the caller. Messages longer than a slot are
+ * truncated.
+ */
+const size_t g_ringSlots = 512;
+const size_t g_slotTextSize = 240;
+
+// Starts or stops (after draining every ring) the writer thread.
+void setEnabled(bool enabled);
+
+bool isEnabled();
+
+// Returns false if async logging is disabled, the caller then logs synchronously. The messages the
+// calling thread queued before are written by then, so its messages stay in order.
+bool enqueue(const char* fmt, QnnLog_Level_t level, uint64_t timestamp, va_list argp);
+
+// Waits until every message enqueued so far is written.
+void flush();
+
+uint64_t getDroppedCount();
+
+}  // namespace async
+}  // namespace log
+}  // namespace qnn
@@ -6,6 +6,7 @@
 //
 //==============================================================================
 
+#include "AsyncLog.hpp"
 #include "LogUtils.hpp"
 
 
@@ -18,14 +19,9 @@ void qnn::log::utils::logCreateLock() {		// zw: We need share the lock between p
 #endif
 }
 
-#ifdef _WIN32
 extern std::string g_ProcName;
-#endif
 
-void qnn::log::utils::logStdoutCallback(const char* fmt,
-                                        QnnLog_Level_t level,
-                                        uint64_t timestamp,
-                                        va_list argp) {
+static const char* levelString(QnnLog_Level_t level) {
   const char* levelStr = "";
   switch (level) {
     case QNN_LOG_LEVEL_ERROR:
@@ -47,7 +43,47 @@ void qnn::log::utils::logStdoutCallback(const char* fmt,
       levelStr = "UNKNOWN";
       break;
   }
+  return levelStr;
+}
 
+int qnn::log::utils::logFormatPrefix(char* buffer, size_t size, QnnLog_Level_t level, uint64_t timestamp) {
+  double ms = (double)timestamp / 1000000.0;
+#ifdef _WIN32
+  int length = snprintf(buffer, size, "%8.1fms [%s][%d][%-7s] ", ms, g_ProcName.c_str(), GetCurrentProcessId(), levelString(level));
+#else
+  int length = snprintf(buffer, size, "%8.1fms [%s][%d][%-7s] ", ms, g_ProcName.c_str(), (int)getpid(), levelString(level));
+#endif
+  if (length < 0) {
+    return 0;
+  }
+  return length < (int)size ? length : (int)size - 1;
+}
+
+void qnn::log::utils::logWrite(const char* data, size_t size) {
+#ifdef _WIN32
+  DWORD dwWaitResult = WaitForSingleObject(sg_logUtilMutex, INFINITE);
+  if (WAIT_OBJECT_0 == dwWaitResult) {
+    fwrite(data, 1, size, stdout);
+    fflush(stdout);
+  }
+  ReleaseMutex(sg_logUtilMutex);
+#else
+  std::lock_guard<std::mutex> lock(sg_logUtilMutex);
+  fwrite(data, 1, size, stdout);
+  fflush(stdout);
+#endif
+}
+
+void qnn::log::utils::logStdoutCallback(const char* fmt,
+                                        QnnLog_Level_t level,
+                                        uint64_t timestamp,
+                                        va_list argp) {
+  // With async logging on, only format into this thread's ring; the writer thread does the I/O.
+  if (async::enqueue(fmt, level, timestamp, argp)) {
+    return;
+  }
+
+  const char* levelStr = levelString(level);
   double ms = (double)timestamp / 1000000.0;
   // To avoid interleaved messages
 #ifdef _WIN32
@@ -57,7 +93,7 @@ void qnn::log::utils::logStdoutCallback(const char* fmt,
         //std::lock_guard<std::mutex> lock(sg_logUtilMutex);
         fprintf(stdout, "%8.1fms [%s][%d][%-7s] ", ms, g_ProcName.c_str(), GetCurrentProcessId(), levelStr);
         vfprintf(stdout, fmt, argp);
-        if (fmt[strlen(fmt) - 1] != '\n') {
+        if (*fmt && fmt[strlen(fmt) - 1] != '\n') {
             fprintf(stdout, "\n");
         }
         fflush(stdout);
@@ -67,9 +103,12 @@ void qnn::log::utils::logStdoutCallback(const char* fmt,
 #else
   {
     std::lock_guard<std::mutex> lock(sg_logUtilMutex);
-    fprintf(stdout, "%8.1fms [%-7s] ", ms, levelStr);
+    fprintf(stdout, "%8.1fms [%s][%d][%-7s] ", ms, g_ProcName.c_str(), (int)getpid(), levelStr);
     vfprintf(stdout, fmt, argp);
-    fprintf(stdout, "\n");
+    if (*fmt && fmt[strlen(fmt) - 1] != '\n') {
+      fprintf(stdout, "\n");
+    }
+    fflush(stdout);     // The Svc processes share stdout with the application.
   }
 #endif
 }
@@ -10,10 +10,13 @@
 
 #include <cstdarg>
 #include <cstdio>
+#include <cstring>
 #include <mutex>
 #include <string>
 #ifdef _WIN32
 #include <windows.h>    // zw.
+#else
+#include <unistd.h>
 #endif
 #include "QnnLog.h"
 
@@ -23,6 +26,11 @@ namespace utils {
 
 void logStdoutCallback(const char* fmt, QnnLog_Level_t level, uint64_t timestamp, va_list argp);
 void logCreateLock();
+
+// Writes the "time [level] " prefix of a log line into 'buffer', returns its length.
+int logFormatPrefix(char* buffer, size_t size, QnnLog_Level_t level, uint64_t timestamp);
+// Writes already formatted lines to stdout under the (cross-process) log lock, then flushes.
+void logWrite(const char* data, size_t size);
 #ifdef _WIN32
 static HANDLE sg_logUtilMutex = nullptr;	// zw: We need share the lock between processes.
 #else
@@ -16,6 +16,8 @@
 
 using namespace qnn::log;
 
+std::atomic<int> qnn::log::g_maxLevel{0};
+
 std::shared_ptr<Logger> Logger::s_logger = nullptr;
 
 std::mutex Logger::s_logMutex;
@@ -32,6 +34,9 @@ std::shared_ptr<Logger> Logger::createLogger(QnnLog_Callback_t callback,
   }
   if (!s_logger) {
     s_logger = std::shared_ptr<Logger>(new (std::nothrow) Logger(callback, maxLevel, status));
+    if (s_logger) {
+      g_maxLevel.store((int)maxLevel, std::memory_order_relaxed);
+    }
   }
   *status = QNN_LOG_NO_ERROR;
   return s_logger;
@@ -47,15 +52,14 @@ Logger::Logger(QnnLog_Callback_t callback, QnnLog_Level_t maxLevel, QnnLog_Error
 
 void Logger::log(QnnLog_Level_t level, const char* file, long line, const char* fmt, ...) {
   if (m_callback) {
-    if (level > m_maxLevel.load(std::memory_order_seq_cst)) {
+    if (level > m_maxLevel.load(std::memory_order_relaxed)) {
       return;
     }
     va_list argp;
     va_start(argp, fmt);
-    std::string logString(fmt);
     std::ignore = file;
     std::ignore = line;
-    (*m_callback)(logString.c_str(), level, getTimestamp() - m_epoch, argp);
+    (*m_callback)(fmt, level, getTimestamp() - m_epoch, argp);
     va_end(argp);
   }
 }
@@ -18,17 +18,30 @@
 
 #define __FILENAME__ (strrchr(__FILE__, '/') + 1)
 
+/**
+ * @brief Most verbose level compiled in, as the numeric value of a QnnLog_Level_t
+ *        (1: ERROR ... 5: DEBUG). Calls above it are removed at compile time,
+ *        e.g. -DQNN_LOG_MAX_COMPILED_LEVEL=3 drops QNN_VERBOSE and QNN_DEBUG.
+ */
+#ifndef QNN_LOG_MAX_COMPILED_LEVEL
+#define QNN_LOG_MAX_COMPILED_LEVEL 5
+#endif
+
 /**
  * @brief Log something with the current logger. Always valid to call, though
- *        it won't do something if no logger has been set.
+ *        it won't do something if no logger has been set. A call filtered by
+ *        the current level costs one relaxed atomic load.
  */
 
-#define QNN_LOG_LEVEL(level, fmt, ...)                                \
-  do {                                                                \
-    auto logger = ::qnn::log::Logger::getLogger();                    \
-    if (logger) {                                                     \
-      logger->log(level, __FILENAME__, __LINE__, fmt, ##__VA_ARGS__); \
-    }                                                                 \
+#define QNN_LOG_LEVEL(level, fmt, ...)                                    \
+  do {                                                                    \
+    if ((level) <= QNN_LOG_MAX_COMPILED_LEVEL &&                          \
+        ::qnn::log::isLevelEnabled(level)) {                              \
+      ::qnn::log::Logger* logger = ::qnn::log::Logger::getLoggerPtr();    \
+      if (logger) {                                                       \
+        logger->log(level, __FILENAME__, __LINE__, fmt, ##__VA_ARGS__);   \
+      }                                                                   \
+    }                                                                     \
   } while (0)
 
 #define QNN_ERROR(fmt, ...) QNN_LOG_LEVEL(QNN_LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
@@ -54,6 +67,14 @@
 namespace qnn {
 namespace log {
 
+// Max level of the current logger, 0 while there is none. Mirrors Logger::m_maxLevel so that
+// filtered calls don't need to touch the logger.
+extern std::atomic<int> g_maxLevel;
+
+inline bool isLevelEnabled(QnnLog_Level_t level) {
+  return (int)level <= g_maxLevel.load(std::memory_order_relaxed);
+}
+
 bool initializeLogging();
 
 QnnLog_Callback_t getLogCallback();
@@ -78,6 +99,7 @@ class Logger final {
 
   void setMaxLevel(QnnLog_Level_t maxLevel) {
     m_maxLevel.store(maxLevel, std::memory_order_seq_cst);
+    g_maxLevel.store((int)maxLevel, std::memory_order_relaxed);
   }
 
   QnnLog_Level_t getMaxLevel() { return m_maxLevel.load(std::memory_order_seq_cst); }
@@ -94,7 +116,13 @@ class Logger final {
 
   static std::shared_ptr<Logger> getLogger() { return s_logger; }
 
-  static void reset() { s_logger = nullptr; }
+  // No reference count update, for the logging macros. The logger lives until reset().
+  static Logger* getLoggerPtr() { return s_logger.get(); }
+
+  static void reset() {
+    g_maxLevel.store(0, std::memory_order_relaxed);
+    s_logger = nullptr;
+  }
 
 // zw: Add for sync the time between processes.
   uint64_t getTimediff();
@@ -0,0 +1,78 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+//------------------------------------------------------------------------------
+/// @file
+///   This file includes APIs to wake a thread of another process waiting on a
+///   word of shared memory on the supported platforms
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace pal {
+class Doorbell;
+}
+
+//------------------------------------------------------------------------------
+/// @brief
+///   Doorbell lets a thread sleep until a thread of another process rings it.
+///   Both sides pass the same word of a SharedMemory, which the ringing side
+///   changes before ring(). On Linux the word is a futex; on Windows an
+///   auto-reset named event does the waking and the word only avoids sleeping
+///   when it has already changed.
+//------------------------------------------------------------------------------
+class pal::Doorbell {
+ public:
+  Doorbell() = default;
+  ~Doorbell();
+
+  Doorbell(const Doorbell &)            = delete;
+  Doorbell &operator=(const Doorbell &) = delete;
+
+  //---------------------------------------------------------------------------
+  /// @brief
+  ///   Creates the doorbell 'name' on 'word'. The name is unused on Linux.
+  ///   Any previous doorbell is released first.
+  /// @return
+  ///   True on success, otherwise false.
+  //---------------------------------------------------------------------------
+  bool create(const std::string &name, std::atomic<uint32_t> *word);
+
+  //---------------------------------------------------------------------------
+  /// @brief
+  ///   Opens the doorbell 'name' another process created on the same word.
+  /// @return
+  ///   True on success, otherwise false.
+  //---------------------------------------------------------------------------
+  bool open(const std::string &name, std::atomic<uint32_t> *word);
+
+  //---------------------------------------------------------------------------
+  /// @brief
+  ///   Sleeps until the doorbell rings or 'timeoutMs' passes, unless the word
+  ///   is no longer 'expected'. It may also return early for no reason.
+  /// @return
+  ///   False on timeout, otherwise true.
+  //---------------------------------------------------------------------------
+  bool wait(uint32_t expected, uint32_t timeoutMs);
+
+  //---------------------------------------------------------------------------
+  /// @brief
+  ///   Wakes the threads waiting on the doorbell.
+  //---------------------------------------------------------------------------
+  void ring();
+
+  void close();
+
+ private:
+  std::atomic<uint32_t> *m_word = nullptr;
+  void *m_event                 = nullptr;  // Windows event handle, unused on Linux.
+};
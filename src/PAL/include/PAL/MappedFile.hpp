@@ -0,0 +1,64 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+//------------------------------------------------------------------------------
+/// @file
+///   This file includes APIs for read-only file mappings on the supported platforms
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace pal {
+class MappedFile;
+}
+
+//------------------------------------------------------------------------------
+/// @brief
+///   MappedFile maps a whole file read-only into the address space. The mapping
+///   lives until close() is called or the object is destroyed.
+//------------------------------------------------------------------------------
+class pal::MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile &)            = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  //---------------------------------------------------------------------------
+  /// @brief
+  ///   Maps the file read-only. Any previous mapping is released first.
+  /// @param path
+  ///   Path of the file to map.
+  /// @return
+  ///   True on success, otherwise false.
+  //---------------------------------------------------------------------------
+  bool open(const std::string &path);
+
+  //---------------------------------------------------------------------------
+  /// @brief
+  ///   Releases the mapping and the underlying file handles.
+  //---------------------------------------------------------------------------
+  void close();
+
+  const uint8_t *data() const { return m_data; }
+
+  size_t size() const { return m_size; }
+
+  bool isOpen() const { return nullptr != m_data; }
+
+ private:
+  uint8_t *m_data = nullptr;
+  size_t m_size   = 0;
+  void *m_file    = nullptr;  // Windows file handle, unused on Linux.
+  void *m_mapping = nullptr;  // Windows file mapping handle, unused on Linux.
+};
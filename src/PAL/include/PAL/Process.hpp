@@ -0,0 +1,106 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+//------------------------------------------------------------------------------
+/// @file
+///   This file includes APIs to start child processes and talk to them through
+///   pipes on the supported platforms
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pal {
+namespace process {
+
+// One end of a pipe: a HANDLE on Windows, a file descriptor on Linux.
+typedef intptr_t PipeHandle;
+// A started child process: the process HANDLE on Windows, the pid on Linux.
+typedef intptr_t ProcessHandle;
+
+const PipeHandle g_invalidPipe = -1;
+
+//---------------------------------------------------------------------------
+/// @brief
+///   Creates a one-way pipe. Neither end is inherited by child processes
+///   unless it is passed to spawn(). On Linux this is a Unix domain socket
+///   pair, so writing to a pipe whose reader died fails instead of raising
+///   SIGPIPE.
+/// @return
+///   True on success, otherwise false.
+//---------------------------------------------------------------------------
+bool createPipe(PipeHandle &readEnd, PipeHandle &writeEnd);
+
+//---------------------------------------------------------------------------
+/// @brief
+///   Starts 'executable' with the arguments 'args'. Without a path separator
+///   'executable' is searched the way the platform does it (PATH on Linux).
+/// @param inherited
+///   Pipe ends the child inherits. Their values can be passed in 'args'.
+/// @param process
+///   Receives the child process, release it with closeProcess().
+/// @return
+///   True on success, otherwise false.
+//---------------------------------------------------------------------------
+bool spawn(const std::string &executable,
+           const std::vector<std::string> &args,
+           const std::vector<PipeHandle> &inherited,
+           ProcessHandle &process);
+
+//---------------------------------------------------------------------------
+/// @brief
+///   Writes all 'size' bytes of 'data' to 'pipe'.
+/// @return
+///   True on success, false if the pipe is broken.
+//---------------------------------------------------------------------------
+bool writePipe(PipeHandle pipe, const void *data, size_t size);
+
+//---------------------------------------------------------------------------
+/// @brief
+///   Reads what is available from 'pipe', at most 'size' bytes, blocking until
+///   at least one byte arrives.
+/// @return
+///   The number of bytes read, 0 at the end of the pipe or on error.
+//---------------------------------------------------------------------------
+size_t readPipe(PipeHandle pipe, void *buffer, size_t size);
+
+//---------------------------------------------------------------------------
+/// @brief
+///   Checks without blocking whether the writer of 'pipe', a read end nobody
+///   reads from, has gone: all its write ends are closed, for instance
+///   because the process holding them exited.
+/// @return
+///   True if the pipe has ended, otherwise false.
+//---------------------------------------------------------------------------
+bool isPipeClosed(PipeHandle pipe);
+
+void closePipe(PipeHandle pipe);
+
+//---------------------------------------------------------------------------
+/// @brief
+///   Blocks until 'process' exits, without releasing it: closeProcess() is
+///   still needed. On Linux, exitCode is 128 + the signal number when a
+///   signal killed the process.
+/// @return
+///   True once the process exited, false if it can't be waited for.
+//---------------------------------------------------------------------------
+bool waitForExit(ProcessHandle process, int &exitCode);
+
+//---------------------------------------------------------------------------
+/// @brief
+///   Releases a process started by spawn(). On Linux this waits for it to
+///   exit, so close the pipes the child reads from first.
+//---------------------------------------------------------------------------
+void closeProcess(ProcessHandle process);
+
+}  // namespace process
+}  // namespace pal
@@ -0,0 +1,85 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+//------------------------------------------------------------------------------
+/// @file
+///   This file includes APIs for named shared memory on the supported platforms
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace pal {
+class SharedMemory;
+}
+
+//------------------------------------------------------------------------------
+/// @brief
+///   SharedMemory maps a named, read-write memory region which other processes
+///   can map by the same name: a named file mapping on Windows, a POSIX shared
+///   memory object on Linux. The mapping lives until close() is called or the
+///   object is destroyed. On Linux the creator also removes the name then, so
+///   processes which mapped the region before keep it.
+//------------------------------------------------------------------------------
+class pal::SharedMemory {
+ public:
+  SharedMemory() = default;
+  ~SharedMemory();
+
+  SharedMemory(const SharedMemory &)            = delete;
+  SharedMemory &operator=(const SharedMemory &) = delete;
+
+  //---------------------------------------------------------------------------
+  /// @brief
+  ///   Creates the region 'name' of 'size' bytes and maps it. Any previous
+  ///   mapping is released first. On Windows an existing region of that name
+  ///   is reused, on Linux the creation fails if the name exists.
+  /// @return
+  ///   True on success, otherwise false.
+  //---------------------------------------------------------------------------
+  bool create(const std::string &name, size_t size);
+
+  //---------------------------------------------------------------------------
+  /// @brief
+  ///   Maps the first 'size' bytes of the existing region 'name', the whole
+  ///   region if 'size' is 0. Any previous mapping is released first.
+  /// @return
+  ///   True on success, otherwise false.
+  //---------------------------------------------------------------------------
+  bool open(const std::string &name, size_t size);
+
+  //---------------------------------------------------------------------------
+  /// @brief
+  ///   Touches every page of the mapping, so that later accesses don't take
+  ///   page faults. The content is not changed.
+  //---------------------------------------------------------------------------
+  void prefault();
+
+  //---------------------------------------------------------------------------
+  /// @brief
+  ///   Releases the mapping and the underlying handles.
+  //---------------------------------------------------------------------------
+  void close();
+
+  uint8_t *data() const { return m_data; }
+
+  size_t size() const { return m_size; }
+
+  bool isOpen() const { return nullptr != m_data; }
+
+ private:
+  uint8_t *m_data = nullptr;
+  size_t m_size   = 0;
+  void *m_mapping = nullptr;  // Windows file mapping handle, unused on Linux.
+  std::string m_unlinkName;   // Linux object to remove on close(), set by create().
+  uint64_t m_unlinkDev   = 0;  // Identity of that object, a new one of the same name is left alone.
+  uint64_t m_unlinkInode = 0;
+};
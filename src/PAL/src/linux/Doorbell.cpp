@@ -0,0 +1,72 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+#include <errno.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <climits>
+
+#include "PAL/Debug.hpp"
+#include "PAL/Doorbell.hpp"
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "The futex word is a plain uint32_t.");
+
+// The word is shared with another process, so no FUTEX_PRIVATE_FLAG.
+static long futex(std::atomic<uint32_t> *word, int op, uint32_t value, const struct timespec *timeout) {
+  return syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), op, value, timeout, nullptr, 0);
+}
+
+pal::Doorbell::~Doorbell() { close(); }
+
+//---------------------------------------------------------------------------
+//    pal::Doorbell::create
+//---------------------------------------------------------------------------
+bool pal::Doorbell::create(const std::string &name, std::atomic<uint32_t> *word) {
+  (void)name;
+  m_word = word;
+  return true;
+}
+
+//---------------------------------------------------------------------------
+//    pal::Doorbell::open
+//---------------------------------------------------------------------------
+bool pal::Doorbell::open(const std::string &name, std::atomic<uint32_t> *word) {
+  (void)name;
+  m_word = word;
+  return true;
+}
+
+//---------------------------------------------------------------------------
+//    pal::Doorbell::wait
+//---------------------------------------------------------------------------
+bool pal::Doorbell::wait(uint32_t expected, uint32_t timeoutMs) {
+  struct timespec timeout;
+  timeout.tv_sec  = timeoutMs / 1000;
+  timeout.tv_nsec = (long)(timeoutMs % 1000) * 1000000;
+  if (futex(m_word, FUTEX_WAIT, expected, &timeout) != 0 && ETIMEDOUT == errno) {
+    return false;
+  }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+//    pal::Doorbell::ring
+//---------------------------------------------------------------------------
+void pal::Doorbell::ring() {
+  if (futex(m_word, FUTEX_WAKE, INT_MAX, nullptr) < 0) {
+    DEBUG_MSG("FUTEX_WAKE failed, errno: %d", errno);
+  }
+}
+
+//---------------------------------------------------------------------------
+//    pal::Doorbell::close
+//---------------------------------------------------------------------------
+void pal::Doorbell::close() { m_word = nullptr; }
@@ -0,0 +1,60 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "PAL/Debug.hpp"
+#include "PAL/MappedFile.hpp"
+
+pal::MappedFile::~MappedFile() { close(); }
+
+//---------------------------------------------------------------------------
+//    pal::MappedFile::open
+//---------------------------------------------------------------------------
+bool pal::MappedFile::open(const std::string &path) {
+  close();
+
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    DEBUG_MSG("Failed to open %s, errno: %d", path.c_str(), errno);
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    ::close(fd);
+    return false;
+  }
+
+  void *addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file.
+  ::close(fd);
+  if (MAP_FAILED == addr) {
+    DEBUG_MSG("Failed to map %s, errno: %d", path.c_str(), errno);
+    return false;
+  }
+
+  m_data = static_cast<uint8_t *>(addr);
+  m_size = static_cast<size_t>(st.st_size);
+  return true;
+}
+
+//---------------------------------------------------------------------------
+//    pal::MappedFile::close
+//---------------------------------------------------------------------------
+void pal::MappedFile::close() {
+  if (nullptr != m_data) {
+    munmap(m_data, m_size);
+  }
+  m_data = nullptr;
+  m_size = 0;
+}
@@ -0,0 +1,170 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <mutex>
+
+#include "PAL/Debug.hpp"
+#include "PAL/Process.hpp"
+
+extern char **environ;
+
+// Pipe ends are close-on-exec. spawn() clears the flag of the inherited ends while the child
+// starts; the lock keeps two spawn() calls from leaking their ends into each other's child.
+static std::mutex sg_spawnMutex;
+
+static void setCloseOnExec(int fd, bool closeOnExec) {
+  int flags = fcntl(fd, F_GETFD);
+  if (flags >= 0) {
+    fcntl(fd, F_SETFD, closeOnExec ? (flags | FD_CLOEXEC) : (flags & ~FD_CLOEXEC));
+  }
+}
+
+//---------------------------------------------------------------------------
+//    pal::process::createPipe
+//---------------------------------------------------------------------------
+bool pal::process::createPipe(PipeHandle &readEnd, PipeHandle &writeEnd) {
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+    DEBUG_MSG("socketpair failed, errno: %d", errno);
+    return false;
+  }
+  // Used one way only.
+  shutdown(fds[0], SHUT_WR);
+  shutdown(fds[1], SHUT_RD);
+  readEnd  = fds[0];
+  writeEnd = fds[1];
+  return true;
+}
+
+//---------------------------------------------------------------------------
+//    pal::process::spawn
+//---------------------------------------------------------------------------
+bool pal::process::spawn(const std::string &executable,
+                         const std::vector<std::string> &args,
+                         const std::vector<PipeHandle> &inherited,
+                         ProcessHandle &process) {
+  std::vector<char *> argv;
+  argv.push_back(const_cast<char *>(executable.c_str()));
+  for (const std::string &arg : args) {
+    argv.push_back(const_cast<char *>(arg.c_str()));
+  }
+  argv.push_back(nullptr);
+
+  std::lock_guard<std::mutex> lock(sg_spawnMutex);
+  for (PipeHandle pipe : inherited) {
+    setCloseOnExec((int)pipe, false);
+  }
+
+  pid_t pid = 0;
+  int error = 0;
+  if (executable.find('/') != std::string::npos) {
+    error = posix_spawn(&pid, executable.c_str(), nullptr, nullptr, argv.data(), environ);
+  } else {
+    error = posix_spawnp(&pid, executable.c_str(), nullptr, nullptr, argv.data(), environ);
+  }
+
+  for (PipeHandle pipe : inherited) {
+    setCloseOnExec((int)pipe, true);
+  }
+  if (0 != error) {
+    DEBUG_MSG("Failed to start %s, error: %d", executable.c_str(), error);
+    return false;
+  }
+
+  process = pid;
+  return true;
+}
+
+//---------------------------------------------------------------------------
+//    pal::process::writePipe
+//---------------------------------------------------------------------------
+bool pal::process::writePipe(PipeHandle pipe, const void *data, size_t size) {
+  const char *cursor = static_cast<const char *>(data);
+  while (size > 0) {
+    ssize_t written = send((int)pipe, cursor, size, MSG_NOSIGNAL);
+    if (written < 0) {
+      if (EINTR == errno) {
+        continue;
+      }
+      DEBUG_MSG("Failed to write to pipe, errno: %d", errno);
+      return false;
+    }
+    cursor += written;
+    size -= (size_t)written;
+  }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+//    pal::process::readPipe
+//---------------------------------------------------------------------------
+size_t pal::process::readPipe(PipeHandle pipe, void *buffer, size_t size) {
+  for (;;) {
+    ssize_t bytes = read((int)pipe, buffer, size);
+    if (bytes >= 0) {
+      return (size_t)bytes;
+    }
+    if (EINTR != errno) {
+      DEBUG_MSG("Failed to read from pipe, errno: %d", errno);
+      return 0;
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+//    pal::process::isPipeClosed
+//---------------------------------------------------------------------------
+bool pal::process::isPipeClosed(PipeHandle pipe) {
+  char byte;
+  ssize_t bytes = recv((int)pipe, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+  return 0 == bytes || (bytes < 0 && EAGAIN != errno && EWOULDBLOCK != errno && EINTR != errno);
+}
+
+//---------------------------------------------------------------------------
+//    pal::process::closePipe
+//---------------------------------------------------------------------------
+void pal::process::closePipe(PipeHandle pipe) {
+  if (g_invalidPipe != pipe) {
+    close((int)pipe);
+  }
+}
+
+//---------------------------------------------------------------------------
+//    pal::process::waitForExit
+//---------------------------------------------------------------------------
+bool pal::process::waitForExit(ProcessHandle process, int &exitCode) {
+  siginfo_t info;
+  for (;;) {
+    info.si_pid = 0;
+    // WNOWAIT leaves the child to be reaped by closeProcess().
+    if (0 == waitid(P_PID, (id_t)process, &info, WEXITED | WNOWAIT)) {
+      exitCode = (CLD_EXITED == info.si_code) ? info.si_status : 128 + info.si_status;
+      return true;
+    }
+    if (EINTR != errno) {
+      DEBUG_MSG("waitid failed for %d, errno: %d", (int)process, errno);
+      return false;
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+//    pal::process::closeProcess
+//---------------------------------------------------------------------------
+void pal::process::closeProcess(ProcessHandle process) {
+  int status = 0;
+  while (waitpid((pid_t)process, &status, 0) < 0 && EINTR == errno) {
+  }
+}
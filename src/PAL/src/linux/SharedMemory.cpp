@@ -0,0 +1,147 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "PAL/Debug.hpp"
+#include "PAL/SharedMemory.hpp"
+
+// POSIX shared memory names start with the only '/' they may contain.
+static std::string objectName(const std::string &name) {
+  std::string result = "/" + name;
+  for (size_t i = 1; i < result.size(); i++) {
+    if ('/' == result[i]) {
+      result[i] = '_';
+    }
+  }
+  return result;
+}
+
+static uint8_t *mapObject(int fd, size_t size) {
+  void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  return (MAP_FAILED == addr) ? nullptr : static_cast<uint8_t *>(addr);
+}
+
+pal::SharedMemory::~SharedMemory() { close(); }
+
+//---------------------------------------------------------------------------
+//    pal::SharedMemory::create
+//---------------------------------------------------------------------------
+bool pal::SharedMemory::create(const std::string &name, size_t size) {
+  close();
+
+  std::string object = objectName(name);
+  // Never take over an existing object: another process may be using it, and only its creator removes it.
+  int fd             = shm_open(object.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    DEBUG_MSG("Failed to create shared memory %s, errno: %d", object.c_str(), errno);
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    DEBUG_MSG("Failed to resize shared memory %s, errno: %d", object.c_str(), errno);
+    ::close(fd);
+    shm_unlink(object.c_str());
+    return false;
+  }
+
+  m_data = mapObject(fd, size);
+  ::close(fd);
+  if (nullptr == m_data) {
+    DEBUG_MSG("Failed to map shared memory %s, errno: %d", object.c_str(), errno);
+    shm_unlink(object.c_str());
+    return false;
+  }
+
+  m_size        = size;
+  m_unlinkName  = object;
+  m_unlinkDev   = static_cast<uint64_t>(st.st_dev);
+  m_unlinkInode = static_cast<uint64_t>(st.st_ino);
+  return true;
+}
+
+//---------------------------------------------------------------------------
+//    pal::SharedMemory::open
+//---------------------------------------------------------------------------
+bool pal::SharedMemory::open(const std::string &name, size_t size) {
+  close();
+
+  std::string object = objectName(name);
+  int fd             = shm_open(object.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    DEBUG_MSG("Failed to open shared memory %s, errno: %d", object.c_str(), errno);
+    return false;
+  }
+  if (0 == size) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+      ::close(fd);
+      return false;
+    }
+    size = static_cast<size_t>(st.st_size);
+  }
+
+  m_data = mapObject(fd, size);
+  ::close(fd);
+  if (nullptr == m_data) {
+    DEBUG_MSG("Failed to map shared memory %s, errno: %d", object.c_str(), errno);
+    return false;
+  }
+
+  m_size = size;
+  return true;
+}
+
+//---------------------------------------------------------------------------
+//    pal::SharedMemory::prefault
+//---------------------------------------------------------------------------
+void pal::SharedMemory::prefault() {
+  if (nullptr == m_data) {
+    return;
+  }
+#ifdef MADV_POPULATE_WRITE
+  // Linux 5.14+: maps the pages writable in one call.
+  if (0 == madvise(m_data, m_size, MADV_POPULATE_WRITE)) {
+    return;
+  }
+#endif
+  size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  for (size_t offset = 0; offset < m_size; offset += pageSize) {
+    (void)*static_cast<volatile uint8_t *>(m_data + offset);
+  }
+}
+
+//---------------------------------------------------------------------------
+//    pal::SharedMemory::close
+//---------------------------------------------------------------------------
+void pal::SharedMemory::close() {
+  if (nullptr != m_data) {
+    munmap(m_data, m_size);
+  }
+  if (!m_unlinkName.empty()) {
+    // Only the object create() made: the name may have been removed and created again since.
+    int fd = shm_open(m_unlinkName.c_str(), O_RDONLY, 0);
+    if (fd >= 0) {
+      struct stat st;
+      if (0 == fstat(fd, &st) && static_cast<uint64_t>(st.st_dev) == m_unlinkDev &&
+          static_cast<uint64_t>(st.st_ino) == m_unlinkInode) {
+        shm_unlink(m_unlinkName.c_str());
+      }
+      ::close(fd);
+    }
+  }
+  m_data = nullptr;
+  m_size = 0;
+  m_unlinkName.clear();
+  m_unlinkDev   = 0;
+  m_unlinkInode = 0;
+}
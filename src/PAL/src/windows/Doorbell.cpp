@@ -0,0 +1,73 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+#include <Windows.h>
+
+#include "PAL/Debug.hpp"
+#include "PAL/Doorbell.hpp"
+
+pal::Doorbell::~Doorbell() { close(); }
+
+//---------------------------------------------------------------------------
+//    pal::Doorbell::create
+//---------------------------------------------------------------------------
+bool pal::Doorbell::create(const std::string &name, std::atomic<uint32_t> *word) {
+  close();
+
+  HANDLE event = CreateEventA(NULL, FALSE, FALSE, name.c_str());
+  if (NULL == event) {
+    DEBUG_MSG("Failed to create event %s, error: %lu", name.c_str(), GetLastError());
+    return false;
+  }
+  m_event = event;
+  m_word  = word;
+  return true;
+}
+
+//---------------------------------------------------------------------------
+//    pal::Doorbell::open
+//---------------------------------------------------------------------------
+bool pal::Doorbell::open(const std::string &name, std::atomic<uint32_t> *word) {
+  close();
+
+  HANDLE event = OpenEventA(EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, name.c_str());
+  if (NULL == event) {
+    DEBUG_MSG("Failed to open event %s, error: %lu", name.c_str(), GetLastError());
+    return false;
+  }
+  m_event = event;
+  m_word  = word;
+  return true;
+}
+
+//---------------------------------------------------------------------------
+//    pal::Doorbell::wait
+//---------------------------------------------------------------------------
+bool pal::Doorbell::wait(uint32_t expected, uint32_t timeoutMs) {
+  // A ring() between this check and the wait leaves the event set, so it isn't lost.
+  if (m_word->load() != expected) {
+    return true;
+  }
+  return WAIT_TIMEOUT != WaitForSingleObject((HANDLE)m_event, timeoutMs);
+}
+
+//---------------------------------------------------------------------------
+//    pal::Doorbell::ring
+//---------------------------------------------------------------------------
+void pal::Doorbell::ring() { SetEvent((HANDLE)m_event); }
+
+//---------------------------------------------------------------------------
+//    pal::Doorbell::close
+//---------------------------------------------------------------------------
+void pal::Doorbell::close() {
+  if (nullptr != m_event) {
+    CloseHandle((HANDLE)m_event);
+  }
+  m_event = nullptr;
+  m_word  = nullptr;
+}
@@ -0,0 +1,79 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+#include <Windows.h>
+
+#include "PAL/Debug.hpp"
+#include "PAL/MappedFile.hpp"
+
+pal::MappedFile::~MappedFile() { close(); }
+
+//---------------------------------------------------------------------------
+//    pal::MappedFile::open
+//---------------------------------------------------------------------------
+bool pal::MappedFile::open(const std::string &path) {
+  close();
+
+  HANDLE file = CreateFileA(path.c_str(),
+                            GENERIC_READ,
+                            FILE_SHARE_READ,
+                            NULL,
+                            OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL,
+                            NULL);
+  if (INVALID_HANDLE_VALUE == file) {
+    DEBUG_MSG("Failed to open %s, error: %lu", path.c_str(), GetLastError());
+    return false;
+  }
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0) {
+    CloseHandle(file);
+    return false;
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (NULL == mapping) {
+    DEBUG_MSG("Failed to create file mapping of %s, error: %lu", path.c_str(), GetLastError());
+    CloseHandle(file);
+    return false;
+  }
+
+  void *addr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (NULL == addr) {
+    DEBUG_MSG("MapViewOfFile failed for %s, error: %lu", path.c_str(), GetLastError());
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+
+  m_file    = file;
+  m_mapping = mapping;
+  m_data    = static_cast<uint8_t *>(addr);
+  m_size    = static_cast<size_t>(fileSize.QuadPart);
+  return true;
+}
+
+//---------------------------------------------------------------------------
+//    pal::MappedFile::close
+//---------------------------------------------------------------------------
+void pal::MappedFile::close() {
+  if (nullptr != m_data) {
+    UnmapViewOfFile(m_data);
+  }
+  if (nullptr != m_mapping) {
+    CloseHandle(m_mapping);
+  }
+  if (nullptr != m_file) {
+    CloseHandle(m_file);
+  }
+  m_data    = nullptr;
+  m_size    = 0;
+  m_mapping = nullptr;
+  m_file    = nullptr;
+}
@@ -0,0 +1,162 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+#include <Windows.h>
+
+#include <mutex>
+
+#include "PAL/Debug.hpp"
+#include "PAL/Process.hpp"
+
+// Pipe ends are not inheritable. spawn() makes the inherited ends inheritable while the child
+// starts; the lock keeps two spawn() calls from leaking their ends into each other's child.
+static std::mutex sg_spawnMutex;
+
+static void setInheritable(pal::process::PipeHandle pipe, bool inheritable) {
+  SetHandleInformation((HANDLE)pipe, HANDLE_FLAG_INHERIT, inheritable ? HANDLE_FLAG_INHERIT : 0);
+}
+
+static std::string quoteArgument(const std::string &arg) {
+  if (!arg.empty() && arg.find_first_of(" \t\"") == std::string::npos) {
+    return arg;
+  }
+  std::string quoted = "\"";
+  for (char c : arg) {
+    if ('"' == c) {
+      quoted += '\\';
+    }
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+//---------------------------------------------------------------------------
+//    pal::process::createPipe
+//---------------------------------------------------------------------------
+bool pal::process::createPipe(PipeHandle &readEnd, PipeHandle &writeEnd) {
+  SECURITY_ATTRIBUTES saAttr;
+  saAttr.nLength              = sizeof(SECURITY_ATTRIBUTES);
+  saAttr.bInheritHandle       = FALSE;
+  saAttr.lpSecurityDescriptor = NULL;
+
+  HANDLE pipeRead  = NULL;
+  HANDLE pipeWrite = NULL;
+  if (!CreatePipe(&pipeRead, &pipeWrite, &saAttr, 0)) {
+    DEBUG_MSG("CreatePipe failed, error: %lu", GetLastError());
+    return false;
+  }
+  readEnd  = (PipeHandle)pipeRead;
+  writeEnd = (PipeHandle)pipeWrite;
+  return true;
+}
+
+//---------------------------------------------------------------------------
+//    pal::process::spawn
+//---------------------------------------------------------------------------
+bool pal::process::spawn(const std::string &executable,
+                         const std::vector<std::string> &args,
+                         const std::vector<PipeHandle> &inherited,
+                         ProcessHandle &process) {
+  std::string commandLine = quoteArgument(executable);
+  for (const std::string &arg : args) {
+    commandLine += " " + quoteArgument(arg);
+  }
+
+  STARTUPINFOA siStartInfo;
+  PROCESS_INFORMATION piProcInfo;
+  ZeroMemory(&siStartInfo, sizeof(STARTUPINFOA));
+  ZeroMemory(&piProcInfo, sizeof(PROCESS_INFORMATION));
+  siStartInfo.cb = sizeof(STARTUPINFOA);
+
+  std::lock_guard<std::mutex> lock(sg_spawnMutex);
+  for (PipeHandle pipe : inherited) {
+    setInheritable(pipe, true);
+  }
+
+  BOOL bSuccess = CreateProcessA(
+      NULL, &commandLine[0], NULL, NULL, TRUE, 0, NULL, NULL, &siStartInfo, &piProcInfo);
+
+  for (PipeHandle pipe : inherited) {
+    setInheritable(pipe, false);
+  }
+  if (!bSuccess) {
+    DEBUG_MSG("Failed to start %s, error: %lu", commandLine.c_str(), GetLastError());
+    return false;
+  }
+
+  CloseHandle(piProcInfo.hThread);
+  process = (ProcessHandle)piProcInfo.hProcess;
+  return true;
+}
+
+//---------------------------------------------------------------------------
+//    pal::process::writePipe
+//---------------------------------------------------------------------------
+bool pal::process::writePipe(PipeHandle pipe, const void *data, size_t size) {
+  const char *cursor = static_cast<const char *>(data);
+  while (size > 0) {
+    DWORD chunk   = size > 0x40000000 ? 0x40000000 : (DWORD)size;
+    DWORD written = 0;
+    if (!WriteFile((HANDLE)pipe, cursor, chunk, &written, NULL)) {
+      DEBUG_MSG("Failed to write to pipe, error: %lu", GetLastError());
+      return false;
+    }
+    cursor += written;
+    size -= written;
+  }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+//    pal::process::readPipe
+//---------------------------------------------------------------------------
+size_t pal::process::readPipe(PipeHandle pipe, void *buffer, size_t size) {
+  DWORD chunk = size > 0x40000000 ? 0x40000000 : (DWORD)size;
+  DWORD bytes = 0;
+  if (!ReadFile((HANDLE)pipe, buffer, chunk, &bytes, NULL)) {
+    DEBUG_MSG("Failed to read from pipe, error: %lu", GetLastError());
+    return 0;
+  }
+  return (size_t)bytes;
+}
+
+//---------------------------------------------------------------------------
+//    pal::process::isPipeClosed
+//---------------------------------------------------------------------------
+bool pal::process::isPipeClosed(PipeHandle pipe) {
+  DWORD available = 0;
+  return !PeekNamedPipe((HANDLE)pipe, NULL, 0, NULL, &available, NULL);
+}
+
+//---------------------------------------------------------------------------
+//    pal::process::closePipe
+//---------------------------------------------------------------------------
+void pal::process::closePipe(PipeHandle pipe) {
+  if (g_invalidPipe != pipe && 0 != pipe) {
+    CloseHandle((HANDLE)pipe);
+  }
+}
+
+//---------------------------------------------------------------------------
+//    pal::process::waitForExit
+//---------------------------------------------------------------------------
+bool pal::process::waitForExit(ProcessHandle process, int &exitCode) {
+  if (WAIT_OBJECT_0 != WaitForSingleObject((HANDLE)process, INFINITE)) {
+    DEBUG_MSG("WaitForSingleObject failed, error: %lu", GetLastError());
+    return false;
+  }
+  DWORD code = 0;
+  GetExitCodeProcess((HANDLE)process, &code);
+  exitCode = (int)code;
+  return true;
+}
+
+//---------------------------------------------------------------------------
+//    pal::process::closeProcess
+//---------------------------------------------------------------------------
+void pal::process::closeProcess(ProcessHandle process) { CloseHandle((HANDLE)process); }
@@ -0,0 +1,106 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+#include <Windows.h>
+
+#include "PAL/Debug.hpp"
+#include "PAL/SharedMemory.hpp"
+
+pal::SharedMemory::~SharedMemory() { close(); }
+
+//---------------------------------------------------------------------------
+//    pal::SharedMemory::create
+//---------------------------------------------------------------------------
+bool pal::SharedMemory::create(const std::string &name, size_t size) {
+  close();
+
+  uint64_t mappingSize = static_cast<uint64_t>(size);
+  HANDLE mapping       = CreateFileMappingA(INVALID_HANDLE_VALUE,
+                                      NULL,
+                                      PAGE_READWRITE,
+                                      static_cast<DWORD>(mappingSize >> 32),
+                                      static_cast<DWORD>(mappingSize & 0xFFFFFFFF),
+                                      name.c_str());
+  if (NULL == mapping) {
+    DEBUG_MSG("Failed to create file mapping %s, error: %lu", name.c_str(), GetLastError());
+    return false;
+  }
+
+  void *addr = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+  if (NULL == addr) {
+    DEBUG_MSG("MapViewOfFile failed for %s, error: %lu", name.c_str(), GetLastError());
+    CloseHandle(mapping);
+    return false;
+  }
+
+  m_mapping = mapping;
+  m_data    = static_cast<uint8_t *>(addr);
+  m_size    = size;
+  return true;
+}
+
+//---------------------------------------------------------------------------
+//    pal::SharedMemory::open
+//---------------------------------------------------------------------------
+bool pal::SharedMemory::open(const std::string &name, size_t size) {
+  close();
+
+  HANDLE mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+  if (NULL == mapping) {
+    DEBUG_MSG("Failed to open file mapping %s, error: %lu", name.c_str(), GetLastError());
+    return false;
+  }
+
+  void *addr = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+  if (NULL == addr) {
+    DEBUG_MSG("MapViewOfFile failed for %s, error: %lu", name.c_str(), GetLastError());
+    CloseHandle(mapping);
+    return false;
+  }
+
+  if (0 == size) {
+    MEMORY_BASIC_INFORMATION info;
+    if (VirtualQuery(addr, &info, sizeof(info))) {
+      size = static_cast<size_t>(info.RegionSize);
+    }
+  }
+
+  m_mapping = mapping;
+  m_data    = static_cast<uint8_t *>(addr);
+  m_size    = size;
+  return true;
+}
+
+//---------------------------------------------------------------------------
+//    pal::SharedMemory::prefault
+//---------------------------------------------------------------------------
+void pal::SharedMemory::prefault() {
+  if (nullptr == m_data) {
+    return;
+  }
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  for (size_t offset = 0; offset < m_size; offset += info.dwPageSize) {
+    (void)*static_cast<volatile uint8_t *>(m_data + offset);
+  }
+}
+
+//---------------------------------------------------------------------------
+//    pal::SharedMemory::close
+//---------------------------------------------------------------------------
+void pal::SharedMemory::close() {
+  if (nullptr != m_data) {
+    UnmapViewOfFile(m_data);
+  }
+  if (nullptr != m_mapping) {
+    CloseHandle(m_mapping);
+  }
+  m_data    = nullptr;
+  m_size    = 0;
+  m_mapping = nullptr;
+}
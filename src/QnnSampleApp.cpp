@@ -8,11 +8,17 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <thread>
 
+#include "BlockingQueue.hpp"
 #include "DataUtil.hpp"
+#include "DynamicLoadUtil.hpp"
 #include "Logger.hpp"
 #include "PAL/Directory.hpp"
 #include "PAL/FileOp.hpp"
@@ -21,6 +27,7 @@
 #include "QnnSampleApp.hpp"
 #include "QnnSampleAppUtils.hpp"
 #include "QnnWrapperUtils.hpp"
+#include "Trace.hpp"
 
 // zw.
 #include "QnnTypeMacros.hpp"
@@ -261,6 +268,26 @@ std::string sample_app::QnnSampleApp::getBackendBuildId() {
   return (backendBuildId == nullptr ? std::string("") : std::string(backendBuildId));
 }
 
+std::string sample_app::QnnSampleApp::getContextCacheConfig(std::vector<std::string>& files) {
+  std::string config = ";op_packages=";
+  for (auto const& opPackagePath : m_opPackagePaths) {
+    std::vector<std::string> opPackage;
+    split(opPackage, opPackagePath, ':');
+    config += opPackagePath + ",";
+    if (!opPackage.empty()) {
+      files.push_back(opPackage[0]);
+    }
+  }
+  config += ";lora=";
+  for (auto const& adapter : m_lora_adapters) {
+    config += adapter.m_graph_name + ",";
+    files.insert(files.end(), adapter.m_bin_paths.begin(), adapter.m_bin_paths.end());
+  }
+  config += std::string(";backend_config=") + (m_backendConfig ? "set" : "none") +
+            ";context_config=" + (m_contextConfig ? "set" : "none");
+  return config;
+}
+
 // Initialize QnnSampleApp. Things it does:
 //  1. Create output directory
 //  2. Read all input list paths provided
@@ -273,11 +300,33 @@ sample_app::StatusCode sample_app::QnnSampleApp::initialize() {
     exitWithMessage("Could not create output directory: " + m_outputPath, EXIT_FAILURE);
   }
 #endif
-  // Read Input File List
-  bool readSuccess;
-  std::tie(m_inputFileLists, m_inputNameToIndex, readSuccess) = readInputLists(m_inputListPaths);
-  if (!readSuccess) {
-    exitWithMessage("Could not read input lists", EXIT_FAILURE);
+  // Read Input File List. Packed datasets are mapped instead of parsed, their graph keeps an
+  // empty file list so the indices stay aligned with m_inputListPaths.
+  m_inputFileLists.clear();
+  m_inputNameToIndex.clear();
+  m_packedDatasets.clear();
+  for (auto const& path : m_inputListPaths) {
+    std::vector<std::vector<std::string>> filePathList;
+    std::unordered_map<std::string, uint32_t> inputNameToIndex;
+    std::shared_ptr<datautil::PackedDataset> packedDataset;
+#ifndef __hexagon__
+    if (datautil::PackedDataset::isPackedDataset(path)) {
+      packedDataset = std::make_shared<datautil::PackedDataset>();
+      if (!packedDataset->open(path)) {
+        exitWithMessage("Could not map packed dataset: " + path, EXIT_FAILURE);
+      }
+    } else
+#endif
+    {
+      bool readSuccess;
+      std::tie(filePathList, inputNameToIndex, readSuccess) = readInputList(path);
+      if (!readSuccess) {
+        exitWithMessage("Could not read input lists", EXIT_FAILURE);
+      }
+    }
+    m_inputFileLists.push_back(std::move(filePathList));
+    m_inputNameToIndex.push_back(std::move(inputNameToIndex));
+    m_packedDatasets.push_back(std::move(packedDataset));
   }
   // initialize logging in the backend
   if (log::isLogInitialized()) {
@@ -316,6 +365,7 @@ sample_app::StatusCode sample_app::QnnSampleApp::initializeProfiling() {
         return StatusCode::FAILURE;
       }
     }
+    m_profilingRecorder = std::make_shared<profiling::ProfilingRecorder>();
   }
   return StatusCode::SUCCESS;
 }
@@ -328,6 +378,7 @@ int32_t sample_app::QnnSampleApp::reportError(const std::string& err) {
 
 // Initialize a QnnBackend.
 sample_app::StatusCode sample_app::QnnSampleApp::initializeBackend() {
+  TRACE_SCOPE("QnnSampleApp::initializeBackend");
   auto qnnStatus = m_qnnFunctionPointers.qnnInterface.backendCreate(
       m_logHandle, (const QnnBackend_Config_t**)m_backendConfig, &m_backendHandle);
   if (QNN_BACKEND_NO_ERROR != qnnStatus) {
@@ -392,6 +443,7 @@ sample_app::StatusCode sample_app::QnnSampleApp::registerOpPackages() {
 
 // Create a Context in a backend.
 sample_app::StatusCode sample_app::QnnSampleApp::createContext() {
+  TRACE_SCOPE("QnnSampleApp::createContext");
   if (QNN_CONTEXT_NO_ERROR !=
       m_qnnFunctionPointers.qnnInterface.contextCreate(m_backendHandle,
                                                        m_deviceHandle,
@@ -445,6 +497,7 @@ sample_app::StatusCode sample_app::QnnSampleApp::freeContext() {
 // say that all intermediate tensors including output tensors
 // are expected to be read by the app.
 sample_app::StatusCode sample_app::QnnSampleApp::composeGraphs() {
+  TRACE_SCOPE("QnnSampleApp::composeGraphs");
   auto returnStatus = StatusCode::SUCCESS;
   if (qnn_wrapper_api::ModelError_t::MODEL_NO_ERROR !=
       m_qnnFunctionPointers.composeGraphsFnHandle(
@@ -465,6 +518,7 @@ sample_app::StatusCode sample_app::QnnSampleApp::composeGraphs() {
 }
 
 sample_app::StatusCode sample_app::QnnSampleApp::finalizeGraphs() {
+  TRACE_SCOPE("QnnSampleApp::finalizeGraphs");
   for (size_t graphIdx = 0; graphIdx < m_graphsCount; graphIdx++) {
     if (QNN_GRAPH_NO_ERROR !=
         m_qnnFunctionPointers.qnnInterface.graphFinalize(
@@ -486,6 +540,7 @@ sample_app::StatusCode sample_app::QnnSampleApp::finalizeGraphs() {
 }
 
 sample_app::StatusCode sample_app::QnnSampleApp::contextApplyBinarySection(QnnContext_SectionType_t section) {
+    TRACE_SCOPE("QnnSampleApp::contextApplyBinarySection");
     sample_app::StatusCode returnStatus = sample_app::StatusCode::SUCCESS;
       for(auto loraadapter = m_lora_adapters.begin(); loraadapter != m_lora_adapters.end(); ++loraadapter){
         std::string model_name = loraadapter->m_graph_name;  
@@ -766,7 +821,19 @@ sample_app::StatusCode sample_app::QnnSampleApp::addGraphsToContext(
     return StatusCode::SUCCESS;
 }
 
+sample_app::StatusCode sample_app::QnnSampleApp::setCachedBinary(const std::string& cachedBinaryPath,
+                                                                 const std::string& systemLibraryPath) {
+  if (dynamicloadutil::StatusCode::SUCCESS !=
+      dynamicloadutil::getQnnSystemFunctionPointers(systemLibraryPath, &m_qnnFunctionPointers)) {
+    QNN_ERROR("Error initializing QNN System Function Pointers from %s", systemLibraryPath.c_str());
+    return StatusCode::FAILURE;
+  }
+  m_cachedBinaryPath = cachedBinaryPath;
+  return StatusCode::SUCCESS;
+}
+
 sample_app::StatusCode sample_app::QnnSampleApp::createFromBinary() {
+  TRACE_SCOPE("QnnSampleApp::createFromBinary");
   QNN_FUNCTION_ENTRY_LOG;
   if (m_cachedBinaryPath.empty()) {
     QNN_ERROR("No name provided to read binary file from.");
@@ -929,7 +996,12 @@ QNN_FUNCTION_EXIT_LOG;
 }
 
 sample_app::StatusCode sample_app::QnnSampleApp::saveBinary() {
-  if (m_saveBinaryName.empty()) {
+  return saveBinary(m_outputPath, m_saveBinaryName);
+}
+
+sample_app::StatusCode sample_app::QnnSampleApp::saveBinary(const std::string& outputDir,
+                                                            const std::string& binaryName) {
+  if (binaryName.empty()) {
     QNN_ERROR("No name provided to save binary file.");
     return StatusCode::FAILURE;
   }
@@ -967,7 +1039,7 @@ sample_app::StatusCode sample_app::QnnSampleApp::saveBinary() {
   }
 #ifndef __hexagon__
   auto dataUtilStatus = tools::datautil::writeBinaryToFile(
-      m_outputPath, m_saveBinaryName + ".bin", (uint8_t*)saveBuffer.get(), writtenBufferSize);
+      outputDir, binaryName + ".bin", (uint8_t*)saveBuffer.get(), writtenBufferSize);
   if (tools::datautil::StatusCode::SUCCESS != dataUtilStatus) {
     QNN_ERROR("Error while writing binary to file.");
     return StatusCode::FAILURE;
@@ -978,8 +1050,10 @@ sample_app::StatusCode sample_app::QnnSampleApp::saveBinary() {
 
 // C:\Qualcomm\AIStack\QNN\<version>\include\QNN\QnnProfile.h
 // C:\Qualcomm\AIStack\QNN\<version>\include\QNN\HTP\QnnHtpProfile.h
+// Events are copied into the profiling recorder; use getProfilingRecorder()->getStats() to
+// aggregate them. Printing each event here used to cost more than the execution itself.
 sample_app::StatusCode sample_app::QnnSampleApp::extractBackendProfilingInfo(
-    Qnn_ProfileHandle_t profileHandle) {
+    Qnn_ProfileHandle_t profileHandle, uint32_t graphIdx) {
   if (nullptr == m_profileBackendHandle) {
     QNN_ERROR("Backend Profile handle is nullptr; may not be initialized.");
     return StatusCode::FAILURE;
@@ -991,16 +1065,26 @@ sample_app::StatusCode sample_app::QnnSampleApp::extractBackendProfilingInfo(
     QNN_ERROR("Failure in profile get events.");
     return StatusCode::FAILURE;
   }
-  QNN_INFO("ProfileEvents: [%p], numEvents: [%d]", profileEvents, numEvents);
+  QNN_DEBUG("ProfileEvents: [%p], numEvents: [%d]", profileEvents, numEvents);
+  m_profilingEvents.clear();
   for (size_t event = 0; event < numEvents; event++) {
-    extractProfilingEvent(*(profileEvents + event));
-    extractProfilingSubEvents(*(profileEvents + event));
+    int32_t eventIdx = (int32_t)m_profilingEvents.size();
+    if (StatusCode::SUCCESS == extractProfilingEvent(*(profileEvents + event), graphIdx, profiling::g_noParent)) {
+      extractProfilingSubEvents(*(profileEvents + event), graphIdx, eventIdx);
+    }
+  }
+  if (0 != m_traceExecuteStartUs && trace::isEnabled()) {
+    trace::addBackendSpans(m_profilingEvents, m_traceExecuteStartUs, QNN_PROFILE_EVENTUNIT_MICROSEC);
+  }
+  m_traceExecuteStartUs = 0;
+  if (m_profilingRecorder) {
+    m_profilingRecorder->record(m_profilingEvents);
   }
   return StatusCode::SUCCESS;
 }
 
 sample_app::StatusCode sample_app::QnnSampleApp::extractProfilingSubEvents(
-    QnnProfile_EventId_t profileEventId) {
+    QnnProfile_EventId_t profileEventId, uint32_t graphIdx, int32_t parent) {
   const QnnProfile_EventId_t* profileSubEvents{nullptr};
   uint32_t numSubEvents{0};
   if (QNN_PROFILE_NO_ERROR != m_qnnFunctionPointers.qnnInterface.profileGetSubEvents(
@@ -1008,28 +1092,34 @@ sample_app::StatusCode sample_app::QnnSampleApp::extractProfilingSubEvents(
     QNN_ERROR("Failure in profile get sub events.");
     return StatusCode::FAILURE;
   }
-  QNN_INFO("ProfileSubEvents: [%p], numSubEvents: [%d]", profileSubEvents, numSubEvents);
   for (size_t subEvent = 0; subEvent < numSubEvents; subEvent++) {
-    extractProfilingEvent(*(profileSubEvents + subEvent));
-    extractProfilingSubEvents(*(profileSubEvents + subEvent));
+    int32_t eventIdx = (int32_t)m_profilingEvents.size();
+    if (StatusCode::SUCCESS == extractProfilingEvent(*(profileSubEvents + subEvent), graphIdx, parent)) {
+      extractProfilingSubEvents(*(profileSubEvents + subEvent), graphIdx, eventIdx);
+    }
   }
   return StatusCode::SUCCESS;
 }
 
 sample_app::StatusCode sample_app::QnnSampleApp::extractProfilingEvent(
-    QnnProfile_EventId_t profileEventId) {
+    QnnProfile_EventId_t profileEventId, uint32_t graphIdx, int32_t parent) {
   QnnProfile_EventData_t eventData;
   if (QNN_PROFILE_NO_ERROR !=
       m_qnnFunctionPointers.qnnInterface.profileGetEventData(profileEventId, &eventData)) {
     QNN_ERROR("Failure in profile get event type.");
     return StatusCode::FAILURE;
   }
-  QNN_INFO("Printing Event Info - Event Type: [%d], Event Value: [%" PRIu64
-            "], Event Identifier: [%s], Event Unit: [%d]",
-            eventData.type,
-            eventData.value,
-            eventData.identifier,
-            eventData.unit);
+  profiling::ProfilingRecord record{};
+  record.value    = eventData.value;
+  record.graphIdx = graphIdx;
+  record.eventIdx = (uint32_t)m_profilingEvents.size();
+  record.parent   = parent;
+  record.type     = eventData.type;
+  record.unit     = eventData.unit;
+  if (nullptr != eventData.identifier) {
+    strncpy(record.identifier, eventData.identifier, profiling::g_maxEventIdentifierLength);
+  }
+  m_profilingEvents.push_back(record);
   return StatusCode::SUCCESS;
 }
 
@@ -1103,11 +1193,80 @@ sample_app::StatusCode sample_app::QnnSampleApp::freeDevice() {
   return StatusCode::SUCCESS;
 }
 
+void sample_app::QnnSampleApp::setPipelineConfig(size_t numReaderThreads,
+                                                 size_t numWriterThreads,
+                                                 size_t prefetchDepth) {
+  m_numReaderThreads = numReaderThreads;
+  m_numWriterThreads = std::max<size_t>(numWriterThreads, 1);
+  m_prefetchDepth    = std::max<size_t>(prefetchDepth, 1);
+}
+
+void sample_app::QnnSampleApp::setAsyncOutput(bool asyncOutput,
+                                              const std::string& containerPath,
+                                              bool compress) {
+  m_asyncOutput                      = asyncOutput || !containerPath.empty() || compress;
+  m_outputWriterConfig.containerPath = containerPath;
+  m_outputWriterConfig.compress      = compress;
+}
+
+static void reportThroughput(const char* graphName,
+                             size_t numInputs,
+                             std::chrono::steady_clock::time_point startTime) {
+  double elapsedMs = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - startTime).count();
+  std::cout << "Graph " << (graphName ? graphName : "") << ": " << numInputs << " inputs in "
+            << elapsedMs << " ms, " << (elapsedMs > 0 ? numInputs * 1000.0 / elapsedMs : 0.0)
+            << " inputs/sec" << std::endl;
+}
+
+size_t sample_app::QnnSampleApp::getNumInputSamples(size_t graphIdx) {
+  if (graphIdx < m_packedDatasets.size() && nullptr != m_packedDatasets[graphIdx]) {
+    return m_packedDatasets[graphIdx]->getNumSamples();
+  }
+  auto& inputFileList = m_inputFileLists[graphIdx];
+  return inputFileList.empty() ? 0 : inputFileList[0].size();
+}
+
+iotensor::PopulateInputTensorsRetType_t sample_app::QnnSampleApp::populateInputBatch(
+    size_t graphIdx, size_t offset, Qnn_Tensor_t* inputs) {
+  TRACE_SCOPE("populateInputTensors");
+#ifndef __hexagon__
+  if (graphIdx < m_packedDatasets.size() && nullptr != m_packedDatasets[graphIdx]) {
+    return m_ioTensor.populateInputTensors((uint32_t)graphIdx,
+                                           *m_packedDatasets[graphIdx],
+                                           offset,
+                                           false,
+                                           inputs,
+                                           (*m_graphsInfo)[graphIdx],
+                                           m_inputDataType);
+  }
+#endif
+  return m_ioTensor.populateInputTensors((uint32_t)graphIdx,
+                                         m_inputFileLists[graphIdx],
+                                         offset,
+                                         false,
+                                         m_inputNameToIndex[graphIdx],
+                                         inputs,
+                                         (*m_graphsInfo)[graphIdx],
+                                         m_inputDataType);
+}
+
 // executeGraphs() that is currently used by qnn-sample-app's main.cpp.
 // This function runs all the graphs present in model.so by reading
 // inputs from input_list based files and writes output to .raw files.
 sample_app::StatusCode sample_app::QnnSampleApp::executeGraphs() {
   auto returnStatus = StatusCode::SUCCESS;
+#ifndef __hexagon__
+  std::shared_ptr<outputwriter::OutputWriter> outputWriter;
+  if (m_asyncOutput && m_dumpOutputs) {
+    outputWriter = std::make_shared<outputwriter::OutputWriter>(m_outputWriterConfig);
+    if (!outputWriter->start()) {
+      QNN_ERROR("Failed to start the output writer");
+      return StatusCode::FAILURE;
+    }
+    m_ioTensor.setOutputWriter(outputWriter);
+  }
+#endif
   for (size_t graphIdx = 0; graphIdx < m_graphsCount; graphIdx++) {
     QNN_DEBUG("Starting execution for graphIdx: %d", graphIdx);
     if (graphIdx >= m_inputFileLists.size()) {
@@ -1115,6 +1274,16 @@ sample_app::StatusCode sample_app::QnnSampleApp::executeGraphs() {
       returnStatus = StatusCode::FAILURE;
       break;
     }
+    auto startTime = std::chrono::steady_clock::now();
+    if (m_numReaderThreads > 0) {
+      size_t numInputsProcessed = 0;
+      returnStatus = executeGraphPipelined(graphIdx, numInputsProcessed);
+      reportThroughput((*m_graphsInfo)[graphIdx].graphName, numInputsProcessed, startTime);
+      if (StatusCode::SUCCESS != returnStatus) {
+        break;
+      }
+      continue;
+    }
     Qnn_Tensor_t* inputs  = nullptr;
     Qnn_Tensor_t* outputs = nullptr;
     if (iotensor::StatusCode::SUCCESS !=
@@ -1123,38 +1292,37 @@ sample_app::StatusCode sample_app::QnnSampleApp::executeGraphs() {
       returnStatus = StatusCode::FAILURE;
       break;
     }
-    auto inputFileList = m_inputFileLists[graphIdx];
-    auto graphInfo     = (*m_graphsInfo)[graphIdx];
-    if (!inputFileList.empty()) {
-      size_t totalCount           = inputFileList[0].size();
+    auto graphInfo    = (*m_graphsInfo)[graphIdx];
+    size_t totalCount = getNumInputSamples(graphIdx);
+    if (totalCount > 0) {
       size_t inputFileIndexOffset = 0;
       while (inputFileIndexOffset < totalCount) {
         iotensor::StatusCode iotReturnStatus;
         size_t numInputFilesPopulated;
         size_t batchSize;
         std::tie(iotReturnStatus, numInputFilesPopulated, batchSize) =
-            m_ioTensor.populateInputTensors(graphIdx,
-                                            inputFileList,
-                                            inputFileIndexOffset,
-                                            false,
-                                            m_inputNameToIndex[graphIdx],
-                                            inputs,
-                                            graphInfo,
-                                            m_inputDataType);
+            populateInputBatch(graphIdx, inputFileIndexOffset, inputs);
         if (iotensor::StatusCode::SUCCESS != iotReturnStatus) {
           returnStatus = StatusCode::FAILURE;
         }
         if (StatusCode::SUCCESS == returnStatus) {
           QNN_DEBUG("Successfully populated input tensors for graphIdx: %d", graphIdx);
           Qnn_ErrorHandle_t executeStatus = QNN_GRAPH_NO_ERROR;
-          executeStatus =
-              m_qnnFunctionPointers.qnnInterface.graphExecute(graphInfo.graph,
-                                                              inputs,
-                                                              graphInfo.numInputTensors,
-                                                              outputs,
-                                                              graphInfo.numOutputTensors,
-                                                              m_profileBackendHandle,
-                                                              nullptr);
+          {
+            TRACE_SCOPE("graphExecute", graphInfo.graphName);
+            m_traceExecuteStartUs = trace::isEnabled() ? trace::nowUs() : 0;
+            executeStatus =
+                m_qnnFunctionPointers.qnnInterface.graphExecute(graphInfo.graph,
+                                                                inputs,
+                                                                graphInfo.numInputTensors,
+                                                                outputs,
+                                                                graphInfo.numOutputTensors,
+                                                                m_profileBackendHandle,
+                                                                nullptr);
+          }
+          if (ProfilingLevel::OFF != m_profilingLevel) {
+            extractBackendProfilingInfo(m_profileBackendHandle, (uint32_t)graphIdx);
+          }
           if (QNN_GRAPH_NO_ERROR != executeStatus) {
             returnStatus = StatusCode::FAILURE;
           }
@@ -1183,6 +1351,7 @@ sample_app::StatusCode sample_app::QnnSampleApp::executeGraphs() {
           break;
         }
       }
+      reportThroughput(graphInfo.graphName, inputFileIndexOffset, startTime);
     }
     m_ioTensor.tearDownInputAndOutputTensors(
         inputs, outputs, graphInfo.numInputTensors, graphInfo.numOutputTensors);
@@ -1193,6 +1362,203 @@ sample_app::StatusCode sample_app::QnnSampleApp::executeGraphs() {
     }
   }
 
+#ifndef __hexagon__
+  if (nullptr != outputWriter) {
+    m_ioTensor.setOutputWriter(nullptr);
+    if (!outputWriter->close()) {
+      QNN_ERROR("Failed to write some of the outputs");
+      returnStatus = StatusCode::FAILURE;
+    }
+  }
+#endif
+  if (nullptr != m_profilingRecorder) {
+    for (auto& event : m_profilingRecorder->getStats()) {
+      QNN_INFO("Profiling graph %u %s: count %llu, min %llu, mean %.1f, p50 %llu, p99 %llu, max %llu (unit %u)",
+               event.graphIdx,
+               event.identifier.c_str(),
+               (unsigned long long)event.count,
+               (unsigned long long)event.min,
+               event.mean,
+               (unsigned long long)event.p50,
+               (unsigned long long)event.p99,
+               (unsigned long long)event.max,
+               event.unit);
+    }
+  }
+  return returnStatus;
+}
+
+namespace {
+// One set of input/output tensors travelling reader -> executor -> writer -> reader.
+struct PipelineSlot {
+  Qnn_Tensor_t* inputs          = nullptr;
+  Qnn_Tensor_t* outputs         = nullptr;
+  size_t inputFileIndexOffset   = 0;
+  size_t numInputFilesPopulated = 0;
+  size_t batchSize              = 0;
+};
+}  // namespace
+
+// Pipelined variant of the executeGraphs() loop for one graph. Reader threads fill the input
+// tensors of up to 'm_prefetchDepth' batches ahead, this thread only calls graphExecute(), and
+// writer threads dump the outputs while the next batch runs. Each batch owns its tensors, so
+// no stage waits on another unless it runs out of slots.
+sample_app::StatusCode sample_app::QnnSampleApp::executeGraphPipelined(size_t graphIdx,
+                                                                       size_t& numInputsProcessed) {
+  numInputsProcessed = 0;
+  auto& graphInfo    = (*m_graphsInfo)[graphIdx];
+  size_t totalCount = getNumInputSamples(graphIdx);
+  if (0 == totalCount) {
+    return StatusCode::SUCCESS;
+  }
+
+  // Prefetched batches, plus the one executing and the one being written.
+  std::vector<PipelineSlot> slots(m_prefetchDepth + 1 + m_numWriterThreads);
+  auto tearDownSlots = [&]() {
+    for (auto& slot : slots) {
+      if (nullptr != slot.inputs || nullptr != slot.outputs) {
+        m_ioTensor.tearDownInputAndOutputTensors(
+            slot.inputs, slot.outputs, graphInfo.numInputTensors, graphInfo.numOutputTensors);
+        slot.inputs  = nullptr;
+        slot.outputs = nullptr;
+      }
+    }
+  };
+  for (auto& slot : slots) {
+    if (iotensor::StatusCode::SUCCESS !=
+        m_ioTensor.setupInputAndOutputTensors(&slot.inputs, &slot.outputs, graphInfo)) {
+      QNN_ERROR("Error in setting up Input and output Tensors for graphIdx: %d", graphIdx);
+      tearDownSlots();
+      return StatusCode::FAILURE;
+    }
+  }
+
+  auto readBatch = [&](PipelineSlot* slot, size_t offset) {
+    iotensor::StatusCode status;
+    std::tie(status, slot->numInputFilesPopulated, slot->batchSize) =
+        populateInputBatch(graphIdx, offset, slot->inputs);
+    slot->inputFileIndexOffset = offset;
+    return iotensor::StatusCode::SUCCESS == status;
+  };
+
+  // The first batch tells how many input files one execution consumes, so batch 'n' starts
+  // at n * stride and the readers can work on batches independently.
+  if (!readBatch(&slots[0], 0) || 0 == slots[0].numInputFilesPopulated) {
+    QNN_ERROR("Failed to populate the first batch for graphIdx: %d", graphIdx);
+    tearDownSlots();
+    return StatusCode::FAILURE;
+  }
+  size_t stride     = slots[0].numInputFilesPopulated;
+  size_t numBatches = (totalCount + stride - 1) / stride;
+
+  BlockingQueue<PipelineSlot*> freeSlots;
+  BlockingQueue<PipelineSlot*> readySlots;
+  BlockingQueue<PipelineSlot*> doneSlots;
+  readySlots.push(&slots[0]);
+  for (size_t i = 1; i < slots.size(); i++) {
+    freeSlots.push(&slots[i]);
+  }
+
+  std::atomic<size_t> nextBatch{1};
+  std::atomic<bool> failed{false};
+  // The last reader to exit closes readySlots, whether the batches are all read or a stage failed, so the
+  // executor never waits on it with nobody left to push.
+  std::atomic<size_t> liveReaders{m_numReaderThreads};
+
+  std::vector<std::thread> readers;
+  for (size_t i = 0; i < m_numReaderThreads; i++) {
+    readers.emplace_back([&]() {
+      PipelineSlot* slot = nullptr;
+      while (!failed.load()) {
+        size_t batch = nextBatch.fetch_add(1);
+        if (batch >= numBatches || !freeSlots.pop(slot)) {
+          break;
+        }
+        size_t offset   = batch * stride;
+        size_t expected = std::min(stride, totalCount - offset);
+        if (!readBatch(slot, offset) || slot->numInputFilesPopulated != expected) {
+          QNN_ERROR("Failed to populate batch at input offset %zu for graphIdx: %d", offset, graphIdx);
+          failed.store(true);
+          readySlots.close();
+          break;
+        }
+        readySlots.push(slot);
+      }
+      if (1 == liveReaders.fetch_sub(1)) {
+        readySlots.close();
+      }
+    });
+  }
+
+  std::vector<std::thread> writers;
+  for (size_t i = 0; i < m_numWriterThreads; i++) {
+    writers.emplace_back([&]() {
+      PipelineSlot* slot = nullptr;
+      while (doneSlots.pop(slot)) {
+#ifndef __hexagon__
+        if (iotensor::StatusCode::SUCCESS !=
+            m_ioTensor.writeOutputTensors((uint32_t)graphIdx,
+                                          slot->inputFileIndexOffset,
+                                          graphInfo.graphName,
+                                          slot->outputs,
+                                          graphInfo.numOutputTensors,
+                                          m_outputDataType,
+                                          m_graphsCount,
+                                          m_outputPath,
+                                          slot->numInputFilesPopulated,
+                                          slot->batchSize)) {
+          failed.store(true);
+        }
+#endif
+        freeSlots.push(slot);
+      }
+    });
+  }
+
+  auto returnStatus = StatusCode::SUCCESS;
+  for (size_t batch = 0; batch < numBatches && !failed.load(); batch++) {
+    PipelineSlot* slot = nullptr;
+    if (!readySlots.pop(slot)) {
+      break;
+    }
+    Qnn_ErrorHandle_t executeStatus;
+    {
+      TRACE_SCOPE("graphExecute", graphInfo.graphName);
+      m_traceExecuteStartUs = trace::isEnabled() ? trace::nowUs() : 0;
+      executeStatus = m_qnnFunctionPointers.qnnInterface.graphExecute(graphInfo.graph,
+                                                                      slot->inputs,
+                                                                      graphInfo.numInputTensors,
+                                                                      slot->outputs,
+                                                                      graphInfo.numOutputTensors,
+                                                                      m_profileBackendHandle,
+                                                                      nullptr);
+    }
+    if (QNN_GRAPH_NO_ERROR != executeStatus) {
+      QNN_ERROR("Execution of Graph: %d failed!", graphIdx);
+      failed.store(true);
+      break;
+    }
+    if (ProfilingLevel::OFF != m_profilingLevel) {
+      extractBackendProfilingInfo(m_profileBackendHandle, (uint32_t)graphIdx);
+    }
+    numInputsProcessed += slot->numInputFilesPopulated;
+    doneSlots.push(slot);
+  }
+
+  doneSlots.close();
+  for (auto& writer : writers) {
+    writer.join();
+  }
+  failed.store(failed.load() || numInputsProcessed < totalCount);
+  freeSlots.close();
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  tearDownSlots();
+
+  if (failed.load()) {
+    returnStatus = StatusCode::FAILURE;
+  }
   return returnStatus;
 }
 
@@ -1225,6 +1591,7 @@ void bufferToFile(std::vector<uint8_t*>& buffers, std::vector<size_t>& size, std
 // improve performance.
 sample_app::StatusCode sample_app::QnnSampleApp::setupInputAndOutputTensors()
 {
+  TRACE_SCOPE("QnnSampleApp::setupInputAndOutputTensors");
   auto returnStatus = qnn::tools::iotensor::StatusCode::SUCCESS;
 
   for (size_t graphIdx = 0; graphIdx < m_graphsCount; graphIdx++) {
@@ -1262,15 +1629,71 @@ sample_app::StatusCode sample_app::QnnSampleApp::tearDownInputAndOutputTensors()
   return static_cast<sample_app::StatusCode>(returnStatus);
 }
 
+sample_app::StatusCode sample_app::QnnSampleApp::warmup(size_t count,
+                                                        bool randomInputs,
+                                                        std::vector<double>& latencyMs) {
+  TRACE_SCOPE("QnnSampleApp::warmup");
+  latencyMs.clear();
+  for (size_t graphIdx = 0; graphIdx < m_graphsCount; graphIdx++) {
+    auto& graphInfo = (*m_graphsInfo)[graphIdx];
+    if (nullptr == graphInfo.m_inputs || nullptr == graphInfo.m_outputs) {
+      QNN_ERROR("Input and output tensors of graphIdx %d are not set up", graphIdx);
+      return StatusCode::FAILURE;
+    }
+    if (randomInputs) {
+      if (iotensor::StatusCode::SUCCESS !=
+          m_ioTensor.populateInputTensorsWithRandValues((uint32_t)graphIdx, graphInfo.m_inputs, graphInfo)) {
+        return StatusCode::FAILURE;
+      }
+    } else {
+      std::vector<size_t> inputSize;
+      if (iotensor::StatusCode::SUCCESS !=
+          m_ioTensor.getTensorsSize(&graphInfo.m_inputs, graphInfo.numInputTensors, graphInfo.inputTensors, inputSize)) {
+        return StatusCode::FAILURE;
+      }
+      for (size_t inputIdx = 0; inputIdx < inputSize.size(); inputIdx++) {
+        memset(QNN_TENSOR_GET_CLIENT_BUF(graphInfo.m_inputs[inputIdx]).data, 0, inputSize[inputIdx]);
+      }
+    }
+  }
+
+  for (size_t run = 0; run < count; run++) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t graphIdx = 0; graphIdx < m_graphsCount; graphIdx++) {
+      auto& graphInfo = (*m_graphsInfo)[graphIdx];
+      Qnn_ErrorHandle_t executeStatus =
+          m_qnnFunctionPointers.qnnInterface.graphExecute(graphInfo.graph,
+                                                          graphInfo.m_inputs,
+                                                          graphInfo.numInputTensors,
+                                                          graphInfo.m_outputs,
+                                                          graphInfo.numOutputTensors,
+                                                          m_profileBackendHandle,
+                                                          nullptr);
+      if (QNN_GRAPH_NO_ERROR != executeStatus) {
+        QNN_ERROR("Warmup execution %zu of graphIdx %d failed", run, graphIdx);
+        return StatusCode::FAILURE;
+      }
+    }
+    latencyMs.push_back(
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+  }
+  return StatusCode::SUCCESS;
+}
+
 sample_app::StatusCode sample_app::QnnSampleApp::executeGraphsBuffers(std::vector<uint8_t*>& inputBuffers, 
                                                                                std::vector<uint8_t*>& outputBuffers, std::vector<size_t>& outputSize,
-                                                                               std::string perfProfile) {
+                                                                               std::string perfProfile,
+                                                                               const std::vector<std::string>& inputDataTypes,
+                                                                               bool nativeOutputs, bool callerOutputs) {
   auto returnStatus = StatusCode::SUCCESS;
+  uint64_t inputConversionUs = 0, executeUs = 0, outputConversionUs = 0;
   
   // We push '12345' to 'outputSize' in function 'ModelRun@main.cpp@SvcQNNHelpper.exe'. In this case, share memory will not be freed, we can use the share memory as output buffer directly.
   bool shareMemory = false;
   uint8_t* pShareBuffer = inputBuffers[0];
-  if (outputSize.size() == 1 && outputSize[0] == 12345) {
+  size_t outputCount = 0;   // Outputs of the graphs so far.
+  size_t firstOutput = outputBuffers.size();   // Buffers from here on are malloc'd by this call.
+  if (!callerOutputs && outputSize.size() == 1 && outputSize[0] == 12345) {
       shareMemory = true;
       outputSize.clear();
 
@@ -1300,9 +1723,15 @@ sample_app::StatusCode sample_app::QnnSampleApp::executeGraphsBuffers(std::vecto
       //while (!inputFileList[0].empty()) 
       {
           size_t startIdx = 0;  // (totalCount - inputFileList[0].size());
-          if (iotensor::StatusCode::SUCCESS !=
-            m_ioTensor.populateInputTensors((uint32_t)graphIdx, inputBuffers, inputs, graphInfo, m_inputDataType)) {
-            returnStatus = StatusCode::FAILURE;
+          {
+            TRACE_SCOPE("populateInputTensors");
+            latency::ScopedStageTimer stageTimer(inputConversionUs);
+            std::vector<bool> nativeInputs;
+            if (StatusCode::SUCCESS != getNativeInputs(inputs, graphInfo.numInputTensors, inputDataTypes, nativeInputs) ||
+                iotensor::StatusCode::SUCCESS !=
+              m_ioTensor.populateInputTensors((uint32_t)graphIdx, inputBuffers, inputs, graphInfo, m_inputDataType, nativeInputs)) {
+              returnStatus = StatusCode::FAILURE;
+            }
           }
 
 #ifdef DEBUG_INFERENCE
@@ -1320,21 +1749,26 @@ sample_app::StatusCode sample_app::QnnSampleApp::executeGraphsBuffers(std::vecto
             QNN_ERROR("Performance boost failure");
           }
 
-          executeStatus =
-              m_qnnFunctionPointers.qnnInterface.graphExecute(graphInfo.graph,
-                                                              inputs,
-                                                              graphInfo.numInputTensors,
-                                                              outputs,
-                                                              graphInfo.numOutputTensors,
-                                                              m_profileBackendHandle,
-                                                              nullptr);
+          {
+            TRACE_SCOPE("graphExecute", graphInfo.graphName);
+            latency::ScopedStageTimer stageTimer(executeUs);
+            m_traceExecuteStartUs = trace::isEnabled() ? trace::nowUs() : 0;
+            executeStatus =
+                m_qnnFunctionPointers.qnnInterface.graphExecute(graphInfo.graph,
+                                                                inputs,
+                                                                graphInfo.numInputTensors,
+                                                                outputs,
+                                                                graphInfo.numOutputTensors,
+                                                                m_profileBackendHandle,
+                                                                nullptr);
+          }
 
           if (false == m_runInCpu && "default" != perfProfile && false == resetPerformance(m_perfInfra)) {
             QNN_ERROR("Performance reset failure");
           }
 
           if (ProfilingLevel::OFF != m_profilingLevel) {
-            extractBackendProfilingInfo(m_profileBackendHandle);
+            extractBackendProfilingInfo(m_profileBackendHandle, (uint32_t)graphIdx);
           }
 
           if (QNN_GRAPH_NO_ERROR != executeStatus) {
@@ -1343,6 +1777,8 @@ sample_app::StatusCode sample_app::QnnSampleApp::executeGraphsBuffers(std::vecto
 
           if (StatusCode::SUCCESS == returnStatus) {
             QNN_DEBUG("Successfully executed graphIdx: %d ", graphIdx);
+            TRACE_SCOPE("convertOutputTensors");
+            latency::ScopedStageTimer stageTimer(outputConversionUs);
 
             // populate output buffer directly
             size_t offset = 0;
@@ -1353,6 +1789,9 @@ sample_app::StatusCode sample_app::QnnSampleApp::executeGraphsBuffers(std::vecto
                 m_ioTensor.fillDims(dims, QNN_TENSOR_GET_DIMENSIONS(outputs[outputIdx]), QNN_TENSOR_GET_RANK(outputs[outputIdx]));
                 size_t elementCount = datautil::calculateElementCount(dims);
                 size_t size = elementCount * (sizeof(float) / sizeof(uint8_t));
+                if (nativeOutputs) {
+                    std::tie(std::ignore, size) = datautil::calculateLength(dims, QNN_TENSOR_GET_DATA_TYPE(outputs[outputIdx]));
+                }
                 uint8_t* buffer = nullptr;
 
                 float* floatBuffer = nullptr;
@@ -1360,12 +1799,25 @@ sample_app::StatusCode sample_app::QnnSampleApp::executeGraphsBuffers(std::vecto
                     floatBuffer = (float*)(pShareBuffer + offset);
                     offset += size;
                 }
+                else if (callerOutputs) {
+                    if (outputCount >= outputBuffers.size() || outputCount >= outputSize.size() || outputSize[outputCount] < size) {
+                        QNN_ERROR("Output buffer %zu is missing or smaller than %zu bytes.", outputCount, size);
+                        returnStatus = StatusCode::FAILURE;
+                        break;
+                    }
+                    floatBuffer = (float*)outputBuffers[outputCount];
+                }
 
-                if (QNN_TENSOR_GET_DATA_TYPE(outputs[outputIdx]) == QNN_DATATYPE_FLOAT_32) {
-                    QNN_DEBUG("Writing in output->dataType == QNN_DATATYPE_FLOAT_32");
-                    // Run the model in CPU.
+                if (nativeOutputs || QNN_TENSOR_GET_DATA_TYPE(outputs[outputIdx]) == QNN_DATATYPE_FLOAT_32) {
+                    QNN_DEBUG("Writing in output->dataType == QNN_DATATYPE_FLOAT_32 or native output");
+                    // Run the model in CPU, or the caller takes the native data.
                     if (!floatBuffer) {
                         floatBuffer = (float*)malloc(size);
+                        if (!floatBuffer) {
+                            QNN_ERROR("Failed to allocate %zu bytes for output %zu.", size, outputIdx);
+                            returnStatus = StatusCode::FAILURE;
+                            break;
+                        }
                     }
                     memcpy(floatBuffer, reinterpret_cast<uint8_t*>(QNN_TENSOR_GET_CLIENT_BUF(&(outputs[outputIdx])).data), size);
                     buffer = reinterpret_cast<uint8_t*>(floatBuffer);
@@ -1376,7 +1828,11 @@ sample_app::StatusCode sample_app::QnnSampleApp::executeGraphsBuffers(std::vecto
                     auto ioReturnStatus = m_ioTensor.convertToFloat(&floatBuffer, &outputs[outputIdx]);
                     if (iotensor::StatusCode::SUCCESS != ioReturnStatus) {
                         QNN_ERROR("failure in convertToFloat");
-                        return StatusCode::FAILURE;
+                        if (!shareMemory && !callerOutputs) {
+                            free(floatBuffer);      // Allocated by convertToFloat().
+                        }
+                        returnStatus = StatusCode::FAILURE;
+                        break;
                     }
                     buffer = reinterpret_cast<uint8_t*>(floatBuffer);
                 }
@@ -1391,9 +1847,13 @@ sample_app::StatusCode sample_app::QnnSampleApp::executeGraphsBuffers(std::vecto
                     // TODO: handle float and native case.
                 }
 
-                if (buffer) {
+                if (buffer && callerOutputs) {
+                    outputSize[outputCount++] = size;
+                }
+                else if (buffer) {
                     outputBuffers.push_back(buffer);
                     outputSize.push_back(size);
+                    outputCount++;
                 }
             }
             // QNN_ERROR("output buffer size: %d\n", outputBuffers.size());
@@ -1412,9 +1872,63 @@ sample_app::StatusCode sample_app::QnnSampleApp::executeGraphsBuffers(std::vecto
     }
   }
 
+  if (nullptr != m_stageHistograms && StatusCode::SUCCESS == returnStatus) {
+    m_stageHistograms->inputConversion.record(inputConversionUs);
+    m_stageHistograms->execute.record(executeUs);
+    m_stageHistograms->outputConversion.record(outputConversionUs);
+  }
+
+  // A failed call returns no outputs: free what the graphs before the failure produced.
+  if (StatusCode::SUCCESS != returnStatus && !shareMemory && !callerOutputs) {
+    for (size_t i = firstOutput; i < outputBuffers.size(); i++) {
+      free(outputBuffers[i]);
+    }
+    outputBuffers.resize(std::min(firstOutput, outputBuffers.size()));
+    outputSize.resize(std::min(firstOutput, outputSize.size()));
+  }
+
   return returnStatus;
 }
 
+sample_app::StatusCode sample_app::QnnSampleApp::getNativeInputs(const Qnn_Tensor_t* inputs,
+                                                                 uint32_t numInputs,
+                                                                 const std::vector<std::string>& inputDataTypes,
+                                                                 std::vector<bool>& nativeInputs) {
+  nativeInputs.assign(numInputs, false);
+  for (size_t inputIdx = 0; inputIdx < inputDataTypes.size() && inputIdx < numInputs; inputIdx++) {
+    std::string tensorDataType = datautil::getDataTypeName(QNN_TENSOR_GET_DATA_TYPE(inputs[inputIdx]));
+    if (inputDataTypes[inputIdx] == tensorDataType) {
+      nativeInputs[inputIdx] = true;
+    } else if (inputDataTypes[inputIdx] != "float32") {
+      QNN_ERROR("Input %zu is %s, the model takes %s or float32.",
+                inputIdx, inputDataTypes[inputIdx].c_str(), tensorDataType.c_str());
+      return StatusCode::FAILURE;
+    }
+  }
+  return StatusCode::SUCCESS;
+}
+
+sample_app::StatusCode sample_app::QnnSampleApp::getIOTensors(std::vector<const Qnn_Tensor_t*>& inputs,
+                                                              std::vector<const Qnn_Tensor_t*>& outputs) {
+  inputs.clear();
+  outputs.clear();
+  if (nullptr == m_graphsInfo || 0 == m_graphsCount) {
+    QNN_ERROR("No graph available to query the tensors.");
+    return StatusCode::FAILURE;
+  }
+
+  for (size_t inputIdx = 0; inputIdx < (*m_graphsInfo)[0].numInputTensors; inputIdx++) {
+    inputs.push_back(&(*m_graphsInfo)[0].inputTensors[inputIdx]);
+  }
+  for (size_t graphIdx = 0; graphIdx < m_graphsCount; graphIdx++) {
+    auto& graphInfo = (*m_graphsInfo)[graphIdx];
+    for (size_t outputIdx = 0; outputIdx < graphInfo.numOutputTensors; outputIdx++) {
+      outputs.push_back(&graphInfo.outputTensors[outputIdx]);
+    }
+  }
+  return StatusCode::SUCCESS;
+}
+
 // zw.
 sample_app::StatusCode sample_app::QnnSampleApp::freeGraphs() {
   qnn_wrapper_api::freeGraphsInfo(&m_graphsInfo, m_graphsCount);
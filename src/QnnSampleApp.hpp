@@ -11,6 +11,8 @@
 #include <queue>
 
 #include "IOTensor.hpp"
+#include "LatencyHistogram.hpp"
+#include "ProfilingRecorder.hpp"
 #include "SampleApp.hpp"
 #include "Lora.hpp"
 
@@ -78,12 +80,27 @@ class QnnSampleApp {
 
   StatusCode executeGraphs();
 
+  // Threads used by executeGraphs() to read inputs ahead of execution and to write outputs
+  // behind it. Zero reader threads keeps the serial read -> execute -> write loop.
+  void setPipelineConfig(size_t numReaderThreads, size_t numWriterThreads, size_t prefetchDepth);
+
+  // Writes the outputs of executeGraphs() from background threads. A non-empty container path
+  // writes all outputs into that one file instead of a directory tree of .raw files.
+  void setAsyncOutput(bool asyncOutput, const std::string& containerPath, bool compress);
+
   StatusCode registerOpPackages();
 
   StatusCode createFromBinary();
 
   StatusCode saveBinary();
 
+  // Serializes the context to 'outputDir'/'binaryName'.bin.
+  StatusCode saveBinary(const std::string& outputDir, const std::string& binaryName);
+
+  // Switches an app created for a model library over to loading 'cachedBinaryPath' with
+  // createFromBinary(), loading the system library it needs.
+  StatusCode setCachedBinary(const std::string& cachedBinaryPath, const std::string& systemLibraryPath);
+
   StatusCode freeContext();
 
   StatusCode terminateBackend();
@@ -93,6 +110,11 @@ class QnnSampleApp {
 
   std::string getBackendBuildId();
 
+  // What a composed context depends on besides the model library and the backend: the op packages and
+  // LoRA adapters, and whether backend or context configs are set. 'files' receives the op package
+  // libraries and adapter binaries, whose changes the context cache has to notice too.
+  std::string getContextCacheConfig(std::vector<std::string>& files);
+
   StatusCode isDevicePropertySupported();
 
   StatusCode isFinalizeDeserializedGraphSupported();
@@ -142,9 +164,23 @@ class QnnSampleApp {
   StatusCode tearDownInputAndOutputTensors();
 
 // zw.
+  // 'inputDataTypes' has the data type name of each input buffer, see datautil::getDataTypeName(). A buffer in the
+  // data type of its input is copied as it is, a "float32" one is converted. Empty means all float32.
+  // 'nativeOutputs' keeps the outputs in their data type instead of converting them to float32.
+  // 'callerOutputs': 'outputBuffers' has a buffer of 'outputSize' bytes for each output, the outputs are written there
+  // and 'outputSize' is set to their sizes. Otherwise the outputs are in buffers allocated with malloc().
   StatusCode executeGraphsBuffers(std::vector<uint8_t*>& inputBuffers,
                                   std::vector<uint8_t*>& outputBuffers, std::vector<size_t>& outputSize,
-                                  std::string perfProfile);
+                                  std::string perfProfile,
+                                  const std::vector<std::string>& inputDataTypes = std::vector<std::string>(),
+                                  bool nativeOutputs = false, bool callerOutputs = false);
+
+  // Tensors behind the buffers of executeGraphsBuffers(): the inputs of the first graph, the outputs of every graph.
+  StatusCode getIOTensors(std::vector<const Qnn_Tensor_t*>& inputs, std::vector<const Qnn_Tensor_t*>& outputs);
+
+  // Runs every graph 'count' times on zero (or random) inputs, using the tensors allocated by
+  // setupInputAndOutputTensors(), and returns the latency of each run in ms.
+  StatusCode warmup(size_t count, bool randomInputs, std::vector<double>& latencyMs);
 
   StatusCode initializeLog();
   StatusCode setLogLevel(QnnLog_Level_t logLevel);
@@ -152,14 +188,40 @@ class QnnSampleApp {
   StatusCode initializePerformance();
   StatusCode destroyPerformance();
 
+  // Records of the backend profiling events, nullptr unless profiling is enabled.
+  std::shared_ptr<profiling::ProfilingRecorder> getProfilingRecorder() { return m_profilingRecorder; }
+
+  // executeGraphsBuffers() records its input conversion, execute and output conversion times here.
+  void setStageHistograms(std::shared_ptr<latency::StageHistograms> histograms) {
+    m_stageHistograms = histograms;
+  }
+
   virtual ~QnnSampleApp();
 
  private:
-  StatusCode extractBackendProfilingInfo(Qnn_ProfileHandle_t profileHandle);
+  StatusCode extractBackendProfilingInfo(Qnn_ProfileHandle_t profileHandle,
+                                         uint32_t graphIdx = profiling::g_noGraph);
+
+  StatusCode extractProfilingSubEvents(QnnProfile_EventId_t profileEventId, uint32_t graphIdx, int32_t parent);
+
+  StatusCode extractProfilingEvent(QnnProfile_EventId_t profileEventId, uint32_t graphIdx, int32_t parent);
+
+  StatusCode executeGraphPipelined(size_t graphIdx, size_t& numInputsProcessed);
 
-  StatusCode extractProfilingSubEvents(QnnProfile_EventId_t profileEventId);
+  // Number of samples available for a graph, from its input list or its packed dataset.
+  size_t getNumInputSamples(size_t graphIdx);
 
-  StatusCode extractProfilingEvent(QnnProfile_EventId_t profileEventId);
+  // Which buffers of executeGraphsBuffers() are in the data type of their input. Fails on a data type which is
+  // neither that one nor float32.
+  StatusCode getNativeInputs(const Qnn_Tensor_t* inputs,
+                             uint32_t numInputs,
+                             const std::vector<std::string>& inputDataTypes,
+                             std::vector<bool>& nativeInputs);
+
+  // Fills 'inputs' with the batch starting at sample 'offset' of the graph's inputs.
+  iotensor::PopulateInputTensorsRetType_t populateInputBatch(size_t graphIdx,
+                                                             size_t offset,
+                                                             Qnn_Tensor_t* inputs);
   
   static const std::string s_defaultOutputPath;
 
@@ -167,6 +229,8 @@ class QnnSampleApp {
   std::vector<std::string> m_inputListPaths;
   std::vector<std::vector<std::vector<std::string>>> m_inputFileLists;
   std::vector<std::unordered_map<std::string, uint32_t>> m_inputNameToIndex;
+  // Memory-mapped datasets for the input lists given as .qaipack files, nullptr for text lists.
+  std::vector<std::shared_ptr<datautil::PackedDataset>> m_packedDatasets;
   std::vector<std::string> m_opPackagePaths;
   std::string m_outputPath;
   std::string m_saveBinaryName;
@@ -196,11 +260,22 @@ class QnnSampleApp {
   std::vector<qnn_wrapper_api::GraphInfo_t*> m_graphInfoPtrList;
   bool m_useMmap;
   ProfilingOption m_profilingOption;
+  std::shared_ptr<profiling::ProfilingRecorder> m_profilingRecorder;
+  std::vector<profiling::ProfilingRecord> m_profilingEvents;  // Events of the request being extracted.
+  uint64_t m_traceExecuteStartUs = 0;  // Start of the graphExecute() whose events get extracted next.
+  std::shared_ptr<latency::StageHistograms> m_stageHistograms;
 
   // zw.
   uint32_t m_powerConfigId = 1;
   QnnHtpDevice_PerfInfrastructure_t m_perfInfra = {nullptr};
   bool m_runInCpu = true;
+
+  size_t m_numReaderThreads = 0;
+  size_t m_numWriterThreads = 1;
+  size_t m_prefetchDepth    = 2;
+
+  bool m_asyncOutput = false;
+  outputwriter::OutputWriterConfig m_outputWriterConfig;
 };
 }  // namespace sample_app
 }  // namespace tools
@@ -8,30 +8,34 @@
 
 #pragma once
 
+#ifdef _WIN32
 #include <windows.h>
 #include <psapi.h>
-#include <iostream>
-#include <fstream>
 #include <direct.h>
 #include <process.h>
 #include <winbase.h>
+#endif
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 
 #include "LibAppBuilder.hpp"
+#include "PAL/SharedMemory.hpp"
 
 
 #define PRINT_MEMINFO (0)
 
-typedef struct ShareMemInfo {
-    size_t size;
-    HANDLE hCreateMapFile;
-    LPVOID lpBase;
-} ShareMemInfo_t;
+typedef pal::SharedMemory ShareMemInfo_t;
 
-std::unordered_map<std::string, ShareMemInfo_t*> sg_share_mem_map;
+// Looked up by inferences on any thread while others create and delete share memories. An inference holds its
+// entry, so a share memory deleted meanwhile stays mapped until the inference is done.
+std::mutex sg_share_mem_mutex;
+std::unordered_map<std::string, std::shared_ptr<ShareMemInfo_t>> sg_share_mem_map;
 
-BOOL Print_MemInfo(std::string TAG) {
-#if PRINT_MEMINFO
+bool Print_MemInfo(std::string TAG) {
+#if PRINT_MEMINFO && defined(_WIN32)
     /*
     MEMORYSTATUSEX memInfo;
     memInfo.dwLength = sizeof(MEMORYSTATUSEX);
@@ -60,12 +64,12 @@ BOOL Print_MemInfo(std::string TAG) {
     return true;
 }
 
-ShareMemInfo_t* FindShareMem(std::string share_memory_name) {
+std::shared_ptr<ShareMemInfo_t> FindShareMem(std::string share_memory_name) {
+    std::lock_guard<std::mutex> lock(sg_share_mem_mutex);
     auto it = sg_share_mem_map.find(share_memory_name);
     if (it != sg_share_mem_map.end()) {
         if (it->second) {
-            auto pShareMemInfo = it->second;
-            return pShareMemInfo;
+            return it->second;
         }
     }
 
@@ -73,50 +77,38 @@ ShareMemInfo_t* FindShareMem(std::string share_memory_name) {
     return nullptr;
 }
 
-BOOL CreateShareMem(std::string share_memory_name, size_t share_memory_size) {
-    DWORD size = (DWORD)share_memory_size;
-    HANDLE hCreateMapFile = nullptr;
-    LPVOID lpBase = nullptr;
-    ShareMemInfo_t* pShareMemInfo = nullptr;
-
-    hCreateMapFile = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, 
-                                        size, share_memory_name.c_str());
-
-    if(hCreateMapFile) {
-        lpBase = MapViewOfFile(hCreateMapFile, FILE_MAP_ALL_ACCESS, 0, 0, size);
+bool CreateShareMem(std::string share_memory_name, size_t share_memory_size) {
+    std::lock_guard<std::mutex> lock(sg_share_mem_mutex);
+    // Creating it again would replace the region the Svc processes have mapped.
+    auto it = sg_share_mem_map.find(share_memory_name);
+    if (it != sg_share_mem_map.end()) {
+        if (it->second->size() == share_memory_size) {
+            QNN_WAR("CreateShareMem::Share memory %s exists, using it.\n", share_memory_name.c_str());
+            return true;
+        }
+        QNN_ERR("CreateShareMem::Share memory %s exists with another size.\n", share_memory_name.c_str());
+        return false;
     }
 
-    if (lpBase) {
-        pShareMemInfo = (ShareMemInfo_t*)malloc(sizeof(ShareMemInfo_t));
-        if (pShareMemInfo) {
-            pShareMemInfo->size = share_memory_size;
-            pShareMemInfo->hCreateMapFile = hCreateMapFile;
-            pShareMemInfo->lpBase = lpBase;
+    std::unique_ptr<ShareMemInfo_t> pShareMemInfo(new ShareMemInfo_t());
 
-            sg_share_mem_map.insert(std::make_pair(share_memory_name, pShareMemInfo));
-            QNN_INF("CreateShareMem::Count = %d\n", (int)sg_share_mem_map.size());
-            return true;
-        }
+    if (pShareMemInfo->create(share_memory_name, share_memory_size)) {
+        pShareMemInfo->prefault();
+        sg_share_mem_map[share_memory_name] = std::move(pShareMemInfo);
+        QNN_INF("CreateShareMem::Count = %d\n", (int)sg_share_mem_map.size());
+        return true;
     }
 
     QNN_ERR("CreateShareMem::create failed.\n");
     return false;
 }
 
-BOOL DeleteShareMem(std::string share_memory_name) {
-    ShareMemInfo_t* pShareMemInfo = FindShareMem(share_memory_name);
-    if (!pShareMemInfo) {
+bool DeleteShareMem(std::string share_memory_name) {
+    std::lock_guard<std::mutex> lock(sg_share_mem_mutex);
+    if (!sg_share_mem_map.erase(share_memory_name)) {      // Unmaps the memory once no inference holds it.
         QNN_ERR("DeleteShareMem::Cant find this share memory %s.\n", share_memory_name.c_str());
         return false;
     }
-    else {
-        UnmapViewOfFile(pShareMemInfo->lpBase);
-        CloseHandle(pShareMemInfo->hCreateMapFile);
-        sg_share_mem_map.erase(share_memory_name);
-        free(pShareMemInfo);
-        QNN_INF("DeleteShareMem::Count = %d\n", (int)sg_share_mem_map.size());
-        return true;
-    }
-
-    return false;
+    QNN_INF("DeleteShareMem::Count = %d\n", (int)sg_share_mem_map.size());
+    return true;
 }
@@ -0,0 +1,192 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+#pragma once
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "LibAppBuilder.hpp"
+#include "PAL/SharedMemory.hpp"
+
+/*
+ * Share memory arena of the application for remote inferences without a named share memory. It is made of
+ * segments, share memories named "<arena name>.<segment index>" which the Svc opens when it first sees them.
+ * Each segment is cut into 1 to 64 slots of one size, a power of two; a bitmap of the free slots lets threads
+ * allocate and free slots without a lock. Only growing the arena by a segment takes a lock. A buffer is described
+ * to the Svc by its arena offset: the segment index above SVC_ARENA_SEGMENT_SHIFT, the offset in the segment below.
+ */
+
+#define SVC_ARENA_MIN_SLOT_SIZE     (64 * 1024)
+#define SVC_ARENA_SEGMENT_SIZE      (32 * 1024 * 1024)      // Segments of small slots hold up to this much.
+#define SVC_ARENA_MAX_SLOTS         64                      // Slots of one segment, the bits of its bitmap.
+#define SVC_ARENA_SIZE_CLASSES      32                      // Slot sizes SVC_ARENA_MIN_SLOT_SIZE << 0..31.
+#define SVC_ARENA_CLASS_SEGMENTS    64                      // Segments per slot size.
+#define SVC_ARENA_MAX_SEGMENTS      (SVC_ARENA_SIZE_CLASSES * SVC_ARENA_CLASS_SEGMENTS)
+
+typedef struct ArenaSegment {
+    pal::SharedMemory memory;
+    uint32_t index = 0;                     // In the name and the arena offsets of the segment.
+    size_t slotSize = 0;
+    uint32_t slotCount = 0;
+    uint64_t slotMask = 0;                  // One bit for each slot.
+    std::atomic<uint64_t> used{0};          // Bit i is set while slot i is allocated.
+} ArenaSegment_t;
+
+// The segments of one slot size, 'count' is published after the segment it counts.
+typedef struct ArenaSizeClass {
+    std::atomic<uint32_t> count{0};
+    ArenaSegment_t* segments[SVC_ARENA_CLASS_SEGMENTS] = {};
+} ArenaSizeClass_t;
+
+// An allocated slot.
+typedef struct ArenaSlice {
+    ArenaSegment_t* segment = nullptr;
+    uint32_t slot = 0;
+    uint8_t* data = nullptr;
+    size_t size = 0;
+} ArenaSlice_t;
+
+typedef struct ShareMemArena {
+    std::string name;
+    std::mutex growMutex;                   // Adding a segment.
+    ArenaSizeClass_t classes[SVC_ARENA_SIZE_CLASSES];
+    std::atomic<uint32_t> segmentCount{0};  // Published after 'segments[segmentCount - 1]'.
+    ArenaSegment_t* segments[SVC_ARENA_MAX_SEGMENTS] = {};
+    std::unique_ptr<ArenaSegment_t> owned[SVC_ARENA_MAX_SEGMENTS];
+} ShareMemArena_t;
+
+std::string ArenaSegmentName(const std::string& arena_name, uint64_t index) {
+    return arena_name + "." + std::to_string(index);
+}
+
+// The arena of this process, created on first use.
+ShareMemArena_t* GetShareMemArena() {
+    static ShareMemArena_t arena;
+    static std::once_flag nameOnce;
+    std::call_once(nameOnce, [] {
+#ifdef _WIN32
+        arena.name = "QAIAppArena_" + std::to_string(GetCurrentProcessId());
+#else
+        arena.name = "QAIAppArena_" + std::to_string(getpid());
+#endif
+    });
+    return &arena;
+}
+
+// Take a free slot of 'pSegment', returns false if it has none.
+bool ArenaTakeSlot(ArenaSegment_t* pSegment, ArenaSlice_t& slice) {
+    uint64_t used = pSegment->used.load(std::memory_order_relaxed);
+    for (;;) {
+        uint64_t free = ~used & pSegment->slotMask;
+        if (!free) {
+            return false;
+        }
+        uint32_t slot = 0;
+        while (!((free >> slot) & 1)) {
+            slot++;
+        }
+        if (pSegment->used.compare_exchange_weak(used, used | (1ull << slot), std::memory_order_acquire)) {
+            slice.segment = pSegment;
+            slice.slot = slot;
+            slice.data = pSegment->memory.data() + slot * pSegment->slotSize;
+            slice.size = pSegment->slotSize;
+            return true;
+        }
+    }
+}
+
+// Allocate a slice of at least 'size' bytes, the arena grows when the slots of that size are all taken.
+bool ArenaAllocate(ShareMemArena_t* pArena, size_t size, ArenaSlice_t& slice) {
+    uint32_t sizeClass = 0;
+    while (sizeClass < SVC_ARENA_SIZE_CLASSES && ((size_t)SVC_ARENA_MIN_SLOT_SIZE << sizeClass) < size) {
+        sizeClass++;
+    }
+    if (sizeClass == SVC_ARENA_SIZE_CLASSES) {
+        QNN_ERR("ArenaAllocate::%llu bytes is too large.\n", (unsigned long long)size);
+        return false;
+    }
+    ArenaSizeClass_t& sizeClassInfo = pArena->classes[sizeClass];
+
+    for (;;) {
+        uint32_t count = sizeClassInfo.count.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < count; i++) {
+            if (ArenaTakeSlot(sizeClassInfo.segments[i], slice)) {
+                return true;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(pArena->growMutex);
+        if (sizeClassInfo.count.load(std::memory_order_relaxed) != count) {
+            continue;       // Another thread added a segment meanwhile.
+        }
+        uint32_t index = pArena->segmentCount.load(std::memory_order_relaxed);
+        if (count == SVC_ARENA_CLASS_SEGMENTS || index == SVC_ARENA_MAX_SEGMENTS) {
+            QNN_ERR("ArenaAllocate::No more segments for slices of %llu bytes.\n", (unsigned long long)size);
+            return false;
+        }
+
+        std::unique_ptr<ArenaSegment_t> pSegment(new ArenaSegment_t());
+        pSegment->index = index;
+        pSegment->slotSize = (size_t)SVC_ARENA_MIN_SLOT_SIZE << sizeClass;
+        pSegment->slotCount = (uint32_t)std::max((size_t)1, std::min((size_t)SVC_ARENA_MAX_SLOTS, (size_t)SVC_ARENA_SEGMENT_SIZE / pSegment->slotSize));
+        pSegment->slotMask = pSegment->slotCount == 64 ? ~0ull : (1ull << pSegment->slotCount) - 1;
+        if (!pSegment->memory.create(ArenaSegmentName(pArena->name, index), pSegment->slotSize * pSegment->slotCount)) {
+            QNN_ERR("ArenaAllocate::Failed to create segment %u of %llu bytes.\n", index,
+                    (unsigned long long)(pSegment->slotSize * pSegment->slotCount));
+            return false;
+        }
+        pSegment->memory.prefault();
+        QNN_INF("ArenaAllocate::Segment %u, %u slots of %llu bytes.\n", index, pSegment->slotCount, (unsigned long long)pSegment->slotSize);
+
+        pArena->segments[index] = pSegment.get();
+        sizeClassInfo.segments[count] = pSegment.get();
+        pArena->owned[index] = std::move(pSegment);
+        pArena->segmentCount.store(index + 1, std::memory_order_release);
+        sizeClassInfo.count.store(count + 1, std::memory_order_release);
+    }
+}
+
+void ArenaFree(const ArenaSlice_t& slice) {
+    if (slice.segment) {
+        slice.segment->used.fetch_and(~(1ull << slice.slot), std::memory_order_release);
+    }
+}
+
+// The segment holding 'buffer', or nullptr if it isn't in the arena.
+ArenaSegment_t* ArenaFindSegment(ShareMemArena_t* pArena, const uint8_t* buffer) {
+    uint32_t count = pArena->segmentCount.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < count; i++) {
+        ArenaSegment_t* pSegment = pArena->segments[i];
+        if (buffer >= pSegment->memory.data() && buffer < pSegment->memory.data() + pSegment->memory.size()) {
+            return pSegment;
+        }
+    }
+    return nullptr;
+}
+
+// Free the slice 'buffer' was allocated in by ArenaAllocate().
+bool ArenaFreeBuffer(ShareMemArena_t* pArena, const uint8_t* buffer) {
+    ArenaSegment_t* pSegment = ArenaFindSegment(pArena, buffer);
+    if (!pSegment) {
+        return false;
+    }
+    ArenaSlice_t slice;
+    slice.segment = pSegment;
+    slice.slot = (uint32_t)((size_t)(buffer - pSegment->memory.data()) / pSegment->slotSize);
+    ArenaFree(slice);
+    return true;
+}
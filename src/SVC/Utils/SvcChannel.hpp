@@ -0,0 +1,250 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "LibAppBuilder.hpp"
+#include "PAL/Doorbell.hpp"
+#include "PAL/Process.hpp"
+#include "PAL/SharedMemory.hpp"
+
+/*
+ * The way messages travel between the application and one Svc process: the pipes, or two byte rings in a share
+ * memory, one for the requests and one for the replies. A thread waiting on a ring spins for a while, then sleeps
+ * on a doorbell the other side rings only when it knows someone sleeps, so a round trip costs no system call while
+ * both sides are busy. With rings the pipes stay open but carry nothing: they end when the other process exits,
+ * which a sleeping thread checks each time its wait times out. The application learns it sooner from the process
+ * handle, see SvcChannelPeerExited().
+ * Each ring has one writer and one reader at a time, the callers serialize their writes and their reads.
+ */
+
+#define SVC_RING_CAPACITY       (256 * 1024)    // Bytes of each ring, larger messages go through in pieces.
+#define SVC_RING_POLL_MS        50              // Sleeps on a doorbell are this long, then the peer is checked.
+
+typedef struct SvcRingHeader {
+    alignas(64) std::atomic<uint64_t> head;     // Bytes written so far, only the writer changes it.
+    std::atomic<uint32_t> dataSeq;              // Doorbell word of the reader, bumped after each write.
+    std::atomic<uint32_t> readerSleeping;
+    std::atomic<uint32_t> closed;               // The writer is gone for good.
+    alignas(64) std::atomic<uint64_t> tail;     // Bytes read so far, only the reader changes it.
+    std::atomic<uint32_t> spaceSeq;             // Doorbell word of the writer, bumped after each read.
+    std::atomic<uint32_t> writerSleeping;
+} SvcRingHeader_t;
+
+typedef struct SvcRing {
+    SvcRingHeader_t* header = nullptr;
+    uint8_t* data = nullptr;
+    pal::Doorbell dataBell;
+    pal::Doorbell spaceBell;
+} SvcRing_t;
+
+// Share memory layout: the header of the request ring, the header of the reply ring, then their data.
+typedef struct SvcRings {
+    pal::SharedMemory memory;
+    SvcRing_t read;
+    SvcRing_t write;
+    uint32_t spinUs = 0;
+} SvcRings_t;
+
+typedef struct SvcChannel {
+    pal::process::PipeHandle hRead = pal::process::g_invalidPipe;
+    pal::process::PipeHandle hWrite = pal::process::g_invalidPipe;
+    std::unique_ptr<SvcRings_t> pRings;         // Set when the messages go through rings.
+    std::atomic<bool> peerExited{false};
+} SvcChannel_t;
+
+static_assert(sizeof(SvcRingHeader_t) == 128, "SvcRingHeader_t is shared by processes of the same build.");
+
+// Map the rings 'name', creating them in the application ('bCreate') or opening them in the Svc.
+bool SvcChannelOpenRings(SvcChannel_t& channel, const std::string& name, uint32_t spin_us, bool bCreate) {
+    std::unique_ptr<SvcRings_t> pRings(new SvcRings_t());
+    size_t size = 2 * sizeof(SvcRingHeader_t) + 2 * (size_t)SVC_RING_CAPACITY;
+    bool bMapped = bCreate ? pRings->memory.create(name, size) : pRings->memory.open(name, size);
+    if (!bMapped) {
+        QNN_ERR("SvcChannelOpenRings::Failed to map %s.\n", name.c_str());
+        return false;
+    }
+    if (bCreate) {
+        memset(pRings->memory.data(), 0, size);
+    }
+    pRings->memory.prefault();
+
+    SvcRingHeader_t* headers = (SvcRingHeader_t*)pRings->memory.data();
+    uint8_t* data = pRings->memory.data() + 2 * sizeof(SvcRingHeader_t);
+    SvcRing_t& requests = bCreate ? pRings->write : pRings->read;
+    SvcRing_t& replies = bCreate ? pRings->read : pRings->write;
+    requests.header = &headers[0];
+    requests.data = data;
+    replies.header = &headers[1];
+    replies.data = data + SVC_RING_CAPACITY;
+
+    bool bSuccess = true;
+    const char* suffixes[] = {".req.data", ".req.space", ".rep.data", ".rep.space"};
+    SvcRing_t* rings[] = {&requests, &replies};
+    for (int i = 0; i < 2; i++) {
+        std::atomic<uint32_t>* words[] = {&rings[i]->header->dataSeq, &rings[i]->header->spaceSeq};
+        pal::Doorbell* bells[] = {&rings[i]->dataBell, &rings[i]->spaceBell};
+        for (int j = 0; j < 2; j++) {
+            std::string bellName = name + suffixes[i * 2 + j];
+            bSuccess = bSuccess && (bCreate ? bells[j]->create(bellName, words[j]) : bells[j]->open(bellName, words[j]));
+        }
+    }
+    if (!bSuccess) {
+        QNN_ERR("SvcChannelOpenRings::Failed to set up the doorbells of %s.\n", name.c_str());
+        return false;
+    }
+
+    pRings->spinUs = spin_us;
+    channel.pRings = std::move(pRings);
+    return true;
+}
+
+// Wait until 'ready()' holds, spinning up to 'spinUs' first. Returns false if the other process is gone.
+template <typename Ready>
+bool SvcRingWait(SvcChannel_t& channel, std::atomic<uint32_t>& seq, std::atomic<uint32_t>& sleeping, pal::Doorbell& bell, Ready ready) {
+    if (ready()) {
+        return true;
+    }
+    if (channel.pRings->spinUs) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(channel.pRings->spinUs);
+        do {
+            std::this_thread::yield();      // Lets the other side run when they share a core.
+            if (ready()) {
+                return true;
+            }
+        } while (std::chrono::steady_clock::now() < deadline);
+    }
+
+    for (;;) {
+        // The other side changes the ring, bumps 'seq', then rings if 'sleeping' is set. Setting 'sleeping' before
+        // reading 'seq' and checking again means either it sees the flag, or the futex sees the new 'seq'.
+        sleeping.store(1);
+        uint32_t value = seq.load();
+        if (ready()) {
+            sleeping.store(0);
+            return true;
+        }
+        bool bRung = bell.wait(value, SVC_RING_POLL_MS);
+        sleeping.store(0);
+        if (ready()) {
+            return true;
+        }
+        if (!bRung && pal::process::isPipeClosed(channel.hRead)) {
+            return false;
+        }
+    }
+}
+
+// Like pal::process::readPipe(): at least one byte, 0 once the writer closed the ring or died.
+size_t SvcRingRead(SvcChannel_t& channel, uint8_t* buffer, size_t size) {
+    SvcRing_t& ring = channel.pRings->read;
+    SvcRingHeader_t* header = ring.header;
+    uint64_t tail = header->tail.load(std::memory_order_relaxed);
+    uint64_t available = 0;
+    auto hasData = [&] {
+        available = header->head.load(std::memory_order_acquire) - tail;
+        return available > 0 || header->closed.load() || channel.peerExited.load();
+    };
+    if (!SvcRingWait(channel, header->dataSeq, header->readerSleeping, ring.dataBell, hasData) || !available) {
+        return 0;
+    }
+
+    size_t bytes = (size_t)std::min(available, (uint64_t)size);
+    size_t offset = (size_t)(tail % SVC_RING_CAPACITY);
+    size_t first = std::min(bytes, (size_t)SVC_RING_CAPACITY - offset);
+    memcpy(buffer, ring.data + offset, first);
+    memcpy(buffer + first, ring.data, bytes - first);
+
+    header->tail.store(tail + bytes);
+    header->spaceSeq.fetch_add(1);
+    if (header->writerSleeping.load()) {
+        ring.spaceBell.ring();
+    }
+    return bytes;
+}
+
+bool SvcRingWrite(SvcChannel_t& channel, const uint8_t* data, size_t size) {
+    SvcRing_t& ring = channel.pRings->write;
+    SvcRingHeader_t* header = ring.header;
+    uint64_t head = header->head.load(std::memory_order_relaxed);
+    uint64_t space = 0;
+    auto hasSpace = [&] {
+        space = SVC_RING_CAPACITY - (head - header->tail.load(std::memory_order_acquire));
+        return space > 0 || channel.peerExited.load();
+    };
+
+    while (size > 0) {
+        if (!SvcRingWait(channel, header->spaceSeq, header->writerSleeping, ring.spaceBell, hasSpace) || !space) {
+            return false;
+        }
+        size_t bytes = (size_t)std::min(space, (uint64_t)size);
+        size_t offset = (size_t)(head % SVC_RING_CAPACITY);
+        size_t first = std::min(bytes, (size_t)SVC_RING_CAPACITY - offset);
+        memcpy(ring.data + offset, data, first);
+        memcpy(ring.data, data + first, bytes - first);
+
+        head += bytes;
+        header->head.store(head);
+        header->dataSeq.fetch_add(1);
+        if (header->readerSleeping.load()) {
+            ring.dataBell.ring();
+        }
+        data += bytes;
+        size -= bytes;
+    }
+    return true;
+}
+
+size_t SvcChannelRead(SvcChannel_t& channel, uint8_t* buffer, size_t size) {
+    if (channel.pRings) {
+        return SvcRingRead(channel, buffer, size);
+    }
+    return pal::process::readPipe(channel.hRead, buffer, size);
+}
+
+bool SvcChannelWrite(SvcChannel_t& channel, const uint8_t* data, size_t size) {
+    if (channel.pRings) {
+        return SvcRingWrite(channel, data, size);
+    }
+    return pal::process::writePipe(channel.hWrite, data, size);
+}
+
+// The other process exited: the threads waiting on the rings read what it left, then the end of the channel.
+// Bumping the doorbell words keeps a thread which is about to sleep from missing the ring.
+void SvcChannelPeerExited(SvcChannel_t& channel) {
+    channel.peerExited.store(true);
+    if (channel.pRings) {
+        channel.pRings->read.header->dataSeq.fetch_add(1);
+        channel.pRings->read.dataBell.ring();
+        channel.pRings->write.header->spaceSeq.fetch_add(1);
+        channel.pRings->write.spaceBell.ring();
+    }
+}
+
+// The reader of the other side sees the end of the channel once it read what was written.
+void SvcChannelClose(SvcChannel_t& channel) {
+    if (channel.pRings) {
+        SvcRing_t& ring = channel.pRings->write;
+        ring.header->closed.store(1);
+        ring.header->dataSeq.fetch_add(1);
+        ring.dataBell.ring();
+    }
+    pal::process::closePipe(channel.hWrite);
+    pal::process::closePipe(channel.hRead);
+    channel.hWrite = pal::process::g_invalidPipe;
+    channel.hRead = pal::process::g_invalidPipe;
+}
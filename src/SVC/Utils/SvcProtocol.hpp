@@ -0,0 +1,320 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "LibAppBuilder.hpp"
+#include "PAL/Process.hpp"
+#include "Utils/SvcChannel.hpp"
+
+/*
+ * Messages exchanged with QAIAppSvc through its SvcChannel. Each message is a SvcMsgHeader followed by
+ * 'payloadSize' bytes holding, in this order:
+ *   'bufferCount' SvcBufferDesc - offset and size of each input / output in the share memory.
+ *   'stringCount' strings       - each one a uint32_t length followed by the characters, no terminator.
+ * Every request carries an id which its reply echoes. Both sides are built from the same sources and
+ * run on the same machine, so the integers are in native byte order; the version check rejects a
+ * QAIAppSvc from another build.
+ */
+
+#define SVC_PROTOCOL_MAGIC      0x56534151      // "QASV"
+#define SVC_PROTOCOL_VERSION    8
+#define SVC_MAX_PAYLOAD_SIZE    (16 * 1024 * 1024)
+
+// Requests: strings / value / buffers they carry.
+// model_name, model_path, backend_lib_path, system_lib_path, then the LoRA adapters, see SvcEncodeLoraAdapters().
+// flags: SVC_FLAG_ASYNC.
+#define SVC_CMD_LOAD            1
+// model_name, share_memory_name, perf_profile, then the data type of each input if they aren't all float32. value: share
+// memory size. buffers: inputs. flags: SVC_FLAG_ARENA, SVC_FLAG_NATIVE.
+#define SVC_CMD_RUN             2
+#define SVC_CMD_RELEASE         3       // model_name.
+#define SVC_CMD_UNMAP           4       // share_memory_name. Drops the mapping the service keeps after SVC_CMD_RUN.
+// Reply to every request except an asynchronous SVC_CMD_LOAD. flags: SVC_STATUS_*. buffers: outputs of SVC_CMD_RUN.
+// SVC_CMD_INFO: value: the number of inputs. strings: 3 per input then per output, see SvcEncodeTensorInfos().
+#define SVC_CMD_REPLY           5
+#define SVC_CMD_INFO            6       // model_name.
+
+#define SVC_FLAG_ASYNC          0x1     // Don't reply, the application doesn't wait for the model to load.
+// SVC_CMD_RUN: share_memory_name names the arena of the application, see ShareMemArena.hpp. The buffer offsets are
+// arena offsets and the last buffer is the area where the outputs go, the value is unused.
+#define SVC_FLAG_ARENA          0x2
+#define SVC_FLAG_NATIVE         0x4     // SVC_CMD_RUN: the outputs in their native data type instead of float32.
+
+#define SVC_STATUS_OK           0
+#define SVC_STATUS_FAILED       1
+#define SVC_STATUS_NO_SPACE     2       // The outputs don't fit into the output area. value: the size they need.
+
+// Arena offset: the index of the segment above this bit, the offset in the segment below.
+#define SVC_ARENA_SEGMENT_SHIFT 40
+#define SVC_ARENA_OFFSET_MASK   ((1ull << SVC_ARENA_SEGMENT_SHIFT) - 1)
+
+typedef struct SvcMsgHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t command;
+    uint32_t requestId;
+    uint32_t flags;             // SVC_FLAG_* in requests, SVC_STATUS_* in replies.
+    uint64_t value;
+    uint32_t bufferCount;
+    uint32_t stringCount;
+    uint64_t payloadSize;
+} SvcMsgHeader_t;
+
+typedef struct SvcBufferDesc {
+    uint64_t offset;
+    uint64_t size;
+} SvcBufferDesc_t;
+
+// A tensor in the reply to SVC_CMD_INFO, followed by its 'rank' dimensions as uint64_t.
+typedef struct SvcTensorDesc {
+    uint64_t size;
+    float scale;
+    int32_t offset;
+    uint32_t quantized;
+    uint32_t rank;
+} SvcTensorDesc_t;
+
+static_assert(sizeof(SvcMsgHeader_t) == 40, "SvcMsgHeader_t layout is part of the protocol.");
+static_assert(sizeof(SvcBufferDesc_t) == 16, "SvcBufferDesc_t layout is part of the protocol.");
+static_assert(sizeof(SvcTensorDesc_t) == 24, "SvcTensorDesc_t layout is part of the protocol.");
+
+// A decoded message. Reusing one object keeps the capacity of its vectors and strings across calls.
+typedef struct SvcMessage {
+    SvcMsgHeader_t header;
+    std::vector<SvcBufferDesc_t> buffers;
+    std::vector<std::string> strings;
+
+    void Reset(uint16_t command, uint32_t requestId) {
+        memset(&header, 0, sizeof(header));
+        header.magic = SVC_PROTOCOL_MAGIC;
+        header.version = SVC_PROTOCOL_VERSION;
+        header.command = command;
+        header.requestId = requestId;
+        buffers.clear();
+        strings.clear();
+    }
+} SvcMessage_t;
+
+// Serialize 'message' into 'data', filling in the counts and the payload size of its header.
+void SvcEncodeMessage(SvcMessage_t& message, std::vector<uint8_t>& data) {
+    size_t payloadSize = message.buffers.size() * sizeof(SvcBufferDesc_t);
+    for (const std::string& str : message.strings) {
+        payloadSize += sizeof(uint32_t) + str.size();
+    }
+
+    message.header.bufferCount = (uint32_t)message.buffers.size();
+    message.header.stringCount = (uint32_t)message.strings.size();
+    message.header.payloadSize = payloadSize;
+
+    data.resize(sizeof(SvcMsgHeader_t) + payloadSize);
+    uint8_t* cursor = data.data();
+    memcpy(cursor, &message.header, sizeof(SvcMsgHeader_t));
+    cursor += sizeof(SvcMsgHeader_t);
+    if (!message.buffers.empty()) {
+        memcpy(cursor, message.buffers.data(), message.buffers.size() * sizeof(SvcBufferDesc_t));
+        cursor += message.buffers.size() * sizeof(SvcBufferDesc_t);
+    }
+    for (const std::string& str : message.strings) {
+        uint32_t length = (uint32_t)str.size();
+        memcpy(cursor, &length, sizeof(uint32_t));
+        cursor += sizeof(uint32_t);
+        memcpy(cursor, str.data(), str.size());
+        cursor += str.size();
+    }
+}
+
+// Check a received header before trusting its sizes.
+bool SvcDecodeHeader(const uint8_t* data, size_t size, SvcMsgHeader_t& header) {
+    if (size != sizeof(SvcMsgHeader_t)) {
+        return false;
+    }
+    memcpy(&header, data, sizeof(SvcMsgHeader_t));
+
+    if (header.magic != SVC_PROTOCOL_MAGIC || header.version != SVC_PROTOCOL_VERSION) {
+        return false;
+    }
+    if (header.command < SVC_CMD_LOAD || header.command > SVC_CMD_INFO) {
+        return false;
+    }
+    if (header.payloadSize > SVC_MAX_PAYLOAD_SIZE) {
+        return false;
+    }
+    // The descriptors and the string lengths alone have to fit into the payload.
+    uint64_t minimumSize = (uint64_t)header.bufferCount * sizeof(SvcBufferDesc_t) + (uint64_t)header.stringCount * sizeof(uint32_t);
+    return minimumSize <= header.payloadSize;
+}
+
+// Parse the payload following 'header', which SvcDecodeHeader() accepted. It must be consumed exactly.
+bool SvcDecodePayload(const SvcMsgHeader_t& header, const uint8_t* data, size_t size, SvcMessage_t& message) {
+    if (size != header.payloadSize) {
+        return false;
+    }
+
+    message.header = header;
+    message.buffers.resize(header.bufferCount);
+    size_t buffersSize = (size_t)header.bufferCount * sizeof(SvcBufferDesc_t);
+    if (buffersSize) {
+        memcpy(message.buffers.data(), data, buffersSize);
+    }
+
+    const uint8_t* cursor = data + buffersSize;
+    const uint8_t* end = data + size;
+    message.strings.resize(header.stringCount);
+    for (uint32_t i = 0; i < header.stringCount; i++) {
+        uint32_t length = 0;
+        if ((size_t)(end - cursor) < sizeof(uint32_t)) {
+            return false;
+        }
+        memcpy(&length, cursor, sizeof(uint32_t));
+        cursor += sizeof(uint32_t);
+        if ((size_t)(end - cursor) < length) {
+            return false;
+        }
+        message.strings[i].assign((const char*)cursor, length);
+        cursor += length;
+    }
+
+    return cursor == end;
+}
+
+// The reply to SVC_CMD_INFO. Each tensor is its name, its data type, then its SvcTensorDesc_t and dimensions as bytes,
+// so the scale arrives bit for bit.
+void SvcEncodeTensorInfos(SvcMessage_t& message, const std::vector<TensorInfo>& inputs, const std::vector<TensorInfo>& outputs) {
+    message.header.value = inputs.size();
+    for (const std::vector<TensorInfo>* infos : {&inputs, &outputs}) {
+        for (const TensorInfo& info : *infos) {
+            SvcTensorDesc_t desc;
+            memset(&desc, 0, sizeof(desc));
+            desc.size = info.size;
+            desc.scale = info.scale;
+            desc.offset = info.offset;
+            desc.quantized = info.quantized ? 1 : 0;
+            desc.rank = (uint32_t)info.shape.size();
+            std::string bytes((const char*)&desc, sizeof(desc));
+            for (size_t dim : info.shape) {
+                uint64_t value = dim;
+                bytes.append((const char*)&value, sizeof(value));
+            }
+            message.strings.push_back(info.name);
+            message.strings.push_back(info.dataType);
+            message.strings.push_back(bytes);
+        }
+    }
+}
+
+bool SvcDecodeTensorInfos(const SvcMessage_t& message, std::vector<TensorInfo>& inputs, std::vector<TensorInfo>& outputs) {
+    if (message.strings.size() % 3 != 0 || message.header.value > message.strings.size() / 3) {
+        return false;
+    }
+    inputs.clear();
+    outputs.clear();
+    for (size_t i = 0; i < message.strings.size(); i += 3) {
+        const std::string& bytes = message.strings[i + 2];
+        SvcTensorDesc_t desc;
+        if (bytes.size() < sizeof(desc)) {
+            return false;
+        }
+        memcpy(&desc, bytes.data(), sizeof(desc));
+        if (bytes.size() != sizeof(desc) + (size_t)desc.rank * sizeof(uint64_t) || desc.quantized > 1) {
+            return false;
+        }
+
+        TensorInfo info;
+        info.name = message.strings[i];
+        info.dataType = message.strings[i + 1];
+        info.size = (size_t)desc.size;
+        info.quantized = desc.quantized != 0;
+        info.scale = desc.scale;
+        info.offset = desc.offset;
+        for (uint32_t d = 0; d < desc.rank; d++) {
+            uint64_t dim = 0;
+            memcpy(&dim, bytes.data() + sizeof(desc) + d * sizeof(uint64_t), sizeof(dim));
+            info.shape.push_back((size_t)dim);
+        }
+        (i / 3 < message.header.value ? inputs : outputs).push_back(info);
+    }
+    return true;
+}
+
+// The LoRA adapters of SVC_CMD_LOAD, appended to its strings and decoded from string 'first' on. Each adapter is its graph name, the number of its bin
+// paths as a uint32_t in bytes, then each bin path as a string of its own, so a path may hold any character.
+void SvcEncodeLoraAdapters(SvcMessage_t& message, const std::vector<LoraAdapter>& adapters) {
+    for (const LoraAdapter& adapter : adapters) {
+        uint32_t count = (uint32_t)adapter.m_bin_paths.size();
+        message.strings.push_back(adapter.m_graph_name);
+        message.strings.push_back(std::string((const char*)&count, sizeof(count)));
+        message.strings.insert(message.strings.end(), adapter.m_bin_paths.begin(), adapter.m_bin_paths.end());
+    }
+}
+
+bool SvcDecodeLoraAdapters(const SvcMessage_t& message, size_t first, std::vector<LoraAdapter>& adapters) {
+    adapters.clear();
+    for (size_t i = first; i < message.strings.size();) {
+        uint32_t count = 0;
+        if (message.strings.size() - i < 2 || message.strings[i + 1].size() != sizeof(count)) {
+            return false;
+        }
+        memcpy(&count, message.strings[i + 1].data(), sizeof(count));
+        if (count > message.strings.size() - i - 2) {
+            return false;
+        }
+        auto paths = message.strings.begin() + i + 2;
+        adapters.push_back(LoraAdapter(message.strings[i], std::vector<std::string>(paths, paths + count)));
+        i += 2 + count;
+    }
+    return true;
+}
+
+// Read exactly 'size' bytes, a channel returns what is available.
+bool SvcReadFull(SvcChannel_t& channel, uint8_t* buffer, size_t size) {
+    while (size > 0) {
+        size_t bytes = SvcChannelRead(channel, buffer, size);
+        if (bytes == 0) {
+            return false;
+        }
+        buffer += bytes;
+        size -= bytes;
+    }
+    return true;
+}
+
+bool SvcWriteMessage(SvcChannel_t& channel, SvcMessage_t& message, std::vector<uint8_t>& scratch) {
+    SvcEncodeMessage(message, scratch);
+    return SvcChannelWrite(channel, scratch.data(), scratch.size());
+}
+
+// Returns false at the end of the channel and on malformed data. The channel can't be resynchronized after a
+// malformed message, the caller has to give up on it.
+bool SvcReadMessage(SvcChannel_t& channel, SvcMessage_t& message, std::vector<uint8_t>& scratch) {
+    uint8_t headerData[sizeof(SvcMsgHeader_t)];
+    SvcMsgHeader_t header;
+
+    if (!SvcReadFull(channel, headerData, sizeof(headerData))) {
+        return false;
+    }
+    if (!SvcDecodeHeader(headerData, sizeof(headerData), header)) {
+        QNN_ERR("SvcReadMessage::Malformed message header, command %d version %d.\n", (int)header.command, (int)header.version);
+        return false;
+    }
+
+    scratch.resize((size_t)header.payloadSize);
+    if (!SvcReadFull(channel, scratch.data(), scratch.size())) {
+        return false;
+    }
+    if (!SvcDecodePayload(header, scratch.data(), scratch.size(), message)) {
+        QNN_ERR("SvcReadMessage::Malformed message payload, command %d.\n", (int)header.command);
+        return false;
+    }
+    return true;
+}
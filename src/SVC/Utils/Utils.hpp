@@ -12,36 +12,135 @@
 #define _LIBAPPBUILDER_UTILS_H
 
 
-#include <tchar.h>
-#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string.h>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#ifndef _WIN32
+#include <errno.h>
+#endif
 
 #include "Utils/ShareMem.hpp"
+#include "Utils/ShareMemArena.hpp"
+#include "Utils/SvcProtocol.hpp"
+#include "PAL/DynamicLoading.hpp"
+#include "PAL/FileOp.hpp"
+#include "PAL/Path.hpp"
+#include "PAL/Process.hpp"
+
+#ifdef _WIN32
+#define SVC_APPBUILDER_EXE   "QAIAppSvc.exe"
+#else
+#define SVC_APPBUILDER_EXE   "QAIAppSvc"
+#endif
 
-#define GLOBAL_BUFSIZE      4096
+// A process which dies this soon after it started counts as a fast restart. After this many fast restarts in a row
+// it is no longer restarted as soon as it dies, only when an inference needs it.
+#define SVC_FAST_RESTART_MS     10000
+#define SVC_MAX_FAST_RESTARTS   3
 
-#ifdef UNICODE  
-#define SVC_APPBUILDER_CMD   TEXT("QAIAppSvc.exe svc %llu %llu %llu %d %d \"%S\"")
-#else  
-#define SVC_APPBUILDER_CMD   TEXT("QAIAppSvc.exe svc %llu %llu %llu %d %d \"%s\"")
-#endif
+using pal::process::PipeHandle;
+using pal::process::ProcessHandle;
 
 uint64_t g_logEpoch = 0;
 int g_logLevel = 0;
 int g_profilingLevel = 0;
 std::string g_ProcName = "^main";
-
-char g_buffer[GLOBAL_BUFSIZE];
-
+bool g_svcDoorbell = false;             // Svc processes created from now on talk through rings, see SvcChannel.hpp.
+uint32_t g_svcSpinUs = 0;
+
+// A request waiting for its reply.
+typedef struct SvcPending {
+    uint32_t requestId = 0;
+    bool done = false;
+    bool bSuccess = false;
+    SvcMessage_t reply;
+} SvcPending_t;
+
+// Several threads can have requests in flight to one Svc process, the Svc may reply out of order. There is no
+// dispatcher thread: one of the waiting threads reads the replies and completes the requests they belong to,
+// its own included. With a single request in flight the reply goes straight to its thread.
+// Requests hold a reference, the channel is closed and the process is waited for when the last one is gone.
+// A watcher thread waits for the process to exit, see WatchSvcProcess().
 typedef struct ProcInfo {
-    HANDLE hSvcPipeInWrite;
-    HANDLE hSvcPipeOutRead;
-    PROCESS_INFORMATION piSvcProcInfo;
+    std::string proc_name;
+    SvcChannel_t channel;                   // Writes to the Svc pipe in, reads from the Svc pipe out.
+    ProcessHandle hSvcProcess = 0;
+    std::thread watcher;
+    std::atomic<bool> stopping{false};      // The process exits because the channel is closed.
+    std::chrono::steady_clock::time_point startTime;
+    uint32_t fastRestarts = 0;              // Processes before this one which died soon after starting.
+    std::atomic<uint32_t> lastRequestId{0};
+    std::atomic<bool> broken{false};        // The Svc exited or closed its pipe, no more replies will come.
+    std::mutex restartMutex;                // One thread replaces the process once it is broken.
+    std::mutex writeMutex;                  // One request at a time on 'channel'.
+    std::mutex pendingMutex;                // Protects the members below.
+    std::condition_variable pendingCond;
+    std::unordered_map<uint32_t, std::shared_ptr<SvcPending_t>> pending;
+    bool reading = false;                   // A waiting thread is reading 'channel'.
+
+    ~ProcInfo() {
+        stopping = true;
+        SvcChannelClose(channel);                       // The Svc process sees the end of its requests, it will exit.
+        if (watcher.joinable()) {
+            // The watcher may drop the last reference itself, after restarting the process.
+            if (watcher.get_id() == std::this_thread::get_id()) {
+                watcher.detach();
+            }
+            else {
+                watcher.join();
+            }
+        }
+        if (hSvcProcess) {
+            pal::process::closeProcess(hSvcProcess);
+        }
+    }
 } ProcInfo_t;
 
-std::unordered_map<std::string, ProcInfo_t*> sg_proc_info_map;      // proc_name map to ProcInfo_t.
-std::unordered_map<std::string, ProcInfo_t*> sg_model_info_map;     // model_name map to ProcInfo_t.
+// One Svc process a model is loaded in, with the load figures used to pick the process of an inference.
+typedef struct SvcReplica {
+    std::string proc_name;
+    std::shared_ptr<ProcInfo_t> pProcInfo;  // Replaced when the process is restarted, see RestartSvcProcess().
+    std::atomic<uint32_t> inflight{0};      // Inferences sent and not answered yet.
+    std::atomic<uint64_t> latencyUs{0};     // Moving average of the recent inference round trips.
+} SvcReplica_t;
+
+// A model loaded in Svc processes. 'replicas[0]' is the process named in ModelInitialize(), ModelSetReplicas()
+// loads the model into more processes and the inferences are spread across them.
+typedef struct SvcModel {
+    std::string proc_name;
+    std::string model_path;
+    std::string backend_lib_path;
+    std::string system_lib_path;
+    std::vector<LoraAdapter> lora_adapters; // Loaded with the model into every process, again when one restarts.
+    std::mutex configMutex;                 // Serializes TalkToSvc_SetReplicas() and TalkToSvc_Destroy().
+    std::mutex mutex;                       // Protects 'replicas' and their 'pProcInfo'.
+    std::vector<std::shared_ptr<SvcReplica_t>> replicas;
+    std::atomic<uint32_t> nextReplica{0};   // Where the next pick starts, spreads the ties.
+    std::atomic<uint64_t> outputBytes{0};   // Size of the outputs of the last inference, sizes the arena slices.
+    std::mutex infoMutex;                   // Protects the members below.
+    bool infoKnown = false;                 // 'inputs' and 'outputs' were asked for, see TalkToSvc_GetInfo().
+    std::vector<TensorInfo> inputs;
+    std::vector<TensorInfo> outputs;
+} SvcModel_t;
+
+std::mutex sg_proc_info_mutex;                                                      // Protects the maps and the set below.
+std::unordered_map<std::string, std::shared_ptr<ProcInfo_t>> sg_proc_info_map;      // proc_name map to ProcInfo_t.
+std::unordered_map<std::string, std::shared_ptr<SvcModel_t>> sg_model_info_map;     // model_name map to SvcModel_t.
+std::unordered_set<std::string> sg_model_loading;                                   // model_name being loaded by TalkToSvc_Initialize().
 
 std::string GetLastErrorAsString(std::string message) {
+#ifndef _WIN32
+    if (errno == 0)
+        return message;
+    return message + " Error: [" + std::to_string(errno) + "] " + strerror(errno);
+#else
     DWORD errorMessageID = ::GetLastError();
     if (errorMessageID == 0)
         return std::string();
@@ -53,325 +152,945 @@ std::string GetLastErrorAsString(std::string message) {
     LocalFree(messageBuffer);
 
     return message + " Error: [" + std::to_string(errorMessageID) + "] " + result;
+#endif
 }
 
 void ErrorExit(std::string message) {
     QNN_ERR(GetLastErrorAsString(message).c_str());
+#ifdef _WIN32
     ExitProcess(1);
+#else
+    exit(1);
+#endif
 }
 
-void split_string(std::vector<std::string> & output, const std::string &input, const char separator) {
-  std::istringstream tokenStream(input);
-  while (!tokenStream.eof()) {
-    std::string value;
-    getline(tokenStream, value, separator);
-    if (!value.empty()) {
-        output.push_back(value);
+std::shared_ptr<ProcInfo_t> FindProcInfo(std::string proc_name) {
+    std::lock_guard<std::mutex> lock(sg_proc_info_mutex);
+    auto it = sg_proc_info_map.find(proc_name);
+    if (it != sg_proc_info_map.end()) {
+        return it->second;
     }
-  }
+
+    return nullptr;
 }
 
-ProcInfo_t* FindProcInfo(std::string proc_name) {
-    auto it = sg_proc_info_map.find(proc_name);
-    if (it != sg_proc_info_map.end()) {
-        if (it->second) {
-            auto pProcInfo = it->second;
-            return pProcInfo;
-        }
+// The record of 'model_name' if it was loaded in 'proc_name'.
+std::shared_ptr<SvcModel_t> FindSvcModel(const std::string& model_name, const std::string& proc_name) {
+    std::lock_guard<std::mutex> lock(sg_proc_info_mutex);
+    auto it = sg_model_info_map.find(model_name);
+    if (it != sg_model_info_map.end() && it->second->proc_name == proc_name) {
+        return it->second;
     }
 
     return nullptr;
 }
 
-ProcInfo_t* CreateSvcProcess(std::string proc_name) {
-    STARTUPINFO siStartInfo;
-    PROCESS_INFORMATION piSvcProcInfo;
-    ProcInfo_t* pProcInfo = nullptr;
-    BOOL bSuccess = FALSE;
+// Called with 'sg_proc_info_mutex' held. Whether a model still has a replica in 'proc_name'.
+bool IsSvcProcessInUse(const std::string& proc_name) {
+    for (auto& it : sg_model_info_map) {
+        std::lock_guard<std::mutex> lock(it.second->mutex);
+        for (auto& pReplica : it.second->replicas) {
+            if (pReplica->proc_name == proc_name) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// On Windows CreateProcess() finds "QAIAppSvc.exe" next to the application or in PATH. On Linux look next
+// to libappbuilder.so first, Python applications don't live in the package directory.
+std::string GetSvcExecutable() {
+#ifndef _WIN32
+    std::string libPath;
+    if (pal::dynamicloading::dlAddrToLibName((void*)&GetSvcExecutable, libPath)) {
+        std::string svcPath = pal::Path::combine(pal::Path::getDirectoryName(libPath), SVC_APPBUILDER_EXE);
+        if (pal::FileOp::checkFileExists(svcPath)) {
+            return svcPath;
+        }
+    }
+#endif
+    return SVC_APPBUILDER_EXE;
+}
 
-    HANDLE hSvcPipeInRead = NULL;
-    HANDLE hSvcPipeInWrite = NULL;
-    HANDLE hSvcPipeOutRead = NULL;
-    HANDLE hSvcPipeOutWrite = NULL;
+void WatchSvcProcess(ProcInfo_t* pProcInfo);
 
-    SECURITY_ATTRIBUTES saAttr;
-    saAttr.nLength = sizeof(SECURITY_ATTRIBUTES);
-    saAttr.bInheritHandle = TRUE;
-    saAttr.lpSecurityDescriptor = NULL;
+// The caller adds the process to 'sg_proc_info_map'. Returns nullptr if the process can't be started.
+std::shared_ptr<ProcInfo_t> CreateSvcProcess(std::string proc_name) {
+    ProcessHandle hSvcProcess = 0;
 
-    if (!CreatePipe(&hSvcPipeOutRead, &hSvcPipeOutWrite, &saAttr, 0))
-        ErrorExit("Create out pipe failed.");
+    PipeHandle hSvcPipeInRead = pal::process::g_invalidPipe;
+    PipeHandle hSvcPipeInWrite = pal::process::g_invalidPipe;
+    PipeHandle hSvcPipeOutRead = pal::process::g_invalidPipe;
+    PipeHandle hSvcPipeOutWrite = pal::process::g_invalidPipe;
 
-    if (!SetHandleInformation(hSvcPipeOutRead, HANDLE_FLAG_INHERIT, 0))
-        ErrorExit("SetHandleInformation for out pipe failed.");
+    if (!pal::process::createPipe(hSvcPipeOutRead, hSvcPipeOutWrite)) {
+        QNN_ERR("%s\n", GetLastErrorAsString("CreateSvcProcess::Create out pipe failed.").c_str());
+        return nullptr;
+    }
+    if (!pal::process::createPipe(hSvcPipeInRead, hSvcPipeInWrite)) {
+        QNN_ERR("%s\n", GetLastErrorAsString("CreateSvcProcess::Create in pipe failed.").c_str());
+        pal::process::closePipe(hSvcPipeOutRead);
+        pal::process::closePipe(hSvcPipeOutWrite);
+        return nullptr;
+    }
 
-    if (!CreatePipe(&hSvcPipeInRead, &hSvcPipeInWrite, &saAttr, 0))
-        ErrorExit("Create in pipe failed");
+    // From here on the ProcInfo_t closes the ends this process keeps.
+    std::shared_ptr<ProcInfo_t> pProcInfo = std::make_shared<ProcInfo_t>();
+    pProcInfo->proc_name = proc_name;
+    pProcInfo->channel.hRead = hSvcPipeOutRead;
+    pProcInfo->channel.hWrite = hSvcPipeInWrite;
+
+    // The Svc process gets the pipe ends it inherits on its command line, then the rings if there are any.
+    std::vector<std::string> args = {"svc", std::to_string((uint64_t)hSvcPipeInRead), std::to_string((uint64_t)hSvcPipeOutWrite),
+                                     std::to_string(g_logEpoch), std::to_string(g_logLevel), std::to_string(g_profilingLevel), proc_name};
+    if (g_svcDoorbell) {
+        static std::atomic<uint32_t> ringCount{0};
+#ifdef _WIN32
+        std::string ringName = "QAIAppRing_" + std::to_string(GetCurrentProcessId()) + "_" + std::to_string(ringCount++);
+#else
+        std::string ringName = "QAIAppRing_" + std::to_string(getpid()) + "_" + std::to_string(ringCount++);
+#endif
+        if (SvcChannelOpenRings(pProcInfo->channel, ringName, g_svcSpinUs, true)) {
+            args.push_back(ringName);
+            args.push_back(std::to_string(g_svcSpinUs));
+        }
+        else {
+            QNN_WAR("CreateSvcProcess::Failed to create the rings, talking to %s through the pipes.\n", proc_name.c_str());
+        }
+    }
 
-    if (!SetHandleInformation(hSvcPipeInWrite, HANDLE_FLAG_INHERIT, 0))
-        ErrorExit("SetHandleInformation for in pipe failed.");
+    bool bSpawned = pal::process::spawn(GetSvcExecutable(), args, {hSvcPipeInRead, hSvcPipeOutWrite}, hSvcProcess);
+    if (!bSpawned) {
+        QNN_ERR("%s\n", GetLastErrorAsString("CreateSvcProcess::CreateProcess failed.").c_str());
+    }
+    pal::process::closePipe(hSvcPipeOutWrite);
+    pal::process::closePipe(hSvcPipeInRead);
+    if (!bSpawned) {
+        return nullptr;
+    }
 
-    ZeroMemory(&piSvcProcInfo, sizeof(PROCESS_INFORMATION));
-    ZeroMemory(&siStartInfo, sizeof(STARTUPINFO));
+    pProcInfo->hSvcProcess = hSvcProcess;
+    pProcInfo->startTime = std::chrono::steady_clock::now();
+    pProcInfo->watcher = std::thread(WatchSvcProcess, pProcInfo.get());
 
-    siStartInfo.cb = sizeof(STARTUPINFO);
+    QNN_INF("CreateSvcProcess Success!");
+    return pProcInfo;
+}
 
-    _stprintf_s((TCHAR*)g_buffer, GLOBAL_BUFSIZE, SVC_APPBUILDER_CMD, (uint64_t)hSvcPipeInRead, (uint64_t)hSvcPipeOutWrite, 
-                g_logEpoch, g_logLevel, g_profilingLevel, proc_name.c_str());
+// Send 'message' with a new request id. If 'pPending' is not null, it receives the request to wait for with
+// TalkToSvc_Wait(); otherwise no reply is expected.
+bool TalkToSvc_Send(ProcInfo_t* pProcInfo, SvcMessage_t& message, const char* caller, std::shared_ptr<SvcPending_t>* pPending) {
+    thread_local std::vector<uint8_t> scratch;
+    uint32_t requestId = ++pProcInfo->lastRequestId;
+    message.header.requestId = requestId;
+
+    // Register before writing, the reply may arrive before the write returns.
+    if (pPending) {
+        std::lock_guard<std::mutex> lock(pProcInfo->pendingMutex);
+        if (pProcInfo->broken) {
+            QNN_ERR("%s::The Svc process died.\n", caller);
+            return false;
+        }
+        *pPending = std::make_shared<SvcPending_t>();
+        (*pPending)->requestId = requestId;
+        pProcInfo->pending[requestId] = *pPending;
+    }
 
-    bSuccess = CreateProcess(NULL, (TCHAR*)g_buffer, NULL, NULL, TRUE, 0, NULL, NULL, &siStartInfo, &piSvcProcInfo);
+    SvcEncodeMessage(message, scratch);
+    bool bSuccess;
+    {
+        std::lock_guard<std::mutex> lock(pProcInfo->writeMutex);
+        bSuccess = SvcChannelWrite(pProcInfo->channel, scratch.data(), scratch.size());
+    }
 
     if (!bSuccess) {
-        ErrorExit("CreateProcess failed.");
+        QNN_ERR("%s::Failed to write the request, perhaps child process died.\n", caller);
+        pProcInfo->broken = true;
+        if (pPending) {
+            std::lock_guard<std::mutex> lock(pProcInfo->pendingMutex);
+            pProcInfo->pending.erase(requestId);
+        }
+        return false;
     }
-    else {
-        CloseHandle(hSvcPipeOutWrite);
-        CloseHandle(hSvcPipeInRead);
+    return true;
+}
 
-        ProcInfo_t* pProcInfo = (ProcInfo_t*)malloc(sizeof(ProcInfo_t));
-        pProcInfo->hSvcPipeOutRead = hSvcPipeOutRead;
-        pProcInfo->hSvcPipeInWrite = hSvcPipeInWrite;
-        pProcInfo->piSvcProcInfo = piSvcProcInfo;
+// Read one reply from the Svc and complete its request. Called with 'pendingMutex' held through 'lock' by the
+// thread which set 'reading'.
+void TalkToSvc_ReadReply(ProcInfo_t* pProcInfo, std::unique_lock<std::mutex>& lock) {
+    thread_local SvcMessage_t reply;
+    thread_local std::vector<uint8_t> scratch;
+
+    lock.unlock();
+    bool bSuccess = SvcReadMessage(pProcInfo->channel, reply, scratch);
+    lock.lock();
+    pProcInfo->reading = false;
+
+    if (bSuccess && reply.header.command == SVC_CMD_REPLY) {
+        auto it = pProcInfo->pending.find(reply.header.requestId);
+        if (it != pProcInfo->pending.end()) {
+            SvcPending_t* pPending = it->second.get();
+            std::swap(pPending->reply, reply);
+            pPending->bSuccess = pPending->reply.header.flags == SVC_STATUS_OK;
+            pPending->done = true;
+            pProcInfo->pending.erase(it);
+        }
+        else {
+            QNN_ERR("TalkToSvc_ReadReply::Reply to unknown request %u.\n", reply.header.requestId);
+        }
+    }
+    else {
+        // Fail what is still waiting, nothing will answer it.
+        QNN_ERR("TalkToSvc_ReadReply::Failed to read the reply, perhaps child process died.\n");
+        pProcInfo->broken = true;
+        for (auto& it : pProcInfo->pending) {
+            it.second->done = true;
+            it.second->bSuccess = false;
+        }
+        pProcInfo->pending.clear();
+    }
 
-        sg_proc_info_map.insert(std::make_pair(proc_name, pProcInfo));
+    // Wake the thread whose request completed, and one which takes over reading.
+    pProcInfo->pendingCond.notify_all();
+}
 
-        QNN_INF("CreateSvcProcess Success!");
-        return pProcInfo;
+// Wait for the reply to a request sent by TalkToSvc_Send() and move it into 'reply'.
+bool TalkToSvc_Wait(ProcInfo_t* pProcInfo, const std::shared_ptr<SvcPending_t>& pPending, SvcMessage_t& reply, const char* caller) {
+    {
+        std::unique_lock<std::mutex> lock(pProcInfo->pendingMutex);
+        while (!pPending->done) {
+            if (!pProcInfo->reading) {
+                pProcInfo->reading = true;
+                TalkToSvc_ReadReply(pProcInfo, lock);
+            }
+            else {
+                pProcInfo->pendingCond.wait(lock);
+            }
+        }
     }
 
-    return nullptr;
+    std::swap(reply, pPending->reply);
+    if (!pPending->bSuccess && reply.header.flags != SVC_STATUS_NO_SPACE) {
+        QNN_ERR("%s::Request %u failed.\n", caller, pPending->requestId);
+    }
+    return pPending->bSuccess;
 }
 
-BOOL StopSvcProcess(std::string proc_name) {
-    ProcInfo_t* pProcInfo = FindProcInfo(proc_name);
-    if (!pProcInfo) {
-        QNN_ERR("TalkToSvc_Inference::Cant find this process %s.\n", proc_name.c_str());
+// Send 'message' and, if 'wait_reply', receive its reply into 'message'.
+bool TalkToSvc_Request(ProcInfo_t* pProcInfo, SvcMessage_t& message, const char* caller, bool wait_reply) {
+    std::shared_ptr<SvcPending_t> pPending;
+
+    if (!TalkToSvc_Send(pProcInfo, message, caller, wait_reply ? &pPending : nullptr)) {
         return false;
     }
+    if (!wait_reply) {
+        return true;
+    }
+    return TalkToSvc_Wait(pProcInfo, pPending, message, caller);
+}
 
-    CloseHandle(pProcInfo->piSvcProcInfo.hProcess);
-    CloseHandle(pProcInfo->piSvcProcInfo.hThread);
-    CloseHandle(pProcInfo->hSvcPipeInWrite);        // This will close pipe write for Svc process, it will exit.
-    CloseHandle(pProcInfo->hSvcPipeOutRead);
-    sg_proc_info_map.erase(proc_name);
-    free(pProcInfo);
-    return true;
+// Remove 'proc_name' from 'sg_proc_info_map' once no model has a replica in it any more.
+// The process exits when the last request holding it is done.
+void StopUnusedSvcProcess(const std::string& proc_name) {
+    std::shared_ptr<ProcInfo_t> pProcInfo;
+    {
+        std::lock_guard<std::mutex> lock(sg_proc_info_mutex);
+        auto it = sg_proc_info_map.find(proc_name);
+        if (it == sg_proc_info_map.end() || IsSvcProcessInUse(proc_name)) {
+            return;
+        }
+        pProcInfo = std::move(it->second);
+        sg_proc_info_map.erase(it);
+    }
+    QNN_INF("StopUnusedSvcProcess::Stop the process %s.\n", proc_name.c_str());
 }
 
-// Send model data to the Svc through share meoory and receive model generated data from share memory.
-BOOL TalkToSvc_Initialize(const std::string& model_name, const std::string& proc_name, const std::string& model_path,
-                          const std::string& backend_lib_path, const std::string& system_lib_path, bool async) {
-    ProcInfo_t* pProcInfo = FindProcInfo(proc_name);
-    if (!pProcInfo) {
-        pProcInfo = CreateSvcProcess(proc_name);
+bool TalkToSvc_Load(ProcInfo_t* pProcInfo, const std::string& model_name, const std::string& model_path,
+                    const std::string& backend_lib_path, const std::string& system_lib_path,
+                    const std::vector<LoraAdapter>& lora_adapters, bool async) {
+    SvcMessage_t message;
+    message.Reset(SVC_CMD_LOAD, 0);
+    message.header.flags = async ? SVC_FLAG_ASYNC : 0;
+    message.strings.push_back(model_name);
+    message.strings.push_back(model_path);
+    message.strings.push_back(backend_lib_path);
+    message.strings.push_back(system_lib_path);
+    SvcEncodeLoraAdapters(message, lora_adapters);
+
+    return TalkToSvc_Request(pProcInfo, message, "TalkToSvc_Load", !async);
+}
 
-        if (!pProcInfo) return false;
+// Whether 'pDead' lived so shortly that replacing it counts as a fast restart.
+bool IsFastRestart(const ProcInfo_t* pDead) {
+    return std::chrono::steady_clock::now() - pDead->startTime < std::chrono::milliseconds(SVC_FAST_RESTART_MS);
+}
+
+// Replace the broken process 'pDead' of 'proc_name' by a new one and load the models which had a replica in it
+// again, with the arguments of their ModelInitialize(). Threads which find the same process broken wait for the
+// first one to replace it. A process no model uses any more is dropped instead.
+bool RestartSvcProcess(const std::string& proc_name, const std::shared_ptr<ProcInfo_t>& pDead) {
+    std::lock_guard<std::mutex> restartLock(pDead->restartMutex);
+
+    std::vector<std::pair<std::string, std::shared_ptr<SvcModel_t>>> models;
+    {
+        std::lock_guard<std::mutex> lock(sg_proc_info_mutex);
+        auto it = sg_proc_info_map.find(proc_name);
+        if (it == sg_proc_info_map.end() || it->second != pDead) {
+            return it != sg_proc_info_map.end();    // Already replaced by another thread, or stopped.
+        }
+        if (!IsSvcProcessInUse(proc_name)) {
+            sg_proc_info_map.erase(it);
+            return false;
+        }
+        for (auto& model : sg_model_info_map) {
+            std::lock_guard<std::mutex> modelLock(model.second->mutex);
+            for (auto& pReplica : model.second->replicas) {
+                if (pReplica->proc_name == proc_name) {
+                    models.push_back(model);
+                    break;
+                }
+            }
+        }
     }
 
-    HANDLE hSvcPipeInWrite = pProcInfo->hSvcPipeInWrite;
-    HANDLE hSvcPipeOutRead = pProcInfo->hSvcPipeOutRead;
-    DWORD dwRead = 0, dwWrite = 0;
-    BOOL bSuccess;
-    std::string async_str = "sync";
+    QNN_WAR("RestartSvcProcess::Svc process %s died, restarting it with %d models.\n", proc_name.c_str(), (int)models.size());
+    TimerHelper timerHelper;
+    std::shared_ptr<ProcInfo_t> pProcInfo = CreateSvcProcess(proc_name);
+    if (!pProcInfo) {
+        return false;
+    }
+    pProcInfo->fastRestarts = IsFastRestart(pDead.get()) ? pDead->fastRestarts + 1 : 0;
+    for (auto& model : models) {
+        SvcModel_t* pModel = model.second.get();
+        if (!TalkToSvc_Load(pProcInfo.get(), model.first, pModel->model_path, pModel->backend_lib_path, pModel->system_lib_path,
+                            pModel->lora_adapters, false)) {
+            QNN_ERR("RestartSvcProcess::Failed to load %s into the new process %s.\n", model.first.c_str(), proc_name.c_str());
+            return false;
+        }
+    }
 
-    if (async) {
-        async_str = "async";
+    {
+        std::lock_guard<std::mutex> lock(sg_proc_info_mutex);
+        auto it = sg_proc_info_map.find(proc_name);
+        if (it == sg_proc_info_map.end() || it->second != pDead) {
+            return false;       // The process was stopped meanwhile.
+        }
+        it->second = pProcInfo;
+        for (auto& model : models) {
+            std::lock_guard<std::mutex> modelLock(model.second->mutex);
+            for (auto& pReplica : model.second->replicas) {
+                if (pReplica->proc_name == proc_name) {
+                    pReplica->pProcInfo = pProcInfo;
+                    pReplica->latencyUs = 0;
+                }
+            }
+        }
     }
+    timerHelper.Print("RestartSvcProcess " + proc_name);
 
-    std::string command = "l" + model_name + ";" + model_path + ";" + backend_lib_path + ";" + system_lib_path + ";" + async_str;
-    dwRead = (DWORD)command.length() + 1;
+    return true;
+}
 
-    TimerHelper timerHelper;
-    // Write command to Svc.
-    bSuccess = WriteFile(hSvcPipeInWrite, command.c_str(), dwRead, &dwWrite, NULL);
-    // QNN_INF("TalkToSvc_Initialize::WriteToPipe: %s dwRead = %d dwWrite = %d\n", command.c_str(), dwRead, dwWrite);
-    if (!bSuccess) return false;
-
-    if (!async) {
-        // Read command from Svc.
-        bSuccess = ReadFile(hSvcPipeOutRead, g_buffer, GLOBAL_BUFSIZE, &dwRead, NULL);
-        if(dwRead) {
-            g_buffer[dwRead] = 0;
-            QNN_INF("TalkToSvc_Initialize::ReadFromPipe: %s dwRead = %d\n", g_buffer, dwRead);
+// Runs on a thread of each Svc process until it exits. If it didn't exit because the channel was closed, the
+// requests waiting for it fail right away and it is restarted, so the replicas which don't get inferences while
+// it is down come back too. A process which keeps dying soon after starting is left to the next inference.
+void WatchSvcProcess(ProcInfo_t* pProcInfo) {
+    int exitCode = 0;
+    if (!pal::process::waitForExit(pProcInfo->hSvcProcess, exitCode) || pProcInfo->stopping) {
+        return;
+    }
+    QNN_ERR("WatchSvcProcess::Svc process %s exited with code %d.\n", pProcInfo->proc_name.c_str(), exitCode);
+    pProcInfo->broken = true;
+    SvcChannelPeerExited(pProcInfo->channel);
+
+    if (IsFastRestart(pProcInfo) && pProcInfo->fastRestarts >= SVC_MAX_FAST_RESTARTS) {
+        QNN_ERR("WatchSvcProcess::Svc process %s died %u times in a row soon after starting, not restarting it.\n",
+                pProcInfo->proc_name.c_str(), pProcInfo->fastRestarts + 1);
+        return;
+    }
+    std::shared_ptr<ProcInfo_t> pDead = FindProcInfo(pProcInfo->proc_name);
+    if (pDead.get() == pProcInfo) {
+        RestartSvcProcess(pProcInfo->proc_name, pDead);
+    }
+    // 'pDead' may hold the last reference, then ~ProcInfo() runs here and detaches this thread.
+}
+
+// Find 'proc_name' or start it, replacing it first if it died.
+std::shared_ptr<ProcInfo_t> GetSvcProcess(const std::string& proc_name) {
+    std::shared_ptr<ProcInfo_t> pProcInfo;
+    {
+        std::lock_guard<std::mutex> lock(sg_proc_info_mutex);
+        auto it = sg_proc_info_map.find(proc_name);
+        if (it != sg_proc_info_map.end()) {
+            pProcInfo = it->second;
         }
         else {
-            QNN_ERR("TalkToSvc_Initialize::ReadFromPipe: Failed to read from hSvcPipeOutRead, perhaps child process died.\n");
+            pProcInfo = CreateSvcProcess(proc_name);
+            if (pProcInfo) {
+                sg_proc_info_map.insert(std::make_pair(proc_name, pProcInfo));
+            }
+            return pProcInfo;
+        }
+    }
+
+    if (pProcInfo->broken) {
+        RestartSvcProcess(proc_name, pProcInfo);
+        pProcInfo = FindProcInfo(proc_name);
+        if (!pProcInfo) {
+            return GetSvcProcess(proc_name);        // Dropped as no model used it, start a new one.
         }
-        if (!bSuccess || dwRead == 0) return false;
     }
+    return pProcInfo;
+}
 
+// Send model data to the Svc through share meoory and receive model generated data from share memory.
+bool TalkToSvc_Initialize(const std::string& model_name, const std::string& proc_name, const std::string& model_path,
+                          const std::string& backend_lib_path, const std::string& system_lib_path,
+                          const std::vector<LoraAdapter>& lora_adapters, bool async) {
+    // Reserve the name before loading, a second model of the same name would be loaded and never released.
+    {
+        std::lock_guard<std::mutex> lock(sg_proc_info_mutex);
+        if (sg_model_info_map.count(model_name) || !sg_model_loading.insert(model_name).second) {
+            QNN_ERR("TalkToSvc_Initialize::The model %s is already loaded.\n", model_name.c_str());
+            return false;
+        }
+    }
+    struct LoadingName {
+        const std::string& name;
+        bool reserved;
+        ~LoadingName() {
+            if (reserved) {
+                std::lock_guard<std::mutex> lock(sg_proc_info_mutex);
+                sg_model_loading.erase(name);
+            }
+        }
+    } loading{model_name, true};
+
+    std::shared_ptr<ProcInfo_t> pProcInfo = GetSvcProcess(proc_name);
+    if (!pProcInfo) return false;
+
+    TimerHelper timerHelper;
+    if (!TalkToSvc_Load(pProcInfo.get(), model_name, model_path, backend_lib_path, system_lib_path, lora_adapters, async)) {
+        StopUnusedSvcProcess(proc_name);
+        return false;
+    }
     timerHelper.Print("TalkToSvc_Initialize::Pipe talk");
 
-    // Add "model_name" to "sg_model_info_map".
-    sg_model_info_map.insert(std::make_pair(model_name, pProcInfo));
+    std::shared_ptr<SvcModel_t> pModel = std::make_shared<SvcModel_t>();
+    pModel->proc_name = proc_name;
+    pModel->model_path = model_path;
+    pModel->backend_lib_path = backend_lib_path;
+    pModel->system_lib_path = system_lib_path;
+    pModel->lora_adapters = lora_adapters;
+    std::shared_ptr<SvcReplica_t> pReplica = std::make_shared<SvcReplica_t>();
+    pReplica->proc_name = proc_name;
+    pReplica->pProcInfo = pProcInfo;
+    pModel->replicas.push_back(pReplica);
+
+    // Add "model_name" to "sg_model_info_map", the reservation is dropped under the same lock.
+    std::lock_guard<std::mutex> lock(sg_proc_info_mutex);
+    sg_model_info_map.insert(std::make_pair(model_name, pModel));
+    sg_model_loading.erase(model_name);
+    loading.reserved = false;
 
-    return bSuccess;
+    return true;
 }
 
-BOOL TalkToSvc_Destroy(std::string model_name, std::string proc_name) {
-    ProcInfo_t* pProcInfo = FindProcInfo(proc_name);
-    if (!pProcInfo) {
-        QNN_ERR("TalkToSvc_Destroy::Cant find this process %s.\n", proc_name.c_str());
+bool TalkToSvc_Release(ProcInfo_t* pProcInfo, const std::string& model_name) {
+    SvcMessage_t message;
+    message.Reset(SVC_CMD_RELEASE, 0);
+    message.strings.push_back(model_name);
+
+    return TalkToSvc_Request(pProcInfo, message, "TalkToSvc_Release", true);
+}
+
+// The inputs and outputs of 'model_name', asked from its first process once and kept with the model.
+bool TalkToSvc_GetInfo(const std::string& model_name, const std::string& proc_name,
+                       std::vector<TensorInfo>& inputs, std::vector<TensorInfo>& outputs) {
+    std::shared_ptr<SvcModel_t> pModel = FindSvcModel(model_name, proc_name);
+    if (!pModel) {
+        QNN_ERR("TalkToSvc_GetInfo::Cant find the model %s in the process %s.\n", model_name.c_str(), proc_name.c_str());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> infoLock(pModel->infoMutex);
+    if (!pModel->infoKnown) {
+        std::shared_ptr<ProcInfo_t> pProcInfo;
+        {
+            std::lock_guard<std::mutex> lock(pModel->mutex);
+            pProcInfo = pModel->replicas[0]->pProcInfo;
+        }
+
+        SvcMessage_t message;
+        message.Reset(SVC_CMD_INFO, 0);
+        message.strings.push_back(model_name);
+        if (!TalkToSvc_Request(pProcInfo.get(), message, "TalkToSvc_GetInfo", true)) {
+            return false;
+        }
+        if (!SvcDecodeTensorInfos(message, pModel->inputs, pModel->outputs)) {
+            QNN_ERR("TalkToSvc_GetInfo::Malformed reply for the model %s.\n", model_name.c_str());
+            return false;
+        }
+        pModel->infoKnown = true;
+    }
+
+    inputs = pModel->inputs;
+    outputs = pModel->outputs;
+    return true;
+}
+
+// Load 'model_name' into 'replicas' Svc processes in all: the one of ModelInitialize() and "<proc_name>#1",
+// "<proc_name>#2", ... Fewer replicas than now release the model from the last ones.
+bool TalkToSvc_SetReplicas(const std::string& model_name, uint32_t replicas) {
+    std::shared_ptr<SvcModel_t> pModel;
+    {
+        std::lock_guard<std::mutex> lock(sg_proc_info_mutex);
+        auto it = sg_model_info_map.find(model_name);
+        if (it != sg_model_info_map.end()) {
+            pModel = it->second;
+        }
+    }
+    if (!pModel) {
+        QNN_ERR("TalkToSvc_SetReplicas::Cant find this model %s.\n", model_name.c_str());
         return false;
     }
+    replicas = std::max(replicas, 1u);
 
-    HANDLE hSvcPipeInWrite = pProcInfo->hSvcPipeInWrite;
-    HANDLE hSvcPipeOutRead = pProcInfo->hSvcPipeOutRead;
-    DWORD dwRead = 0, dwWrite = 0;
-    BOOL bSuccess;
+    std::lock_guard<std::mutex> configLock(pModel->configMutex);
+    if (FindSvcModel(model_name, pModel->proc_name) != pModel) {
+        QNN_ERR("TalkToSvc_SetReplicas::The model %s was destroyed.\n", model_name.c_str());
+        return false;
+    }
 
-    std::string command = "r" + model_name;
-    dwRead = (DWORD)command.length() + 1;
+    size_t count = 0;
+    {
+        std::lock_guard<std::mutex> lock(pModel->mutex);
+        count = pModel->replicas.size();
+    }
 
     TimerHelper timerHelper;
-    // Write command to Svc.
-    bSuccess = WriteFile(hSvcPipeInWrite, command.c_str(), dwRead, &dwWrite, NULL);
-    QNN_INF("TalkToSvc_Destroy::WriteToPipe: %s dwRead = %d dwWrite = %d\n", command.c_str(), dwRead, dwWrite);
-    if (!bSuccess) return false;
+    for (; count < replicas; count++) {
+        std::string proc_name = pModel->proc_name + "#" + std::to_string(count);
+        std::shared_ptr<ProcInfo_t> pProcInfo = GetSvcProcess(proc_name);
+        if (!pProcInfo) {
+            return false;
+        }
+        if (!TalkToSvc_Load(pProcInfo.get(), model_name, pModel->model_path, pModel->backend_lib_path, pModel->system_lib_path,
+                            pModel->lora_adapters, false)) {
+            StopUnusedSvcProcess(proc_name);
+            return false;
+        }
 
-    // Read command from Svc.
-    bSuccess = ReadFile(hSvcPipeOutRead, g_buffer, GLOBAL_BUFSIZE, &dwRead, NULL);
-    if (dwRead) {
-        g_buffer[dwRead] = 0;
-        QNN_INF("TalkToSvc_Destroy::ReadFromPipe: %s dwRead = %d\n", g_buffer, dwRead);
+        std::shared_ptr<SvcReplica_t> pReplica = std::make_shared<SvcReplica_t>();
+        pReplica->proc_name = proc_name;
+        pReplica->pProcInfo = pProcInfo;
+        std::lock_guard<std::mutex> lock(pModel->mutex);
+        pModel->replicas.push_back(pReplica);
     }
-    else {
-        QNN_ERR("TalkToSvc_Destroy::ReadFromPipe: Failed to read from hSvcPipeOutRead, perhaps child process died.\n");
+
+    bool bSuccess = true;
+    for (; count > replicas; count--) {
+        std::shared_ptr<SvcReplica_t> pReplica;
+        std::shared_ptr<ProcInfo_t> pProcInfo;
+        {
+            std::lock_guard<std::mutex> lock(pModel->mutex);
+            pReplica = pModel->replicas.back();
+            pProcInfo = pReplica->pProcInfo;
+            pModel->replicas.pop_back();
+        }
+        if (!TalkToSvc_Release(pProcInfo.get(), model_name)) {
+            bSuccess = false;
+        }
+        StopUnusedSvcProcess(pReplica->proc_name);
+    }
+    timerHelper.Print("TalkToSvc_SetReplicas " + model_name);
+
+    return bSuccess;
+}
+
+bool TalkToSvc_Destroy(std::string model_name, std::string proc_name) {
+    std::shared_ptr<SvcModel_t> pModel = FindSvcModel(model_name, proc_name);
+    if (!pModel) {
+        QNN_ERR("TalkToSvc_Destroy::Cant find the model %s in the process %s.\n", model_name.c_str(), proc_name.c_str());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> configLock(pModel->configMutex);
+    std::vector<std::shared_ptr<SvcReplica_t>> replicas;
+    {
+        std::lock_guard<std::mutex> lock(sg_proc_info_mutex);
+        auto it = sg_model_info_map.find(model_name);
+        if (it == sg_model_info_map.end() || it->second != pModel) {
+            QNN_ERR("TalkToSvc_Destroy::The model %s was destroyed.\n", model_name.c_str());
+            return false;
+        }
+        sg_model_info_map.erase(it);
+
+        std::lock_guard<std::mutex> modelLock(pModel->mutex);
+        replicas = pModel->replicas;
     }
-    if (!bSuccess || dwRead == 0) return false;
-    timerHelper.Print("TalkToSvc_Destroy::Pipe talk");
 
-    sg_model_info_map.erase(model_name);
-    if(sg_model_info_map.size() == 0) {     // If no model in this process, stop this process.
-        QNN_INF("TalkToSvc_Destroy::StopSvcProcess.\n");
-        StopSvcProcess(proc_name);
+    TimerHelper timerHelper;
+    bool bSuccess = true;
+    for (auto& pReplica : replicas) {
+        std::shared_ptr<ProcInfo_t> pProcInfo;
+        {
+            std::lock_guard<std::mutex> lock(pModel->mutex);
+            pProcInfo = pReplica->pProcInfo;
+        }
+        if (!TalkToSvc_Release(pProcInfo.get(), model_name)) {
+            bSuccess = false;
+        }
+        // If no model in this process, stop this process.
+        StopUnusedSvcProcess(pReplica->proc_name);
     }
+    timerHelper.Print("TalkToSvc_Destroy::Pipe talk");
 
     return bSuccess;
 }
 
-// The format of strStringSize: "124,3333,434343,132", included the inputSize content.
-void ShareMemToVector(std::string strBufferArray, uint8_t* lpBase, std::vector<uint8_t*>& buffers, std::vector<size_t>& size) {
-    std::vector<std::string> strArray;
-    std::vector<std::string> strOffsetArray;
-    std::vector<std::string> strSizeArray;
-    split_string(strArray, strBufferArray, '=');
-    split_string(strOffsetArray, strArray[0], ',');
-    split_string(strSizeArray, strArray[1], ',');
+// Ask every Svc process to drop its mapping of 'share_memory_name' before the share memory is deleted. Otherwise
+// the mapping keeps the memory alive, and a new share memory of the same name would not be seen by the Svc.
+bool TalkToSvc_UnmapShareMem(const std::string& share_memory_name) {
+    bool bSuccess = true;
+
+    // Don't hold the map while waiting for the replies, inferences and restarts need it meanwhile.
+    std::vector<std::shared_ptr<ProcInfo_t>> processes;
+    {
+        std::lock_guard<std::mutex> lock(sg_proc_info_mutex);
+        for (auto& it : sg_proc_info_map) {
+            processes.push_back(it.second);
+        }
+    }
 
-    size_t offset = 0;
-    size_t dataSize = 0;
+    for (auto& pProcInfo : processes) {
+        SvcMessage_t message;
+        message.Reset(SVC_CMD_UNMAP, 0);
+        message.strings.push_back(share_memory_name);
 
-    // Perhaps the data in buffer is not in order.
-    for (int i = 0; i < strOffsetArray.size(); i++) {
-        offset = std::stoull(strOffsetArray[i]);
-        dataSize = std::stoull(strSizeArray[i]);
-        size.push_back(dataSize);
-        buffers.push_back(reinterpret_cast<uint8_t*>(lpBase + offset));
+        if (!TalkToSvc_Request(pProcInfo.get(), message, "TalkToSvc_UnmapShareMem", true)) {
+            bSuccess = false;
+        }
     }
+
+    return bSuccess;
 }
 
-// Copy data to 'pShareMemInfo->lpBase'. If the data in 'buffers' has been in the area of share memory, don't copy.
-std::pair<std::string, std::string> VectorToShareMem(size_t share_memory_size, uint8_t* lpBase, std::vector<uint8_t*>& buffers, std::vector<size_t>& size) {
-    QNN_INF("VectorToShareMem Start. size = %llu\n", share_memory_size);
-    //TimerHelper timerHelper;
+// Restore the buffers described by 'descs' in the share memory, rejecting descriptors outside of it.
+bool ShareMemToVector(const std::vector<SvcBufferDesc_t>& descs, size_t share_memory_size, uint8_t* lpBase,
+                      std::vector<uint8_t*>& buffers, std::vector<size_t>& size) {
+    for (const SvcBufferDesc_t& desc : descs) {
+        if (desc.offset > share_memory_size || desc.size > share_memory_size - desc.offset) {
+            QNN_ERR("ShareMemToVector::Buffer at %llu size %llu is outside of the share memory.\n",
+                    (unsigned long long)desc.offset, (unsigned long long)desc.size);
+            return false;
+        }
+        size.push_back((size_t)desc.size);
+        buffers.push_back(lpBase + desc.offset);
+    }
+    return true;
+}
+
+// Copy data to 'pShareMemInfo->lpBase' and describe it in 'descs'. If the data in 'buffers' has been in the area of share memory, don't copy.
+bool VectorToShareMem(size_t share_memory_size, uint8_t* lpBase, std::vector<uint8_t*>& buffers, std::vector<size_t>& size,
+                      std::vector<SvcBufferDesc_t>& descs) {
+    QNN_INF("VectorToShareMem Start. size = %llu\n", (unsigned long long)share_memory_size);
 
-    std::string strOffsetArray = "";
-    std::string strSizeArray = "";
     size_t offset = 0;
     size_t dataSize = 0;
     uint8_t* buffer = nullptr;
+    uint8_t* lpEnd = lpBase + share_memory_size;
 
-    // How to handle the case - part of the data in buffers are in the share memory?
-    // Calculate the offset, avoid overflow the input data which already in the share memory.
+    // Copy behind the data which is already in the share memory, so that it isn't overwritten.
     for (int i = 0; i < buffers.size(); i++) {
         buffer = buffers[i];
-        if (buffer >= lpBase && buffer <= lpBase + share_memory_size) {     // This buffer is in the share memory area.
-            offset += size[i];
+        if (buffer >= lpBase && buffer < lpEnd) {     // This buffer is in the share memory area.
+            offset = std::max(offset, (size_t)(buffer - lpBase) + size[i]);
         }
     }
 
     // Copy the data which is not in share memory to share memory.
+    descs.resize(buffers.size());
     for (int i = 0; i < buffers.size(); i++) {
         buffer = buffers[i];
         dataSize = size[i];
-        if (buffer >= lpBase && buffer <= lpBase + share_memory_size) {     // This buffer is in the share memory area.
-            strOffsetArray += std::to_string(buffer - lpBase) + ",";
-            //QNN_INF("VectorToShareMem in buffers, ignore copy.\n");
+        if (buffer >= lpBase && buffer < lpEnd) {     // This buffer is in the share memory area.
+            descs[i].offset = buffer - lpBase;
         }
         else {
-            memcpy((uint8_t*)lpBase + offset, buffers[i], dataSize);        // This buffer is NOT in the share memory area, copy it.
-            strOffsetArray += std::to_string(offset) + ",";
+            if (offset > share_memory_size || dataSize > share_memory_size - offset) {
+                QNN_ERR("VectorToShareMem::The data doesn't fit into the share memory of size %llu.\n", (unsigned long long)share_memory_size);
+                return false;
+            }
+            memcpy(lpBase + offset, buffer, dataSize);        // This buffer is NOT in the share memory area, copy it.
+            descs[i].offset = offset;
             offset += dataSize;
-            //QNN_INF("VectorToShareMem NOT in buffers, copy...\n");
         }
-        strSizeArray += std::to_string(dataSize) + ",";
+        descs[i].size = dataSize;
     }
 
-    //timerHelper.Print("VectorToShareMem::offset = " + std::to_string(offset));
-    // QNN_INF("VectorToShareMem End.\n");
-    // QNN_INF("VectorToShareMem::strOffsetArray = %s.\n", strOffsetArray.c_str());
-    return std::make_pair(strOffsetArray, strSizeArray);
+    return true;
 }
 
-// Send model data to the Svc through share memory and receive model generated data from share memory.
-BOOL TalkToSvc_Inference(std::string model_name, std::string proc_name, std::string share_memory_name, 
-                         std::vector<uint8_t*>& inputBuffers, std::vector<size_t>& inputSize,
-                         std::vector<uint8_t*>& outputBuffers, std::vector<size_t>& outputSize,
-                         std::string perfProfile) {
-    ProcInfo_t* pProcInfo = FindProcInfo(proc_name);
-    if (!pProcInfo) {
-        QNN_ERR("TalkToSvc_Inference::Cant find this process %s.\n", proc_name.c_str());
-        return false;
+// The replica to run the next inference of 'pModel': the one with the fewest inferences in flight, weighted by
+// its recent latency so that a slow process gets less work. Broken processes are skipped while another one works.
+std::shared_ptr<SvcReplica_t> PickSvcReplica(SvcModel_t* pModel, std::shared_ptr<ProcInfo_t>& pProcInfo) {
+    std::lock_guard<std::mutex> lock(pModel->mutex);
+    size_t count = pModel->replicas.size();
+    size_t start = count > 1 ? pModel->nextReplica++ % count : 0;
+    std::shared_ptr<SvcReplica_t> pBest = pModel->replicas[start];
+    uint64_t bestCost = UINT64_MAX;
+
+    for (size_t i = 0; i < count && count > 1; i++) {
+        const std::shared_ptr<SvcReplica_t>& pReplica = pModel->replicas[(start + i) % count];
+        if (pReplica->pProcInfo->broken) {
+            continue;
+        }
+        uint64_t cost = (uint64_t)(pReplica->inflight + 1) * std::max(pReplica->latencyUs.load(), (uint64_t)1);
+        if (cost < bestCost) {
+            bestCost = cost;
+            pBest = pReplica;
+        }
     }
 
-    ShareMemInfo_t* pShareMemInfo = FindShareMem(share_memory_name);
-    if (!pShareMemInfo) {
-        QNN_ERR("TalkToSvc_Inference::Cant find this share memory %s.\n", share_memory_name.c_str());
-        return false;
+    pProcInfo = pBest->pProcInfo;
+    return pBest;
+}
+
+// Describe the inputs of an arena inference in 'descs': inputs allocated in the arena are used where they are, the
+// others are copied to the start of 'slice'. The rest of 'slice' is the output area, described by the last desc.
+bool VectorToArena(ShareMemArena_t* pArena, const ArenaSlice_t& slice, std::vector<uint8_t*>& buffers,
+                   std::vector<size_t>& size, std::vector<SvcBufferDesc_t>& descs) {
+    uint64_t sliceOffset = ((uint64_t)slice.segment->index << SVC_ARENA_SEGMENT_SHIFT) + (uint64_t)(slice.data - slice.segment->memory.data());
+    size_t offset = 0;
+
+    descs.resize(buffers.size() + 1);
+    for (size_t i = 0; i < buffers.size(); i++) {
+        ArenaSegment_t* pSegment = ArenaFindSegment(pArena, buffers[i]);
+        size_t segmentOffset = pSegment ? (size_t)(buffers[i] - pSegment->memory.data()) : 0;
+        if (pSegment && size[i] <= pSegment->memory.size() - segmentOffset) {
+            descs[i].offset = ((uint64_t)pSegment->index << SVC_ARENA_SEGMENT_SHIFT) + segmentOffset;
+        }
+        else {
+            if (size[i] > slice.size - offset) {
+                QNN_ERR("VectorToArena::The inputs don't fit into the arena slice of size %llu.\n", (unsigned long long)slice.size);
+                return false;
+            }
+            memcpy(slice.data + offset, buffers[i], size[i]);
+            descs[i].offset = sliceOffset + offset;
+            offset += size[i];
+        }
+        descs[i].size = size[i];
     }
 
-    HANDLE hSvcPipeInWrite = pProcInfo->hSvcPipeInWrite;
-    HANDLE hSvcPipeOutRead = pProcInfo->hSvcPipeOutRead;
-    DWORD dwRead = 0, dwWrite = 0;
-    BOOL bSuccess;
+    descs.back().offset = sliceOffset + offset;
+    descs.back().size = slice.size - offset;
+    return true;
+}
 
-    std::string command = "g" + model_name + ";" + share_memory_name + ";" + std::to_string(pShareMemInfo->size) + ";";
-    // 'offset' in share memory(according to 'inputBuffers' data size, so that we can restore this data to 'std::vector<uint8_t*>' in Svc).
-    std::pair<std::string, std::string> strResultArray = VectorToShareMem(pShareMemInfo->size, (uint8_t*)pShareMemInfo->lpBase, inputBuffers, inputSize);
-    command = command + strResultArray.first + "=" + strResultArray.second + ";";
-    command = command + perfProfile;
-    dwRead = (DWORD)command.length() + 1;
+// Restore the outputs of an arena inference, rejecting descriptors outside of the arena.
+bool ArenaToVector(ShareMemArena_t* pArena, const std::vector<SvcBufferDesc_t>& descs, std::vector<uint8_t*>& buffers,
+                   std::vector<size_t>& size) {
+    uint32_t segmentCount = pArena->segmentCount.load(std::memory_order_acquire);
+    for (const SvcBufferDesc_t& desc : descs) {
+        uint64_t index = desc.offset >> SVC_ARENA_SEGMENT_SHIFT;
+        uint64_t offset = desc.offset & SVC_ARENA_OFFSET_MASK;
+        ArenaSegment_t* pSegment = index < segmentCount ? pArena->segments[index] : nullptr;
+        if (!pSegment || offset > pSegment->memory.size() || desc.size > pSegment->memory.size() - offset) {
+            QNN_ERR("ArenaToVector::Buffer at %llx size %llu is outside of the arena.\n",
+                    (unsigned long long)desc.offset, (unsigned long long)desc.size);
+            return false;
+        }
+        size.push_back((size_t)desc.size);
+        buffers.push_back(pSegment->memory.data() + offset);
+    }
+    return true;
+}
+
+// Copy the outputs the Svc returned into the buffers of the caller, whose sizes come in 'outputSize'.
+bool CopyToCallerOutputs(const std::vector<uint8_t*>& buffers, const std::vector<size_t>& size,
+                         std::vector<uint8_t*>& outputBuffers, std::vector<size_t>& outputSize) {
+    if (buffers.size() != outputBuffers.size() || buffers.size() != outputSize.size()) {
+        QNN_ERR("TalkToSvc_Inference::%zu outputs for %zu output buffers.\n", buffers.size(), outputBuffers.size());
+        return false;
+    }
+    for (size_t i = 0; i < buffers.size(); i++) {
+        if (size[i] > outputSize[i]) {
+            QNN_ERR("TalkToSvc_Inference::Output buffer %zu is smaller than %zu bytes.\n", i, size[i]);
+            return false;
+        }
+        memcpy(outputBuffers[i], buffers[i], size[i]);
+        outputSize[i] = size[i];
+    }
+    return true;
+}
 
-    // start_time();
-    // Write command to Svc.
-    bSuccess = WriteFile(hSvcPipeInWrite, command.c_str(), dwRead, &dwWrite, NULL);
-    // QNN_INF("TalkToSvc_Inference::WriteToPipe: %s dwRead = %d dwWrite = %d\n", command.c_str(), dwRead, dwWrite);
-    if (!bSuccess) return false;
+// Copy the outputs the Svc returned into new buffers, which the caller frees like those of a local inference.
+bool CopyToNewOutputs(const std::vector<uint8_t*>& buffers, const std::vector<size_t>& size,
+                      std::vector<uint8_t*>& outputBuffers, std::vector<size_t>& outputSize) {
+    size_t first = outputBuffers.size();
+    for (size_t i = 0; i < buffers.size(); i++) {
+        uint8_t* buffer = (uint8_t*)malloc(std::max(size[i], (size_t)1));
+        if (!buffer) {
+            QNN_ERR("TalkToSvc_Inference::Failed to allocate %zu bytes for output %zu.\n", size[i], i);
+            for (size_t j = first; j < outputBuffers.size(); j++) {
+                free(outputBuffers[j]);
+            }
+            outputBuffers.resize(first);
+            outputSize.resize(first);
+            return false;
+        }
+        memcpy(buffer, buffers[i], size[i]);
+        outputBuffers.push_back(buffer);
+        outputSize.push_back(size[i]);
+    }
+    return true;
+}
 
-    // Read command from Svc.
-    bSuccess = ReadFile(hSvcPipeOutRead, g_buffer, GLOBAL_BUFSIZE, &dwRead, NULL);
-    if(dwRead) {
-        g_buffer[dwRead] = 0;
-        QNN_INF("TalkToSvc_Inference::ReadFromPipe: %s dwRead = %d\n", g_buffer, dwRead);
+// Send model data to the Svc through share memory and receive model generated data from share memory.
+// Without 'share_memory_name' the data goes through a slice of the arena, which is freed before returning: the
+// outputs are copied to buffers the caller frees. 'inputDataTypes', 'nativeOutputs' and 'callerOutputs' are those of
+// LibAppBuilder::ModelInference(), the Svc converts the inputs and outputs.
+bool TalkToSvc_Inference(std::string model_name, std::string proc_name, std::string share_memory_name, 
+                         std::vector<uint8_t*>& inputBuffers, std::vector<size_t>& inputSize,
+                         std::vector<uint8_t*>& outputBuffers, std::vector<size_t>& outputSize,
+                         std::string perfProfile, const std::vector<std::string>& inputDataTypes = std::vector<std::string>(),
+                         bool nativeOutputs = false, bool callerOutputs = false) {
+    std::shared_ptr<SvcModel_t> pModel = FindSvcModel(model_name, proc_name);
+
+    struct OwnedSlice {
+        ArenaSlice_t slice;
+        ~OwnedSlice() { ArenaFree(slice); }
+    } owned;
+    ArenaSlice_t& slice = owned.slice;
+
+    // The types go along only if an input isn't float32, as most inferences have none.
+    bool bFloatInputs = std::all_of(inputDataTypes.begin(), inputDataTypes.end(),
+                                    [](const std::string& dataType) { return dataType == "float32"; });
+
+    // Where the Svc put the outputs, they're copied from there unless the caller reads them in 'share_memory_name'.
+    std::vector<uint8_t*> replyBuffers;
+    std::vector<size_t> replySize;
+
+    ShareMemArena_t* pArena = nullptr;
+    std::shared_ptr<ShareMemInfo_t> pShareMemInfo;     // Held until the outputs are read from it.
+    size_t copySize = 0;
+    uint64_t outputBytes = 0;
+    if (share_memory_name.empty()) {
+        pArena = GetShareMemArena();
+        for (size_t i = 0; i < inputBuffers.size(); i++) {
+            if (!ArenaFindSegment(pArena, inputBuffers[i])) {
+                copySize += inputSize[i];
+            }
+        }
+        outputBytes = pModel ? pModel->outputBytes.load() : 0;
     }
     else {
-        QNN_ERR("TalkToSvc_Inference::ReadFromPipe: Failed to read from hSvcPipeOutRead, perhaps child process died.\n");
+        pShareMemInfo = FindShareMem(share_memory_name);
+        if (!pShareMemInfo) {
+            QNN_ERR("TalkToSvc_Inference::Cant find this share memory %s.\n", share_memory_name.c_str());
+            return false;
+        }
     }
-    if (!bSuccess || dwRead == 0) return false;
-    //print_time("TalkToSvc_Inference::Pipe talk");
 
-    // Read the output data from 'share_memory_name'.
-    if (dwRead) {
-        if (g_buffer[0] == 'F') {  // ACTION_FAILED == Failed.
+    // A process which died is replaced and the inference runs once more. So does an arena inference whose outputs
+    // need a larger slice.
+    bool bRestarted = false;
+    bool bResized = false;
+    for (;;) {
+        std::shared_ptr<ProcInfo_t> pProcInfo;
+        std::shared_ptr<SvcReplica_t> pReplica;
+        if (pModel) {
+            pReplica = PickSvcReplica(pModel.get(), pProcInfo);
+        }
+        else {
+            pProcInfo = FindProcInfo(proc_name);
+        }
+        if (!pProcInfo) {
+            QNN_ERR("TalkToSvc_Inference::Cant find this process %s.\n", proc_name.c_str());
             return false;
         }
 
-        ShareMemToVector(g_buffer, (uint8_t*)pShareMemInfo->lpBase, outputBuffers, outputSize);
-    }
+        thread_local SvcMessage_t message;       // Keeps its capacity, inferences are the hot path.
+        message.Reset(SVC_CMD_RUN, 0);
+        message.strings.push_back(model_name);
+        message.strings.push_back(pArena ? pArena->name : share_memory_name);
+        message.strings.push_back(perfProfile);
+        if (!bFloatInputs) {
+            message.strings.insert(message.strings.end(), inputDataTypes.begin(), inputDataTypes.end());
+        }
+        message.header.flags = nativeOutputs ? SVC_FLAG_NATIVE : 0;
+
+        if (pArena) {
+            message.header.flags |= SVC_FLAG_ARENA;
+            if (!slice.segment && !ArenaAllocate(pArena, copySize + (size_t)outputBytes, slice)) {
+                return false;
+            }
+            if (!VectorToArena(pArena, slice, inputBuffers, inputSize, message.buffers)) {
+                return false;
+            }
+        }
+        else {
+            message.header.value = pShareMemInfo->size();
+            // 'offset' in share memory(according to 'inputBuffers' data size, so that we can restore this data to 'std::vector<uint8_t*>' in Svc).
+            if (!VectorToShareMem(pShareMemInfo->size(), pShareMemInfo->data(), inputBuffers, inputSize, message.buffers)) {
+                return false;
+            }
+        }
 
-    return bSuccess;
+        TimerHelper timerHelper;
+        if (pReplica) pReplica->inflight++;
+        bool bSuccess = TalkToSvc_Request(pProcInfo.get(), message, "TalkToSvc_Inference", true);
+        if (pReplica) {
+            pReplica->inflight--;
+            if (bSuccess) {
+                // Concurrent inferences of the replica all land in the average.
+                uint64_t latencyUs = (uint64_t)(timerHelper.ElapsedMs() * 1000);
+                uint64_t averageUs = pReplica->latencyUs.load();
+                while (!pReplica->latencyUs.compare_exchange_weak(averageUs, averageUs ? (averageUs * 7 + latencyUs) / 8 : latencyUs)) {
+                }
+            }
+        }
+
+        if (bSuccess && pArena) {
+            if (!ArenaToVector(pArena, message.buffers, replyBuffers, replySize)) {
+                return false;
+            }
+            if (pModel) {
+                uint64_t totalSize = 0;
+                for (size_t bytes : replySize) {
+                    totalSize += bytes;
+                }
+                pModel->outputBytes = totalSize;
+            }
+            return callerOutputs ? CopyToCallerOutputs(replyBuffers, replySize, outputBuffers, outputSize)
+                                 : CopyToNewOutputs(replyBuffers, replySize, outputBuffers, outputSize);
+        }
+        if (bSuccess && !callerOutputs) {
+            // Read the output data from 'share_memory_name'.
+            return ShareMemToVector(message.buffers, pShareMemInfo->size(), pShareMemInfo->data(), outputBuffers, outputSize);
+        }
+        if (bSuccess) {
+            return ShareMemToVector(message.buffers, pShareMemInfo->size(), pShareMemInfo->data(), replyBuffers, replySize) &&
+                   CopyToCallerOutputs(replyBuffers, replySize, outputBuffers, outputSize);
+        }
+
+        if (pArena && message.header.flags == SVC_STATUS_NO_SPACE && !bResized) {
+            bResized = true;
+            outputBytes = message.header.value;
+            ArenaFree(slice);
+            slice = ArenaSlice_t();
+            continue;
+        }
+        if (!pReplica || !pProcInfo->broken || bRestarted) {
+            return false;
+        }
+        bRestarted = true;
+        if (!RestartSvcProcess(pReplica->proc_name, pProcInfo)) {
+            return false;
+        }
+    }
 }
 
 #endif
-
@@ -14,102 +14,194 @@
 #include <string>
 #include <sstream>
 #include <map>
+#include <algorithm>
+#include <deque>
+#include <thread>
+#include <unordered_set>
 
 
 // ============================== Service / QAIAppSvc ============================== //
 
-#define ACTION_OK        "OK"
-#define ACTION_FAILED    "Failed"
-
 LibAppBuilder g_LibAppBuilder;
+std::mutex sg_reply_mutex;                  // The model workers share the out pipe.
+
+// Share memory stays mapped between requests, mapping and unmapping it for each one costs page table work and
+// page faults on every access. The application drops the mapping with SVC_CMD_UNMAP before deleting the share memory.
+// A 'share_memory_size' of 0 maps the whole share memory, whatever its size.
+std::shared_ptr<ShareMemInfo_t> OpenShareMem(std::string share_memory_name, size_t share_memory_size) {
+    std::lock_guard<std::mutex> lock(sg_share_mem_mutex);
+    auto it = sg_share_mem_map.find(share_memory_name);
+    if (it != sg_share_mem_map.end() && (share_memory_size == 0 || it->second->size() == share_memory_size)) {
+        return it->second;
+    }
 
-LPVOID OpenShareMem(std::string share_memory_name, size_t share_memory_size) {
-    HANDLE hOpenMapFile = nullptr;
-    LPVOID lpBase = nullptr;
-    ShareMemInfo_t* pShareMemInfo = nullptr;
+    std::shared_ptr<ShareMemInfo_t> pShareMemInfo(new ShareMemInfo_t());
 
-    hOpenMapFile = OpenFileMappingA(FILE_MAP_ALL_ACCESS, NULL, share_memory_name.c_str());
+    if (!pShareMemInfo->open(share_memory_name, share_memory_size)) {
+        QNN_ERR("OpenShareMem::Can't open share memory %s.\n", share_memory_name.c_str());
+        return nullptr;
+    }
+    pShareMemInfo->prefault();
+    QNN_INF("OpenShareMem::Mapped share memory %s size %llu.\n", share_memory_name.c_str(), (unsigned long long)pShareMemInfo->size());
 
-    if (hOpenMapFile) {
-        lpBase = MapViewOfFile(hOpenMapFile, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    sg_share_mem_map[share_memory_name] = pShareMemInfo;
+    return pShareMemInfo;
+}
+
+void CloseShareMem(std::string share_memory_name) {
+    std::lock_guard<std::mutex> lock(sg_share_mem_mutex);
+    if (sg_share_mem_map.erase(share_memory_name)) {
+        QNN_INF("CloseShareMem::Unmapped share memory %s.\n", share_memory_name.c_str());
     }
-    if (lpBase) {
-        pShareMemInfo = (ShareMemInfo_t*)malloc(sizeof(ShareMemInfo_t));
+}
 
-        if (pShareMemInfo) {
-            pShareMemInfo->hCreateMapFile = hOpenMapFile;
-            pShareMemInfo->lpBase = lpBase;
-            pShareMemInfo->size = share_memory_size;
-            // QNN_INF("OpenShareMem::pShareMemInfo %p\n", pShareMemInfo);
-            sg_share_mem_map.insert(std::make_pair(share_memory_name, pShareMemInfo));
-        }
+// Reply to 'request' with 'status' (SVC_STATUS_*) and the output buffers in 'reply.buffers', or the strings in
+// 'reply.strings' which RunRequest() cleared.
+bool WriteReplyStatus(SvcChannel_t& channel, const SvcMessage_t& request, SvcMessage_t& reply, uint32_t status,
+                      uint64_t value, std::vector<uint8_t>& scratch) {
+    reply.header.magic = SVC_PROTOCOL_MAGIC;
+    reply.header.version = SVC_PROTOCOL_VERSION;
+    reply.header.command = SVC_CMD_REPLY;
+    reply.header.requestId = request.header.requestId;
+    reply.header.flags = status;
+    reply.header.value = value;
+    if (status != SVC_STATUS_OK) {
+        reply.buffers.clear();
+        reply.strings.clear();
     }
 
-    return lpBase;
+    SvcEncodeMessage(reply, scratch);
+    std::lock_guard<std::mutex> lock(sg_reply_mutex);
+    return SvcChannelWrite(channel, scratch.data(), scratch.size());
 }
 
-void CloseShareMem(std::string share_memory_name) {
-    ShareMemInfo_t* pShareMemInfo = sg_share_mem_map[share_memory_name];
+bool WriteReply(SvcChannel_t& channel, const SvcMessage_t& request, SvcMessage_t& reply, bool bSuccess,
+                std::vector<uint8_t>& scratch) {
+    return WriteReplyStatus(channel, request, reply, bSuccess ? SVC_STATUS_OK : SVC_STATUS_FAILED, 0, scratch);
+}
 
-    if (pShareMemInfo) {
-        // QNN_INF("CloseShareMem::pShareMemInfo %p\n", pShareMemInfo);
-        UnmapViewOfFile(pShareMemInfo->lpBase);
-        CloseHandle(pShareMemInfo->hCreateMapFile);
-        sg_share_mem_map.erase(share_memory_name);
-        free(pShareMemInfo);
-    }
-    else {
-        QNN_ERR("CloseShareMem::Can't find share memory%s.\n", share_memory_name.c_str());
+// The address of the arena buffer 'desc' in the segment it belongs to, mapping the segment when it is new.
+uint8_t* ArenaBuffer(const std::string& arena_name, const SvcBufferDesc_t& desc) {
+    std::shared_ptr<ShareMemInfo_t> pSegment = OpenShareMem(ArenaSegmentName(arena_name, desc.offset >> SVC_ARENA_SEGMENT_SHIFT), 0);
+    uint64_t offset = desc.offset & SVC_ARENA_OFFSET_MASK;
+    if (!pSegment || offset > pSegment->size() || desc.size > pSegment->size() - offset) {
+        QNN_ERR("ArenaBuffer::Buffer at %llx size %llu is outside of the arena %s.\n",
+                (unsigned long long)desc.offset, (unsigned long long)desc.size, arena_name.c_str());
+        return nullptr;
     }
+    return pSegment->data() + offset;
 }
 
-void ModelLoad(std::string cmdBuf, HANDLE hSvcPipeOutWrite) {
-    BOOL bSuccess;
-    Print_MemInfo("ModelLoad Start.");
+// The data types of the inputs of an SVC_CMD_RUN request, empty if they are all float32.
+std::vector<std::string> RunInputDataTypes(const SvcMessage_t& request) {
+    return std::vector<std::string>(request.strings.begin() + 3, request.strings.end());
+}
 
-    std::vector<std::string> commands;
-    split_string(commands, cmdBuf, ';');
+// Run an inference whose inputs are in the arena of the application and copy the outputs to the output area, the
+// last buffer of the request.
+void ModelRunArena(const SvcMessage_t& request, SvcMessage_t& reply, SvcChannel_t& channel, std::vector<uint8_t>& scratch) {
+    const std::string& model_name = request.strings[0];
+    const std::string& arena_name = request.strings[1];
+    std::string perfProfile       = request.strings[2];
 
-    std::string model_name                  = commands[0];
-    std::string model_path                  = commands[1];
-    std::string backend_lib_path            = commands[2];
-    std::string system_lib_path             = commands[3];
-    std::string async_str                   = commands[4];
+    std::vector<uint8_t*> inputBuffers;
+    std::vector<uint8_t*> outputBuffers;
+    std::vector<size_t> outputSize;
+    std::vector<std::string> inputDataTypes = RunInputDataTypes(request);
+    uint8_t* lpOutput = request.buffers.empty() ? nullptr : ArenaBuffer(arena_name, request.buffers.back());
+    bool bSuccess = lpOutput != nullptr;
 
-    Print_MemInfo("ModelLoad::ModelInitialize Start.");
-    QNN_INF("ModelLoad::ModelInitialize::Model name %s\n", model_name.c_str());
-    std::vector<LoraAdapter> Adapters ;
-    bSuccess = g_LibAppBuilder.ModelInitialize(model_name.c_str(), model_path, backend_lib_path, system_lib_path, Adapters);
-    QNN_INF("ModelLoad::ModelInitialize End ret = %d\n", bSuccess);
-    Print_MemInfo("ModelLoad::ModelInitialize End.");
+    for (size_t i = 0; bSuccess && i + 1 < request.buffers.size(); i++) {
+        inputBuffers.push_back(ArenaBuffer(arena_name, request.buffers[i]));
+        bSuccess = inputBuffers.back() != nullptr;
+    }
 
-    if (!(async_str == "async")) {
-        if(bSuccess) {
-            bSuccess = WriteFile(hSvcPipeOutWrite, ACTION_OK, (DWORD)strlen(ACTION_OK) + 1, NULL, NULL);
-        }
-        else {
-            bSuccess = WriteFile(hSvcPipeOutWrite, ACTION_FAILED, (DWORD)strlen(ACTION_FAILED) + 1, NULL, NULL);
+    if (bSuccess) {
+        bSuccess = g_LibAppBuilder.ModelInference(model_name.c_str(), inputBuffers, inputDataTypes, outputBuffers, outputSize, perfProfile,
+                                                  (request.header.flags & SVC_FLAG_NATIVE) != 0);
+    }
+    if (!bSuccess) {
+        WriteReply(channel, request, reply, false, scratch);
+        return;
+    }
+
+    uint64_t totalSize = 0;
+    for (size_t size : outputSize) {
+        totalSize += size;
+    }
+    const SvcBufferDesc_t& area = request.buffers.back();
+    if (totalSize > area.size) {
+        for (uint8_t* buffer : outputBuffers) {
+            free(buffer);
         }
+        WriteReplyStatus(channel, request, reply, SVC_STATUS_NO_SPACE, totalSize, scratch);
+        return;
+    }
+
+    reply.buffers.resize(outputBuffers.size());
+    uint64_t offset = 0;
+    for (size_t i = 0; i < outputBuffers.size(); i++) {
+        memcpy(lpOutput + offset, outputBuffers[i], outputSize[i]);
+        free(outputBuffers[i]);
+        reply.buffers[i].offset = area.offset + offset;
+        reply.buffers[i].size = outputSize[i];
+        offset += outputSize[i];
+    }
+
+    WriteReply(channel, request, reply, true, scratch);
+}
+
+void ModelLoad(const SvcMessage_t& request, SvcMessage_t& reply, SvcChannel_t& channel, std::vector<uint8_t>& scratch) {
+    bool bSuccess = false;
+    Print_MemInfo("ModelLoad Start.");
+
+    std::vector<LoraAdapter> Adapters ;
+    if (request.strings.size() >= 4 && SvcDecodeLoraAdapters(request, 4, Adapters)) {
+        const std::string& model_name       = request.strings[0];
+        const std::string& model_path       = request.strings[1];
+        const std::string& backend_lib_path = request.strings[2];
+        const std::string& system_lib_path  = request.strings[3];
+
+        Print_MemInfo("ModelLoad::ModelInitialize Start.");
+        QNN_INF("ModelLoad::ModelInitialize::Model name %s\n", model_name.c_str());
+        bSuccess = g_LibAppBuilder.ModelInitialize(model_name.c_str(), model_path, backend_lib_path, system_lib_path, Adapters);
+        QNN_INF("ModelLoad::ModelInitialize End ret = %d\n", bSuccess);
+        Print_MemInfo("ModelLoad::ModelInitialize End.");
+    }
+
+    if (!(request.header.flags & SVC_FLAG_ASYNC)) {
+        reply.buffers.clear();
+        WriteReply(channel, request, reply, bSuccess, scratch);
     }
 }
 
-void ModelRun(std::string cmdBuf, HANDLE hSvcPipeOutWrite) {
-    BOOL bSuccess;
+void ModelRun(const SvcMessage_t& request, SvcMessage_t& reply, SvcChannel_t& channel, std::vector<uint8_t>& scratch) {
+    bool bSuccess;
     Print_MemInfo("ModelRun Start.");
     // TimerHelper timerHelper;
 
-    std::vector<std::string> commands;
-    split_string(commands, cmdBuf, ';');
-
-    std::string model_name        = commands[0];
-    std::string share_memory_name = commands[1];
-    size_t share_memory_size      = std::stoull(commands[2]);
-    std::string strBufferArray    = commands[3];
-    std::string perfProfile       = commands[4];
+    if (request.strings.size() < 3) {
+        WriteReply(channel, request, reply, false, scratch);
+        return;
+    }
+    if (request.header.flags & SVC_FLAG_ARENA) {
+        ModelRunArena(request, reply, channel, scratch);
+        return;
+    }
 
+    const std::string& model_name        = request.strings[0];
+    const std::string& share_memory_name = request.strings[1];
+    std::string perfProfile              = request.strings[2];
+    size_t share_memory_size             = (size_t)request.header.value;
+    std::vector<std::string> inputDataTypes = RunInputDataTypes(request);
 
     // Open share memory and read the inference data from share memory.
-    LPVOID lpBase = OpenShareMem(share_memory_name, share_memory_size);
+    std::shared_ptr<ShareMemInfo_t> pShareMemInfo = OpenShareMem(share_memory_name, share_memory_size);
+    if (!pShareMemInfo) {
+        WriteReply(channel, request, reply, false, scratch);
+        return;
+    }
+    uint8_t* lpBase = pShareMemInfo->data();
 
     std::vector<uint8_t*> inputBuffers;
     std::vector<size_t> inputSize;
@@ -118,91 +210,238 @@ void ModelRun(std::string cmdBuf, HANDLE hSvcPipeOutWrite) {
     outputSize.push_back(12345);
 
     // Fill data from 'pShareMemInfo->lpBase' to 'inputBuffers' vector before inference the model.
-    ShareMemToVector(strBufferArray, (uint8_t*)lpBase, inputBuffers, inputSize);
+    bSuccess = ShareMemToVector(request.buffers, share_memory_size, lpBase, inputBuffers, inputSize);
 
-    Print_MemInfo("ModelRun::ModelInference Start.");
-    //QNN_INF("ModelRun::ModelInference %s\n", model_name.c_str());
-    bSuccess = g_LibAppBuilder.ModelInference(model_name.c_str(), inputBuffers, outputBuffers, outputSize, perfProfile);
-    //QNN_INF("ModelRun::ModelInference End ret = %d\n", bSuccess);
-    Print_MemInfo("ModelRun::ModelInference End.");
+    if (bSuccess) {
+        Print_MemInfo("ModelRun::ModelInference Start.");
+        //QNN_INF("ModelRun::ModelInference %s\n", model_name.c_str());
+        bSuccess = g_LibAppBuilder.ModelInference(model_name.c_str(), inputBuffers, inputDataTypes, outputBuffers, outputSize, perfProfile,
+                                                  (request.header.flags & SVC_FLAG_NATIVE) != 0);
+        //QNN_INF("ModelRun::ModelInference End ret = %d\n", bSuccess);
+        Print_MemInfo("ModelRun::ModelInference End.");
+    }
 
     // Fill data from outputBuffers to 'pShareMemInfo->lpBase' and send back to client.
-    std::pair<std::string, std::string> strResultArray = VectorToShareMem(share_memory_size, (uint8_t*)lpBase, outputBuffers, outputSize);
+    if (bSuccess) {
+        bSuccess = VectorToShareMem(share_memory_size, lpBase, outputBuffers, outputSize, reply.buffers);
+    }
 
     outputBuffers.clear();
     outputSize.clear();
 
-    Print_MemInfo("ModelRun::CloseShareMem Start.");
-    CloseShareMem(share_memory_name);
-    Print_MemInfo("ModelRun::CloseShareMem End.");
-
     // timerHelper.Print("ModelRun");
 
-    DWORD dwRead = 0, dwWrite = 0;
-    std::string command = strResultArray.first + "=" + strResultArray.second;
-    dwRead = (DWORD)command.length() + 1;
-    if (bSuccess) {
-        bSuccess = WriteFile(hSvcPipeOutWrite, command.c_str(), dwRead, &dwWrite, NULL);
-    }
-    else {
-        bSuccess = WriteFile(hSvcPipeOutWrite, ACTION_FAILED, (DWORD)strlen(ACTION_FAILED) + 1, NULL, NULL);
-    }
+    WriteReply(channel, request, reply, bSuccess, scratch);
 }
 
-void ModelRelease(std::string cmdBuf, HANDLE hSvcPipeOutWrite) {
-    BOOL bSuccess;
+void ModelRelease(const SvcMessage_t& request, SvcMessage_t& reply, SvcChannel_t& channel, std::vector<uint8_t>& scratch) {
+    bool bSuccess = false;
     Print_MemInfo("ModelRelease Start.");
 
-    std::vector<std::string> commands;
-    split_string(commands, cmdBuf, ';');
+    if (request.strings.size() == 1) {
+        const std::string& model_name = request.strings[0];
 
-    std::string model_name = commands[0];
+        Print_MemInfo("ModelRelease::ModelDestroy Start.");
+        QNN_INF("ModelRelease::ModelDestroy %s\n", model_name.c_str());
+        bSuccess = g_LibAppBuilder.ModelDestroy(model_name.c_str());
+        QNN_INF("ModelRelease::ModelDestroy End ret = %d\n", bSuccess);
+        Print_MemInfo("ModelRelease::ModelDestroy End.");
+    }
 
-    Print_MemInfo("ModelRelease::ModelDestroy Start.");
-    QNN_INF("ModelRelease::ModelDestroy %s\n", model_name.c_str());
-    bSuccess = g_LibAppBuilder.ModelDestroy(model_name.c_str());
-    QNN_INF("ModelRelease::ModelDestroy End ret = %d\n", bSuccess);
-    Print_MemInfo("ModelRelease::ModelDestroy End.");
+    reply.buffers.clear();
+    WriteReply(channel, request, reply, bSuccess, scratch);
+}
 
-    if (bSuccess) {
-        bSuccess = WriteFile(hSvcPipeOutWrite, ACTION_OK, (DWORD)strlen(ACTION_OK) + 1, NULL, NULL);
+void ModelInfo(const SvcMessage_t& request, SvcMessage_t& reply, SvcChannel_t& channel, std::vector<uint8_t>& scratch) {
+    std::vector<TensorInfo> inputs;
+    std::vector<TensorInfo> outputs;
+    bool bSuccess = request.strings.size() == 1 && g_LibAppBuilder.ModelGetInfo(request.strings[0], inputs, outputs);
+
+    reply.buffers.clear();
+    if (!bSuccess) {
+        WriteReply(channel, request, reply, false, scratch);
+        return;
     }
-    else {
-        bSuccess = WriteFile(hSvcPipeOutWrite, ACTION_FAILED, (DWORD)strlen(ACTION_FAILED) + 1, NULL, NULL);
+    SvcEncodeTensorInfos(reply, inputs, outputs);
+    WriteReplyStatus(channel, request, reply, SVC_STATUS_OK, reply.header.value, scratch);
+}
+
+void ShareMemUnmap(const SvcMessage_t& request, SvcMessage_t& reply, SvcChannel_t& channel, std::vector<uint8_t>& scratch) {
+    bool bSuccess = false;
+
+    if (request.strings.size() == 1) {
+        CloseShareMem(request.strings[0]);      // Not mapped is fine, the Svc may never have used it.
+        bSuccess = true;
     }
+
+    reply.buffers.clear();
+    WriteReply(channel, request, reply, bSuccess, scratch);
 }
 
-int svcprocess_run(HANDLE hSvcPipeInRead, HANDLE hSvcPipeOutWrite) {
-    DWORD dwRead = 0, dwWrite = 0;
-    BOOL bSuccess = false;
+// Requests are read by one thread at a time, the leader. Right after reading, it hands the reading over to an
+// idle thread (or starts one) and runs the request itself, unless the model is busy on another thread. Then the
+// request is queued for that thread, which runs the requests of its model in order. So requests don't switch
+// threads, and the models in one Svc process don't wait for each other. With a single model loaded there is
+// nobody to overlap with, the leader keeps reading and saves waking a thread for each request.
+typedef struct ModelQueue {
+    bool busy = false;                      // A thread is running a request of this model.
+    std::deque<SvcMessage_t> requests;
+} ModelQueue_t;
+
+typedef struct SvcWorkers {
+    SvcChannel_t channel;                   // Reads from the Svc pipe in, writes to the Svc pipe out.
+    std::mutex mutex;                       // Protects the members below.
+    std::condition_variable cond;
+    bool leader = false;                    // A thread is reading 'channel'.
+    bool exiting = false;
+    int idle = 0;                           // Threads waiting to become the leader.
+    std::unordered_map<std::string, ModelQueue_t> models;
+    std::unordered_set<std::string> loaded;
+    std::vector<std::thread> threads;
+} SvcWorkers_t;
+
+void RunRequest(const SvcMessage_t& request, SvcMessage_t& reply, SvcChannel_t& channel, std::vector<uint8_t>& scratch) {
+    reply.strings.clear();
+    switch (request.header.command) {
+        case SVC_CMD_LOAD:
+            ModelLoad(request, reply, channel, scratch);
+            break;
 
-    if ((hSvcPipeOutWrite == INVALID_HANDLE_VALUE) || (hSvcPipeInRead == INVALID_HANDLE_VALUE)) {
-        ErrorExit("Svc::Failed to get write or read handle.");
+        case SVC_CMD_RUN:
+            ModelRun(request, reply, channel, scratch);
+            break;
+
+        case SVC_CMD_RELEASE:
+            ModelRelease(request, reply, channel, scratch);
+            break;
+
+        case SVC_CMD_UNMAP:
+            ShareMemUnmap(request, reply, channel, scratch);
+            break;
+
+        case SVC_CMD_INFO:
+            ModelInfo(request, reply, channel, scratch);
+            break;
+
+        default:
+            WriteReply(channel, request, reply, false, scratch);
+            break;
     }
+}
 
+void SvcWorkerRun(SvcWorkers_t* pWorkers) {
+    SvcMessage_t request;
+    SvcMessage_t reply;
+    std::vector<uint8_t> scratch;
+
+    std::unique_lock<std::mutex> lock(pWorkers->mutex);
     for (;;) {
-        bSuccess = ReadFile(hSvcPipeInRead, g_buffer, GLOBAL_BUFSIZE, &dwRead, NULL);
+        pWorkers->idle++;
+        pWorkers->cond.wait(lock, [pWorkers] { return pWorkers->exiting || !pWorkers->leader; });
+        pWorkers->idle--;
+        if (pWorkers->exiting) {
+            break;
+        }
+
+        pWorkers->leader = true;
+        lock.unlock();
+        bool bRead = SvcReadMessage(pWorkers->channel, request, scratch);
+        lock.lock();
+        pWorkers->leader = false;
 
-        if (!bSuccess || dwRead == 0) {
-            QNN_WAR("Svc::Failed to read from hSvcPipeInRead, perhaps parent process closed pipe or died.\n");
+        if (!bRead) {
+            QNN_WAR("Svc::Failed to read a request, perhaps parent process closed pipe or died.\n");
+            pWorkers->exiting = true;
+            pWorkers->cond.notify_all();
             break;
         }
 
-        char* cmdBuf = g_buffer + 1;
-        switch (g_buffer[0]) {
-            case 'l':   // load model.
-                ModelLoad(cmdBuf, hSvcPipeOutWrite);
-                break;
+        // Requests of a model are queued in the order they are read, before the next leader reads. So SVC_CMD_INFO
+        // sees the model an asynchronous SVC_CMD_LOAD is still loading.
+        std::string model_name;
+        ModelQueue_t* pModel = nullptr;
+        uint16_t command = request.header.command;
+        if ((command == SVC_CMD_LOAD || command == SVC_CMD_RUN || command == SVC_CMD_RELEASE || command == SVC_CMD_INFO) &&
+            !request.strings.empty()) {
+            model_name = request.strings[0];
+            if (command == SVC_CMD_LOAD) {
+                pWorkers->loaded.insert(model_name);
+            }
+            else if (command == SVC_CMD_RELEASE) {
+                pWorkers->loaded.erase(model_name);
+            }
+            ModelQueue_t& model = pWorkers->models[model_name];
+            if (model.busy) {
+                model.requests.emplace_back();
+                std::swap(model.requests.back(), request);
+            }
+            else {
+                model.busy = true;
+                pModel = &model;
+            }
+        }
 
-            case 'g':   // run Graphs.
-                ModelRun(cmdBuf, hSvcPipeOutWrite);
-                break;
+        bool bHandOver = !pModel || pWorkers->loaded.size() > 1;
+        bool bWakeIdle = bHandOver && pWorkers->idle > 0;
+        if (bHandOver && !bWakeIdle) {
+            pWorkers->threads.emplace_back(SvcWorkerRun, pWorkers);
+        }
+        lock.unlock();
+        if (bWakeIdle) {
+            pWorkers->cond.notify_one();      // Unlocked, so that the woken thread doesn't block on 'mutex' right away.
+        }
+
+        if (!pModel) {
+            if (model_name.empty()) {       // Not for a model, or malformed.
+                RunRequest(request, reply, pWorkers->channel, scratch);
+            }
+            lock.lock();
+            continue;
+        }
 
-            case 'r':   // release model.
-                ModelRelease(cmdBuf, hSvcPipeOutWrite);
+        // Run the request, then what was queued for the model meanwhile.
+        for (;;) {
+            RunRequest(request, reply, pWorkers->channel, scratch);
+            lock.lock();
+            if (pModel->requests.empty()) {
                 break;
+            }
+            std::swap(request, pModel->requests.front());
+            pModel->requests.pop_front();
+            lock.unlock();
+        }
+        pModel->busy = false;
+        if (!pWorkers->loaded.count(model_name)) {
+            pWorkers->models.erase(model_name);
         }
     }
+}
+
+// 'ring_name' names the rings the application created for this process, empty if it talks through the pipes.
+int svcprocess_run(PipeHandle hSvcPipeInRead, PipeHandle hSvcPipeOutWrite, const std::string& ring_name, uint32_t spin_us) {
+    SvcWorkers_t workers;
+    workers.channel.hRead = hSvcPipeInRead;
+    workers.channel.hWrite = hSvcPipeOutWrite;
+
+    if ((hSvcPipeOutWrite == pal::process::g_invalidPipe) || (hSvcPipeInRead == pal::process::g_invalidPipe)) {
+        ErrorExit("Svc::Failed to get write or read handle.");
+    }
+    if (!ring_name.empty() && !SvcChannelOpenRings(workers.channel, ring_name, spin_us, false)) {
+        ErrorExit("Svc::Failed to open the rings.");
+    }
+
+    // This thread is the first leader. Once the channel is closed no thread is started any more.
+    SvcWorkerRun(&workers);
+
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(workers.mutex);
+        std::swap(threads, workers.threads);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    SvcChannelClose(workers.channel);
 
     return 0;
 }
@@ -212,10 +451,10 @@ int svcprocess_run(HANDLE hSvcPipeInRead, HANDLE hSvcPipeOutWrite) {
 #define BUFSIZE             (256)
 
 // test code, load and run model.
-int hostprocess_run(std::string qnn_lib_path, std::string model_path,
-                    std::string input_raw_path, int input_count, int memory_size,
+int hostprocess_run(std::string qnn_lib_path, std::string backend, std::string model_path,
+                    std::string input_raw_path, int input_count, int memory_size, int loop_count,
                     std::string perf_profile, std::vector <LoraAdapter>& Adapters ) {
-    BOOL result = false;
+    bool result = false;
 
     std::string MODEL_NAME = "<model_name>";
     std::string PROC_NAME = "<proc_name>";
@@ -224,11 +463,19 @@ int hostprocess_run(std::string qnn_lib_path, std::string model_path,
     std::string model_name = MODEL_NAME;
     std::string proc_name = PROC_NAME;
 
-    std::string backend_lib_path = qnn_lib_path + "\\QnnHtp.dll";
+#ifdef _WIN32
+    std::string backend_lib_path = qnn_lib_path + "\\Qnn" + backend + ".dll";
     std::string system_lib_path = qnn_lib_path + "\\QnnSystem.dll";
 
     std::string input_data_path = input_raw_path + "\\input_%d.raw";
     std::string output_data_path = input_raw_path + "\\output_%d.raw";
+#else
+    std::string backend_lib_path = qnn_lib_path + "/libQnn" + backend + ".so";
+    std::string system_lib_path = qnn_lib_path + "/libQnnSystem.so";
+
+    std::string input_data_path = input_raw_path + "/input_%d.raw";
+    std::string output_data_path = input_raw_path + "/output_%d.raw";
+#endif
 
     QNN_INF("Load data from raw data file to vector Start.\n");
     std::vector<uint8_t*> inputBuffers;
@@ -238,7 +485,7 @@ int hostprocess_run(std::string qnn_lib_path, std::string model_path,
     char dataPath[BUFSIZE];
 
     for (int i = 0; i < input_count; i++) {
-        sprintf_s(dataPath, BUFSIZE, input_data_path.c_str(), i);
+        snprintf(dataPath, BUFSIZE, input_data_path.c_str(), i);
         std::ifstream in(dataPath, std::ifstream::binary);
         if (!in) {
             QNN_ERR("Failed to open input file: %s", dataPath);
@@ -272,12 +519,21 @@ int hostprocess_run(std::string qnn_lib_path, std::string model_path,
         // SetPerfProfileGlobal("burst");
 
         {
-            // Inference.
-            result = libAppBuilder.ModelInference(model_name, inputBuffers, outputBuffers, outputSize, perf_profile);
+            // Inference. Only the outputs of the last run are kept.
+            TimerHelper timerHelper;
+            for (int loop = 0; loop < loop_count; loop++) {
+                for (int i = 0; i < outputBuffers.size(); i++) {
+                    free(outputBuffers[i]);
+                }
+                outputBuffers.clear();
+                outputSize.clear();
+                result = libAppBuilder.ModelInference(model_name, inputBuffers, outputBuffers, outputSize, perf_profile);
+            }
+            QNN_WAR("ModelInference: %d runs, %.3f ms per run.\n", loop_count, timerHelper.ElapsedMs() / loop_count);
 
             // Verify the output data here. Free the data in vector.
             for (int i = 0; i < outputSize.size(); i++) {
-                sprintf_s(dataPath, BUFSIZE, output_data_path.c_str(), i);
+                snprintf(dataPath, BUFSIZE, output_data_path.c_str(), i);
                 std::ofstream os(dataPath, std::ofstream::binary);
                 if (!os) {
                     QNN_ERR("Failed to open output file for writing: %s", dataPath);
@@ -311,12 +567,18 @@ int hostprocess_run(std::string qnn_lib_path, std::string model_path,
         QNN_INF("TalkToSvc_Initialize End %d.\n", result);
 
         QNN_INF("TalkToSvc_Inference Start.\n");
-        result = libAppBuilder.ModelInference(model_name, proc_name, model_memory_name, inputBuffers, inputSize, outputBuffers, outputSize, perf_profile);
+        TimerHelper timerHelper;
+        for (int loop = 0; loop < loop_count; loop++) {     // The outputs are in the share memory, the last run's stay there.
+            outputBuffers.clear();
+            outputSize.clear();
+            result = libAppBuilder.ModelInference(model_name, proc_name, model_memory_name, inputBuffers, inputSize, outputBuffers, outputSize, perf_profile);
+        }
+        QNN_WAR("TalkToSvc_Inference: %d runs, %.3f ms per run.\n", loop_count, timerHelper.ElapsedMs() / loop_count);
         QNN_INF("TalkToSvc_Inference End %d.\n", result);
 
         // Verify the output data here. Free the data in vector.
         for (int i = 0; i < outputSize.size(); i++) {
-            sprintf_s(dataPath, BUFSIZE, output_data_path.c_str(), i);
+            snprintf(dataPath, BUFSIZE, output_data_path.c_str(), i);
             std::ofstream os(dataPath, std::ofstream::binary);
             if (!os) {
                 QNN_ERR("Failed to open output file for writing: %s", dataPath);
@@ -409,14 +671,16 @@ std::map<std::string, std::vector<std::string>> parse_binary_updates(
 
 int main(int argc, char** argv) {
     if (argc > 1 && argv[1] && argv[1][0] == 's') {  // Start server.
-        HANDLE hSvcPipeInRead = (HANDLE)std::stoull(argv[2]);
-        HANDLE hSvcPipeOutWrite = (HANDLE)std::stoull(argv[3]);
+        PipeHandle hSvcPipeInRead = (PipeHandle)std::stoull(argv[2]);
+        PipeHandle hSvcPipeOutWrite = (PipeHandle)std::stoull(argv[3]);
+        std::string ring_name = argc > 9 ? argv[8] : "";
+        uint32_t spin_us = argc > 9 ? (uint32_t)std::stoul(argv[9]) : 0;
         SetLogLevel(std::stoi(argv[5]));
         SetProfilingLevel(std::stoi(argv[6]));
         SetProcInfo(argv[7], std::stoull(argv[4]));
         QNN_INF("Svc App Start proc %s.\n", argv[7]);
         Print_MemInfo("Svc App Start.");
-        svcprocess_run(hSvcPipeInRead, hSvcPipeOutWrite);
+        svcprocess_run(hSvcPipeInRead, hSvcPipeOutWrite, ring_name, spin_us);
         Print_MemInfo("Svc App End.");
     }
     else {  // Start test mode to load & run model.
@@ -424,7 +688,10 @@ int main(int argc, char** argv) {
                                           --model_path <str:model_path> --perf_profile <str:perf_profile> --input_path <str:input_raw_path> 
                                           --input_count <int:input_count> --memory_size<int:memory_size> 
                                           --binary_updates<str:graph_name,binary_update_path_1;binary_update_path_2>
+                                          --backend <str:backend> --loop_count <int:loop_count>
          input files are under 'input_raw_path' and the file names format are 'input_%d.raw'. 
+         'backend' selects the QNN backend library, e.g. 'Cpu' for QnnCpu.dll / libQnnCpu.so, default 'Htp'.
+         'loop_count' runs the inference that many times and prints the average time per run, default 1.
          */
 
         try {
@@ -445,6 +712,16 @@ int main(int argc, char** argv) {
                 memory_size = std::stoi(args["--memory_size"][0]);
             }
 
+            std::string backend = "Htp";
+            if (args.count("--backend")) {
+                backend = args["--backend"][0];
+            }
+
+            int loop_count = 1;
+            if (args.count("--loop_count")) {
+                loop_count = std::max(1, std::stoi(args["--loop_count"][0]));
+            }
+
             std::map<std::string, std::vector<std::string>> binary_updates;
             if (args.count("--binary_updates")) {
                 binary_updates = parse_binary_updates(args["--binary_updates"]);
@@ -469,7 +746,7 @@ int main(int argc, char** argv) {
             }
             
 
-            hostprocess_run(qnn_lib_path, model_path, input_list_path, input_count, memory_size, perf_profile, Adapters);
+            hostprocess_run(qnn_lib_path, backend, model_path, input_list_path, input_count, memory_size, loop_count, perf_profile, Adapters);
 
         }
         catch (const std::exception& e) {
@@ -478,6 +755,8 @@ int main(int argc, char** argv) {
             printf("Command formant: QAIAppSvc.exe --log_level <int:log_level> --QNN_Libraries_Path <str:QNN_Libraries_Path> --model_path <str:model_path> --perf_profile <str:perf_profile> --input_path <str:input_raw_path> --input_count <int:input_count> --memory_size<int:memory_size> --binary_updates<str:graph_name,binary_update_path_1;binary_update_path_2>\n");
             printf("'memory_size' is an option parameter, only needed while running the model in remote process.\n");
             printf("--binary_updates is an optional parameter that can be passed if you want to apply adapters to the graph. This parameter can be specified multiple times if needed.\n");
+            printf("--backend is an optional parameter selecting the QNN backend library, e.g. 'Cpu' or 'Htp' (default).\n");
+            printf("--loop_count is an optional parameter, runs the inference that many times and prints the average time per run.\n");
             printf("Example: --log_level 2 --QNN_Libraries_Path C:\\user\\lorav2\\qnn_assets\\2.28.2 --model_path C:\\user\\lorav2\\running_sample_app\\models_and_input\\text_encoder.serialized_qnn_2.28.bin --perf_profile burst --input_path C:\\user\\lorav2\\runnig_qai_helper\\text_encoder_inputs --input_count 2 --binary_updates text_encoder,C:\\user\\lorav2\\running_sample_app\\models_and_input\\text_encoder_Stickers_qnn_2.28.bin;C:\\user\\lorav2\\running_sample_app\\models_and_input\\text_encoder_TShirtDesignAF.bin  --memory_size 102400000\n");
             return 1;
         }
@@ -0,0 +1,236 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "BatchScheduler.hpp"
+#include "Logger.hpp"
+
+using namespace qnn::tools::batchscheduler;
+
+BatchScheduler::BatchScheduler(const std::string& name,
+                               const BatchConfig& config,
+                               const std::vector<BatchInput>& inputs,
+                               BatchExecuteFn executeFn)
+    : m_name(name),
+      m_config(config),
+      m_inputs(inputs),
+      m_executeFn(std::move(executeFn)) {
+  if (m_config.modelBatchSize == 0) {
+    m_config.modelBatchSize = 1;
+  }
+  if (m_config.maxBatchSize == 0 || m_config.maxBatchSize > m_config.modelBatchSize) {
+    m_config.maxBatchSize = m_config.modelBatchSize;
+  }
+  for (const BatchInput& input : m_inputs) {
+    size_t elementSize = std::max(input.elementSize, sizeof(float));
+    m_packedInputs.emplace_back(input.itemElements * elementSize * m_config.modelBatchSize, 0);
+  }
+  m_worker = std::thread(&BatchScheduler::run, this);
+  QNN_INFO("BatchScheduler[%s]: model batch %zu, max batch %zu, max wait %u us",
+           m_name.c_str(), m_config.modelBatchSize, m_config.maxBatchSize, m_config.maxWaitUs);
+}
+
+BatchScheduler::~BatchScheduler() { stop(); }
+
+void BatchScheduler::stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stop && !m_worker.joinable()) {
+      return;
+    }
+    m_stop = true;
+  }
+  m_queueCv.notify_all();
+  if (m_worker.joinable()) {
+    m_worker.join();
+  }
+
+  BatchStats stats = getStats();
+  if (stats.batches > 0) {
+    QNN_INFO("BatchScheduler[%s]: %llu requests in %llu batches, avg fill %.2f, avg wait %.1f us",
+             m_name.c_str(),
+             (unsigned long long)stats.requests,
+             (unsigned long long)stats.batches,
+             (double)stats.requests / stats.batches,
+             (double)stats.totalWaitUs / (stats.requests ? stats.requests : 1));
+  }
+}
+
+BatchStats BatchScheduler::getStats() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats;
+}
+
+bool BatchScheduler::submit(std::vector<uint8_t*>& inputBuffers,
+                            std::vector<uint8_t*>& outputBuffers,
+                            std::vector<size_t>& outputSize,
+                            std::string& perfProfile,
+                            const std::vector<std::string>& inputDataTypes,
+                            bool nativeOutputs) {
+  if (inputBuffers.size() != m_inputs.size()) {
+    QNN_ERROR("BatchScheduler[%s]: expected %zu inputs, received %zu",
+              m_name.c_str(), m_inputs.size(), inputBuffers.size());
+    return false;
+  }
+
+  Request request;
+  request.inputBuffers  = &inputBuffers;
+  request.outputBuffers = &outputBuffers;
+  request.outputSize    = &outputSize;
+  request.perfProfile   = &perfProfile;
+  request.nativeOutputs = nativeOutputs;
+  request.arrival       = std::chrono::steady_clock::now();
+  // The item size follows the data type, a type the model can't take would be packed with the wrong size.
+  for (size_t inputIdx = 0; inputIdx < m_inputs.size(); inputIdx++) {
+    std::string dataType = inputIdx < inputDataTypes.size() ? inputDataTypes[inputIdx] : "float32";
+    if (dataType != "float32" && dataType != m_inputs[inputIdx].dataType) {
+      QNN_ERROR("BatchScheduler[%s]: input %zu is %s, the model takes %s or float32",
+                m_name.c_str(), inputIdx, dataType.c_str(), m_inputs[inputIdx].dataType.c_str());
+      return false;
+    }
+    request.dataTypes.push_back(dataType);
+  }
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  if (m_stop) {
+    QNN_ERROR("BatchScheduler[%s]: scheduler is stopped", m_name.c_str());
+    return false;
+  }
+  m_queue.push_back(&request);
+  if (m_queue.size() == 1 || m_queue.size() >= m_config.maxBatchSize) {
+    m_queueCv.notify_one();
+  }
+  m_doneCv.wait(lock, [&request] { return request.done; });
+
+  return request.result;
+}
+
+void BatchScheduler::run() {
+  std::vector<Request*> batch;
+  batch.reserve(m_config.maxBatchSize);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    m_queueCv.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+    if (m_queue.empty()) {
+      break;  // Stopped and drained.
+    }
+
+    // Give the batch until the oldest request's deadline to fill up.
+    auto deadline = m_queue.front()->arrival + std::chrono::microseconds(m_config.maxWaitUs);
+    m_queueCv.wait_until(lock, deadline, [this] {
+      return m_stop || m_queue.size() >= m_config.maxBatchSize;
+    });
+
+    // The oldest request and the queued ones with its data types, output mode and perf profile make the batch.
+    // The others stay queued in their order for a later batch.
+    batch.clear();
+    for (auto it = m_queue.begin(); it != m_queue.end() && batch.size() < m_config.maxBatchSize;) {
+      Request* request = *it;
+      if (batch.empty() || (request->dataTypes == batch[0]->dataTypes &&
+                            request->nativeOutputs == batch[0]->nativeOutputs &&
+                            *request->perfProfile == *batch[0]->perfProfile)) {
+        batch.push_back(request);
+        it = m_queue.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    m_stats.requests += batch.size();
+    m_stats.batches++;
+    m_stats.paddedItems += m_config.modelBatchSize - batch.size();
+    for (auto request : batch) {
+      m_stats.totalWaitUs +=
+          std::chrono::duration_cast<std::chrono::microseconds>(start - request->arrival).count();
+    }
+
+    lock.unlock();
+    bool result = executeBatch(batch);
+    lock.lock();
+
+    for (auto request : batch) {
+      request->result = result;
+      request->done   = true;
+    }
+    m_doneCv.notify_all();
+  }
+}
+
+size_t BatchScheduler::itemSize(size_t inputIdx, const std::string& dataType) const {
+  const BatchInput& input = m_inputs[inputIdx];
+  return input.itemElements * (dataType == input.dataType ? input.elementSize : sizeof(float));
+}
+
+bool BatchScheduler::executeBatch(std::vector<Request*>& batch) {
+  // Pack each request into its slot of the batched input, zero the unused slots.
+  std::vector<uint8_t*> packedBuffers;
+  for (size_t inputIdx = 0; inputIdx < m_inputs.size(); inputIdx++) {
+    size_t inputItemSize = itemSize(inputIdx, batch[0]->dataTypes[inputIdx]);
+    uint8_t* packed      = m_packedInputs[inputIdx].data();
+    for (size_t slot = 0; slot < batch.size(); slot++) {
+      memcpy(packed + slot * inputItemSize, (*batch[slot]->inputBuffers)[inputIdx], inputItemSize);
+    }
+    if (batch.size() < m_config.modelBatchSize) {
+      memset(packed + batch.size() * inputItemSize, 0, (m_config.modelBatchSize - batch.size()) * inputItemSize);
+    }
+    packedBuffers.push_back(packed);
+  }
+
+  std::vector<uint8_t*> outputBuffers;
+  std::vector<size_t> outputSize;
+  bool result = m_executeFn(packedBuffers, outputBuffers, outputSize, *batch[0]->perfProfile,
+                            batch[0]->dataTypes, batch[0]->nativeOutputs);
+  if (!result) {
+    QNN_ERROR("BatchScheduler[%s]: batch execution failed", m_name.c_str());
+  }
+  for (size_t outputIdx = 0; result && outputIdx < outputSize.size(); outputIdx++) {
+    if (outputSize[outputIdx] % m_config.modelBatchSize != 0) {
+      QNN_ERROR("BatchScheduler[%s]: output %zu of %zu bytes doesn't split into %zu items",
+                m_name.c_str(), outputIdx, outputSize[outputIdx], m_config.modelBatchSize);
+      result = false;
+    }
+  }
+
+  // Scatter: slot 'n' of every output belongs to the n-th request of the batch. The requests get
+  // their slices only once all of them are allocated, a failure fails the whole batch.
+  std::vector<std::vector<uint8_t*>> items(batch.size());
+  for (size_t outputIdx = 0; result && outputIdx < outputBuffers.size(); outputIdx++) {
+    size_t outputItemSize = outputSize[outputIdx] / m_config.modelBatchSize;
+    for (size_t slot = 0; slot < batch.size(); slot++) {
+      uint8_t* item = (uint8_t*)malloc(std::max(outputItemSize, (size_t)1));
+      if (nullptr == item) {
+        QNN_ERROR("BatchScheduler[%s]: failed to allocate %zu bytes", m_name.c_str(), outputItemSize);
+        result = false;
+        break;
+      }
+      memcpy(item, outputBuffers[outputIdx] + slot * outputItemSize, outputItemSize);
+      items[slot].push_back(item);
+    }
+  }
+
+  for (size_t slot = 0; slot < batch.size(); slot++) {
+    for (size_t outputIdx = 0; outputIdx < items[slot].size(); outputIdx++) {
+      if (result) {
+        batch[slot]->outputBuffers->push_back(items[slot][outputIdx]);
+        batch[slot]->outputSize->push_back(outputSize[outputIdx] / m_config.modelBatchSize);
+      } else {
+        free(items[slot][outputIdx]);
+      }
+    }
+  }
+  for (auto buffer : outputBuffers) {
+    free(buffer);
+  }
+
+  return result;
+}
@@ -0,0 +1,125 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace qnn {
+namespace tools {
+namespace batchscheduler {
+
+// Runs one packed batch through the model. Output buffers are malloc'd by the callee,
+// same contract as QnnSampleApp::executeGraphsBuffers().
+using BatchExecuteFn = std::function<bool(std::vector<uint8_t*>& inputBuffers,
+                                          std::vector<uint8_t*>& outputBuffers,
+                                          std::vector<size_t>& outputSize,
+                                          std::string& perfProfile,
+                                          const std::vector<std::string>& inputDataTypes,
+                                          bool nativeOutputs)>;
+
+// One model input. Requests pass it in its native 'dataType' or as "float32".
+struct BatchInput {
+  std::string dataType;
+  size_t itemElements = 0;  // Elements of one batch item.
+  size_t elementSize  = 0;  // Bytes of one element in 'dataType'.
+};
+
+struct BatchConfig {
+  size_t modelBatchSize = 1;   // Leading dimension of the model inputs/outputs.
+  size_t maxBatchSize   = 1;   // Max requests packed into one execution, <= modelBatchSize.
+  uint32_t maxWaitUs    = 0;   // How long the oldest queued request may wait for the batch to fill.
+};
+
+struct BatchStats {
+  uint64_t requests      = 0;
+  uint64_t batches       = 0;
+  uint64_t paddedItems   = 0;  // Zero-filled slots sent to the model because the batch was partial.
+  uint64_t totalWaitUs   = 0;  // Sum of queueing delay of all requests.
+};
+
+/*
+ * Dynamic micro-batching for models compiled with a batch dimension > 1.
+ * Callers submit single-item requests from any thread; a worker thread gathers up to
+ * 'maxBatchSize' of them within 'maxWaitUs', packs them into one batched input, runs
+ * one graph execution and scatters the outputs back to each caller. Unused batch slots
+ * are zero padded, same as datautil::readBatchData() does for partial batches.
+ * Only requests with the same input data types, output mode and perf profile share a batch.
+ */
+class BatchScheduler {
+ public:
+  BatchScheduler(const std::string& name,
+                 const BatchConfig& config,
+                 const std::vector<BatchInput>& inputs,
+                 BatchExecuteFn executeFn);
+  ~BatchScheduler();
+
+  BatchScheduler(const BatchScheduler&) = delete;
+  BatchScheduler& operator=(const BatchScheduler&) = delete;
+
+  // Blocks until the batch holding this request has been executed. 'inputBuffers' hold one
+  // item each, in the data types named by 'inputDataTypes' (empty means all float32);
+  // 'outputBuffers' receive malloc'd per-item slices which the caller frees.
+  bool submit(std::vector<uint8_t*>& inputBuffers,
+              std::vector<uint8_t*>& outputBuffers,
+              std::vector<size_t>& outputSize,
+              std::string& perfProfile,
+              const std::vector<std::string>& inputDataTypes = std::vector<std::string>(),
+              bool nativeOutputs                             = false);
+
+  // Stops accepting requests, flushes the queue and joins the worker thread.
+  void stop();
+
+  BatchStats getStats();
+
+  const BatchConfig& getConfig() const { return m_config; }
+
+ private:
+  struct Request {
+    std::vector<uint8_t*>* inputBuffers;
+    std::vector<uint8_t*>* outputBuffers;
+    std::vector<size_t>* outputSize;
+    std::string* perfProfile;
+    std::vector<std::string> dataTypes;  // Of each input, "float32" or its native data type.
+    bool nativeOutputs;
+    std::chrono::steady_clock::time_point arrival;
+    bool done   = false;
+    bool result = false;
+  };
+
+  void run();
+  bool executeBatch(std::vector<Request*>& batch);
+  size_t itemSize(size_t inputIdx, const std::string& dataType) const;
+
+  std::string m_name;
+  BatchConfig m_config;
+  std::vector<BatchInput> m_inputs;
+  BatchExecuteFn m_executeFn;
+
+  // Packed input buffers, allocated once for the full model batch in the wider of the two data types.
+  std::vector<std::vector<uint8_t>> m_packedInputs;
+
+  std::mutex m_mutex;
+  std::condition_variable m_queueCv;
+  std::condition_variable m_doneCv;
+  std::deque<Request*> m_queue;
+  bool m_stop = false;
+  BatchStats m_stats;
+  std::thread m_worker;
+};
+
+}  // namespace batchscheduler
+}  // namespace tools
+}  // namespace qnn
@@ -0,0 +1,86 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace qnn {
+namespace tools {
+
+/*
+ * Small multi-producer / multi-consumer queue used to hand work between pipeline threads.
+ * A capacity of 0 means unbounded. Once closed, push() fails and pop() drains what is left
+ * and then returns false.
+ */
+template <typename T>
+class BlockingQueue {
+ public:
+  explicit BlockingQueue(size_t capacity = 0) : m_capacity(capacity) {}
+
+  BlockingQueue(const BlockingQueue&) = delete;
+  BlockingQueue& operator=(const BlockingQueue&) = delete;
+
+  bool push(T item) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notFull.wait(lock, [this] { return m_closed || 0 == m_capacity || m_queue.size() < m_capacity; });
+    if (m_closed) {
+      return false;
+    }
+    m_queue.push_back(std::move(item));
+    m_notEmpty.notify_one();
+    return true;
+  }
+
+  bool pop(T& item) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notEmpty.wait(lock, [this] { return m_closed || !m_queue.empty(); });
+    if (m_queue.empty()) {
+      return false;
+    }
+    item = std::move(m_queue.front());
+    m_queue.pop_front();
+    m_notFull.notify_one();
+    return true;
+  }
+
+  bool tryPop(T& item) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_queue.empty()) {
+      return false;
+    }
+    item = std::move(m_queue.front());
+    m_queue.pop_front();
+    m_notFull.notify_one();
+    return true;
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_closed = true;
+    m_notEmpty.notify_all();
+    m_notFull.notify_all();
+  }
+
+  size_t size() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_queue.size();
+  }
+
+ private:
+  size_t m_capacity;
+  bool m_closed = false;
+  std::deque<T> m_queue;
+  std::mutex m_mutex;
+  std::condition_variable m_notEmpty;
+  std::condition_variable m_notFull;
+};
+
+}  // namespace tools
+}  // namespace qnn
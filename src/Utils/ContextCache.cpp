@@ -0,0 +1,210 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <sys/stat.h>
+#include <thread>
+
+#include "ContextCache.hpp"
+#include "DataUtil.hpp"
+#include "Logger.hpp"
+#include "PAL/Directory.hpp"
+#include "PAL/FileOp.hpp"
+#include "PAL/MappedFile.hpp"
+#include "PAL/Path.hpp"
+
+using namespace qnn::tools;
+
+static const std::string sg_indexFileName = "context_cache.idx";
+static const std::string sg_entryExtension = ".bin";
+
+// Serializes index updates of this process. Other processes sharing the directory can only
+// lose an index update, never corrupt an entry, since entries are moved in place atomically.
+static std::mutex sg_cacheMutex;
+
+struct CacheEntry {
+  uint64_t size     = 0;
+  uint64_t lastUsed = 0;
+};
+
+static uint64_t fnv1a(uint64_t hash, const uint8_t* data, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+static uint64_t now() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::seconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+// "path:size:mtime" of 'path', or "path:missing".
+static std::string fileIdentity(const std::string& path) {
+#ifdef _WIN32
+  struct _stat64 st;
+  bool found = 0 == _stat64(path.c_str(), &st);
+#else
+  struct stat st;
+  bool found = 0 == stat(path.c_str(), &st);
+#endif
+  if (!found) {
+    return path + ":missing";
+  }
+  return path + ":" + std::to_string((unsigned long long)st.st_size) + ":" +
+         std::to_string((long long)st.st_mtime);
+}
+
+static std::string entryPath(const std::string& cacheDir, const std::string& key) {
+  return cacheDir + pal::Path::getSeparator() + key + sg_entryExtension;
+}
+
+static std::map<std::string, CacheEntry> readIndex(const std::string& cacheDir) {
+  std::map<std::string, CacheEntry> index;
+  std::ifstream in(cacheDir + pal::Path::getSeparator() + sg_indexFileName);
+  std::string key;
+  CacheEntry entry;
+  while (in >> key >> entry.size >> entry.lastUsed) {
+    if (pal::FileOp::checkFileExists(entryPath(cacheDir, key))) {
+      index[key] = entry;
+    }
+  }
+  return index;
+}
+
+static void writeIndex(const std::string& cacheDir, const std::map<std::string, CacheEntry>& index) {
+  const std::string indexPath = cacheDir + pal::Path::getSeparator() + sg_indexFileName;
+  const std::string tempPath  = indexPath + ".tmp";
+  {
+    std::ofstream out(tempPath, std::ofstream::trunc);
+    for (auto& item : index) {
+      out << item.first << " " << item.second.size << " " << item.second.lastUsed << "\n";
+    }
+    if (!out) {
+      QNN_WARN("Failed to write context cache index: %s", tempPath.c_str());
+      return;
+    }
+  }
+  pal::FileOp::move(tempPath, indexPath, true);
+}
+
+std::string contextcache::computeKey(const std::string& modelPath,
+                                     const std::string& backendBuildId,
+                                     const std::string& config,
+                                     const std::vector<std::string>& dependencies) {
+  pal::MappedFile model;
+  if (!model.open(modelPath)) {
+    QNN_WARN("Context cache: unable to read model library %s", modelPath.c_str());
+    return std::string();
+  }
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  hash          = fnv1a(hash, model.data(), model.size());
+  hash          = fnv1a(hash, reinterpret_cast<const uint8_t*>(backendBuildId.data()), backendBuildId.size());
+  hash          = fnv1a(hash, reinterpret_cast<const uint8_t*>(config.data()), config.size());
+  for (const std::string& dependency : dependencies) {
+    std::string identity = fileIdentity(dependency) + ";";
+    hash                 = fnv1a(hash, reinterpret_cast<const uint8_t*>(identity.data()), identity.size());
+  }
+
+  char key[17];
+  snprintf(key, sizeof(key), "%016llx", (unsigned long long)hash);
+  return std::string(key);
+}
+
+bool contextcache::lookup(const std::string& cacheDir, const std::string& key, std::string& binaryPath) {
+  if (cacheDir.empty() || key.empty()) {
+    return false;
+  }
+  std::string path = entryPath(cacheDir, key);
+  if (!pal::FileOp::checkFileExists(path)) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(sg_cacheMutex);
+  auto index = readIndex(cacheDir);
+  auto& entry = index[key];
+  if (0 == entry.size) {
+    size_t size{0};
+    std::tie(std::ignore, size) = datautil::getFileSize(path);
+    entry.size = size;
+  }
+  entry.lastUsed = now();
+  writeIndex(cacheDir, index);
+
+  binaryPath = path;
+  return true;
+}
+
+std::string contextcache::getTempName(const std::string& key) {
+  static std::atomic<uint32_t> s_counter{0};
+  std::ostringstream name;
+  name << key << ".tmp" << std::hash<std::thread::id>()(std::this_thread::get_id()) % 100000 << "_"
+       << s_counter.fetch_add(1);
+  return name.str();
+}
+
+bool contextcache::commit(const std::string& cacheDir,
+                          const std::string& key,
+                          const std::string& tempPath,
+                          uint64_t maxCacheSize) {
+  std::string path = entryPath(cacheDir, key);
+  if (!pal::FileOp::move(tempPath, path, true)) {
+    QNN_WARN("Context cache: failed to move %s to %s", tempPath.c_str(), path.c_str());
+    pal::FileOp::deleteFile(tempPath);
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(sg_cacheMutex);
+  auto index = readIndex(cacheDir);
+  size_t size{0};
+  std::tie(std::ignore, size) = datautil::getFileSize(path);
+  index[key].size     = size;
+  index[key].lastUsed = now();
+
+  if (maxCacheSize > 0) {
+    uint64_t total = 0;
+    for (auto& item : index) {
+      total += item.second.size;
+    }
+    while (total > maxCacheSize && index.size() > 1) {
+      auto oldest = index.end();
+      for (auto it = index.begin(); it != index.end(); ++it) {
+        if (it->first != key && (oldest == index.end() || it->second.lastUsed < oldest->second.lastUsed)) {
+          oldest = it;
+        }
+      }
+      if (oldest == index.end()) {
+        break;
+      }
+      QNN_INFO("Context cache: evicting %s (%llu bytes)",
+               oldest->first.c_str(), (unsigned long long)oldest->second.size);
+      pal::FileOp::deleteFile(entryPath(cacheDir, oldest->first));
+      total -= oldest->second.size;
+      index.erase(oldest);
+    }
+  }
+  writeIndex(cacheDir, index);
+  return true;
+}
+
+void contextcache::evict(const std::string& cacheDir, const std::string& key) {
+  std::lock_guard<std::mutex> lock(sg_cacheMutex);
+  pal::FileOp::deleteFile(entryPath(cacheDir, key));
+  auto index = readIndex(cacheDir);
+  index.erase(key);
+  writeIndex(cacheDir, index);
+}
@@ -0,0 +1,55 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace qnn {
+namespace tools {
+namespace contextcache {
+
+/*
+ * On-disk cache of serialized contexts for models loaded from a model library. Entries are
+ * named after a key derived from the content of the model library, the backend build id, the
+ * graph configuration and the files the context depends on (backend library, op packages,
+ * LoRA adapters), so a changed model or SDK never picks up a stale binary.
+ *
+ * Entries are written to a temporary file and moved in place, so a concurrent reader sees
+ * either no entry or a complete one. An index file in the cache directory tracks the size
+ * and last use of each entry; the least recently used entries are removed once the cache
+ * grows above its size limit.
+ */
+
+// Returns an empty string if the model library can't be read. 'dependencies' are keyed by
+// path, size and modification time; hashing them would cost more than composing small graphs.
+std::string computeKey(const std::string& modelPath,
+                       const std::string& backendBuildId,
+                       const std::string& config,
+                       const std::vector<std::string>& dependencies);
+
+// Returns true and the path of the cached context binary if 'key' is in the cache.
+bool lookup(const std::string& cacheDir, const std::string& key, std::string& binaryPath);
+
+// Name (without the .bin extension) to save a new entry under before commit().
+std::string getTempName(const std::string& key);
+
+// Moves the saved binary into the cache as the entry for 'key' and prunes the cache down to
+// 'maxCacheSize' bytes. 0 means no limit.
+bool commit(const std::string& cacheDir,
+            const std::string& key,
+            const std::string& tempPath,
+            uint64_t maxCacheSize);
+
+// Removes the entry for 'key', e.g. when the backend rejected the cached binary.
+void evict(const std::string& cacheDir, const std::string& key);
+
+}  // namespace contextcache
+}  // namespace tools
+}  // namespace qnn
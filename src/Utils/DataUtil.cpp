@@ -34,6 +34,11 @@ std::tuple<datautil::StatusCode, size_t> datautil::getDataTypeSizeInBytes(Qnn_Da
   return std::make_tuple(StatusCode::SUCCESS, g_dataTypeToSize.find(dataType)->second);
 }
 
+std::string datautil::getDataTypeName(Qnn_DataType_t dataType) {
+  auto it = g_dataTypeToName.find(dataType);
+  return it == g_dataTypeToName.end() ? std::string() : it->second;
+}
+
 size_t datautil::calculateElementCount(std::vector<size_t> dims) {
   if (dims.size() == 0) {
     return 0;
@@ -216,8 +221,9 @@ datautil::StatusCode datautil::writeDataToFile(std::string fileDir,
   if (StatusCode::SUCCESS != err) {
     return err;
   }
-  for (size_t l = 0; l < length; l++) {
-    os.write(reinterpret_cast<char*>(&(*(buffer + l))), 1);
+  if (!os.write(reinterpret_cast<char*>(buffer), length)) {
+    QNN_ERROR("Failed to write output file: %s", outputPath.c_str());
+    return StatusCode::DATA_WRITE_FAIL;
   }
   return StatusCode::SUCCESS;
 }
@@ -251,9 +257,9 @@ datautil::StatusCode datautil::writeBatchDataToFile(std::vector<std::string> fil
       QNN_ERROR("Failed to open output file for writing: %s", outputPath.c_str());
       return StatusCode::FILE_OPEN_FAIL;
     }
-    for (size_t l = 0; l < outputSize; l++) {
-      size_t bufferIndex = l + (batchIndex * outputSize);
-      os.write(reinterpret_cast<char*>(&(*(buffer + bufferIndex))), 1);
+    if (!os.write(reinterpret_cast<char*>(buffer + (batchIndex * outputSize)), outputSize)) {
+      QNN_ERROR("Failed to write output file: %s", outputPath.c_str());
+      return StatusCode::DATA_WRITE_FAIL;
     }
   }
   return StatusCode::SUCCESS;
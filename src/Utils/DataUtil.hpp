@@ -9,6 +9,7 @@
 
 #include <map>
 #include <queue>
+#include <string>
 #include <vector>
 
 #include "QnnTypes.h"
@@ -34,6 +35,9 @@ using ReadBatchDataRetType_t = std::tuple<StatusCode, size_t, size_t>;
 
 std::tuple<StatusCode, size_t> getDataTypeSizeInBytes(Qnn_DataType_t dataType);
 
+// Name of the numpy dtype holding 'dataType', e.g. "uint8" for QNN_DATATYPE_UFIXED_POINT_8. Empty if unknown.
+std::string getDataTypeName(Qnn_DataType_t dataType);
+
 std::tuple<StatusCode, size_t> calculateLength(std::vector<size_t> dims, Qnn_DataType_t dataType);
 
 size_t calculateElementCount(std::vector<size_t> dims);
@@ -130,6 +134,27 @@ const std::map<Qnn_DataType_t, size_t> g_dataTypeToSize = {
     {QNN_DATATYPE_UFIXED_POINT_32, 4},
     {QNN_DATATYPE_BOOL_8, 1},
 };
+
+const std::map<Qnn_DataType_t, std::string> g_dataTypeToName = {
+    {QNN_DATATYPE_INT_8, "int8"},
+    {QNN_DATATYPE_INT_16, "int16"},
+    {QNN_DATATYPE_INT_32, "int32"},
+    {QNN_DATATYPE_INT_64, "int64"},
+    {QNN_DATATYPE_UINT_8, "uint8"},
+    {QNN_DATATYPE_UINT_16, "uint16"},
+    {QNN_DATATYPE_UINT_32, "uint32"},
+    {QNN_DATATYPE_UINT_64, "uint64"},
+    {QNN_DATATYPE_FLOAT_16, "float16"},
+    {QNN_DATATYPE_FLOAT_32, "float32"},
+    {QNN_DATATYPE_FLOAT_64, "float64"},
+    {QNN_DATATYPE_SFIXED_POINT_8, "int8"},
+    {QNN_DATATYPE_SFIXED_POINT_16, "int16"},
+    {QNN_DATATYPE_SFIXED_POINT_32, "int32"},
+    {QNN_DATATYPE_UFIXED_POINT_8, "uint8"},
+    {QNN_DATATYPE_UFIXED_POINT_16, "uint16"},
+    {QNN_DATATYPE_UFIXED_POINT_32, "uint32"},
+    {QNN_DATATYPE_BOOL_8, "bool"},
+};
 }  // namespace datautil
 }  // namespace tools
 }  // namespace qnn
@@ -22,6 +22,7 @@
 #endif
 #include "PAL/StringOp.hpp"
 #include "QnnTypeMacros.hpp"
+#include "Trace.hpp"
 
 using namespace qnn;
 using namespace qnn::tools;
@@ -339,6 +340,135 @@ iotensor::PopulateInputTensorsRetType_t iotensor::IOTensor::populateInputTensors
   return {StatusCode::SUCCESS, numFilesPopulated, numBatchSize};
 }
 
+#ifndef __hexagon__
+// Helper method to populate an input tensor from a packed dataset. When the batch is made of
+// whole samples the float data is converted straight out of the mapping, otherwise the samples
+// are gathered and zero padded the same way readBatchData() does.
+iotensor::PopulateInputTensorsRetType_t iotensor::IOTensor::populateInputTensor(
+    const datautil::PackedDataset& dataset,
+    const size_t inputColumn,
+    const size_t sampleOffset,
+    const bool loopBackToStart,
+    Qnn_Tensor_t* input,
+    iotensor::InputDataType inputDataType) {
+  if (nullptr == input) {
+    QNN_ERROR("input is nullptr");
+    return {StatusCode::FAILURE, 0, 0};
+  }
+
+  auto returnStatus        = StatusCode::SUCCESS;
+  size_t numFilesPopulated = 0;
+  size_t batchSize         = 0;
+  std::vector<size_t> dims;
+  fillDims(dims, QNN_TENSOR_GET_DIMENSIONS(input), QNN_TENSOR_GET_RANK(input));
+
+  if (inputDataType == InputDataType::FLOAT &&
+      QNN_TENSOR_GET_DATA_TYPE(input) != QNN_DATATYPE_FLOAT_32) {
+    datautil::StatusCode status;
+    size_t floatLength{0};
+    std::tie(status, floatLength) = datautil::calculateLength(dims, QNN_DATATYPE_FLOAT_32);
+    if (datautil::StatusCode::SUCCESS != status) {
+      return {StatusCode::FAILURE, 0, 0};
+    }
+    const uint8_t* view = dataset.getBatchView(inputColumn, sampleOffset, floatLength, numFilesPopulated);
+    if (nullptr != view) {
+      batchSize    = numFilesPopulated;
+      returnStatus = copyFromFloatToNative(reinterpret_cast<float*>(const_cast<uint8_t*>(view)), input);
+    } else {
+      uint8_t* floatBuffer = nullptr;
+      returnStatus         = allocateBuffer(&floatBuffer, dims, QNN_DATATYPE_FLOAT_32);
+      if (StatusCode::SUCCESS == returnStatus) {
+        std::tie(status, numFilesPopulated, batchSize) = dataset.readBatchData(
+            inputColumn, sampleOffset, loopBackToStart, dims, QNN_DATATYPE_FLOAT_32, floatBuffer);
+        if (datautil::StatusCode::SUCCESS != status) {
+          QNN_ERROR("Failure in PackedDataset::readBatchData");
+          returnStatus = StatusCode::FAILURE;
+        } else {
+          returnStatus = copyFromFloatToNative(reinterpret_cast<float*>(floatBuffer), input);
+        }
+      }
+      if (nullptr != floatBuffer) {
+        free(floatBuffer);
+      }
+    }
+  } else {
+    datautil::StatusCode status;
+    std::tie(status, numFilesPopulated, batchSize) =
+        dataset.readBatchData(inputColumn,
+                              sampleOffset,
+                              loopBackToStart,
+                              dims,
+                              QNN_TENSOR_GET_DATA_TYPE(input),
+                              static_cast<uint8_t*>(QNN_TENSOR_GET_CLIENT_BUF(input).data));
+    if (datautil::StatusCode::SUCCESS != status) {
+      QNN_ERROR("Failure in PackedDataset::readBatchData");
+      returnStatus = StatusCode::FAILURE;
+    }
+  }
+  return {returnStatus, numFilesPopulated, batchSize};
+}
+
+// Helper method to populate all input tensors from a packed dataset.
+iotensor::PopulateInputTensorsRetType_t iotensor::IOTensor::populateInputTensors(
+    uint32_t graphIdx,
+    const datautil::PackedDataset& dataset,
+    const size_t sampleOffset,
+    const bool loopBackToStart,
+    Qnn_Tensor_t* inputs,
+    qnn_wrapper_api::GraphInfo_t graphInfo,
+    iotensor::InputDataType inputDataType) {
+  QNN_DEBUG("populateInputTensors() from packed dataset, graphIndx %d", graphIdx);
+  if (nullptr == inputs) {
+    QNN_ERROR("inputs is nullptr");
+    return {StatusCode::FAILURE, 0, 0};
+  }
+  auto inputCount = graphInfo.numInputTensors;
+  if (dataset.getNumInputs() != inputCount) {
+    QNN_ERROR("Incorrect amount of packed inputs for graphIdx: %d. Expected: %d, received: %d",
+              graphIdx,
+              inputCount,
+              dataset.getNumInputs());
+    return {StatusCode::FAILURE, 0, 0};
+  }
+  const auto& inputNameToIndex = dataset.getInputNameToIndex();
+  size_t numFilesPopulated     = 0;
+  size_t numBatchSize          = 0;
+  for (size_t inputIdx = 0; inputIdx < inputCount; inputIdx++) {
+    size_t inputColumn = inputIdx;
+    std::string inputNodeName;
+    if (QNN_TENSOR_GET_NAME(graphInfo.inputTensors[inputIdx]))
+      inputNodeName = QNN_TENSOR_GET_NAME(graphInfo.inputTensors[inputIdx]);
+    if (!inputNodeName.empty() && inputNameToIndex.find(inputNodeName) != inputNameToIndex.end()) {
+      inputColumn = inputNameToIndex.at(inputNodeName);
+    }
+    StatusCode returnStatus;
+    size_t currentInputNumFilesPopulated = 0;
+    size_t currentInputNumBatchSize      = 0;
+    std::tie(returnStatus, currentInputNumFilesPopulated, currentInputNumBatchSize) =
+        populateInputTensor(dataset, inputColumn, sampleOffset, loopBackToStart, &(inputs[inputIdx]), inputDataType);
+    if (StatusCode::SUCCESS != returnStatus) {
+      QNN_ERROR("populateInputTensor failed for packed input %s with index %d",
+                inputNodeName.c_str(),
+                inputIdx);
+      return {StatusCode::FAILURE, currentInputNumFilesPopulated, currentInputNumBatchSize};
+    }
+    if (inputIdx == 0) {
+      numFilesPopulated = currentInputNumFilesPopulated;
+      numBatchSize      = currentInputNumBatchSize;
+    } else if (numFilesPopulated != currentInputNumFilesPopulated ||
+               numBatchSize != currentInputNumBatchSize) {
+      QNN_ERROR("Packed input %s with index %d populated %d samples, expected %d",
+                inputNodeName.c_str(),
+                inputIdx,
+                currentInputNumFilesPopulated,
+                numFilesPopulated);
+      return {StatusCode::FAILURE, numFilesPopulated, numBatchSize};
+    }
+  }
+  return {StatusCode::SUCCESS, numFilesPopulated, numBatchSize};
+}
+#endif
+
 // zw. Optimize performance.
 // Helper method to populate an input tensor in the graph during execution.
 // It relies on reading data from buffer provided during executeGraph() call.
@@ -378,7 +508,8 @@ iotensor::StatusCode iotensor::IOTensor::populateInputTensors(
     std::vector<uint8_t*> inputBuffers,
     Qnn_Tensor_t* inputs,
     qnn_wrapper_api::GraphInfo_t graphInfo,
-    iotensor::InputDataType inputDataType) {
+    iotensor::InputDataType inputDataType,
+    const std::vector<bool>& nativeInputs) {
   if (nullptr == inputs) {
     QNN_ERROR("inputs is nullptr");
     return StatusCode::FAILURE;
@@ -392,8 +523,9 @@ iotensor::StatusCode iotensor::IOTensor::populateInputTensors(
     return StatusCode::FAILURE;
   }
   for (size_t inputIdx = 0; inputIdx < inputCount; inputIdx++) {
+    bool native = inputIdx < nativeInputs.size() && nativeInputs[inputIdx];
     if (StatusCode::SUCCESS !=
-        populateInputTensor(inputBuffers[inputIdx], &(inputs[inputIdx]), inputDataType)) {
+        populateInputTensor(inputBuffers[inputIdx], &(inputs[inputIdx]), native ? InputDataType::NATIVE : inputDataType)) {
       QNN_DEBUG("populateInputTensor() failure for input: %d", inputIdx);
       return StatusCode::FAILURE;
     }
@@ -873,12 +1005,8 @@ iotensor::StatusCode iotensor::IOTensor::convertAndWriteOutputTensorInFloat(
     return StatusCode::FAILURE;
   }
   uint8_t* bufferToWrite = reinterpret_cast<uint8_t*>(floatBuffer);
-  if (datautil::StatusCode::SUCCESS !=
-      datautil::writeBatchDataToFile(
-          outputPaths, fileName, dims, QNN_DATATYPE_FLOAT_32, bufferToWrite, outputBatchSize)) {
-    QNN_ERROR("failure in writeBatchDataToFile");
-    returnStatus = StatusCode::FAILURE;
-  }
+  returnStatus =
+      writeBatchData(outputPaths, fileName, dims, QNN_DATATYPE_FLOAT_32, bufferToWrite, outputBatchSize);
   if (nullptr != floatBuffer) {
     QNN_DEBUG("freeing floatBuffer");
     free(floatBuffer);
@@ -901,19 +1029,47 @@ iotensor::StatusCode iotensor::IOTensor::writeOutputTensor(Qnn_Tensor_t* output,
   std::vector<size_t> dims;
   fillDims(dims, QNN_TENSOR_GET_DIMENSIONS(output), QNN_TENSOR_GET_RANK(output));
   uint8_t* bufferToWrite = reinterpret_cast<uint8_t*>(QNN_TENSOR_GET_CLIENT_BUF(output).data);
-  if (datautil::StatusCode::SUCCESS !=
-      datautil::writeBatchDataToFile(outputPaths,
-                                     fileName,
-                                     dims,
-                                     QNN_TENSOR_GET_DATA_TYPE(output),
-                                     bufferToWrite,
-                                     outputBatchSize)) {
-    QNN_ERROR("failure in writeBatchDataToFile");
-    returnStatus = StatusCode::FAILURE;
-  }
+  returnStatus = writeBatchData(
+      outputPaths, fileName, dims, QNN_TENSOR_GET_DATA_TYPE(output), bufferToWrite, outputBatchSize);
   return returnStatus;
 }
 
+// Splits a batched output into one blob per input. With an output writer the blobs are copied
+// into recycled buffers and queued, so the caller can reuse the tensor right away.
+iotensor::StatusCode iotensor::IOTensor::writeBatchData(const std::vector<std::string>& outputPaths,
+                                                        const std::string& fileName,
+                                                        const std::vector<size_t>& dims,
+                                                        Qnn_DataType_t dataType,
+                                                        uint8_t* buffer,
+                                                        size_t outputBatchSize) {
+  if (nullptr == m_outputWriter) {
+    if (datautil::StatusCode::SUCCESS !=
+        datautil::writeBatchDataToFile(outputPaths, fileName, dims, dataType, buffer, outputBatchSize)) {
+      QNN_ERROR("failure in writeBatchDataToFile");
+      return StatusCode::FAILURE;
+    }
+    return StatusCode::SUCCESS;
+  }
+
+  datautil::StatusCode err{datautil::StatusCode::SUCCESS};
+  size_t length{0};
+  std::tie(err, length) = datautil::calculateLength(dims, dataType);
+  if (datautil::StatusCode::SUCCESS != err || nullptr == buffer || 0 == outputBatchSize) {
+    QNN_ERROR("Invalid output buffer for %s", fileName.c_str());
+    return StatusCode::FAILURE;
+  }
+  size_t outputSize = length / outputBatchSize;
+  for (size_t batchIndex = 0; batchIndex < outputPaths.size(); batchIndex++) {
+    std::vector<uint8_t> blob = m_outputWriter->acquireBuffer(outputSize);
+    pal::StringOp::memscpy(blob.data(), outputSize, buffer + batchIndex * outputSize, outputSize);
+    if (!m_outputWriter->submit(outputPaths[batchIndex], fileName, std::move(blob))) {
+      QNN_ERROR("failure in OutputWriter::submit");
+      return StatusCode::FAILURE;
+    }
+  }
+  return StatusCode::SUCCESS;
+}
+
 // Write out all output tensors to files. If output_data_type is float,
 // then all outputs will be raw floats regardless of what the model outputs.
 // If the output_data_type is native, then output is written as produced by the model.
@@ -930,6 +1086,7 @@ iotensor::StatusCode iotensor::IOTensor::writeOutputTensors(uint32_t graphIdx,
                                                             std::string outputPath,
                                                             size_t numInputFilesPopulated,
                                                             size_t outputBatchSize) {
+  TRACE_SCOPE("writeOutputTensors");
   if (nullptr == outputs) {
     QNN_ERROR("Received nullptr");
     return StatusCode::FAILURE;
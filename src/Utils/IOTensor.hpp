@@ -20,6 +20,10 @@
 #include "QnnTensor.h"
 #include "QnnTypes.h"
 #include "QnnWrapperUtils.hpp"
+#ifndef __hexagon__
+#include "OutputWriter.hpp"
+#include "PackedDataset.hpp"
+#endif
 
 namespace qnn {
 namespace tools {
@@ -63,12 +67,25 @@ class IOTensor {
       qnn_wrapper_api::GraphInfo_t graphInfo,
       iotensor::InputDataType inputDataType);
 
+#ifndef __hexagon__
+  // Same as above, reading the samples from a memory-mapped packed dataset.
+  PopulateInputTensorsRetType_t populateInputTensors(uint32_t graphIdx,
+                                                     const datautil::PackedDataset &dataset,
+                                                     const size_t sampleOffset,
+                                                     const bool loopBackToStart,
+                                                     Qnn_Tensor_t *inputs,
+                                                     qnn_wrapper_api::GraphInfo_t graphInfo,
+                                                     InputDataType inputDataType);
+#endif
+
   // zw. Optimize performance.
+  // 'nativeInputs' marks the buffers already in the data type of their tensor, the others are in 'inputDataType'.
   StatusCode populateInputTensors(uint32_t graphIdx,
                                   std::vector<uint8_t *> inputBuffers,
                                   Qnn_Tensor_t *inputs,
                                   qnn_wrapper_api::GraphInfo_t graphInfo,
-                                  InputDataType inputDataType);
+                                  InputDataType inputDataType,
+                                  const std::vector<bool> &nativeInputs = std::vector<bool>());
 
   StatusCode populateInputTensorsWithRandValues(uint32_t graphIdx,
                                                 Qnn_Tensor_t *inputs,
@@ -87,6 +104,14 @@ class IOTensor {
 
   StatusCode getTensorsSize(Qnn_Tensor_t** tensors, uint32_t tensorCount, Qnn_Tensor_t* tensorWrappers, std::vector<size_t>& size);     // zw. Optimize performance.
 
+#ifndef __hexagon__
+  // When set, writeOutputTensors() hands the outputs to this writer instead of writing them
+  // synchronously. Pass nullptr to go back to synchronous writes.
+  void setOutputWriter(std::shared_ptr<outputwriter::OutputWriter> outputWriter) {
+    m_outputWriter = outputWriter;
+  }
+#endif
+
  private:
   PopulateInputTensorsRetType_t populateInputTensor(const std::vector<std::string> &filePaths,
                                                     const size_t filePathsIndexOffset,
@@ -96,6 +121,15 @@ class IOTensor {
 
   StatusCode populateInputTensor(uint8_t *buffer, Qnn_Tensor_t *input, InputDataType inputDataType);    // zw. Optimize performance.
 
+#ifndef __hexagon__
+  PopulateInputTensorsRetType_t populateInputTensor(const datautil::PackedDataset &dataset,
+                                                    const size_t inputColumn,
+                                                    const size_t sampleOffset,
+                                                    const bool loopBackToStart,
+                                                    Qnn_Tensor_t *input,
+                                                    InputDataType inputDataType);
+#endif
+
   PopulateInputTensorsRetType_t readDataAndAllocateBuffer(const std::vector<std::string> &filePaths,
                                                           const size_t filePathsIndexOffset,
                                                           const bool loopBackToStart,
@@ -116,6 +150,14 @@ class IOTensor {
                                std::vector<std::string> outputPaths,
                                std::string fileName,
                                size_t outputBatchSize);
+
+  // writeBatchDataToFile() or, with an output writer set, the queued equivalent.
+  StatusCode writeBatchData(const std::vector<std::string> &outputPaths,
+                            const std::string &fileName,
+                            const std::vector<size_t> &dims,
+                            Qnn_DataType_t dataType,
+                            uint8_t *buffer,
+                            size_t outputBatchSize);
 #endif
 
   StatusCode allocateAndCopyBuffer(uint8_t **buffer, Qnn_Tensor_t *tensor);
@@ -128,6 +170,9 @@ class IOTensor {
 
   StatusCode setupTensors(Qnn_Tensor_t **tensors, uint32_t tensorCount, Qnn_Tensor_t *tensorsInfo);
 
+#ifndef __hexagon__
+  std::shared_ptr<outputwriter::OutputWriter> m_outputWriter;
+#endif
 };
 }  // namespace iotensor
 }  // namespace tools
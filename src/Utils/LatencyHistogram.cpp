@@ -0,0 +1,94 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+#include <limits>
+
+#include "LatencyHistogram.hpp"
+
+using namespace qnn::tools::latency;
+
+static size_t bucketIndex(uint64_t us) {
+  if (us < g_subBuckets) {
+    return (size_t)us;
+  }
+  size_t power = 0;
+  for (uint64_t value = us; value > 1; value >>= 1) {
+    power++;
+  }
+  if (power >= g_maxPowerOf2) {
+    return g_numBuckets - 1;
+  }
+  size_t sub = (size_t)(us >> (power - 4)) & (g_subBuckets - 1);
+  return g_subBuckets + (power - 4) * g_subBuckets + sub;
+}
+
+// Largest value falling into bucket 'index'.
+static uint64_t bucketUpperBound(size_t index) {
+  if (index < g_subBuckets) {
+    return index;
+  }
+  size_t power = (index - g_subBuckets) / g_subBuckets + 4;
+  uint64_t sub = (index - g_subBuckets) % g_subBuckets;
+  return ((g_subBuckets + sub + 1) << (power - 4)) - 1;
+}
+
+LatencyHistogram::LatencyHistogram() { reset(); }
+
+void LatencyHistogram::record(uint64_t us) {
+  m_buckets[bucketIndex(us)].fetch_add(1, std::memory_order_relaxed);
+  m_sum.fetch_add(us, std::memory_order_relaxed);
+
+  uint64_t current = m_min.load(std::memory_order_relaxed);
+  while (us < current && !m_min.compare_exchange_weak(current, us, std::memory_order_relaxed)) {
+  }
+  current = m_max.load(std::memory_order_relaxed);
+  while (us > current && !m_max.compare_exchange_weak(current, us, std::memory_order_relaxed)) {
+  }
+}
+
+LatencySnapshot LatencyHistogram::snapshot() const {
+  LatencySnapshot snapshot;
+  uint64_t counts[g_numBuckets];
+  uint64_t total = 0;
+  for (size_t i = 0; i < g_numBuckets; i++) {
+    counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+  if (0 == total) {
+    return snapshot;
+  }
+  snapshot.count  = total;
+  snapshot.sumUs  = m_sum.load(std::memory_order_relaxed);
+  snapshot.minUs  = m_min.load(std::memory_order_relaxed);
+  snapshot.maxUs  = m_max.load(std::memory_order_relaxed);
+  snapshot.meanUs = (double)snapshot.sumUs / total;
+
+  // Nearest-rank percentiles, reported as the upper bound of the bucket holding the rank.
+  const uint64_t permille[] = {500, 900, 990, 999};
+  uint64_t* results[]       = {&snapshot.p50Us, &snapshot.p90Us, &snapshot.p99Us, &snapshot.p999Us};
+  size_t next               = 0;
+  uint64_t seen             = 0;
+  for (size_t i = 0; i < g_numBuckets && next < 4; i++) {
+    seen += counts[i];
+    while (next < 4 && seen * 1000 >= total * permille[next]) {
+      uint64_t value = bucketUpperBound(i);
+      *results[next] = (value < snapshot.maxUs && i + 1 < g_numBuckets) ? value : snapshot.maxUs;
+      next++;
+    }
+  }
+  return snapshot;
+}
+
+void LatencyHistogram::reset() {
+  for (auto& bucket : m_buckets) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  m_sum.store(0, std::memory_order_relaxed);
+  m_min.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+  m_max.store(0, std::memory_order_relaxed);
+}
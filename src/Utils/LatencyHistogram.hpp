@@ -0,0 +1,95 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace qnn {
+namespace tools {
+namespace latency {
+
+/*
+ * Log-linear buckets in microseconds, HDR histogram style: values below 16 us get a bucket
+ * each, every power of two above is split in 16 buckets, so a bucket is never wider than
+ * 1/16 (6.25%) of its values. The top bucket ends at 2^40 us, about 12 days.
+ */
+const size_t g_subBuckets   = 16;
+const size_t g_maxPowerOf2  = 40;
+const size_t g_numBuckets   = g_subBuckets + (g_maxPowerOf2 - 4) * g_subBuckets;
+
+struct LatencySnapshot {
+  uint64_t count  = 0;
+  uint64_t sumUs  = 0;
+  uint64_t minUs  = 0;
+  uint64_t maxUs  = 0;
+  double meanUs   = 0;
+  uint64_t p50Us  = 0;
+  uint64_t p90Us  = 0;
+  uint64_t p99Us  = 0;
+  uint64_t p999Us = 0;
+};
+
+/*
+ * Latency histogram updated with relaxed atomics only, so any number of threads can record
+ * into it without a lock. A snapshot taken while others record may be off by the samples in
+ * flight, which is fine for monitoring.
+ */
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  void record(uint64_t us);
+
+  LatencySnapshot snapshot() const;
+
+  void reset();
+
+ private:
+  std::atomic<uint64_t> m_buckets[g_numBuckets];
+  std::atomic<uint64_t> m_sum;
+  std::atomic<uint64_t> m_min;
+  std::atomic<uint64_t> m_max;
+};
+
+// Stages of one ModelInference() call. 'total' includes the time spent queued for a batch.
+struct StageHistograms {
+  LatencyHistogram total;
+  LatencyHistogram inputConversion;
+  LatencyHistogram execute;
+  LatencyHistogram outputConversion;
+};
+
+// Adds the lifetime of the enclosing scope, in microseconds, to 'elapsedUs'.
+class ScopedStageTimer {
+ public:
+  explicit ScopedStageTimer(uint64_t& elapsedUs)
+      : m_elapsedUs(elapsedUs), m_start(std::chrono::steady_clock::now()) {}
+
+  ~ScopedStageTimer() {
+    m_elapsedUs += (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - m_start)
+                       .count();
+  }
+
+  ScopedStageTimer(const ScopedStageTimer&) = delete;
+  ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+ private:
+  uint64_t& m_elapsedUs;
+  std::chrono::steady_clock::time_point m_start;
+};
+
+}  // namespace latency
+}  // namespace tools
+}  // namespace qnn
@@ -0,0 +1,293 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+#include <chrono>
+#include <cstring>
+
+#ifdef QNN_ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "Logger.hpp"
+#include "OutputWriter.hpp"
+#include "PAL/Directory.hpp"
+#include "PAL/FileOp.hpp"
+#include "PAL/Path.hpp"
+
+using namespace qnn::tools::outputwriter;
+
+// Keep a few spare buffers per queue slot, more than that is just memory held for nothing.
+static const size_t sg_maxPooledBuffersPerSlot = 2;
+
+OutputWriter::OutputWriter(const OutputWriterConfig& config)
+    : m_config(config), m_queue(config.queueDepth) {
+  if (m_config.numThreads == 0) {
+    m_config.numThreads = 1;
+  }
+#ifndef QNN_ENABLE_ZLIB
+  if (m_config.compress) {
+    QNN_WARN("OutputWriter: built without zlib, outputs are written uncompressed");
+    m_config.compress = false;
+  }
+#endif
+}
+
+OutputWriter::~OutputWriter() { close(); }
+
+bool OutputWriter::start() {
+  std::lock_guard<std::mutex> lock(m_startMutex);
+  if (m_started.load()) {
+    return true;
+  }
+  if (!m_config.containerPath.empty()) {
+    std::string dir = pal::Path::getDirectoryName(m_config.containerPath);
+    if (!dir.empty() && !pal::Directory::makePath(dir)) {
+      QNN_ERROR("Failed to create output directory: %s", dir.c_str());
+      return false;
+    }
+    m_container.open(m_config.containerPath, std::ofstream::binary | std::ofstream::trunc);
+    if (!m_container) {
+      QNN_ERROR("Failed to open output container for writing: %s", m_config.containerPath.c_str());
+      return false;
+    }
+    // Placeholder, the real header is written by finalizeContainer().
+    OutputContainerHeader header{};
+    m_container.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_containerOffset = sizeof(header);
+  }
+  for (size_t i = 0; i < m_config.numThreads; i++) {
+    m_workers.emplace_back(&OutputWriter::run, this);
+  }
+  m_started.store(true);
+  return true;
+}
+
+std::vector<uint8_t> OutputWriter::acquireBuffer(size_t size) {
+  std::vector<uint8_t> buffer;
+  {
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    if (!m_bufferPool.empty()) {
+      buffer = std::move(m_bufferPool.back());
+      m_bufferPool.pop_back();
+    }
+  }
+  buffer.resize(size);
+  return buffer;
+}
+
+void OutputWriter::releaseBuffer(std::vector<uint8_t>&& buffer) {
+  std::lock_guard<std::mutex> lock(m_poolMutex);
+  if (m_bufferPool.size() < sg_maxPooledBuffersPerSlot * (m_config.queueDepth + m_config.numThreads)) {
+    m_bufferPool.push_back(std::move(buffer));
+  }
+}
+
+bool OutputWriter::submit(const std::string& fileDir,
+                          const std::string& fileName,
+                          std::vector<uint8_t>&& data) {
+  if (!m_started.load() && !start()) {
+    return false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+    m_pending++;
+  }
+  Job job;
+  job.fileDir  = fileDir;
+  job.fileName = fileName;
+  job.data     = std::move(data);
+
+  auto begin = std::chrono::steady_clock::now();
+  bool pushed = m_queue.push(std::move(job));
+  uint64_t blockedUs =
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+  {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_stats.blockedUs += blockedUs;
+  }
+
+  if (!pushed) {
+    QNN_ERROR("OutputWriter: writer is closed, dropping %s", fileName.c_str());
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+    m_pending--;
+    m_pendingCv.notify_all();
+    return false;
+  }
+  return !m_failed.load();
+}
+
+bool OutputWriter::flush() {
+  std::unique_lock<std::mutex> lock(m_pendingMutex);
+  m_pendingCv.wait(lock, [this] { return 0 == m_pending; });
+  return !m_failed.load();
+}
+
+bool OutputWriter::close() {
+  std::lock_guard<std::mutex> lock(m_startMutex);
+  if (!m_started.load()) {
+    return !m_failed.load();
+  }
+  flush();
+  m_queue.close();
+  for (auto& worker : m_workers) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+  m_workers.clear();
+  m_started.store(false);
+
+  if (m_container.is_open() && !finalizeContainer()) {
+    m_failed.store(true);
+  }
+
+  OutputWriterStats stats = getStats();
+  QNN_INFO("OutputWriter: %llu blobs, %llu bytes (%llu on disk), submit blocked %llu us",
+           (unsigned long long)stats.blobs,
+           (unsigned long long)stats.rawBytes,
+           (unsigned long long)stats.writtenBytes,
+           (unsigned long long)stats.blockedUs);
+  return !m_failed.load();
+}
+
+OutputWriterStats OutputWriter::getStats() {
+  std::lock_guard<std::mutex> lock(m_statsMutex);
+  return m_stats;
+}
+
+void OutputWriter::run() {
+  Job job;
+  std::vector<uint8_t> scratch;
+  while (m_queue.pop(job)) {
+    if (!writeJob(job, scratch)) {
+      m_failed.store(true);
+    }
+    releaseBuffer(std::move(job.data));
+    job.data = std::vector<uint8_t>();
+
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+    m_pending--;
+    if (0 == m_pending) {
+      m_pendingCv.notify_all();
+    }
+  }
+}
+
+bool OutputWriter::writeJob(Job& job, std::vector<uint8_t>& scratch) {
+  const uint8_t* data = job.data.data();
+  size_t size         = job.data.size();
+  uint32_t flags      = 0;
+  std::string fileName = job.fileName;
+
+#ifdef QNN_ENABLE_ZLIB
+  if (m_config.compress) {
+    uLongf compressedSize = compressBound((uLong)size);
+    scratch.resize(compressedSize);
+    if (Z_OK != compress2(scratch.data(), &compressedSize, data, (uLong)size, Z_BEST_SPEED)) {
+      QNN_ERROR("OutputWriter: failed to compress %s", job.fileName.c_str());
+      return false;
+    }
+    data  = scratch.data();
+    size  = compressedSize;
+    flags = g_outputBlobCompressed;
+    fileName += ".z";
+  }
+#else
+  (void)scratch;
+#endif
+
+  bool result;
+  if (m_container.is_open()) {
+    result = appendToContainer(job.fileDir + pal::Path::getSeparator() + fileName,
+                               data, size, job.data.size(), flags);
+  } else {
+    result = writeLooseFile(job.fileDir, fileName, data, size);
+  }
+
+  std::lock_guard<std::mutex> lock(m_statsMutex);
+  m_stats.blobs++;
+  m_stats.rawBytes += job.data.size();
+  m_stats.writtenBytes += size;
+  return result;
+}
+
+bool OutputWriter::writeLooseFile(const std::string& fileDir,
+                                  const std::string& fileName,
+                                  const uint8_t* data,
+                                  size_t size) {
+  // Every batch writes into the same few directories, only create each of them once.
+  bool created;
+  {
+    std::lock_guard<std::mutex> lock(m_dirMutex);
+    created = m_createdDirs.count(fileDir) > 0;
+  }
+  if (!created) {
+    if (!pal::Directory::makePath(fileDir)) {
+      QNN_ERROR("Failed to create output directory: %s", fileDir.c_str());
+      return false;
+    }
+    std::lock_guard<std::mutex> lock(m_dirMutex);
+    m_createdDirs.insert(fileDir);
+  }
+
+  const std::string outputPath(fileDir + pal::Path::getSeparator() + fileName);
+  std::ofstream os(outputPath, std::ofstream::binary);
+  if (!os) {
+    QNN_ERROR("Failed to open output file for writing: %s", outputPath.c_str());
+    return false;
+  }
+  if (!os.write(reinterpret_cast<const char*>(data), size)) {
+    QNN_ERROR("Failed to write output file: %s", outputPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool OutputWriter::appendToContainer(const std::string& name,
+                                     const uint8_t* data,
+                                     size_t size,
+                                     size_t rawSize,
+                                     uint32_t flags) {
+  std::lock_guard<std::mutex> lock(m_containerMutex);
+  OutputContainerEntry entry{};
+  entry.offset     = m_containerOffset;
+  entry.size       = size;
+  entry.rawSize    = rawSize;
+  entry.flags      = flags;
+  entry.nameLength = (uint32_t)name.size();
+  if (!m_container.write(reinterpret_cast<const char*>(data), size)) {
+    QNN_ERROR("Failed to append %s to the output container", name.c_str());
+    return false;
+  }
+  m_containerOffset += size;
+  m_containerIndex.emplace_back(entry, name);
+  return true;
+}
+
+bool OutputWriter::finalizeContainer() {
+  std::lock_guard<std::mutex> lock(m_containerMutex);
+  OutputContainerHeader header{};
+  memcpy(header.magic, g_outputContainerMagic, sizeof(g_outputContainerMagic));
+  header.version     = g_outputContainerVersion;
+  header.numEntries  = m_containerIndex.size();
+  header.indexOffset = m_containerOffset;
+
+  for (auto& entry : m_containerIndex) {
+    m_container.write(reinterpret_cast<const char*>(&entry.first), sizeof(entry.first));
+    m_container.write(entry.second.data(), entry.second.size());
+  }
+  m_container.seekp(0);
+  m_container.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  bool result = !m_container.fail();
+  m_container.close();
+  if (!result) {
+    QNN_ERROR("Failed to finalize output container: %s", m_config.containerPath.c_str());
+  }
+  m_containerIndex.clear();
+  return result;
+}
@@ -0,0 +1,141 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "BlockingQueue.hpp"
+
+namespace qnn {
+namespace tools {
+namespace outputwriter {
+
+/*
+ * Output container: every output blob of a run in one file.
+ *
+ *   OutputContainerHeader
+ *   blobs              written in completion order
+ *   index              numEntries x (OutputContainerEntry + name), at 'indexOffset'
+ *
+ * The header is rewritten on close() once the index is known, so a container without a
+ * valid magic was not closed properly.
+ */
+const char g_outputContainerMagic[8]   = {'Q', 'A', 'I', 'O', 'U', 'T', '\0', '\0'};
+const uint32_t g_outputContainerVersion = 1;
+const uint32_t g_outputBlobCompressed   = 0x1;  // Blob is a zlib stream of 'rawSize' bytes.
+
+struct OutputContainerHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t numEntries;
+  uint64_t indexOffset;
+};
+
+struct OutputContainerEntry {
+  uint64_t offset;
+  uint64_t size;
+  uint64_t rawSize;
+  uint32_t flags;
+  uint32_t nameLength;  // Followed by the relative path of the blob, not null terminated.
+};
+
+struct OutputWriterConfig {
+  size_t queueDepth  = 16;     // Max blobs waiting for the disk before submit() blocks.
+  size_t numThreads  = 1;
+  bool compress      = false;  // Needs a build with zlib (QNN_ENABLE_ZLIB).
+  std::string containerPath;   // Write one container file instead of a file per blob.
+};
+
+struct OutputWriterStats {
+  uint64_t blobs        = 0;
+  uint64_t rawBytes     = 0;
+  uint64_t writtenBytes = 0;
+  uint64_t blockedUs    = 0;   // Time submit() spent waiting for a free queue slot.
+};
+
+/*
+ * Background writer for output tensors. The executing thread copies each output into a
+ * recycled buffer and returns; writer threads create the directories, optionally compress
+ * and write the blobs, either as loose files or appended to a single container.
+ */
+class OutputWriter {
+ public:
+  explicit OutputWriter(const OutputWriterConfig& config);
+  ~OutputWriter();
+
+  OutputWriter(const OutputWriter&) = delete;
+  OutputWriter& operator=(const OutputWriter&) = delete;
+
+  bool start();
+
+  // Returns a buffer of 'size' bytes, reusing one released by a writer thread if possible.
+  std::vector<uint8_t> acquireBuffer(size_t size);
+
+  // Queues 'data' to be written to 'fileDir'/'fileName'. Blocks only when the queue is full.
+  bool submit(const std::string& fileDir, const std::string& fileName, std::vector<uint8_t>&& data);
+
+  // Waits until everything submitted so far is on disk. Returns false if any write failed.
+  bool flush();
+
+  // Flushes, stops the writer threads and finalizes the container.
+  bool close();
+
+  OutputWriterStats getStats();
+
+ private:
+  struct Job {
+    std::string fileDir;
+    std::string fileName;
+    std::vector<uint8_t> data;
+  };
+
+  void run();
+  bool writeJob(Job& job, std::vector<uint8_t>& scratch);
+  bool writeLooseFile(const std::string& fileDir, const std::string& fileName, const uint8_t* data, size_t size);
+  bool appendToContainer(const std::string& name, const uint8_t* data, size_t size, size_t rawSize, uint32_t flags);
+  bool finalizeContainer();
+  void releaseBuffer(std::vector<uint8_t>&& buffer);
+
+  OutputWriterConfig m_config;
+  BlockingQueue<Job> m_queue;
+  std::vector<std::thread> m_workers;
+  std::mutex m_startMutex;   // Serializes start() and close(); submit() may start from any thread.
+  std::atomic<bool> m_started{false};
+  std::atomic<bool> m_failed{false};
+
+  std::mutex m_pendingMutex;
+  std::condition_variable m_pendingCv;
+  size_t m_pending = 0;
+
+  std::mutex m_poolMutex;
+  std::vector<std::vector<uint8_t>> m_bufferPool;
+
+  std::mutex m_dirMutex;
+  std::unordered_set<std::string> m_createdDirs;
+
+  std::mutex m_containerMutex;
+  std::ofstream m_container;
+  uint64_t m_containerOffset = 0;
+  std::vector<std::pair<OutputContainerEntry, std::string>> m_containerIndex;
+
+  std::mutex m_statsMutex;
+  OutputWriterStats m_stats;
+};
+
+}  // namespace outputwriter
+}  // namespace tools
+}  // namespace qnn
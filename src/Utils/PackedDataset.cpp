@@ -0,0 +1,301 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+#include <cstring>
+#include <fstream>
+
+#include "Logger.hpp"
+#include "PAL/FileOp.hpp"
+#include "PackedDataset.hpp"
+
+using namespace qnn;
+using namespace qnn::tools;
+using namespace qnn::tools::datautil;
+
+static size_t alignUp(size_t value) {
+  return (value + g_packedDatasetAlignment - 1) / g_packedDatasetAlignment * g_packedDatasetAlignment;
+}
+
+bool datautil::PackedDataset::isPackedDataset(const std::string& path) {
+  const std::string& ext = g_packedDatasetExtension;
+  return path.size() > ext.size() && 0 == path.compare(path.size() - ext.size(), ext.size(), ext);
+}
+
+bool datautil::PackedDataset::open(const std::string& path) {
+  if (!m_file.open(path)) {
+    QNN_ERROR("Failed to map packed dataset: %s", path.c_str());
+    return false;
+  }
+
+  const uint8_t* base = m_file.data();
+  if (m_file.size() < sizeof(PackedDatasetHeader)) {
+    QNN_ERROR("Packed dataset %s is truncated", path.c_str());
+    m_file.close();
+    return false;
+  }
+  const PackedDatasetHeader* header = reinterpret_cast<const PackedDatasetHeader*>(base);
+  if (0 != memcmp(header->magic, g_packedDatasetMagic, sizeof(g_packedDatasetMagic)) ||
+      header->version != g_packedDatasetVersion) {
+    QNN_ERROR("%s is not a packed dataset of version %u", path.c_str(), g_packedDatasetVersion);
+    m_file.close();
+    return false;
+  }
+
+  // Compare by subtraction and division, so a corrupt header cannot overflow the checks.
+  uint64_t fileSize = m_file.size();
+  if (header->namesOffset > fileSize || header->indexOffset > fileSize ||
+      header->numInputs > (fileSize - header->namesOffset) / g_packedDatasetNameSize ||
+      (header->numInputs > 0 &&
+       header->numSamples > (fileSize - header->indexOffset) / sizeof(PackedDatasetEntry) / header->numInputs)) {
+    QNN_ERROR("Packed dataset %s is truncated", path.c_str());
+    m_file.close();
+    return false;
+  }
+
+  uint64_t numEntries = (uint64_t)header->numInputs * header->numSamples;
+  m_numInputs  = header->numInputs;
+  m_numSamples = header->numSamples;
+  m_entries    = reinterpret_cast<const PackedDatasetEntry*>(base + header->indexOffset);
+  for (uint64_t i = 0; i < numEntries; i++) {
+    if (m_entries[i].offset > fileSize || m_entries[i].size > fileSize - m_entries[i].offset) {
+      QNN_ERROR("Packed dataset %s has an entry outside of the file", path.c_str());
+      m_file.close();
+      return false;
+    }
+  }
+
+  m_inputNameToIndex.clear();
+  const char* names = reinterpret_cast<const char*>(base + header->namesOffset);
+  for (uint32_t inputIdx = 0; inputIdx < m_numInputs; inputIdx++) {
+    const char* name = names + (size_t)inputIdx * g_packedDatasetNameSize;
+    size_t length    = strnlen(name, g_packedDatasetNameSize);
+    if (length > 0) {
+      m_inputNameToIndex[std::string(name, length)] = inputIdx;
+    }
+  }
+
+  QNN_DEBUG("Mapped packed dataset %s: %zu inputs, %zu samples", path.c_str(), m_numInputs, m_numSamples);
+  return true;
+}
+
+const datautil::PackedDatasetEntry* datautil::PackedDataset::getEntry(size_t inputIdx,
+                                                                      size_t sampleIdx) const {
+  if (inputIdx >= m_numInputs || sampleIdx >= m_numSamples) {
+    return nullptr;
+  }
+  return &m_entries[inputIdx * m_numSamples + sampleIdx];
+}
+
+datautil::ReadBatchDataRetType_t datautil::PackedDataset::readBatchData(size_t inputIdx,
+                                                                        size_t sampleOffset,
+                                                                        bool loopBackToStart,
+                                                                        const std::vector<size_t>& dims,
+                                                                        Qnn_DataType_t dataType,
+                                                                        uint8_t* buffer) const {
+  if (nullptr == buffer) {
+    QNN_ERROR("buffer is nullptr");
+    return std::make_tuple(StatusCode::INVALID_BUFFER, 0, 0);
+  }
+  if (inputIdx >= m_numInputs || 0 == m_numSamples) {
+    QNN_ERROR("Packed dataset has no samples for input %zu", inputIdx);
+    return std::make_tuple(StatusCode::DATA_READ_FAIL, 0, 0);
+  }
+  StatusCode err{StatusCode::SUCCESS};
+  size_t tensorLength{0};
+  std::tie(err, tensorLength) = datautil::calculateLength(dims, dataType);
+  if (StatusCode::SUCCESS != err) {
+    return std::make_tuple(err, 0, 0);
+  }
+
+  size_t numInputsCopied = 0;
+  size_t numBatchSize    = 0;
+  size_t totalLength     = 0;
+  size_t sampleIdx       = sampleOffset;
+  while (true) {
+    if (sampleIdx >= m_numSamples) {
+      if (loopBackToStart) {
+        sampleIdx = sampleIdx % m_numSamples;
+      } else {
+        numBatchSize += (tensorLength - totalLength) / (totalLength / numBatchSize);
+        // pad the vector with zeros
+        memset(buffer + totalLength, 0, tensorLength - totalLength);
+        break;
+      }
+    }
+    const PackedDatasetEntry* entry = getEntry(inputIdx, sampleIdx);
+    const size_t sampleSize         = (size_t)entry->size;
+    if (sampleSize == 0 || sampleSize > tensorLength || (tensorLength % sampleSize) != 0) {
+      QNN_ERROR(
+          "Packed sample %zu of input %zu has %zu bytes. If the model expects a batch size of "
+          "one, the sample size should match the tensor extent: %zu bytes. If the model expects a "
+          "batch size > 1, the sample size should evenly divide the tensor extent.",
+          sampleIdx,
+          inputIdx,
+          sampleSize,
+          tensorLength);
+      return std::make_tuple(StatusCode::DATA_SIZE_MISMATCH, numInputsCopied, numBatchSize);
+    }
+    memcpy(buffer + numInputsCopied * sampleSize, m_file.data() + entry->offset, sampleSize);
+    totalLength += sampleSize;
+    numInputsCopied += 1;
+    numBatchSize += 1;
+    sampleIdx += 1;
+    if (totalLength >= tensorLength) {
+      break;
+    }
+  }
+  return std::make_tuple(StatusCode::SUCCESS, numInputsCopied, numBatchSize);
+}
+
+const uint8_t* datautil::PackedDataset::getBatchView(size_t inputIdx,
+                                                     size_t sampleOffset,
+                                                     size_t tensorLength,
+                                                     size_t& numSamples) const {
+  numSamples                      = 0;
+  const PackedDatasetEntry* first = getEntry(inputIdx, sampleOffset);
+  if (nullptr == first || 0 == first->size || (tensorLength % first->size) != 0) {
+    return nullptr;
+  }
+  size_t count = tensorLength / (size_t)first->size;
+  if (sampleOffset + count > m_numSamples) {
+    return nullptr;
+  }
+  // Samples of a column are written back to back, so the batch is contiguous as long as
+  // they all have the same size.
+  const PackedDatasetEntry* last = getEntry(inputIdx, sampleOffset + count - 1);
+  if (last->offset + last->size - first->offset != tensorLength) {
+    return nullptr;
+  }
+  numSamples = count;
+  return m_file.data() + first->offset;
+}
+
+datautil::StatusCode datautil::packInputList(
+    const std::vector<std::vector<std::string>>& filePaths,
+    const std::unordered_map<std::string, uint32_t>& inputNameToIndex,
+    const std::string& outputPath,
+    Qnn_DataType_t dataType) {
+  if (filePaths.empty() || filePaths[0].empty()) {
+    QNN_ERROR("Input list is empty, nothing to pack into %s", outputPath.c_str());
+    return StatusCode::DATA_READ_FAIL;
+  }
+  const size_t numInputs  = filePaths.size();
+  const size_t numSamples = filePaths[0].size();
+  for (size_t inputIdx = 1; inputIdx < numInputs; inputIdx++) {
+    if (filePaths[inputIdx].size() != numSamples) {
+      QNN_ERROR("Input %zu has %zu files, expected %zu", inputIdx, filePaths[inputIdx].size(), numSamples);
+      return StatusCode::DATA_SIZE_MISMATCH;
+    }
+  }
+
+  size_t elementSize = 0;
+  if (QNN_DATATYPE_UNDEFINED != dataType) {
+    StatusCode err{StatusCode::SUCCESS};
+    std::tie(err, elementSize) = datautil::getDataTypeSizeInBytes(dataType);
+    if (StatusCode::SUCCESS != err) {
+      return err;
+    }
+  }
+
+  // Lay out the file: header, names, index, then one aligned column per input.
+  PackedDatasetHeader header{};
+  memcpy(header.magic, g_packedDatasetMagic, sizeof(g_packedDatasetMagic));
+  header.version     = g_packedDatasetVersion;
+  header.numInputs   = (uint32_t)numInputs;
+  header.numSamples  = numSamples;
+  header.namesOffset = alignUp(sizeof(PackedDatasetHeader));
+  header.indexOffset = alignUp(header.namesOffset + numInputs * g_packedDatasetNameSize);
+
+  std::vector<PackedDatasetEntry> entries(numInputs * numSamples);
+  size_t dataOffset = alignUp(header.indexOffset + entries.size() * sizeof(PackedDatasetEntry));
+  for (size_t inputIdx = 0; inputIdx < numInputs; inputIdx++) {
+    dataOffset = alignUp(dataOffset);
+    for (size_t sampleIdx = 0; sampleIdx < numSamples; sampleIdx++) {
+      StatusCode err{StatusCode::SUCCESS};
+      size_t fileSize{0};
+      std::tie(err, fileSize) = datautil::getFileSize(filePaths[inputIdx][sampleIdx]);
+      if (StatusCode::SUCCESS != err) {
+        return err;
+      }
+      if (elementSize > 0 && (fileSize % elementSize) != 0) {
+        QNN_ERROR("Size of %s is not a multiple of the element size %zu",
+                  filePaths[inputIdx][sampleIdx].c_str(), elementSize);
+        return StatusCode::DATA_SIZE_MISMATCH;
+      }
+      PackedDatasetEntry& entry = entries[inputIdx * numSamples + sampleIdx];
+      entry.offset              = dataOffset;
+      entry.size                = fileSize;
+      entry.dataType            = (uint32_t)dataType;
+      entry.rank                = 1;
+      entry.dims[0]             = (uint32_t)(elementSize > 0 ? fileSize / elementSize : fileSize);
+      dataOffset += fileSize;
+    }
+  }
+
+  std::vector<char> names(numInputs * g_packedDatasetNameSize, 0);
+  for (auto& nameIdx : inputNameToIndex) {
+    if (nameIdx.second < numInputs) {
+      strncpy(names.data() + (size_t)nameIdx.second * g_packedDatasetNameSize,
+              nameIdx.first.c_str(), g_packedDatasetNameSize - 1);
+    }
+  }
+
+  // Write to a temporary file and move it in place so a reader never sees a partial dataset.
+  std::string tmpPath = outputPath + ".tmp";
+  {
+    std::ofstream out(tmpPath, std::ofstream::binary | std::ofstream::trunc);
+    if (!out) {
+      QNN_ERROR("Failed to open packed dataset for writing: %s", tmpPath.c_str());
+      return StatusCode::FILE_OPEN_FAIL;
+    }
+    auto padTo = [&out](size_t offset) {
+      static const char zeros[g_packedDatasetAlignment] = {0};
+      size_t pos = (size_t)out.tellp();
+      if (offset > pos) {
+        out.write(zeros, offset - pos);
+      }
+    };
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    padTo(header.namesOffset);
+    out.write(names.data(), names.size());
+    padTo(header.indexOffset);
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(PackedDatasetEntry));
+
+    std::vector<char> buffer;
+    for (size_t inputIdx = 0; inputIdx < numInputs && out; inputIdx++) {
+      for (size_t sampleIdx = 0; sampleIdx < numSamples; sampleIdx++) {
+        const PackedDatasetEntry& entry = entries[inputIdx * numSamples + sampleIdx];
+        padTo(entry.offset);
+        buffer.resize(entry.size);
+        if (StatusCode::SUCCESS != datautil::readBinaryFromFile(filePaths[inputIdx][sampleIdx],
+                                                                reinterpret_cast<uint8_t*>(buffer.data()),
+                                                                buffer.size())) {
+          out.close();
+          pal::FileOp::deleteFile(tmpPath);
+          return StatusCode::DATA_READ_FAIL;
+        }
+        out.write(buffer.data(), buffer.size());
+      }
+    }
+    if (!out) {
+      QNN_ERROR("Failed to write packed dataset: %s", tmpPath.c_str());
+      out.close();
+      pal::FileOp::deleteFile(tmpPath);
+      return StatusCode::DATA_WRITE_FAIL;
+    }
+  }
+
+  if (!pal::FileOp::move(tmpPath, outputPath, true)) {
+    QNN_ERROR("Failed to move %s to %s", tmpPath.c_str(), outputPath.c_str());
+    pal::FileOp::deleteFile(tmpPath);
+    return StatusCode::DATA_WRITE_FAIL;
+  }
+  QNN_INFO("Packed %zu samples of %zu inputs into %s", numSamples, numInputs, outputPath.c_str());
+  return StatusCode::SUCCESS;
+}
@@ -0,0 +1,114 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "DataUtil.hpp"
+#include "PAL/MappedFile.hpp"
+#include "QnnTypes.h"
+
+namespace qnn {
+namespace tools {
+namespace datautil {
+
+/*
+ * Packed dataset: all the raw files of an input list stored in one file, read through a
+ * memory mapping instead of one ifstream per file.
+ *
+ *   PackedDatasetHeader
+ *   input names        numInputs x char[g_packedDatasetNameSize]
+ *   index              numInputs x numSamples PackedDatasetEntry, input-major
+ *   data               one column per input, 64-byte aligned; the samples of a column are
+ *                      stored back to back so a batch of consecutive samples is contiguous.
+ */
+const char g_packedDatasetMagic[8]         = {'Q', 'A', 'I', 'P', 'A', 'C', 'K', '\0'};
+const uint32_t g_packedDatasetVersion      = 1;
+const uint32_t g_packedDatasetNameSize     = 256;
+const uint32_t g_packedDatasetMaxRank      = 8;
+const size_t g_packedDatasetAlignment      = 64;
+const std::string g_packedDatasetExtension = ".qaipack";
+
+struct PackedDatasetHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t numInputs;
+  uint64_t numSamples;
+  uint64_t namesOffset;
+  uint64_t indexOffset;
+};
+
+struct PackedDatasetEntry {
+  uint64_t offset;    // From the start of the file.
+  uint64_t size;      // In bytes.
+  uint32_t dataType;  // Qnn_DataType_t of the sample, QNN_DATATYPE_UNDEFINED if not known.
+  uint32_t rank;
+  uint32_t dims[g_packedDatasetMaxRank];
+};
+
+class PackedDataset {
+ public:
+  static bool isPackedDataset(const std::string& path);
+
+  bool open(const std::string& path);
+
+  size_t getNumSamples() const { return m_numSamples; }
+
+  size_t getNumInputs() const { return m_numInputs; }
+
+  const std::unordered_map<std::string, uint32_t>& getInputNameToIndex() const {
+    return m_inputNameToIndex;
+  }
+
+  const PackedDatasetEntry* getEntry(size_t inputIdx, size_t sampleIdx) const;
+
+  /*
+   * Same contract as datautil::readBatchData(), reading the samples of column 'inputIdx'
+   * from the mapping instead of from files.
+   */
+  ReadBatchDataRetType_t readBatchData(size_t inputIdx,
+                                       size_t sampleOffset,
+                                       bool loopBackToStart,
+                                       const std::vector<size_t>& dims,
+                                       Qnn_DataType_t dataType,
+                                       uint8_t* buffer) const;
+
+  /*
+   * Returns a pointer into the mapping when 'tensorLength' bytes are covered exactly by
+   * consecutive samples starting at 'sampleOffset', so the caller can consume them without
+   * copying. Returns nullptr when the batch is partial or the samples don't fit the tensor.
+   */
+  const uint8_t* getBatchView(size_t inputIdx,
+                              size_t sampleOffset,
+                              size_t tensorLength,
+                              size_t& numSamples) const;
+
+ private:
+  pal::MappedFile m_file;
+  size_t m_numInputs                    = 0;
+  size_t m_numSamples                   = 0;
+  const PackedDatasetEntry* m_entries   = nullptr;
+  std::unordered_map<std::string, uint32_t> m_inputNameToIndex;
+};
+
+/*
+ * Packs the files of a parsed input list into a packed dataset at 'outputPath'.
+ * @param filePaths one vector of sample files per input, as returned by readInputList()
+ * @param inputNameToIndex input names given in the input list, may be empty
+ * @param dataType data type of the files, QNN_DATATYPE_UNDEFINED if not known
+ */
+StatusCode packInputList(const std::vector<std::vector<std::string>>& filePaths,
+                         const std::unordered_map<std::string, uint32_t>& inputNameToIndex,
+                         const std::string& outputPath,
+                         Qnn_DataType_t dataType);
+
+}  // namespace datautil
+}  // namespace tools
+}  // namespace qnn
@@ -0,0 +1,87 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+#include "ProfilingRecorder.hpp"
+
+using namespace qnn::tools::profiling;
+
+// Nearest-rank percentile of sorted 'samples'.
+static uint64_t percentile(const std::vector<uint64_t>& samples, size_t pct) {
+  size_t rank = (samples.size() * pct + 99) / 100;
+  return samples[rank > 0 ? rank - 1 : 0];
+}
+
+ProfilingRecorder::ProfilingRecorder(size_t capacity) : m_ring(capacity > 0 ? capacity : 1) {}
+
+void ProfilingRecorder::record(std::vector<ProfilingRecord>& records) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  uint64_t requestId = m_requestId++;
+  for (auto& record : records) {
+    record.requestId = requestId;
+    m_ring[m_next]   = record;
+    m_next           = (m_next + 1) % m_ring.size();
+  }
+  m_size = std::min(m_size + records.size(), m_ring.size());
+}
+
+std::vector<ProfilingRecord> ProfilingRecorder::getRecords() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<ProfilingRecord> records;
+  records.reserve(m_size);
+  size_t first = (m_next + m_ring.size() - m_size) % m_ring.size();
+  for (size_t i = 0; i < m_size; i++) {
+    records.push_back(m_ring[(first + i) % m_ring.size()]);
+  }
+  return records;
+}
+
+std::vector<ProfilingEventStats> ProfilingRecorder::getStats() {
+  // Copy out first, so executions aren't blocked while sorting.
+  std::vector<ProfilingRecord> records = getRecords();
+
+  std::map<std::tuple<uint32_t, std::string, uint32_t>, std::vector<uint64_t>> values;
+  std::map<std::tuple<uint32_t, std::string, uint32_t>, uint32_t> types;
+  for (auto& record : records) {
+    auto key = std::make_tuple(record.graphIdx, std::string(record.identifier), record.unit);
+    values[key].push_back(record.value);
+    types[key] = record.type;
+  }
+
+  std::vector<ProfilingEventStats> stats;
+  stats.reserve(values.size());
+  for (auto& item : values) {
+    std::vector<uint64_t>& samples = item.second;
+    std::sort(samples.begin(), samples.end());
+
+    ProfilingEventStats event;
+    std::tie(event.graphIdx, event.identifier, event.unit) = item.first;
+    event.type  = types[item.first];
+    event.count = samples.size();
+    event.min   = samples.front();
+    event.max   = samples.back();
+    double sum  = 0;
+    for (uint64_t sample : samples) {
+      sum += (double)sample;
+    }
+    event.mean = sum / samples.size();
+    event.p50  = percentile(samples, 50);
+    event.p99  = percentile(samples, 99);
+    stats.push_back(event);
+  }
+  return stats;
+}
+
+void ProfilingRecorder::reset() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_next = 0;
+  m_size = 0;
+}
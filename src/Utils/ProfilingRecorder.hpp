@@ -0,0 +1,83 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace qnn {
+namespace tools {
+namespace profiling {
+
+const uint32_t g_noGraph  = 0xFFFFFFFF;  // Event not tied to a graph, e.g. context creation.
+const int32_t g_noParent  = -1;
+const size_t g_maxEventIdentifierLength = 63;
+const size_t g_defaultRecorderCapacity  = 16384;
+
+// One backend profiling event. Fixed size, so the ring never allocates on the hot path.
+struct ProfilingRecord {
+  uint64_t requestId;
+  uint64_t value;
+  uint32_t graphIdx;
+  uint32_t eventIdx;  // Position of the event within its request, in depth-first order.
+  int32_t parent;     // 'eventIdx' of the parent event, g_noParent for top level events.
+  uint32_t type;      // QnnProfile_EventType_t
+  uint32_t unit;      // QnnProfile_EventUnit_t
+  char identifier[g_maxEventIdentifierLength + 1];
+};
+
+// Aggregate of all recorded occurrences of one event of one graph.
+struct ProfilingEventStats {
+  std::string identifier;
+  uint32_t graphIdx = g_noGraph;
+  uint32_t type     = 0;
+  uint32_t unit     = 0;
+  uint64_t count    = 0;
+  uint64_t min      = 0;
+  uint64_t max      = 0;
+  double mean       = 0;
+  uint64_t p50      = 0;
+  uint64_t p99      = 0;
+};
+
+/*
+ * Preallocated ring of profiling records of one model. Executions only copy their events
+ * into the ring; the oldest records are overwritten once it is full. Per-event statistics
+ * are computed from the records held in the ring when getStats() is called, off the
+ * execution path.
+ */
+class ProfilingRecorder {
+ public:
+  explicit ProfilingRecorder(size_t capacity = g_defaultRecorderCapacity);
+
+  ProfilingRecorder(const ProfilingRecorder&) = delete;
+  ProfilingRecorder& operator=(const ProfilingRecorder&) = delete;
+
+  // Appends the events of one request, stamping them with a new request id.
+  void record(std::vector<ProfilingRecord>& records);
+
+  std::vector<ProfilingEventStats> getStats();
+
+  // Copy of the records currently held, oldest first.
+  std::vector<ProfilingRecord> getRecords();
+
+  void reset();
+
+ private:
+  std::mutex m_mutex;
+  std::vector<ProfilingRecord> m_ring;
+  size_t m_next         = 0;
+  size_t m_size         = 0;
+  uint64_t m_requestId  = 0;
+};
+
+}  // namespace profiling
+}  // namespace tools
+}  // namespace qnn
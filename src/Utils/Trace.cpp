@@ -0,0 +1,202 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "Logger.hpp"
+#include "Trace.hpp"
+
+using namespace qnn::tools;
+
+std::atomic<bool> trace::g_traceEnabled{false};
+
+namespace {
+
+struct TraceEvent {
+  std::string name;
+  const char* category;
+  uint64_t startUs;
+  uint64_t durationUs;
+  std::string detail;
+};
+
+struct ThreadBuffer {
+  std::mutex mutex;  // Only contended while dump() or clear() runs.
+  std::vector<TraceEvent> events;
+  uint32_t tid;       // Of the OS, so spans line up with other tools.
+  bool exited = false;
+};
+
+}  // namespace
+
+static std::mutex sg_buffersMutex;
+static std::vector<std::shared_ptr<ThreadBuffer>> sg_buffers;
+static std::atomic<uint64_t> sg_droppedEvents{0};
+
+static uint32_t currentThreadId() {
+#ifdef _WIN32
+  return (uint32_t)GetCurrentThreadId();
+#else
+  return (uint32_t)syscall(SYS_gettid);
+#endif
+}
+
+namespace {
+
+// The buffer of a thread. When the thread exits, an empty buffer is freed right away; one holding spans is
+// kept for dump() until the next clear().
+struct LocalBuffer {
+  std::shared_ptr<ThreadBuffer> buffer = std::make_shared<ThreadBuffer>();
+
+  LocalBuffer() {
+    buffer->tid = currentThreadId();
+    std::lock_guard<std::mutex> lock(sg_buffersMutex);
+    sg_buffers.push_back(buffer);
+  }
+
+  ~LocalBuffer() {
+    std::lock_guard<std::mutex> lock(sg_buffersMutex);
+    std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+    buffer->exited = true;
+    if (buffer->events.empty()) {
+      sg_buffers.erase(std::find(sg_buffers.begin(), sg_buffers.end(), buffer));
+    }
+  }
+};
+
+}  // namespace
+
+static ThreadBuffer& localBuffer() {
+  thread_local LocalBuffer local;
+  return *local.buffer;
+}
+
+static void appendEvent(TraceEvent&& event) {
+  ThreadBuffer& buffer = localBuffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  if (buffer.events.size() >= trace::g_maxEventsPerThread) {
+    sg_droppedEvents++;
+    return;
+  }
+  buffer.events.push_back(std::move(event));
+}
+
+static void writeJsonString(std::ofstream& out, const std::string& value) {
+  out << '"';
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      out << '\\' << c;
+    } else if ((unsigned char)c < 0x20) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      out << escaped;
+    } else {
+      out << c;
+    }
+  }
+  out << '"';
+}
+
+void trace::setEnabled(bool enabled) { g_traceEnabled.store(enabled, std::memory_order_relaxed); }
+
+uint64_t trace::nowUs() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void trace::addSpan(const char* name,
+                    const char* category,
+                    uint64_t startUs,
+                    uint64_t durationUs,
+                    const std::string& detail) {
+  appendEvent(TraceEvent{name, category, startUs, durationUs, detail});
+}
+
+void trace::addBackendSpans(const std::vector<profiling::ProfilingRecord>& records,
+                            uint64_t startUs,
+                            uint32_t timeUnit) {
+  // Start of each event, and where the next child of each event starts.
+  std::vector<uint64_t> starts(records.size(), startUs);
+  std::vector<uint64_t> childCursor(records.size(), startUs);
+  for (size_t i = 0; i < records.size(); i++) {
+    const profiling::ProfilingRecord& record = records[i];
+    if (record.parent >= 0 && (size_t)record.parent < i) {
+      starts[i] = childCursor[record.parent];
+    }
+    childCursor[i] = starts[i];
+    if (record.unit != timeUnit) {
+      continue;
+    }
+    if (record.parent >= 0 && (size_t)record.parent < i) {
+      childCursor[record.parent] += record.value;
+    }
+    appendEvent(TraceEvent{record.identifier, "backend", starts[i], record.value, std::string()});
+  }
+}
+
+bool trace::dump(const std::string& path) {
+  std::ofstream out(path, std::ofstream::trunc);
+  if (!out) {
+    QNN_ERROR("Failed to open trace file for writing: %s", path.c_str());
+    return false;
+  }
+
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  {
+    std::lock_guard<std::mutex> lock(sg_buffersMutex);
+    buffers = sg_buffers;
+  }
+
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  for (auto& buffer : buffers) {
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+    for (auto& event : buffer->events) {
+      out << (first ? "\n" : ",\n") << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+          << ",\"ts\":" << event.startUs << ",\"dur\":" << event.durationUs << ",\"cat\":\"" << event.category
+          << "\",\"name\":";
+      writeJsonString(out, event.name);
+      if (!event.detail.empty()) {
+        out << ",\"args\":{\"detail\":";
+        writeJsonString(out, event.detail);
+        out << "}";
+      }
+      out << "}";
+      first = false;
+    }
+  }
+  out << "\n],\"otherData\":{\"droppedEvents\":" << sg_droppedEvents.load() << "}}\n";
+
+  if (!out) {
+    QNN_ERROR("Failed to write trace file: %s", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+void trace::clear() {
+  std::lock_guard<std::mutex> lock(sg_buffersMutex);
+  for (auto it = sg_buffers.begin(); it != sg_buffers.end();) {
+    std::shared_ptr<ThreadBuffer> buffer = *it;
+    std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+    buffer->events.clear();
+    it = buffer->exited ? sg_buffers.erase(it) : it + 1;
+  }
+  sg_droppedEvents = 0;
+}
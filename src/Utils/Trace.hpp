@@ -0,0 +1,92 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ProfilingRecorder.hpp"
+
+namespace qnn {
+namespace tools {
+namespace trace {
+
+/*
+ * Timeline tracing of host work, written out in the Chrome trace event format, which
+ * chrome://tracing and ui.perfetto.dev both load.
+ *
+ * Spans are appended to a buffer owned by the calling thread, so recording never contends
+ * with other threads. While tracing is disabled a span costs one relaxed atomic load.
+ */
+
+extern std::atomic<bool> g_traceEnabled;
+
+const size_t g_maxEventsPerThread = 1 << 20;  // Further spans are dropped and counted.
+
+inline bool isEnabled() { return g_traceEnabled.load(std::memory_order_relaxed); }
+
+void setEnabled(bool enabled);
+
+// Microseconds on the steady clock, the time base of all spans.
+uint64_t nowUs();
+
+void addSpan(const char* name, const char* category, uint64_t startUs, uint64_t durationUs,
+             const std::string& detail = std::string());
+
+// Adds the backend profiling events of one execution, started at 'startUs', as spans on the
+// calling thread. Only events in 'timeUnit' have a duration. The backend reports no start
+// times: top level events start with the execution, sub-events are laid out back to back
+// from the start of their parent.
+void addBackendSpans(const std::vector<profiling::ProfilingRecord>& records,
+                     uint64_t startUs,
+                     uint32_t timeUnit);
+
+// Writes every span recorded so far to 'path' as Chrome trace JSON.
+bool dump(const std::string& path);
+
+void clear();
+
+class ScopedSpan {
+ public:
+  // 'detail' is shown as an argument of the span, e.g. the model or graph name.
+  explicit ScopedSpan(const char* name, const char* detail = nullptr)
+      : m_name(name), m_startUs(isEnabled() ? nowUs() : 0) {
+    if (m_startUs && detail) {
+      m_detail = detail;
+    }
+  }
+
+  ScopedSpan(const char* name, const std::string& detail) : ScopedSpan(name, detail.c_str()) {}
+
+  ~ScopedSpan() {
+    if (m_startUs) {
+      addSpan(m_name, "host", m_startUs, nowUs() - m_startUs, m_detail);
+    }
+  }
+
+  ScopedSpan(const ScopedSpan&) = delete;
+  ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+ private:
+  const char* m_name;
+  uint64_t m_startUs;
+  std::string m_detail;
+};
+
+}  // namespace trace
+}  // namespace tools
+}  // namespace qnn
+
+#define QNN_TRACE_CONCAT_(a, b) a##b
+#define QNN_TRACE_CONCAT(a, b)  QNN_TRACE_CONCAT_(a, b)
+
+// Traces the enclosing scope: TRACE_SCOPE("name") or TRACE_SCOPE("name", detail_string).
+#define TRACE_SCOPE(...) \
+  qnn::tools::trace::ScopedSpan QNN_TRACE_CONCAT(traceSpan_, __LINE__)(__VA_ARGS__)
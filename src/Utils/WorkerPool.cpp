@@ -0,0 +1,46 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+#include "WorkerPool.hpp"
+#include "Logger.hpp"
+
+using namespace qnn::tools::workerpool;
+
+WorkerPool::WorkerPool(const std::string& name, size_t threadCount)
+    : m_name(name), m_tasks(std::make_shared<BlockingQueue<Task>>()) {
+  if (0 == threadCount) {
+    threadCount = 1;
+  }
+  for (size_t i = 0; i < threadCount; i++) {
+    m_threads.emplace_back(&WorkerPool::run, m_tasks);
+  }
+  QNN_INFO("WorkerPool[%s]: %zu threads", m_name.c_str(), threadCount);
+}
+
+WorkerPool::~WorkerPool() { stop(); }
+
+bool WorkerPool::post(Task task) { return m_tasks->push(std::move(task)); }
+
+void WorkerPool::stop() {
+  m_tasks->close();
+  for (std::thread& thread : m_threads) {
+    if (thread.get_id() == std::this_thread::get_id()) {
+      thread.detach();  // Stopped by one of its tasks, the thread exits once that task returns.
+    } else if (thread.joinable()) {
+      thread.join();
+    }
+  }
+}
+
+void WorkerPool::run(std::shared_ptr<BlockingQueue<Task>> tasks) {
+  Task task;
+  while (tasks->pop(task)) {
+    task();
+    task = nullptr;     // Release what the task holds before waiting for the next one.
+  }
+}
@@ -0,0 +1,55 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BlockingQueue.hpp"
+
+namespace qnn {
+namespace tools {
+namespace workerpool {
+
+using Task = std::function<void()>;
+
+/*
+ * Fixed set of threads running the tasks posted to it in the order they were posted.
+ * Used to run inferences for callers which don't want to block, e.g. an asyncio event loop.
+ */
+class WorkerPool {
+ public:
+  WorkerPool(const std::string& name, size_t threadCount);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  // Returns false once the pool is stopped, 'task' isn't run then.
+  bool post(Task task);
+
+  // Runs the tasks already posted, then joins the threads.
+  void stop();
+
+  size_t getThreadCount() const { return m_threads.size(); }
+
+ private:
+  static void run(std::shared_ptr<BlockingQueue<Task>> tasks);
+
+  std::string m_name;
+  // Shared with the threads: the one a task stopped the pool from is detached and may outlive the pool.
+  std::shared_ptr<BlockingQueue<Task>> m_tasks;
+  std::vector<std::thread> m_threads;
+};
+
+}  // namespace workerpool
+}  // namespace tools
+}  // namespace qnn
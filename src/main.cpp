@@ -8,6 +8,7 @@
 
 #include <iostream>
 #include <memory>
+#include <stdexcept>
 #include <string>
 
 #include "BuildId.hpp"
@@ -15,6 +16,7 @@
 #include "Logger.hpp"
 #include "PAL/DynamicLoading.hpp"
 #include "PAL/GetOpt.hpp"
+#include "PackedDataset.hpp"
 #include "QnnSampleApp.hpp"
 #include "QnnSampleAppUtils.hpp"
 
@@ -121,6 +123,31 @@ void showHelp() {
          "                                  libQnnSystem.so is provided under <target>/lib in the "
          "SDK.\n"
          "\n"
+      << "  --num_io_threads    <VAL>       Number of threads reading the next input batches while\n"
+         "                                  the current one executes. Defaults to 0, which reads,\n"
+         "                                  executes and writes each batch in turn.\n"
+      << "\n"
+      << "  --prefetch_depth    <VAL>       Number of input batches read ahead of execution when\n"
+         "                                  --num_io_threads is set. Defaults to 2.\n"
+      << "\n"
+      << "  --num_writer_threads <VAL>      Number of threads writing outputs when --num_io_threads\n"
+         "                                  is set. Defaults to 1.\n"
+      << "\n"
+      << "  --pack_dataset      <FILE>      Pack the files of --input_list into one memory-mapped\n"
+         "                                  dataset and exit. Takes one output file per input list,\n"
+         "                                  comma separated. Files ending in .qaipack can then be\n"
+         "                                  passed to --input_list directly.\n"
+      << "\n"
+      << "  --async_output                  Write outputs from a background thread so execution\n"
+         "                                  does not wait for the disk.\n"
+      << "\n"
+      << "  --output_container  <FILE>      Write all outputs into this single file (index and\n"
+         "                                  blobs) instead of one .raw file per output. Implies\n"
+         "                                  --async_output.\n"
+      << "\n"
+      << "  --compress_outputs              Compress each output with zlib, when the library was\n"
+         "                                  built with zlib. Implies --async_output.\n"
+      << "\n"
       << "  --version                       Print the QNN SDK version.\n"
       << "\n"
       << "  --help                          Show this help message.\n"
@@ -134,6 +161,56 @@ void showHelpAndExit(std::string&& error) {
   std::exit(EXIT_FAILURE);
 }
 
+size_t parseCountOrExit(const char* value, const char* option) {
+  std::string text = value ? value : "";
+  size_t parsed    = 0;
+  size_t count     = 0;
+  try {
+    // std::stoul would quietly wrap "-1" around to a huge count.
+    if (text.find('-') == std::string::npos) {
+      count = std::stoul(text, &parsed);
+    }
+  } catch (const std::exception&) {
+    parsed = 0;
+  }
+  if (text.empty() || parsed != text.size()) {
+    showHelpAndExit("Invalid number for " + std::string(option) + ": " + text);
+  }
+  return count;
+}
+
+// Converts each text input list into the packed dataset at the same position of 'outputPaths'.
+int packInputLists(const std::string& inputListPaths,
+                   const std::string& outputPaths,
+                   iotensor::InputDataType inputDataType) {
+  std::vector<std::string> inputLists;
+  std::vector<std::string> outputs;
+  split(inputLists, inputListPaths, ',');
+  split(outputs, outputPaths, ',');
+  if (inputLists.size() != outputs.size()) {
+    showHelpAndExit("--pack_dataset needs one output file per input list.");
+  }
+  Qnn_DataType_t dataType = inputDataType == iotensor::InputDataType::FLOAT ? QNN_DATATYPE_FLOAT_32
+                                                                            : QNN_DATATYPE_UNDEFINED;
+  for (size_t i = 0; i < inputLists.size(); i++) {
+    std::vector<std::vector<std::string>> filePathList;
+    std::unordered_map<std::string, uint32_t> inputNameToIndex;
+    bool readSuccess;
+    std::tie(filePathList, inputNameToIndex, readSuccess) = readInputList(inputLists[i]);
+    if (!readSuccess) {
+      std::cerr << "ERROR: Could not read input list " << inputLists[i] << "\n";
+      return EXIT_FAILURE;
+    }
+    if (datautil::StatusCode::SUCCESS !=
+        datautil::packInputList(filePathList, inputNameToIndex, outputs[i], dataType)) {
+      std::cerr << "ERROR: Could not pack " << inputLists[i] << " into " << outputs[i] << "\n";
+      return EXIT_FAILURE;
+    }
+    std::cout << "Packed " << inputLists[i] << " into " << outputs[i] << std::endl;
+  }
+  return EXIT_SUCCESS;
+}
+
 std::unique_ptr<sample_app::QnnSampleApp> processCommandLine(int argc,
                                                              char** argv,
                                                              bool& loadFromCachedBinary) {
@@ -152,7 +229,14 @@ std::unique_ptr<sample_app::QnnSampleApp> processCommandLine(int argc,
     OPT_RETRIEVE_CONTEXT = 11,
     OPT_SAVE_CONTEXT     = 12,
     OPT_VERSION          = 13,
-    OPT_SYSTEM_LIBRARY   = 14
+    OPT_SYSTEM_LIBRARY   = 14,
+    OPT_NUM_IO_THREADS   = 15,
+    OPT_PREFETCH_DEPTH   = 16,
+    OPT_NUM_WRITER_THREADS = 17,
+    OPT_PACK_DATASET     = 18,
+    OPT_ASYNC_OUTPUT     = 19,
+    OPT_OUTPUT_CONTAINER = 20,
+    OPT_COMPRESS_OUTPUTS = 21
   };
 
   // Create the command line options
@@ -172,6 +256,13 @@ std::unique_ptr<sample_app::QnnSampleApp> processCommandLine(int argc,
       {"save_context", pal::required_argument, NULL, OPT_SAVE_CONTEXT},
       {"system_library", pal::required_argument, NULL, OPT_SYSTEM_LIBRARY},
       {"version", pal::no_argument, NULL, OPT_VERSION},
+      {"num_io_threads", pal::required_argument, NULL, OPT_NUM_IO_THREADS},
+      {"prefetch_depth", pal::required_argument, NULL, OPT_PREFETCH_DEPTH},
+      {"num_writer_threads", pal::required_argument, NULL, OPT_NUM_WRITER_THREADS},
+      {"pack_dataset", pal::required_argument, NULL, OPT_PACK_DATASET},
+      {"async_output", pal::no_argument, NULL, OPT_ASYNC_OUTPUT},
+      {"output_container", pal::required_argument, NULL, OPT_OUTPUT_CONTAINER},
+      {"compress_outputs", pal::no_argument, NULL, OPT_COMPRESS_OUTPUTS},
       {NULL, 0, NULL, 0}};
 
   // Command line parsing loop
@@ -191,6 +282,13 @@ std::unique_ptr<sample_app::QnnSampleApp> processCommandLine(int argc,
   std::string saveBinaryName;
   QnnLog_Level_t logLevel{QNN_LOG_LEVEL_ERROR};
   std::string systemLibraryPath;
+  size_t numReaderThreads = 0;
+  size_t numWriterThreads = 1;
+  size_t prefetchDepth    = 2;
+  std::string packDatasetPaths;
+  bool asyncOutput = false;
+  bool compressOutputs = false;
+  std::string outputContainerPath;
   while ((opt = pal::getOptLongOnly(argc, argv, "", s_longOptions, &longIndex)) != -1) {
     switch (opt) {
       case OPT_HELP:
@@ -279,6 +377,46 @@ std::unique_ptr<sample_app::QnnSampleApp> processCommandLine(int argc,
         }
         break;
 
+      case OPT_NUM_IO_THREADS:
+        numReaderThreads = parseCountOrExit(pal::g_optArg, "--num_io_threads");
+        break;
+
+      case OPT_PREFETCH_DEPTH:
+        prefetchDepth = parseCountOrExit(pal::g_optArg, "--prefetch_depth");
+        if (0 == prefetchDepth) {
+          showHelpAndExit("Prefetch depth must be at least 1.");
+        }
+        break;
+
+      case OPT_NUM_WRITER_THREADS:
+        numWriterThreads = parseCountOrExit(pal::g_optArg, "--num_writer_threads");
+        if (0 == numWriterThreads) {
+          showHelpAndExit("Number of writer threads must be at least 1.");
+        }
+        break;
+
+      case OPT_PACK_DATASET:
+        packDatasetPaths = pal::g_optArg;
+        if (packDatasetPaths.empty()) {
+          showHelpAndExit("Packed dataset output file not specified.");
+        }
+        break;
+
+      case OPT_ASYNC_OUTPUT:
+        asyncOutput = true;
+        break;
+
+      case OPT_OUTPUT_CONTAINER:
+        outputContainerPath = pal::g_optArg;
+        if (outputContainerPath.empty()) {
+          showHelpAndExit("Output container file not specified.");
+        }
+        break;
+
+      case OPT_COMPRESS_OUTPUTS:
+        compressOutputs = true;
+        break;
+
       default:
         std::cerr << "ERROR: Invalid argument passed: " << argv[pal::g_optInd - 1]
                   << "\nPlease check the Arguments section in the description below.\n";
@@ -287,6 +425,13 @@ std::unique_ptr<sample_app::QnnSampleApp> processCommandLine(int argc,
     }
   }
 
+  if (!packDatasetPaths.empty()) {
+    if (inputListPaths.empty()) {
+      showHelpAndExit("Missing option: --input_list\n");
+    }
+    std::exit(packInputLists(inputListPaths, packDatasetPaths, parsedInputDataType));
+  }
+
   if (!modelPath.empty()) {
     if (!cachedBinaryPath.empty()) {
       showHelpAndExit(
@@ -362,6 +507,8 @@ std::unique_ptr<sample_app::QnnSampleApp> processCommandLine(int argc,
                                                                              dumpOutputs,
                                                                              cachedBinaryPath,
                                                                              saveBinaryName));
+  app->setPipelineConfig(numReaderThreads, numWriterThreads, prefetchDepth);
+  app->setAsyncOutput(asyncOutput, outputContainerPath, compressOutputs);
   return app;
 }
 
@@ -0,0 +1,142 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+// Throughput of the micro-batching scheduler against a model whose execution costs about the same for a full
+// batch as for one item. Every client checks that it gets back its own item, and a batch whose outputs don't
+// split into items must fail all of its requests. Clients with different perf profiles must not share a batch.
+//
+// Usage: bench_batch_scheduler [threads] [requests per thread] [model batch] [execute us]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BatchScheduler.hpp"
+
+using namespace qnn::tools::batchscheduler;
+
+static const size_t sg_itemElements = 1024;
+
+// The perf profiles of the mixed clients. The first element of their items holds the index of theirs plus one.
+static const char* sg_profiles[] = {"burst", "balanced"};
+
+// Returns each float32 input item as the output item, after 'executeUs'. With 'checkProfiles' it fails a batch
+// holding an item of a mixed client whose perf profile isn't the one the batch runs with.
+static BatchExecuteFn makeModel(size_t modelBatchSize, uint32_t executeUs, bool splitOutputs, bool checkProfiles = false) {
+  return [=](std::vector<uint8_t*>& inputBuffers, std::vector<uint8_t*>& outputBuffers, std::vector<size_t>& outputSize,
+             std::string& perfProfile, const std::vector<std::string>&, bool) {
+    std::this_thread::sleep_for(std::chrono::microseconds(executeUs));
+    for (size_t slot = 0; checkProfiles && slot < modelBatchSize; slot++) {
+      float profile = ((const float*)inputBuffers[0])[slot * sg_itemElements];
+      if (profile != 0 && perfProfile != sg_profiles[(int)profile - 1]) {
+        return false;
+      }
+    }
+    size_t size = sg_itemElements * sizeof(float) * modelBatchSize + (splitOutputs ? 0 : 1);
+    uint8_t* output = (uint8_t*)malloc(size);
+    memcpy(output, inputBuffers[0], std::min(size, sg_itemElements * sizeof(float) * modelBatchSize));
+    outputBuffers.push_back(output);
+    outputSize.push_back(size);
+    return true;
+  };
+}
+
+// Runs 'threads' clients of 'requests' inferences each, returns the failed ones. With 'mixed' the clients take
+// turns with the perf profiles of 'sg_profiles', otherwise they all use "burst".
+static long runClients(BatchScheduler& scheduler, int threads, int requests, double& seconds, bool mixed = false) {
+  std::atomic<long> failed{0};
+  std::vector<std::thread> clients;
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < threads; t++) {
+    clients.emplace_back([&, t] {
+      std::vector<float> item(sg_itemElements);
+      for (int i = 0; i < requests; i++) {
+        std::fill(item.begin(), item.end(), (float)(t * requests + i));
+        std::string perfProfile = "burst";
+        if (mixed) {
+          item[0]     = (float)(t % 2 + 1);
+          perfProfile = sg_profiles[t % 2];
+        }
+        std::vector<uint8_t*> inputBuffers{(uint8_t*)item.data()};
+        std::vector<uint8_t*> outputBuffers;
+        std::vector<size_t> outputSize;
+        bool ok = scheduler.submit(inputBuffers, outputBuffers, outputSize, perfProfile);
+        if (!ok || outputBuffers.size() != 1 || outputSize[0] != item.size() * sizeof(float) ||
+            0 != memcmp(outputBuffers[0], item.data(), outputSize[0])) {
+          failed++;
+        }
+        for (uint8_t* buffer : outputBuffers) {
+          free(buffer);
+        }
+      }
+    });
+  }
+  for (auto& client : clients) {
+    client.join();
+  }
+  seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return failed;
+}
+
+int main(int argc, char** argv) {
+  int threads           = argc > 1 ? atoi(argv[1]) : 8;
+  int requests          = argc > 2 ? atoi(argv[2]) : 200;
+  size_t modelBatchSize = argc > 3 ? (size_t)atoi(argv[3]) : 8;
+  uint32_t executeUs    = argc > 4 ? (uint32_t)atoi(argv[4]) : 1000;
+  std::vector<BatchInput> inputs{{"float32", sg_itemElements, sizeof(float)}};
+  int result = EXIT_SUCCESS;
+
+  for (size_t maxBatchSize = 1; maxBatchSize <= modelBatchSize; maxBatchSize *= 2) {
+    BatchConfig config;
+    config.modelBatchSize = modelBatchSize;
+    config.maxBatchSize   = maxBatchSize;
+    config.maxWaitUs      = 200;
+    BatchScheduler scheduler("bench", config, inputs, makeModel(modelBatchSize, executeUs, true));
+
+    double seconds = 0;
+    long failed    = runClients(scheduler, threads, requests, seconds);
+    BatchStats stats = scheduler.getStats();
+    printf("max batch %2zu: %8.0f inferences/s, avg fill %5.2f, avg wait %7.1f us, %ld failed\n", maxBatchSize,
+           threads * requests / seconds, (double)stats.requests / std::max<uint64_t>(stats.batches, 1),
+           (double)stats.totalWaitUs / std::max<uint64_t>(stats.requests, 1), failed);
+    if (failed) {
+      result = EXIT_FAILURE;
+    }
+  }
+
+  // Outputs which aren't a whole number of items fail every request of the batch.
+  BatchConfig config;
+  config.modelBatchSize = modelBatchSize;
+  config.maxBatchSize   = modelBatchSize;
+  BatchScheduler scheduler("unsplittable", config, inputs, makeModel(modelBatchSize, 0, false));
+  double seconds = 0;
+  long failed    = runClients(scheduler, threads, 4, seconds);
+  printf("unsplittable outputs: %ld of %d requests failed\n", failed, threads * 4);
+  if (failed != threads * 4) {
+    result = EXIT_FAILURE;
+  }
+
+  // Each batch runs with the perf profile of all of its requests.
+  config.maxWaitUs = 200;
+  BatchScheduler mixedScheduler("mixed", config, inputs, makeModel(modelBatchSize, executeUs, true, true));
+  failed           = runClients(mixedScheduler, threads, requests, seconds, true);
+  BatchStats stats = mixedScheduler.getStats();
+  printf("mixed perf profiles: avg fill %5.2f, %ld failed\n",
+         (double)stats.requests / std::max<uint64_t>(stats.batches, 1), failed);
+  if (failed) {
+    result = EXIT_FAILURE;
+  }
+
+  return result;
+}
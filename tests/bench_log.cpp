@@ -0,0 +1,196 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+// Cost of the logging calls: a QNN_DEBUG filtered out by the level, with or without QNN_LOG_MAX_COMPILED_LEVEL,
+// and a QNN_INFO written synchronously or through the asynchronous rings, flooding or in bursts. The log goes to a
+// file, the results to the console. Every logged call has to end up in the file, in order, or in the dropped
+// count, also while the asynchronous logging is switched off and on under load.
+//
+// Usage: bench_log [filtered calls per thread] [logged calls per thread] [threads] [log file]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "LibAppBuilder.hpp"
+#include "Logger.hpp"
+
+static const char* sg_marker = "bench_log line";
+static FILE* sg_console      = nullptr;
+static const char* sg_logPath = nullptr;
+
+// Runs 'body(thread)' on 'threads' threads, returns the nanoseconds per call it reports through 'timedNs'.
+template <typename Body>
+static double runThreads(int threads, long calls, Body body) {
+  std::vector<std::thread> workers;
+  std::atomic<uint64_t> timedNs{0};
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([&, t] { timedNs += body(t); });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  return (double)timedNs / ((double)threads * calls);
+}
+
+static uint64_t elapsedNs(std::chrono::steady_clock::time_point start) {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void truncateLog() {
+  fflush(stdout);
+  if (!freopen(sg_logPath, "w", stdout)) {
+    fprintf(sg_console, "can't open %s\n", sg_logPath);
+    exit(EXIT_FAILURE);
+  }
+}
+
+// The lines of the bench in the log, -1 if the calls of a thread are out of order.
+static long countLogLines() {
+  fflush(stdout);
+  FILE* file = fopen(sg_logPath, "r");
+  long lines = 0;
+  bool ordered = true;
+  std::vector<long> lastCall;
+  char line[1024];
+  while (file && fgets(line, sizeof(line), file)) {
+    const char* text = strstr(line, sg_marker);
+    int thread = 0;
+    long call = 0;
+    if (!text) {
+      continue;
+    }
+    lines++;
+    if (2 == sscanf(text + strlen(sg_marker), " thread %d call %ld", &thread, &call) && thread >= 0) {
+      if ((size_t)thread >= lastCall.size()) {
+        lastCall.resize(thread + 1, -1);
+      }
+      ordered = ordered && call > lastCall[thread];
+      lastCall[thread] = call;
+    }
+  }
+  if (file) {
+    fclose(file);
+  }
+  return ordered ? lines : -1;
+}
+
+// Logs 'calls' QNN_INFO per thread, in bursts of 'burst' calls 'pauseUs' apart if 'burst' is set. Returns false
+// if a call is neither in the log nor dropped.
+static bool benchLogged(const char* name, bool async, int threads, long calls, int burst, int pauseUs) {
+  truncateLog();
+  SetLogAsync(async);
+  uint64_t dropped = GetLogDroppedCount();
+  double ns = runThreads(threads, calls, [&](int t) {
+    uint64_t timed = 0;
+    for (long i = 0; i < calls;) {
+      long end = burst ? std::min(calls, i + burst) : calls;
+      auto start = std::chrono::steady_clock::now();
+      for (; i < end; i++) {
+        QNN_INFO("%s thread %d call %ld of %ld", sg_marker, t, i, calls);
+      }
+      timed += elapsedNs(start);
+      if (burst) {
+        std::this_thread::sleep_for(std::chrono::microseconds(pauseUs));
+      }
+    }
+    return timed;
+  });
+  SetLogAsync(false);     // Writes what is queued.
+  dropped = GetLogDroppedCount() - dropped;
+
+  long expected = threads * calls - (long)dropped, written = countLogLines();
+  fprintf(sg_console, "%-30s %-5s %d threads: %8.1f ns/call, %llu of %ld dropped\n", name, async ? "async" : "sync",
+          threads, ns, (unsigned long long)dropped, threads * calls);
+  if (written != expected) {
+    fprintf(sg_console, "  %ld lines written, %ld expected (-1: out of order)\n", written, expected);
+    return false;
+  }
+  return true;
+}
+
+// Switches the asynchronous logging off and on while the threads log: every call is written, in order, or dropped.
+static bool checkToggle(int threads, long calls) {
+  truncateLog();
+  SetLogAsync(true);
+  uint64_t dropped = GetLogDroppedCount();
+  std::atomic<int> running{threads};
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([&, t] {
+      for (long i = 0; i < calls; i++) {
+        QNN_INFO("%s thread %d call %ld", sg_marker, t, i);
+      }
+      running--;
+    });
+  }
+  int toggles = 0;
+  for (; running > 0; toggles++) {
+    SetLogAsync(toggles % 2 == 1);
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  SetLogAsync(false);
+  dropped = GetLogDroppedCount() - dropped;
+
+  long expected = threads * calls - (long)dropped, written = countLogLines();
+  fprintf(sg_console, "switched async %d times: %ld lines written, %ld expected (-1: out of order)\n", toggles,
+          written, expected);
+  return written == expected;
+}
+
+int main(int argc, char** argv) {
+  long filteredCalls = argc > 1 ? atol(argv[1]) : 20000000;
+  long loggedCalls   = argc > 2 ? atol(argv[2]) : 200000;
+  int threads        = argc > 3 ? atoi(argv[3]) : 4;
+  std::string logPath = argc > 4 ? argv[4] : "bench_log_" + std::to_string(getpid()) + ".txt";
+
+  // The results go to the console, stdout to the log file.
+  sg_console = fdopen(dup(fileno(stdout)), "w");
+  setvbuf(sg_console, nullptr, _IONBF, 0);
+  sg_logPath = logPath.c_str();
+  truncateLog();
+  SetLogLevel(QNN_LOG_LEVEL_INFO);
+
+  fprintf(sg_console, "QNN_LOG_MAX_COMPILED_LEVEL %d\n", QNN_LOG_MAX_COMPILED_LEVEL);
+  for (int n : {1, threads}) {
+    double ns = runThreads(n, filteredCalls, [&](int t) {
+      auto start = std::chrono::steady_clock::now();
+      for (long i = 0; i < filteredCalls; i++) {
+        QNN_DEBUG("%s thread %d call %ld", sg_marker, t, i);
+      }
+      return elapsedNs(start);
+    });
+    fprintf(sg_console, "filtered QNN_DEBUG                 %d threads: %8.2f ns/call\n", n, ns);
+  }
+  if (countLogLines()) {
+    fprintf(sg_console, "a filtered call was written\n");
+    return EXIT_FAILURE;
+  }
+
+  bool ok = true;
+  for (bool async : {false, true}) {
+    ok = benchLogged("QNN_INFO flood", async, 1, loggedCalls, 0, 0) && ok;
+    ok = benchLogged("QNN_INFO flood", async, threads, loggedCalls, 0, 0) && ok;
+    ok = benchLogged("QNN_INFO bursts of 64 / 200 us", async, threads, loggedCalls / 10, 64, 200) && ok;
+  }
+  ok = checkToggle(threads, loggedCalls) && ok;
+
+  fclose(stdout);
+  remove(sg_logPath);
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
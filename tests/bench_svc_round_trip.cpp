@@ -0,0 +1,109 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+// Round-trip latency of the Svc protocol without a model: a client thread sends SVC_CMD_RUN requests shaped like
+// those of an inference, an echo thread decodes each one and answers with a reply carrying the outputs, like
+// QAIAppSvc does. Measured over the pipes and over the share memory rings, so the cost of the framing and of the
+// transport shows apart from the inference.
+//
+// Usage: bench_svc_round_trip [round trips] [outputs] [ring spin us]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "Utils/SvcProtocol.hpp"
+
+// Answers every request with 'outputs' buffers until the channel ends.
+static void echo(SvcChannel_t* channel, size_t outputs) {
+  SvcMessage_t request, reply;
+  std::vector<uint8_t> scratch;
+  while (SvcReadMessage(*channel, request, scratch)) {
+    reply.Reset(SVC_CMD_REPLY, request.header.requestId);
+    for (size_t i = 0; i < outputs; i++) {
+      reply.buffers.push_back({i * 4096, 4096});
+    }
+    if (!SvcWriteMessage(*channel, reply, scratch)) {
+      break;
+    }
+  }
+  SvcChannelClose(*channel);
+}
+
+// Returns the round trips which failed, 'latencies' gets the others in microseconds.
+static long measure(SvcChannel_t& client, long roundTrips, std::vector<double>& latencies) {
+  SvcMessage_t request, reply;
+  std::vector<uint8_t> scratch;
+  long failed = 0;
+  for (long i = 0; i < roundTrips; i++) {
+    request.Reset(SVC_CMD_RUN, (uint32_t)i);
+    request.strings.push_back("model");
+    request.strings.push_back("share_memory");
+    request.strings.push_back("burst");
+    request.buffers.push_back({0, 4096});
+
+    auto start = std::chrono::steady_clock::now();
+    bool ok = SvcWriteMessage(client, request, scratch) && SvcReadMessage(client, reply, scratch);
+    auto end = std::chrono::steady_clock::now();
+    if (!ok || reply.header.requestId != (uint32_t)i) {
+      failed++;
+      continue;
+    }
+    latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+  }
+  return failed;
+}
+
+// One run over a fresh pair of pipes, and rings too if 'ringName' is set.
+static bool run(const char* transport, const std::string& ringName, uint32_t spinUs, long roundTrips, size_t outputs) {
+  SvcChannel_t client, server;
+  if (!pal::process::createPipe(server.hRead, client.hWrite) || !pal::process::createPipe(client.hRead, server.hWrite)) {
+    printf("%s: failed to create the pipes\n", transport);
+    return false;
+  }
+  if (!ringName.empty() && (!SvcChannelOpenRings(client, ringName, spinUs, true) ||
+                            !SvcChannelOpenRings(server, ringName, spinUs, false))) {
+    printf("%s: failed to map the rings\n", transport);
+    return false;
+  }
+
+  std::thread server_thread(echo, &server, outputs);
+  std::vector<double> latencies;
+  latencies.reserve(roundTrips);
+  measure(client, std::min(roundTrips, 1000L), latencies);     // Warm up.
+  latencies.clear();
+  long failed = measure(client, roundTrips, latencies);
+  SvcChannelClose(client);
+  server_thread.join();
+
+  if (latencies.empty()) {
+    printf("%s: all %ld round trips failed\n", transport, roundTrips);
+    return false;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  printf("%-18s p50 %7.1f us  p99 %7.1f us  max %8.1f us  %ld failed\n", transport, latencies[latencies.size() / 2],
+         latencies[latencies.size() * 99 / 100], latencies.back(), failed);
+  return failed == 0;
+}
+
+int main(int argc, char** argv) {
+  long roundTrips = argc > 1 ? atol(argv[1]) : 20000;
+  size_t outputs  = argc > 2 ? (size_t)atol(argv[2]) : 4;
+  uint32_t spinUs = argc > 3 ? (uint32_t)atoi(argv[3]) : 20;
+  std::string ringName = "qai_bench_rt_" + std::to_string(getpid());
+
+  bool ok = run("pipes", "", 0, roundTrips, outputs);
+  ok = run("rings, no spin", ringName + "_0", 0, roundTrips, outputs) && ok;
+  ok = run(("rings, spin " + std::to_string(spinUs) + " us").c_str(), ringName + "_s", spinUs, roundTrips, outputs) && ok;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,243 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+// Fuzz the decoders of the Svc protocol: random messages have to survive the round trip, and truncated, extended,
+// corrupted, oversized and random ones have to be rejected or decoded within their bounds, never read past them.
+// Run it under AddressSanitizer to catch the reads the checks would miss.
+//
+// Usage: fuzz_svc_protocol [iterations] [seed]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Utils/SvcProtocol.hpp"
+
+// The decoding SvcReadMessage() does, from a buffer instead of a channel. The payload is copied to a buffer of its
+// own size, so reading past it is caught.
+static bool decode(const std::vector<uint8_t>& data, SvcMessage_t& message) {
+  SvcMsgHeader_t header;
+  if (data.size() < sizeof(header) || !SvcDecodeHeader(data.data(), sizeof(header), header)) {
+    return false;
+  }
+  std::vector<uint8_t> payload(data.begin() + sizeof(header), data.end());
+  return SvcDecodePayload(header, payload.data(), payload.size(), message);
+}
+
+static bool sameMessage(const SvcMessage_t& a, const SvcMessage_t& b) {
+  return 0 == memcmp(&a.header, &b.header, sizeof(a.header)) && a.strings == b.strings && a.buffers.size() == b.buffers.size() &&
+         (a.buffers.empty() || 0 == memcmp(a.buffers.data(), b.buffers.data(), a.buffers.size() * sizeof(SvcBufferDesc_t)));
+}
+
+static void randomMessage(std::mt19937_64& rng, SvcMessage_t& message) {
+  message.Reset((uint16_t)(SVC_CMD_LOAD + rng() % SVC_CMD_INFO), (uint32_t)rng());
+  message.header.flags = (uint32_t)(rng() % 8);
+  message.header.value = rng();
+  for (int i = (int)(rng() % 8); i > 0; i--) {
+    message.buffers.push_back({rng(), rng()});
+  }
+  for (int i = (int)(rng() % 6); i > 0; i--) {
+    std::string str(rng() % 64, '\0');
+    for (char& c : str) {
+      c = (char)rng();
+    }
+    message.strings.push_back(str);
+  }
+}
+
+static void mutate(std::mt19937_64& rng, std::vector<uint8_t>& data) {
+  switch (rng() % 5) {
+    case 0:   // Flip a few bytes.
+      for (int k = 1 + (int)(rng() % 4); k > 0; k--) {
+        data[rng() % data.size()] ^= (uint8_t)(1 + rng() % 255);
+      }
+      break;
+    case 1:   // Truncate.
+      data.resize(rng() % data.size());
+      break;
+    case 2:   // Extend.
+      for (int k = 1 + (int)(rng() % 16); k > 0; k--) {
+        data.push_back((uint8_t)rng());
+      }
+      break;
+    case 3: { // Corrupt a count or the payload size of the header, which the bounds checks rely on.
+      SvcMsgHeader_t header;
+      memcpy(&header, data.data(), sizeof(header));
+      switch (rng() % 3) {
+        case 0: header.bufferCount = (uint32_t)rng(); break;
+        case 1: header.stringCount = (uint32_t)rng(); break;
+        case 2: header.payloadSize = rng() % 2 ? rng() : header.payloadSize + rng() % 64 - 32; break;
+      }
+      memcpy(data.data(), &header, sizeof(header));
+      break;
+    }
+    case 4: { // Random bytes behind a valid magic and version.
+      data.resize(sizeof(SvcMsgHeader_t) + rng() % 256);
+      for (uint8_t& byte : data) {
+        byte = (uint8_t)rng();
+      }
+      uint32_t magic = SVC_PROTOCOL_MAGIC;
+      uint16_t version = SVC_PROTOCOL_VERSION;
+      memcpy(data.data(), &magic, sizeof(magic));
+      memcpy(data.data() + sizeof(magic), &version, sizeof(version));
+      break;
+    }
+  }
+}
+
+// Headers which must never be accepted.
+static int checkOversized() {
+  int failed = 0;
+  SvcMessage_t message;
+  std::vector<uint8_t> data;
+  message.Reset(SVC_CMD_RUN, 1);
+  message.strings.push_back("model");
+  SvcEncodeMessage(message, data);
+
+  SvcMsgHeader_t header;
+  memcpy(&header, data.data(), sizeof(header));
+  SvcMsgHeader_t bad = header;
+  bad.payloadSize = (uint64_t)SVC_MAX_PAYLOAD_SIZE + 1;
+  failed += SvcDecodeHeader((const uint8_t*)&bad, sizeof(bad), bad);
+  bad = header;
+  bad.bufferCount = 0xffffffff;
+  failed += SvcDecodeHeader((const uint8_t*)&bad, sizeof(bad), bad);
+  bad = header;
+  bad.stringCount = 0xffffffff;
+  failed += SvcDecodeHeader((const uint8_t*)&bad, sizeof(bad), bad);
+  bad = header;
+  bad.version = SVC_PROTOCOL_VERSION + 1;
+  failed += SvcDecodeHeader((const uint8_t*)&bad, sizeof(bad), bad);
+  bad = header;
+  bad.command = SVC_CMD_INFO + 1;
+  failed += SvcDecodeHeader((const uint8_t*)&bad, sizeof(bad), bad);
+  failed += SvcDecodeHeader(data.data(), sizeof(header) - 1, bad);
+
+  // A string longer than the payload.
+  std::vector<uint8_t> payload(data.begin() + sizeof(header), data.end());
+  uint32_t length = 0xfffffff0;
+  memcpy(payload.data(), &length, sizeof(length));
+  failed += SvcDecodePayload(header, payload.data(), payload.size(), message);
+
+  if (failed) {
+    printf("%d oversized or invalid headers were accepted\n", failed);
+  }
+  return failed;
+}
+
+// Tensor infos from random replies: decoded or rejected, never read out of their strings.
+static long fuzzTensorInfos(std::mt19937_64& rng, long iterations) {
+  long accepted = 0;
+  SvcMessage_t message;
+  std::vector<TensorInfo> inputs, outputs;
+  for (long it = 0; it < iterations; it++) {
+    TensorInfo info;
+    info.name = "t";
+    info.dataType = "uint8";
+    info.size = rng();
+    info.scale = (float)rng();
+    info.offset = (int32_t)rng();
+    info.quantized = rng() % 2;
+    info.shape.resize(rng() % 6);
+    for (size_t& dim : info.shape) {
+      dim = rng();
+    }
+    message.Reset(SVC_CMD_REPLY, 0);
+    SvcEncodeTensorInfos(message, {info}, {});
+    std::string& bytes = message.strings[2];
+    switch (rng() % 3) {
+      case 0: bytes.resize(rng() % (bytes.size() + 1)); break;
+      case 1: bytes.append(rng() % 16, 'x'); break;
+      case 2: bytes[rng() % bytes.size()] ^= (char)(1 + rng() % 255); break;
+    }
+    accepted += SvcDecodeTensorInfos(message, inputs, outputs);
+  }
+  return accepted;
+}
+
+// LoRA adapters of SVC_CMD_LOAD: random ones, with ';' and ',' in the paths, have to come back as they were, and
+// with a string dropped or a count corrupted they have to be rejected or decoded within the strings. Returns the
+// round trips which failed.
+static long fuzzLoraAdapters(std::mt19937_64& rng, long iterations, long& accepted) {
+  long failed = 0;
+  SvcMessage_t message;
+  for (long it = 0; it < iterations; it++) {
+    std::vector<LoraAdapter> adapters, decoded;
+    for (size_t a = rng() % 4; a > 0; a--) {
+      std::vector<std::string> paths(rng() % 4);
+      for (std::string& path : paths) {
+        path = "/lora;dir,x/" + std::to_string(rng() % 1000) + (rng() % 2 ? ";" : "") + ".bin";
+      }
+      adapters.push_back(LoraAdapter("graph_" + std::to_string(a), paths));
+    }
+    message.Reset(SVC_CMD_LOAD, 0);
+    message.strings = {"model", "model_path", "backend", "system"};
+    SvcEncodeLoraAdapters(message, adapters);
+    bool same = SvcDecodeLoraAdapters(message, 4, decoded) && decoded.size() == adapters.size();
+    for (size_t a = 0; same && a < adapters.size(); a++) {
+      same = decoded[a].m_graph_name == adapters[a].m_graph_name && decoded[a].m_bin_paths == adapters[a].m_bin_paths;
+    }
+    failed += !same;
+
+    if (message.strings.size() > 4) {
+      if (rng() % 2) {
+        message.strings.pop_back();
+      }
+      else {
+        std::string& count = message.strings[5];
+        count[rng() % count.size()] ^= (char)(1 + rng() % 255);
+      }
+      accepted += SvcDecodeLoraAdapters(message, 4, decoded);
+    }
+  }
+  return failed;
+}
+
+int main(int argc, char** argv) {
+  long iterations = argc > 1 ? atol(argv[1]) : 1000000;
+  uint64_t seed   = argc > 2 ? strtoull(argv[2], nullptr, 10) : 42;
+  std::mt19937_64 rng(seed);
+  SvcMessage_t message, decoded;
+  std::vector<uint8_t> data;
+  long accepted = 0;
+
+  for (long it = 0; it < iterations; it++) {
+    randomMessage(rng, message);
+    SvcEncodeMessage(message, data);
+    if (!decode(data, decoded) || !sameMessage(message, decoded)) {
+      printf("round trip %ld failed, seed %llu\n", it, (unsigned long long)seed);
+      return EXIT_FAILURE;
+    }
+
+    mutate(rng, data);
+    if (decode(data, decoded)) {
+      // An accepted message has to be one the encoder makes from it.
+      std::vector<uint8_t> again;
+      SvcEncodeMessage(decoded, again);
+      if (again != data) {
+        printf("mutated message %ld decoded inconsistently, seed %llu\n", it, (unsigned long long)seed);
+        return EXIT_FAILURE;
+      }
+      accepted++;
+    }
+  }
+
+  long infosAccepted = fuzzTensorInfos(rng, iterations / 10);
+  long adaptersAccepted = 0;
+  long adaptersFailed = fuzzLoraAdapters(rng, iterations / 10, adaptersAccepted);
+  printf("%ld round trips, %ld mutated messages accepted, %ld mutated tensor infos accepted, "
+         "%ld mutated LoRA adapters accepted\n", iterations, accepted, infosAccepted, adaptersAccepted);
+  if (adaptersFailed) {
+    printf("%ld LoRA adapter round trips failed, seed %llu\n", adaptersFailed, (unsigned long long)seed);
+    return EXIT_FAILURE;
+  }
+  return checkOversized() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,300 @@
+//==============================================================================
+//
+// Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+//
+// SPDX-License-Identifier: BSD-3-Clause
+//
+//==============================================================================
+
+// Fault injection on the service processes: threads keep inferences in flight on every replica of a model while
+// the replicas are killed one after the other. The requests pending on a dead process are failed, not left waiting,
+// and run once more on its new process; every other kill takes that new process down too, so the callers whose
+// retry was in it fail. An inference may fail, but it has to return. Each replica has to come back in a new
+// process, and afterwards every inference has to succeed with the outputs it had before the kills.
+// Needs QAIAppSvc and a model:
+//   QAI_APPBUILDER_TEST_MODEL   path of the model.
+//   QAI_APPBUILDER_TEST_LIBS    directory of the QNN libraries.
+//   QAI_APPBUILDER_TEST_RUNTIME 'Htp' (default) or 'Cpu'.
+// Skipped without them, with exit code 77.
+//
+// Usage: test_svc_fault [replicas] [threads] [kills] [period ms] [timeout ms]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <memory>
+#include <signal.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "LibAppBuilder.hpp"
+
+#define TEST_SKIPPED    77
+
+static const char* sg_modelName = "fault";
+static const char* sg_procName  = "fault_svc";
+
+static int64_t nowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// The pid of the QAIAppSvc process of 'procName', 0 if there is none. Its command line is
+// "QAIAppSvc svc <pipe in> <pipe out> <log epoch> <log level> <profiling level> <proc name> ...".
+static int findSvcProcess(const std::string& procName) {
+  DIR* dir = opendir("/proc");
+  if (!dir) {
+    return 0;
+  }
+  int found = 0;
+  while (struct dirent* entry = readdir(dir)) {
+    int pid = atoi(entry->d_name);
+    if (pid <= 0) {
+      continue;
+    }
+    // Read with read(2): the process may exit meanwhile, then the read fails.
+    int fd = open((std::string("/proc/") + entry->d_name + "/cmdline").c_str(), O_RDONLY);
+    if (fd < 0) {
+      continue;
+    }
+    std::string cmdline;
+    char buffer[512];
+    ssize_t bytes;
+    while ((bytes = read(fd, buffer, sizeof(buffer))) > 0) {
+      cmdline.append(buffer, (size_t)bytes);
+    }
+    close(fd);
+    std::vector<std::string> args;
+    for (size_t start = 0; start < cmdline.size();) {
+      size_t end = cmdline.find('\0', start);
+      end = end == std::string::npos ? cmdline.size() : end;
+      args.push_back(cmdline.substr(start, end - start));
+      start = end + 1;
+    }
+    if (args.size() > 7 && args[0].find("QAIAppSvc") != std::string::npos && args[1] == "svc" && args[7] == procName) {
+      found = pid;
+      break;
+    }
+  }
+  closedir(dir);
+  return found;
+}
+
+// Inferences on the replicas, with what the checks need to know about them.
+class Clients {
+public:
+  Clients(LibAppBuilder& app, const std::vector<TensorInfo>& inputs, int threads)
+      : m_app(app), m_callStartMs(threads) {
+    for (const TensorInfo& info : inputs) {
+      m_inputs.push_back(std::vector<uint8_t>(info.size, 0));
+    }
+    for (auto& start : m_callStartMs) {
+      start = 0;
+    }
+  }
+
+  // One inference, its outputs in 'outputs'.
+  bool infer(std::vector<std::vector<uint8_t>>& outputs) {
+    std::vector<uint8_t*> inputBuffers;
+    std::vector<size_t> inputSize;
+    for (auto& input : m_inputs) {
+      inputBuffers.push_back(input.data());
+      inputSize.push_back(input.size());
+    }
+    std::vector<uint8_t*> outputBuffers;
+    std::vector<size_t> outputSize;
+    std::string perfProfile = "burst";
+    bool ok = m_app.ModelInference(sg_modelName, sg_procName, std::string(), inputBuffers, inputSize, outputBuffers,
+                                   outputSize, perfProfile);
+    outputs.clear();
+    for (size_t i = 0; i < outputBuffers.size(); i++) {
+      outputs.push_back(std::vector<uint8_t>(outputBuffers[i], outputBuffers[i] + outputSize[i]));
+      free(outputBuffers[i]);
+    }
+    return ok;
+  }
+
+  void start(const std::vector<std::vector<uint8_t>>& expected) {
+    for (size_t t = 0; t < m_callStartMs.size(); t++) {
+      m_threads.emplace_back([this, t, &expected] {
+        std::vector<std::vector<uint8_t>> outputs;
+        while (!m_stop) {
+          int64_t startMs = nowMs();
+          m_callStartMs[t] = startMs;
+          bool ok = infer(outputs);
+          int64_t ms = nowMs() - startMs;
+          m_callStartMs[t] = 0;
+          if (ok && outputs == expected) {
+            m_succeeded++;
+          }
+          else {
+            m_failed++;
+            int64_t longest = m_longestFailureMs;
+            while (ms > longest && !m_longestFailureMs.compare_exchange_weak(longest, ms)) {
+            }
+          }
+        }
+        m_finished++;
+      });
+    }
+  }
+
+  // The longest an inference in flight has been running, in milliseconds.
+  int64_t longestCallMs() const {
+    int64_t now = nowMs(), longest = 0;
+    for (auto& start : m_callStartMs) {
+      int64_t startMs = start;
+      if (startMs) {
+        longest = std::max(longest, now - startMs);
+      }
+    }
+    return longest;
+  }
+
+  // Returns false if a thread is still in an inference after 'timeoutMs'. The threads are left running then.
+  bool stop(int64_t timeoutMs) {
+    m_stop = true;
+    int64_t deadline = nowMs() + timeoutMs;
+    while (m_finished < (int)m_threads.size()) {
+      if (nowMs() > deadline) {
+        return false;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (auto& thread : m_threads) {
+      thread.join();
+    }
+    return true;
+  }
+
+  long succeeded() const { return m_succeeded; }
+  long failed() const { return m_failed; }
+  int64_t longestFailureMs() const { return m_longestFailureMs; }
+
+private:
+  LibAppBuilder& m_app;
+  std::vector<std::vector<uint8_t>> m_inputs;
+  std::vector<std::atomic<int64_t>> m_callStartMs;  // When the inference of each thread started, 0 between them.
+  std::vector<std::thread> m_threads;
+  std::atomic<bool> m_stop{false};
+  std::atomic<int> m_finished{0};
+  std::atomic<long> m_succeeded{0};
+  std::atomic<long> m_failed{0};
+  std::atomic<int64_t> m_longestFailureMs{0};
+};
+
+int main(int argc, char** argv) {
+  int replicas      = argc > 1 ? atoi(argv[1]) : 2;
+  int threads       = argc > 2 ? atoi(argv[2]) : 4;
+  int kills         = argc > 3 ? atoi(argv[3]) : 4;
+  int periodMs      = argc > 4 ? atoi(argv[4]) : 300;
+  int64_t timeoutMs = argc > 5 ? atoll(argv[5]) : 30000;
+
+  const char* modelPath = getenv("QAI_APPBUILDER_TEST_MODEL");
+  const char* libsPath  = getenv("QAI_APPBUILDER_TEST_LIBS");
+  const char* runtime   = getenv("QAI_APPBUILDER_TEST_RUNTIME");
+  if (!modelPath || !libsPath) {
+    printf("skipped: needs QAI_APPBUILDER_TEST_MODEL and QAI_APPBUILDER_TEST_LIBS\n");
+    return TEST_SKIPPED;
+  }
+  std::string backendLibPath = std::string(libsPath) + "/libQnn" + (runtime ? runtime : "Htp") + ".so";
+  std::string systemLibPath  = std::string(libsPath) + "/libQnnSystem.so";
+
+  LibAppBuilder app;
+  std::vector<TensorInfo> inputs, outputs;
+  if (!app.ModelInitialize(sg_modelName, sg_procName, modelPath, backendLibPath, systemLibPath, false) ||
+      !app.ModelSetReplicas(sg_modelName, replicas) || !app.ModelGetInfo(sg_modelName, sg_procName, inputs, outputs)) {
+    printf("failed to load %s in %d replicas\n", modelPath, replicas);
+    return EXIT_FAILURE;
+  }
+
+  Clients clients(app, inputs, threads);
+  std::vector<std::vector<uint8_t>> expected;
+  if (!clients.infer(expected)) {
+    printf("the inference failed before any kill\n");
+    return EXIT_FAILURE;
+  }
+
+  // Kill a replica while inferences are in flight, wait until it runs in a new process and inferences succeed again.
+  int result = EXIT_SUCCESS;
+  std::vector<int64_t> recoveryMs;
+  clients.start(expected);
+  for (int k = 0; k < kills && result == EXIT_SUCCESS; k++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(periodMs));
+    int replica = k % replicas;
+    std::string procName = replica ? std::string(sg_procName) + "#" + std::to_string(replica) : sg_procName;
+    int pid = findSvcProcess(procName);
+    if (!pid) {
+      printf("kill %d: no process for %s\n", k, procName.c_str());
+      result = EXIT_FAILURE;
+      break;
+    }
+
+    int64_t killMs = nowMs();
+    long succeeded = clients.succeeded();
+    bool killAgain = k % 2 == 1;
+    kill(pid, SIGKILL);
+    for (;;) {
+      int newPid = findSvcProcess(procName);
+      if (newPid && newPid != pid && killAgain) {
+        kill(newPid, SIGKILL);
+        pid = newPid;
+        killAgain = false;
+        continue;
+      }
+      if (newPid && newPid != pid && clients.succeeded() > succeeded + threads) {
+        recoveryMs.push_back(nowMs() - killMs);
+        break;
+      }
+      if (clients.longestCallMs() > timeoutMs) {
+        printf("kill %d: an inference hangs for %lld ms\n", k, (long long)clients.longestCallMs());
+        result = EXIT_FAILURE;
+        break;
+      }
+      if (nowMs() - killMs > timeoutMs) {
+        printf("kill %d: %s not restarted after %lld ms\n", k, procName.c_str(), (long long)timeoutMs);
+        result = EXIT_FAILURE;
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  if (!clients.stop(timeoutMs)) {
+    // A caller left waiting on a dead process, the threads can't be joined.
+    printf("inferences still in flight %lld ms after the end of the test\n", (long long)timeoutMs);
+    fflush(stdout);
+    _exit(EXIT_FAILURE);
+  }
+  if (clients.longestFailureMs() > timeoutMs) {
+    printf("a failed inference took %lld ms to return\n", (long long)clients.longestFailureMs());
+    result = EXIT_FAILURE;
+  }
+
+  // Nothing is left pending on the replicas: each one answers every inference with the outputs of before.
+  long failedAfter = 0;
+  std::vector<std::vector<uint8_t>> outputsAfter;
+  for (int i = 0; i < 4 * replicas; i++) {
+    if (!clients.infer(outputsAfter) || outputsAfter != expected) {
+      failedAfter++;
+    }
+  }
+  if (failedAfter) {
+    result = EXIT_FAILURE;
+  }
+
+  std::sort(recoveryMs.begin(), recoveryMs.end());
+  printf("replicas %d threads %d kills %zu: %ld ok, %ld failed (longest %lld ms), recovery p50 %lld ms max %lld ms, "
+         "%ld of %d failed after\n", replicas, threads, recoveryMs.size(), clients.succeeded(), clients.failed(),
+         (long long)clients.longestFailureMs(), (long long)(recoveryMs.empty() ? 0 : recoveryMs[recoveryMs.size() / 2]),
+         (long long)(recoveryMs.empty() ? 0 : recoveryMs.back()), failedAfter, 4 * replicas);
+
+  app.ModelDestroy(sg_modelName, sg_procName);
+  return result;
+}
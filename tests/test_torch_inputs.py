@@ -0,0 +1,129 @@
+#=============================================================================
+#
+# Copyright (c) 2023, Qualcomm Innovation Center, Inc. All rights reserved.
+#
+# SPDX-License-Identifier: BSD-3-Clause
+#
+#=============================================================================
+
+# Inputs and 'out' arrays which aren't numpy arrays: torch CPU tensors, and objects whose '__dlpack__' fails.
+# Needs the qai_appbuilder package and a model:
+#   QAI_APPBUILDER_TEST_MODEL   path of the model.
+#   QAI_APPBUILDER_TEST_LIBS    directory of the QNN libraries.
+#   QAI_APPBUILDER_TEST_RUNTIME 'Htp' (default) or 'Cpu'.
+# The tests are skipped without them, the torch tests without torch.
+#
+# Usage: python -m unittest -v test_torch_inputs
+
+import os
+import unittest
+
+import numpy as np
+
+try:
+    import torch
+except ImportError:
+    torch = None
+
+try:
+    from qai_appbuilder import QNNConfig, QNNContext, LogLevel
+except ImportError:
+    QNNContext = None
+
+MODEL_PATH = os.getenv("QAI_APPBUILDER_TEST_MODEL")
+LIBS_PATH = os.getenv("QAI_APPBUILDER_TEST_LIBS")
+RUNTIME = os.getenv("QAI_APPBUILDER_TEST_RUNTIME", "Htp")
+
+g_model = None
+
+
+def setUpModule():
+    global g_model
+    if QNNContext is None or not MODEL_PATH or not LIBS_PATH:
+        raise unittest.SkipTest("needs qai_appbuilder, QAI_APPBUILDER_TEST_MODEL and QAI_APPBUILDER_TEST_LIBS")
+    QNNConfig.Config(LIBS_PATH, RUNTIME, LogLevel.ERROR)
+    g_model = QNNContext("test_torch_inputs", MODEL_PATH)
+
+
+def tearDownModule():
+    global g_model
+    g_model = None
+
+
+def numpy_inputs():
+    rng = np.random.default_rng(0)
+    return [np.ascontiguousarray(rng.random(spec["shape"]).astype(spec["dtype"]) if spec["dtype"] == "float32" else
+                                 rng.integers(0, 2, spec["shape"]).astype(spec["dtype"]))
+            for spec in g_model.input_specs]
+
+
+class FailingDLPack:
+    """An object whose '__dlpack__' raises, with or without '__array__' to fall back to."""
+    def __init__(self, array):
+        self.array = array
+
+    def __dlpack__(self, stream=None):
+        raise BufferError("no DLPack for this device")
+
+    def __dlpack_device__(self):
+        return (1, 0)
+
+
+class FailingDLPackWithArray(FailingDLPack):
+    def __array__(self, dtype=None, copy=None):
+        return self.array
+
+
+class DLPackFallbackTest(unittest.TestCase):
+    def test_array_fallback(self):
+        inputs = numpy_inputs()
+        expected = g_model.Inference(inputs)
+        outputs = g_model.Inference([FailingDLPackWithArray(array) for array in inputs])
+        for output, reference in zip(outputs, expected):
+            np.testing.assert_array_equal(output, reference)
+
+    def test_no_fallback_raises_type_error(self):
+        inputs = numpy_inputs()
+        with self.assertRaisesRegex(TypeError, "Input 0 .*from_dlpack"):
+            g_model.Inference([FailingDLPack(inputs[0])] + inputs[1:])
+
+
+@unittest.skipIf(torch is None, "needs torch")
+class TorchTensorTest(unittest.TestCase):
+    def test_tensor_inputs(self):
+        inputs = numpy_inputs()
+        expected = g_model.Inference(inputs)
+        outputs = g_model.Inference([torch.from_numpy(array.copy()) for array in inputs])
+        for output, reference in zip(outputs, expected):
+            np.testing.assert_array_equal(output, reference)
+
+    def test_out_tensors(self):
+        inputs = numpy_inputs()
+        expected = g_model.Inference(inputs)
+        out = [torch.empty(tuple(spec["shape"]), dtype=torch.float32) for spec in g_model.output_specs]
+        outputs = g_model.Inference(inputs, out=out)
+        self.assertEqual(len(outputs), len(out))
+        for output, tensor, reference in zip(outputs, out, expected):
+            self.assertIs(output, tensor)
+            np.testing.assert_array_equal(tensor.numpy(), reference)
+
+    def test_outputs_to_torch_share_memory(self):
+        outputs = g_model.Inference(numpy_inputs())
+        for output in outputs:
+            self.assertEqual(torch.from_dlpack(output).data_ptr(), output.ctypes.data)
+
+    def test_tensor_requiring_grad_raises_type_error(self):
+        inputs = numpy_inputs()
+        tensor = torch.from_numpy(inputs[0].astype(np.float32)).requires_grad_()
+        with self.assertRaisesRegex(TypeError, "Input 0"):
+            g_model.Inference([tensor] + inputs[1:])
+
+    def test_non_contiguous_tensor_raises_value_error(self):
+        inputs = numpy_inputs()
+        strided = torch.from_numpy(np.repeat(inputs[0].reshape(-1), 2))[::2]
+        with self.assertRaisesRegex(ValueError, "not C-contiguous"):
+            g_model.Inference([strided] + inputs[1:])
+
+
+if __name__ == "__main__":
+    unittest.main()